@@ -0,0 +1,360 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+#include "m_arena.h"
+
+#include "m_mempool.h"
+
+#undef M_TRACE
+#if defined(M_TRACE_MODE) && defined(M_TRACE_ARENA)
+#define M_TRACE(msg, ...) _M_TRACER("-- Arena -- "msg, __VA_ARGS__)
+#else
+#define M_TRACE(moo, ...)
+#endif
+
+static M_TLS m_Arena*
+_m_Arena_global = NULL;
+
+static const m_Allocator
+_m_Arena_allocator = { &m_Arena_malloc, &m_Arena_realloc, &m_Arena_free };
+
+#define _m_Arena_round(sz) \
+  (((sz) + (M_ARENA_ALIGN - 1)) & ~(M_SZ)(M_ARENA_ALIGN - 1))
+
+#define M_ARENA_HEADER _m_Arena_round(sizeof(m_ArenaBlock))
+
+#define _m_ArenaBlock_data(blk) ((M_UCHAR*)(blk) + M_ARENA_HEADER)
+
+/*
+ *  Make a block the one in use.
+ */
+#define _m_Arena_use(a, blk) \
+  do { \
+    (a)->block = (blk); \
+    (a)->top = (a)->floor = _m_ArenaBlock_data(blk); \
+    (a)->end = (a)->top + (blk)->size; \
+  } while (0)
+
+m_Arena*
+m_Arena_get(M_VOID)
+{
+  return _m_Arena_global;
+}
+
+M_VOID
+m_Arena_set(const m_Arena* const a)
+{
+  M_TRACE("setting global arena ("M_PTR_FMT")", a);
+  _m_Arena_global = (m_Arena*) a;
+}
+
+M_BOOL
+m_Arena_new(m_Arena** const a,
+        const M_SZ blocksz)
+{
+  assert(a && !*a);
+  M_TRACE("new ("M_PTR_FMT") blocksz ("M_SZ_FMT")", a, blocksz);
+  if (!a || *a) return M_FALSE;
+
+  *a = M_MALLOC(sizeof(m_Arena));
+  assert(*a);
+  if (!*a) return M_FALSE;
+  return m_Arena_init(*a, blocksz);
+}
+
+M_VOID
+m_Arena_delete(m_Arena** const a)
+{
+  assert(a && *a);
+  M_TRACE("delete ("M_PTR_FMT")", *a);
+  if (!a || !*a) return;
+
+  m_Arena_fini(*a);
+  M_FREE(*a, sizeof(m_Arena));
+  *a = NULL;
+}
+
+M_BOOL
+m_Arena_init(m_Arena* const a,
+        const M_SZ blocksz)
+{
+  assert(a);
+  M_TRACE("init ("M_PTR_FMT") blocksz ("M_SZ_FMT")", a, blocksz);
+  if (!a) return M_FALSE;
+
+  a->first = a->block = NULL;
+  a->top = a->end = a->floor = NULL;
+  a->blocksz = blocksz ? blocksz : M_ARENA_BLOCK;
+  a->used = 0;
+  a->size = 0;
+  return M_TRUE;
+}
+
+M_VOID
+m_Arena_fini(m_Arena* const a)
+{
+  m_ArenaBlock* blk;
+
+  assert(a);
+  M_TRACE("fini ("M_PTR_FMT")", a);
+  if (!a) return;
+
+  while ((blk = a->first))
+  {
+    a->first = blk->next;
+    M_FREE(blk, M_ARENA_HEADER + blk->size);
+  }
+  a->block = NULL;
+  a->top = a->end = a->floor = NULL;
+  a->used = 0;
+  a->size = 0;
+}
+
+/*
+ *  Go on with the next block with room for sz, or a new one put before
+ *  the next.
+ */
+static M_PTR
+_m_Arena_alloc_block(m_Arena* const a,
+        const M_SZ sz)
+{
+  m_ArenaBlock* blk = a->block ? a->block->next : a->first;
+
+  if (!blk || blk->size < sz)
+  {
+    const M_SZ size = M_MAX(sz, a->blocksz);
+
+    if (size > (M_SZ)-1 - M_ARENA_HEADER) return NULL;
+    blk = M_MALLOC(M_ARENA_HEADER + size);
+    assert(blk);
+    if (!blk) return NULL;
+    M_TRACE("new block ("M_PTR_FMT") size ("M_SZ_FMT")", blk, size);
+    blk->size = size;
+    if (a->block)
+    {
+      blk->next = a->block->next;
+      a->block->next = blk;
+    }
+    else
+    {
+      blk->next = a->first;
+      a->first = blk;
+    }
+    a->size += size;
+  }
+  _m_Arena_use(a, blk);
+  a->top += sz;
+  a->used += sz;
+  return a->floor;
+}
+
+M_PTR
+m_Arena_alloc(m_Arena* const a,
+        const M_SZ sz)
+{
+  M_SZ need;
+  M_PTR p;
+
+  assert(a);
+  if (!a) return NULL;
+
+  if (sz > (M_SZ)-1 - M_ARENA_ALIGN) return NULL;
+  need = _m_Arena_round(sz ? sz : 1);
+  if ((M_SZ)(a->end - a->top) < need)
+    return _m_Arena_alloc_block(a, need);
+  p = a->top;
+  a->top += need;
+  a->used += need;
+  return p;
+}
+
+/*
+ *  The last allocation, with nothing above it to keep for a mark.
+ */
+#define _m_Arena_is_last(a, p, oldsz) \
+  ((M_UCHAR*)(p) >= (a)->floor \
+  && (M_UCHAR*)(p) + _m_Arena_round((oldsz) ? (oldsz) : 1) == (a)->top)
+
+M_PTR
+m_Arena_resize(m_Arena* const a,
+        const M_PTR p,
+        const M_SZ sz,
+        const M_SZ oldsz)
+{
+  M_PTR q;
+
+  assert(a);
+  if (!a) return NULL;
+
+  if (!p) return m_Arena_alloc(a, sz);
+  if (sz > (M_SZ)-1 - M_ARENA_ALIGN) return NULL;
+  if (_m_Arena_is_last(a, p, oldsz)
+      && (M_SZ)(a->end - (M_UCHAR*)p) >= _m_Arena_round(sz ? sz : 1))
+  {
+    a->used -= a->top - (M_UCHAR*)p;
+    a->top = (M_UCHAR*)p + _m_Arena_round(sz ? sz : 1);
+    a->used += a->top - (M_UCHAR*)p;
+    return (M_PTR) p;
+  }
+  if (sz <= oldsz) return (M_PTR) p;
+  q = m_Arena_alloc(a, sz);
+  if (!q) return NULL;
+  memcpy(q, p, oldsz);
+  return q;
+}
+
+M_VOID
+m_Arena_release(m_Arena* const a,
+        const M_PTR p,
+        const M_SZ sz)
+{
+  assert(a);
+  if (!a || !p) return;
+
+  if (_m_Arena_is_last(a, p, sz))
+  {
+    a->used -= a->top - (M_UCHAR*)p;
+    a->top = (M_UCHAR*)p;
+  }
+}
+
+M_VOID
+m_Arena_mark(m_Arena* const a,
+        m_ArenaMark* const mark)
+{
+  assert(a);
+  assert(mark);
+  M_TRACE("mark ("M_PTR_FMT") top ("M_PTR_FMT")", a, a->top);
+  if (!a || !mark) return;
+
+  mark->block = a->block;
+  mark->top = a->top;
+  mark->floor = a->floor;
+  mark->used = a->used;
+  a->floor = a->top;
+}
+
+M_VOID
+m_Arena_rewind(m_Arena* const a,
+        const m_ArenaMark* const mark)
+{
+  assert(a);
+  assert(mark);
+  M_TRACE("rewind ("M_PTR_FMT") top ("M_PTR_FMT")", a, mark->top);
+  if (!a || !mark) return;
+
+  a->block = mark->block;
+  a->top = mark->top;
+  a->end = mark->block ?
+      _m_ArenaBlock_data(mark->block) + mark->block->size : NULL;
+  a->floor = mark->floor;
+  a->used = mark->used;
+}
+
+M_VOID
+m_Arena_reset(m_Arena* const a)
+{
+  assert(a);
+  M_TRACE("reset ("M_PTR_FMT") used ("M_SZ_FMT")", a, a->used);
+  if (!a) return;
+
+  if (a->first)
+    _m_Arena_use(a, a->first);
+  a->used = 0;
+}
+
+M_VOID
+m_Arena_purge(m_Arena* const a)
+{
+  m_ArenaBlock* blk;
+  m_ArenaBlock** next;
+
+  assert(a);
+  M_TRACE("purge ("M_PTR_FMT")", a);
+  if (!a) return;
+
+  next = a->block ? &a->block->next : &a->first;
+  while ((blk = *next))
+  {
+    *next = blk->next;
+    a->size -= blk->size;
+    M_FREE(blk, M_ARENA_HEADER + blk->size);
+  }
+}
+
+M_PTR
+m_Arena_malloc(const M_SZ sz)
+{
+  return m_Arena_alloc(_m_Arena_global, sz);
+}
+
+M_PTR
+m_Arena_realloc(const M_PTR p,
+        const M_SZ sz,
+        const M_SZ oldsz)
+{
+  return m_Arena_resize(_m_Arena_global, p, sz, oldsz);
+}
+
+M_VOID
+m_Arena_free(const M_PTR p,
+        const M_SZ sz)
+{
+  m_Arena_release(_m_Arena_global, p, sz);
+}
+
+M_VOID
+m_Arena_drop(M_PTR p)
+{
+  M_UNUSED(p);
+}
+
+const m_Allocator*
+m_Arena_allocator(M_VOID)
+{
+  return &_m_Arena_allocator;
+}
+
+#ifndef NDEBUG
+
+M_VOID
+m_Arena_debug(const m_Arena* const a)
+{
+  const m_ArenaBlock* blk;
+  M_SZ n = 0;
+
+  assert(a);
+  for (blk = a->first; blk; blk = blk->next) ++n;
+  printf("-- Arena -- debug ("M_PTR_FMT"):\n"
+         "--     blocks = "M_SZ_FMT"\n"
+         "--     size = "M_SZ_FMT"\n"
+         "--     used = "M_SZ_FMT"\n"
+         "--     blocksz = "M_SZ_FMT"\n"
+         "-- end arena debug\n",
+      a, n, a->size, a->used, a->blocksz);
+}
+
+#endif /* !NDEBUG */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
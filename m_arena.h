@@ -0,0 +1,293 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+/**
+ *  \file m_arena.h
+ *  \brief Arena (region) allocator.
+ *  \author Stanislas Marquis <stan@astrorigin.com>
+ */
+
+/*
+ *  Memory is cut from big blocks by moving a pointer, and never given
+ *  back one allocation at a time: all of it goes at once, by resetting
+ *  the arena, or by rewinding it to a mark taken before. Blocks are kept
+ *  by a reset and used again, so an arena serving one request after the
+ *  other stops asking for memory once it has seen the biggest request.
+ *
+ *  Containers can take their memory from an arena through the functions
+ *  working on the arena set for the current thread: m_Arena_allocator
+ *  for m_Array and m_String (see m_Array_init2 and m_String_init2), or
+ *  m_Arena_malloc and m_Arena_drop for m_BTree_init2. Finalizing them is
+ *  then optional, the reset takes all.
+ *
+ *  An arena serves one thread.
+ */
+
+#ifndef M_ARENA_H
+#define M_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "m_h.h"
+#include "m_array.h"
+
+/**
+ *  \def M_ARENA_BLOCK
+ *  \brief Default size of the blocks of an arena.
+ */
+#define M_ARENA_BLOCK 65536
+
+/**
+ *  \def M_ARENA_ALIGN
+ *  \brief Alignment of all allocations (a power of 2).
+ */
+#define M_ARENA_ALIGN 16
+
+/**
+ *  \typedef m_ArenaBlock
+ */
+typedef struct _m_ArenaBlock m_ArenaBlock;
+
+/**
+ *  \struct _m_ArenaBlock
+ *  \brief Header of a block, followed by its memory.
+ */
+struct _m_ArenaBlock
+{
+  m_ArenaBlock* next; /* next block, used after this one */
+  M_SZ size; /* bytes after the header */
+};
+
+/**
+ *  \typedef m_Arena
+ */
+typedef struct _m_Arena m_Arena;
+
+/**
+ *  \struct _m_Arena
+ *  \brief The arena.
+ */
+struct _m_Arena
+{
+  m_ArenaBlock* first; /* blocks, in order of use */
+  m_ArenaBlock* block; /* block in use (NULL before the first) */
+  M_UCHAR* top; /* next free byte in block */
+  M_UCHAR* end; /* end of block */
+  M_UCHAR* floor; /* memory below was there at the last mark */
+  M_SZ blocksz; /* size of new blocks */
+  M_SZ used; /* bytes handed out */
+  M_SZ size; /* bytes held in blocks */
+};
+
+/**
+ *  \typedef m_ArenaMark
+ */
+typedef struct _m_ArenaMark m_ArenaMark;
+
+/**
+ *  \struct _m_ArenaMark
+ *  \brief A point to rewind an arena to.
+ */
+struct _m_ArenaMark
+{
+  m_ArenaBlock* block;
+  M_UCHAR* top;
+  M_UCHAR* floor;
+  M_SZ used;
+};
+
+/**
+ *  \brief Get the arena set for the current thread (or NULL).
+ */
+M_DLLAPI m_Arena*
+m_Arena_get(M_VOID);
+
+/**
+ *  \brief Set the arena used by m_Arena_malloc and friends in the
+ *  current thread (or NULL).
+ *  \param a The arena.
+ */
+M_DLLAPI M_VOID
+m_Arena_set(const m_Arena* const a);
+
+/**
+ *  \brief Allocate for a new arena.
+ *  \param a The arena (by ref, initialized to NULL).
+ *  \param blocksz Size of blocks, or 0 for M_ARENA_BLOCK.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_Arena_new(m_Arena** const a,
+        const M_SZ blocksz);
+
+/**
+ *  \brief Delete an arena, and all memory taken from it.
+ *  \param a The arena (by ref).
+ */
+M_DLLAPI M_VOID
+m_Arena_delete(m_Arena** const a);
+
+/**
+ *  \brief Initialize an arena.
+ *  \param a The arena.
+ *  \param blocksz Size of blocks, or 0 for M_ARENA_BLOCK.
+ *  \return M_TRUE, or M_FALSE on error.
+ *
+ *  No memory is taken before the first allocation.
+ */
+M_DLLAPI M_BOOL
+m_Arena_init(m_Arena* const a,
+        const M_SZ blocksz);
+
+/**
+ *  \brief Finalize an arena, and free all memory taken from it.
+ *  \param a The arena.
+ */
+M_DLLAPI M_VOID
+m_Arena_fini(m_Arena* const a);
+
+/**
+ *  \brief Allocate memory from an arena.
+ *  \param a The arena.
+ *  \param sz Size of memory.
+ *  \return Memory aligned to M_ARENA_ALIGN, or NULL on error.
+ */
+M_DLLAPI M_PTR
+m_Arena_alloc(m_Arena* const a,
+        const M_SZ sz);
+
+/**
+ *  \brief Resize memory taken from an arena.
+ *  \param a The arena.
+ *  \param p The memory (or NULL).
+ *  \param sz New size.
+ *  \param oldsz Size of memory.
+ *  \return The memory, moved or not, or NULL on error.
+ *
+ *  The last allocation grows in place while its block has room.
+ */
+M_DLLAPI M_PTR
+m_Arena_resize(m_Arena* const a,
+        const M_PTR p,
+        const M_SZ sz,
+        const M_SZ oldsz);
+
+/**
+ *  \brief Give memory back to an arena.
+ *  \param a The arena.
+ *  \param p The memory.
+ *  \param sz Size of memory.
+ *
+ *  Only the last allocation is taken back, others wait for the reset.
+ */
+M_DLLAPI M_VOID
+m_Arena_release(m_Arena* const a,
+        const M_PTR p,
+        const M_SZ sz);
+
+/**
+ *  \brief Mark the current state of an arena.
+ *  \param a The arena.
+ *  \param mark The mark.
+ */
+M_DLLAPI M_VOID
+m_Arena_mark(m_Arena* const a,
+        m_ArenaMark* const mark);
+
+/**
+ *  \brief Free all memory taken from an arena since a mark.
+ *  \param a The arena.
+ *  \param mark The mark.
+ *
+ *  Marks nest: rewinding to a mark drops the marks taken after it.
+ */
+M_DLLAPI M_VOID
+m_Arena_rewind(m_Arena* const a,
+        const m_ArenaMark* const mark);
+
+/**
+ *  \brief Free all memory taken from an arena, keeping its blocks.
+ *  \param a The arena.
+ */
+M_DLLAPI M_VOID
+m_Arena_reset(m_Arena* const a);
+
+/**
+ *  \brief Free the blocks an arena does not use at the moment.
+ *  \param a The arena.
+ */
+M_DLLAPI M_VOID
+m_Arena_purge(m_Arena* const a);
+
+/**
+ *  \brief Allocate memory from the arena of the current thread.
+ *  \see m_Arena_alloc
+ */
+M_DLLAPI M_PTR
+m_Arena_malloc(const M_SZ sz);
+
+/**
+ *  \brief Resize memory taken from the arena of the current thread.
+ *  \see m_Arena_resize
+ */
+M_DLLAPI M_PTR
+m_Arena_realloc(const M_PTR p,
+        const M_SZ sz,
+        const M_SZ oldsz);
+
+/**
+ *  \brief Give memory back to the arena of the current thread.
+ *  \see m_Arena_release
+ */
+M_DLLAPI M_VOID
+m_Arena_free(const M_PTR p,
+        const M_SZ sz);
+
+/**
+ *  \brief Free function without size (for m_BTree_init2), does nothing.
+ */
+M_DLLAPI M_VOID
+m_Arena_drop(M_PTR p);
+
+/**
+ *  \brief Get allocation functions for the arena of the current thread.
+ */
+M_DLLAPI const m_Allocator*
+m_Arena_allocator(M_VOID);
+
+#ifndef NDEBUG
+
+M_DLLAPI M_VOID
+m_Arena_debug(const m_Arena* const a);
+
+#endif /* !NDEBUG */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !M_ARENA_H */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -40,29 +40,44 @@ m_Array_new(m_Array** const arr,
     const M_SZ len,
     const M_SZ unit,
     const m_array_calc_space_fn_t csfn)
+{
+  return m_Array_new2(arr, len, unit, csfn, NULL);
+}
+
+M_BOOL
+m_Array_new2(m_Array** const arr,
+    const M_SZ len,
+    const M_SZ unit,
+    const m_array_calc_space_fn_t csfn,
+    const m_Allocator* const alloc)
 {
   assert(arr && !*arr);
   assert(unit);
-  M_TRACE("new ("M_PTR_FMT") len ("M_SZ_FMT") unit ("M_SZ_FMT")",
-      arr, len, unit);
+  M_TRACE("new2 ("M_PTR_FMT") len ("M_SZ_FMT") unit ("M_SZ_FMT")"
+      " allocator ("M_PTR_FMT")", arr, len, unit, alloc);
   if (!arr || *arr || !unit) return M_FALSE;
 
-  *arr = M_MALLOC(sizeof(m_Array));
+  *arr = alloc ? (*alloc->malloc_fn)(sizeof(m_Array))
+      : M_MALLOC(sizeof(m_Array));
   assert(*arr);
   if (!*arr) return M_FALSE;
-  return m_Array_init(*arr, len, unit, csfn);
+  return m_Array_init2(*arr, len, unit, csfn, alloc);
 }
 
 M_VOID
 m_Array_delete(m_Array** const arr,
         const m_array_finalize_fn_t fn)
 {
+  const m_Allocator* alloc;
+
   assert(arr && *arr);
   M_TRACE("delete ("M_PTR_FMT") finalize_fn ("M_PTR_FMT")", *arr, fn);
   if (!arr || !*arr) return;
 
+  alloc = (*arr)->allocator;
   m_Array_fini(*arr, fn);
-  M_FREE(*arr, sizeof(m_Array));
+  if (alloc) (*alloc->free_fn)(*arr, sizeof(m_Array));
+  else M_FREE(*arr, sizeof(m_Array));
   *arr = NULL;
 }
 
@@ -71,13 +86,23 @@ m_Array_init(m_Array* const arr,
         const M_SZ len,
         const M_SZ unit,
         const m_array_calc_space_fn_t csfn)
+{
+  return m_Array_init2(arr, len, unit, csfn, NULL);
+}
+
+M_BOOL
+m_Array_init2(m_Array* const arr,
+        const M_SZ len,
+        const M_SZ unit,
+        const m_array_calc_space_fn_t csfn,
+        const m_Allocator* const alloc)
 {
   M_SZ space_req;
 
   assert(arr);
   assert(unit);
-  M_TRACE("init ("M_PTR_FMT") len ("M_SZ_FMT") unit ("M_SZ_FMT")",
-      arr, len, unit);
+  M_TRACE("init2 ("M_PTR_FMT") len ("M_SZ_FMT") unit ("M_SZ_FMT")"
+      " allocator ("M_PTR_FMT")", arr, len, unit, alloc);
   if (!arr || !unit) return M_FALSE;
 
   arr->data = NULL;
@@ -85,12 +110,13 @@ m_Array_init(m_Array* const arr,
   arr->unit = unit;
   arr->capacity = 0;
   arr->calc_space_fn = csfn;
+  arr->allocator = alloc;
 
   space_req = csfn ? (*csfn)(arr, len) : len * unit;
   assert(space_req >= len * unit);
   if (space_req)
   {
-    arr->data = M_MALLOC(space_req);
+    arr->data = m_Array_MALLOC(arr, space_req);
     assert(arr->data);
     if (!arr->data) return M_FALSE;
     arr->capacity = space_req;
@@ -110,13 +136,14 @@ m_Array_fini(m_Array* const arr,
   {
     assert(arr->capacity);
     if (fn) m_Array_traverse(arr, fn);
-    M_FREE(arr->data, arr->capacity);
+    m_Array_FREE(arr, arr->data, arr->capacity);
     arr->data = NULL;
   }
   arr->len = 0;
   arr->unit = 0;
   arr->capacity = 0;
   arr->calc_space_fn = NULL;
+  arr->allocator = NULL;
 }
 
 M_BOOL
@@ -130,15 +157,16 @@ _m_Array_set_capacity(m_Array* const arr,
   {
     if (space_req)
     {
-      arr->data = arr->data ? M_REALLOC(arr->data, space_req, arr->capacity)
-          : M_MALLOC(space_req);
+      arr->data = arr->data
+          ? m_Array_REALLOC(arr, arr->data, space_req, arr->capacity)
+          : m_Array_MALLOC(arr, space_req);
       assert(arr->data);
       if (!arr->data) return M_FALSE;
     }
     else
     {
       assert(arr->data);
-      M_FREE(arr->data, arr->capacity);
+      m_Array_FREE(arr, arr->data, arr->capacity);
       arr->data = NULL;
     }
     arr->capacity = space_req;
@@ -420,8 +448,10 @@ m_Array_debug(const m_Array* const arr)
          "--     unit = "M_SZ_FMT"\n"
          "--     capacity = "M_SZ_FMT"\n"
          "--     calc_space_fn = ("M_PTR_FMT")\n"
+         "--     allocator = ("M_PTR_FMT")\n"
          "-- end array debug\n",
-      arr, arr->data, arr->len, arr->unit, arr->capacity, arr->calc_space_fn);
+      arr, arr->data, arr->len, arr->unit, arr->capacity, arr->calc_space_fn,
+      arr->allocator);
 }
 
 #endif /* !NDEBUG */
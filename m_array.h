@@ -63,6 +63,23 @@ typedef M_VOID (*m_array_finalize_fn_t)(M_PTR elem);
  */
 typedef M_VOID (*m_array_copy_fn_t)(M_PTR dest_elem, const M_PTR src_elem);
 
+/**
+ *  \typedef m_Allocator
+ */
+typedef struct _m_Allocator m_Allocator;
+
+/**
+ *  \struct _m_Allocator
+ *  \brief Allocation functions, with the same interface as M_MALLOC,
+ *  M_REALLOC and M_FREE.
+ */
+struct _m_Allocator
+{
+  M_PTR (*malloc_fn)(M_SZ sz);
+  M_PTR (*realloc_fn)(const M_PTR p, M_SZ sz, M_SZ oldsz);
+  M_VOID (*free_fn)(const M_PTR p, M_SZ sz);
+};
+
 /**
  *  \struct _m_Array
  */
@@ -74,8 +91,48 @@ struct _m_Array
   M_SZ capacity; /* size of data buffer (if 0, data is NULL) */
   /* function to get size of data buffer (can be NULL) */
   m_array_calc_space_fn_t calc_space_fn;
+  /* allocation functions for the buffer (NULL for M_MALLOC) */
+  const m_Allocator* allocator;
 };
 
+/**
+ *  \brief Allocate memory for an array buffer.
+ */
+#define m_Array_MALLOC(arr, sz) \
+  ((arr)->allocator ? (*(arr)->allocator->malloc_fn)(sz) : M_MALLOC(sz))
+
+/**
+ *  \brief Reallocate memory of an array buffer.
+ */
+#define m_Array_REALLOC(arr, p, sz, oldsz) \
+  ((arr)->allocator ? (*(arr)->allocator->realloc_fn)((p), (sz), (oldsz)) \
+  : M_REALLOC((p), (sz), (oldsz)))
+
+/**
+ *  \brief Free memory of an array buffer.
+ */
+#define m_Array_FREE(arr, p, sz) \
+  do { \
+    if ((arr)->allocator) (*(arr)->allocator->free_fn)((p), (sz)); \
+    else M_FREE((p), (sz)); \
+  } while (0)
+
+/**
+ *  \brief Make an array of num elements of size sz at p, without copying.
+ *
+ *  The array does not own the buffer, it must not be modified nor
+ *  finalized.
+ */
+#define m_Array_view(arr, p, num, sz) \
+  do { \
+    (arr)->data = (M_PTR) (p); \
+    (arr)->len = (num); \
+    (arr)->unit = (sz); \
+    (arr)->capacity = (num); \
+    (arr)->calc_space_fn = NULL; \
+    (arr)->allocator = NULL; \
+  } while (0)
+
 /**
  *  \brief Allocate for an array.
  *  \param arr The array (by ref, initialized to NULL).
@@ -90,6 +147,23 @@ m_Array_new(m_Array** const arr,
         const M_SZ unit,
         const m_array_calc_space_fn_t calc_space_fn);
 
+/**
+ *  \brief Allocate for an array (extended version).
+ *  \param arr The array (by ref, initialized to NULL).
+ *  \param len Prepare space for a number of elements.
+ *  \param unit Size of one element (not 0).
+ *  \param calc_space_fn Allocation strategy function (or NULL).
+ *  \param allocator Allocation functions for the array and its buffer,
+ *  or NULL for M_MALLOC.
+ *  \return M_TRUE, or M_FALSE on input or memory error.
+ */
+M_DLLAPI M_BOOL
+m_Array_new2(m_Array** const arr,
+        const M_SZ len,
+        const M_SZ unit,
+        const m_array_calc_space_fn_t calc_space_fn,
+        const m_Allocator* const allocator);
+
 /**
  *  \brief Delete an array (and its content).
  *  \param arr The array (by ref, not NULL).
@@ -113,6 +187,23 @@ m_Array_init(m_Array* const arr,
         const M_SZ unit,
         const m_array_calc_space_fn_t calc_space_fn);
 
+/**
+ *  \brief Initialize an array (extended version).
+ *  \param arr The array (not NULL).
+ *  \param len Prepare space for a number of elements.
+ *  \param unit Size of one element (not 0).
+ *  \param calc_space_fn Allocation strategy function (or NULL).
+ *  \param allocator Allocation functions for the buffer, or NULL for
+ *  M_MALLOC.
+ *  \return M_TRUE, or M_FALSE on input or memory error.
+ */
+M_DLLAPI M_BOOL
+m_Array_init2(m_Array* const arr,
+        const M_SZ len,
+        const M_SZ unit,
+        const m_array_calc_space_fn_t calc_space_fn,
+        const m_Allocator* const allocator);
+
 /**
  *  \brief Finalize an array.
  *  \param arr The array (not NULL).
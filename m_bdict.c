@@ -35,6 +35,23 @@ SOFTWARE.
 #define M_TRACE(moo, ...)
 #endif
 
+/*
+ *  Size of an array data, in bytes.
+ */
+#define _m_BDict_keysz(key) ((key)->len * (key)->unit)
+
+/*
+ *  Compare a node key with a key of known length.
+ */
+#define _m_BDictNode_is(nd, k, l) \
+  (m_BDictNode_len(nd) == (l) && !memcmp((nd)->key, (k), (l)))
+
+/*
+ *  Size of the allocation of a node.
+ */
+#define _m_BDictNode_alloc_size(nd) \
+  (m_BDictNode_is_ro(nd) ? sizeof(m_BDictNode) : m_BDictNode_size((nd)->len))
+
 M_BOOL
 m_BDict_new(m_BDict** const d)
 {
@@ -42,17 +59,31 @@ m_BDict_new(m_BDict** const d)
   M_TRACE("new ("M_PTR_FMT")", d);
   if (!d) return M_FALSE;
 
-  return m_BTree_new(d);
+  *d = M_MALLOC(sizeof(m_BDict));
+  assert(*d);
+  if (!*d) return M_FALSE;
+  return m_BDict_init(*d);
 }
 
 M_BOOL
-m_BDict_init(m_BDict* const d)
+m_BDict_init2(m_BDict* const d,
+        const m_hash_fn_t hash_fn,
+        const M_ID seed)
 {
   assert(d);
-  M_TRACE("init ("M_PTR_FMT")", d);
+  M_TRACE("init2 ("M_PTR_FMT")", d);
   if (!d) return M_FALSE;
 
-  return m_BTree_init((m_BTree*)d, M_MALLOC_REF, _m_BTree_node_free_ref);
+  d->finalize_fn = NULL;
+  d->hash_fn = hash_fn ? hash_fn : &M_HASH_DEFAULT;
+  d->seed = seed;
+  return m_BTree_init(&d->tree);
+}
+
+M_BOOL
+m_BDict_init(m_BDict* const d)
+{
+  return m_BDict_init2(d, NULL, 0);
 }
 
 M_VOID
@@ -62,8 +93,13 @@ m_BDict_fini(m_BDict* const d)
   M_TRACE("fini ("M_PTR_FMT")", d);
   if (!d) return;
 
-  m_BTree_traverse((m_BTree*)d, (M_VOID(*)(M_PTR))&m_BDict_node_list_delete);
-  m_BTree_fini((m_BTree*)d);
+  if (d->finalize_fn)
+  {
+    m_BDict_traverse(d, d->finalize_fn);
+    d->finalize_fn = NULL;
+  }
+  m_BTree_traverse(&d->tree, (M_VOID(*)(M_PTR))&m_BDict_node_list_delete);
+  m_BTree_fini(&d->tree);
 }
 
 M_VOID
@@ -81,45 +117,59 @@ m_BDict_delete(m_BDict** const d)
 M_PTR
 m_BDict_get(const m_BDict* const d,
         const m_Array* const key)
+{
+  assert(key && key->data && key->len);
+  if (!key || !key->data || !key->len) return NULL;
+
+  return m_BDict_get_len(d, key->data, _m_BDict_keysz(key));
+}
+
+M_PTR
+m_BDict_get_len(const m_BDict* const d,
+        const M_PTR key,
+        const M_SZ len)
 {
   m_BDictNode* nd;
-  M_ID k;
 
   assert(d);
-  assert(key && key->data);
+  assert(key && len);
   M_TRACE("get ("M_PTR_FMT") key ("M_PTR_FMT")", d, key);
-  if (!d || !key || !key->data) return NULL;
+  if (!d || !key || !len) return NULL;
 
-  k = m_BDict_hash(key->data, key->len);
-  nd = m_BTree_get((m_BTree*)d, k);
+  nd = m_BTree_get(&d->tree, (*d->hash_fn)(key, len, d->seed));
   for (; nd; nd = nd->next)
   {
-    if (nd->key.len == key->len && !memcmp(nd->key.data, key->data, key->len))
-      return nd->val;
+    if (_m_BDictNode_is(nd, key, len)) return nd->val;
   }
   return NULL;
 }
 
-M_BOOL
-m_BDict_set(m_BDict* const d,
-        const m_Array* const key,
+/*
+ *  Set an element, copying or borrowing the key for a new node.
+ */
+static M_BOOL
+_m_BDict_set(m_BDict* const d,
+        const M_PTR key,
+        const M_SZ len,
         const M_PTR const val,
-        M_PTR* const prev)
+        M_PTR* const prev,
+        const M_BOOL ro)
 {
   M_ID k;
   m_BDictNode* nd;
 
-  assert(d);
-  assert(key && key->data);
-  M_TRACE("set ("M_PTR_FMT") key ("M_PTR_FMT") val ("M_PTR_FMT")", d, key, val);
-  if (!d || !key || !key->data) return M_FALSE;
-
-  k = m_BDict_hash(key->data, key->len);
-  nd = m_BTree_get((m_BTree*)d, k);
+  k = (*d->hash_fn)(key, len, d->seed);
+  nd = m_BTree_get(&d->tree, k);
   if (nd == NULL)
   {
-    if (!m_BDict_node_new(&nd, key, val)) return M_FALSE;
-    if (m_BTree_insert((m_BTree*)d, k, nd) != 1) return M_FALSE;
+    if (!(ro ? m_BDict_node_new_ro(&nd, key, len, val)
+        : m_BDict_node_new(&nd, key, len, val)))
+      return M_FALSE;
+    if (m_BTree_insert(&d->tree, k, nd) != 1)
+    {
+      m_BDict_node_delete(&nd);
+      return M_FALSE;
+    }
     if (prev) *prev = (M_PTR) val;
   }
   else
@@ -127,14 +177,15 @@ m_BDict_set(m_BDict* const d,
     m_BDictNode* last = NULL;
     for (; nd; nd = nd->next)
     {
-      if (nd->key.len == key->len && !memcmp(nd->key.data, key->data, key->len))
-        break;
+      if (_m_BDictNode_is(nd, key, len)) break;
       last = nd;
     }
     if (nd == NULL)
     {
       assert(last);
-      if (!m_BDict_node_new(&nd, key, val)) return M_FALSE;
+      if (!(ro ? m_BDict_node_new_ro(&nd, key, len, val)
+          : m_BDict_node_new(&nd, key, len, val)))
+        return M_FALSE;
       last->next = nd;
       if (prev) *prev = (M_PTR) val;
     }
@@ -147,28 +198,80 @@ m_BDict_set(m_BDict* const d,
   return M_TRUE;
 }
 
+M_BOOL
+m_BDict_set(m_BDict* const d,
+        const m_Array* const key,
+        const M_PTR const val,
+        M_PTR* const prev)
+{
+  assert(key && key->data && key->len);
+  if (!key || !key->data || !key->len) return M_FALSE;
+
+  return m_BDict_set_len(d, key->data, _m_BDict_keysz(key), val, prev);
+}
+
+M_BOOL
+m_BDict_set_len(m_BDict* const d,
+        const M_PTR key,
+        const M_SZ len,
+        const M_PTR const val,
+        M_PTR* const prev)
+{
+  assert(d);
+  assert(key && len);
+  M_TRACE("set ("M_PTR_FMT") key ("M_PTR_FMT") val ("M_PTR_FMT")", d, key, val);
+  if (!d || !key || !len) return M_FALSE;
+
+  return _m_BDict_set(d, key, len, val, prev, M_FALSE);
+}
+
+M_BOOL
+m_BDict_set_ro(m_BDict* const d,
+        const M_PTR key,
+        const M_SZ len,
+        const M_PTR const val,
+        M_PTR* const prev)
+{
+  assert(d);
+  assert(key && len);
+  M_TRACE("set_ro ("M_PTR_FMT") key ("M_PTR_FMT") val ("M_PTR_FMT")", d, key, val);
+  if (!d || !key || !len) return M_FALSE;
+
+  return _m_BDict_set(d, key, len, val, prev, M_TRUE);
+}
+
 M_PTR
 m_BDict_unset(m_BDict* const d,
         const m_Array* const key)
+{
+  assert(key && key->data && key->len);
+  if (!key || !key->data || !key->len) return NULL;
+
+  return m_BDict_unset_len(d, key->data, _m_BDict_keysz(key));
+}
+
+M_PTR
+m_BDict_unset_len(m_BDict* const d,
+        const M_PTR key,
+        const M_SZ len)
 {
   m_BDictNode* nd, *first, *prev = NULL;
   M_ID k;
 
   assert(d);
-  assert(key && key->data);
+  assert(key && len);
   M_TRACE("unset ("M_PTR_FMT") key ("M_PTR_FMT")", d, key);
-  if (!d || !key || !key->data) return NULL;
+  if (!d || !key || !len) return NULL;
 
-  k = m_BDict_hash(key->data, key->len);
-  nd = m_BTree_get((m_BTree*)d, k);
+  k = (*d->hash_fn)(key, len, d->seed);
+  nd = m_BTree_get(&d->tree, k);
   if (!nd) return NULL;
-
   if (!nd->next)
   {
-    if (nd->key.len == key->len && !memcmp(nd->key.data, key->data, key->len))
+    if (_m_BDictNode_is(nd, key, len))
     {
       M_PTR val = nd->val;
-      m_BTree_remove((m_BTree*)d, k);
+      m_BTree_remove(&d->tree, k, NULL);
       m_BDict_node_delete(&nd);
       return val;
     }
@@ -177,11 +280,11 @@ m_BDict_unset(m_BDict* const d,
   first = nd;
   for (; nd; nd = nd->next)
   {
-    if (nd->key.len == key->len && !memcmp(nd->key.data, key->data, key->len))
+    if (_m_BDictNode_is(nd, key, len))
     {
       M_PTR val = nd->val;
-      if (nd == first) m_BTree_set((m_BTree*)d, k, nd->next);
-      m_SLList_take(first, nd, prev);
+      if (nd == first) m_BTree_set(&d->tree, k, nd->next, NULL);
+      m_SLList_TAKE(&first, nd, prev);
       m_BDict_node_delete(&nd);
       return val;
     }
@@ -194,36 +297,68 @@ M_VOID
 m_BDict_traverse(m_BDict* const d,
         M_VOID (* const func)(M_PTR))
 {
-  return m_Dict_traverse((m_Dict*)d, func);
+  m_BTNode* nd;
+  m_BDictNode* n;
+
+  assert(d);
+  assert(func);
+  if (!d || !func) return;
+
+  nd = m_BTree_least(&d->tree);
+  for (; nd; nd = m_BTree_next(nd))
+  {
+    n = (m_BDictNode*) nd->val;
+    for (; n; n = n->next)
+    {
+      (*func)(n->val);
+    }
+  }
 }
 
 M_VOID
 m_BDict_traverse2(m_BDict* const d,
-        M_VOID (* const traverse_fn)(M_PTR val, M_PTR udata),
+        M_VOID (* const func)(M_PTR, M_PTR),
         M_PTR const userdata)
 {
-  return m_Dict_traverse2((m_Dict*)d, func, userdata);
+  m_BTNode* nd;
+  m_BDictNode* n;
+
+  assert(d);
+  assert(func);
+  if (!d || !func) return;
+
+  nd = m_BTree_least(&d->tree);
+  for (; nd; nd = m_BTree_next(nd))
+  {
+    n = (m_BDictNode*) nd->val;
+    for (; n; n = n->next)
+    {
+      (*func)(n->val, userdata);
+    }
+  }
 }
 
 M_VOID
 m_BDict_traverse_keyval(m_BDict* const d,
         M_VOID (* const func)(m_Array*, M_PTR))
 {
-  p_BTNode* nd;
+  m_BTNode* nd;
   m_BDictNode* n;
+  m_Array key;
 
   assert(d);
   assert(func);
-  M_TRACE("traverse_keyval ("M_PTR_FMT") func ("M_PTR_FMT")", d, func);
+  M_TRACE("traverse_keyval ("M_PTR_FMT")", d);
   if (!d || !func) return;
 
-  nd = m_BTree_least((m_BTree*)d);
+  nd = m_BTree_least(&d->tree);
   for (; nd; nd = m_BTree_next(nd))
   {
     n = (m_BDictNode*) nd->val;
     for (; n; n = n->next)
     {
-      (*func)(&n->key, n->val);
+      m_Array_view(&key, n->key, m_BDictNode_len(n), 1);
+      (*func)(&key, n->val);
     }
   }
 }
@@ -233,198 +368,93 @@ m_BDict_traverse_keyval2(m_BDict* const d,
         M_VOID (* const func)(m_Array*, M_PTR, M_PTR),
         M_PTR const userdata)
 {
-  p_BTNode* nd;
+  m_BTNode* nd;
   m_BDictNode* n;
+  m_Array key;
 
   assert(d);
   assert(func);
-  M_TRACE("traverse_keyval2 ("M_PTR_FMT") func ("M_PTR_FMT")", d, func);
+  M_TRACE("traverse_keyval2 ("M_PTR_FMT")", d);
   if (!d || !func) return;
 
-  nd = m_BTree_least((m_BTree*)d);
+  nd = m_BTree_least(&d->tree);
   for (; nd; nd = m_BTree_next(nd))
   {
     n = (m_BDictNode*) nd->val;
     for (; n; n = n->next)
     {
-      (*func)(&n->key, n->val, userdata);
+      m_Array_view(&key, n->key, m_BDictNode_len(n), 1);
+      (*func)(&key, n->val, userdata);
     }
   }
 }
 
 M_BOOL
-m_BDict_node_new( m_BDictNode** nd,
-        const m_Array* key,
-        const M_PTR val )
-{
-    assert( nd )
-    *nd = M_MALLOC( sizeof( m_BDictNode ));
-    assert( *nd )
-#ifdef NDEBUG
-    if ( !*nd )
-        return M_FALSE;
-#endif
-    return m_BDict_node_init( *nd, key, val );
-}
-
-M_VOID
-m_BDict_node_delete( m_BDictNode** nd )
-{
-    assert( *nd )
-    m_BDict_node_fini( *nd );
-    M_FREE( *nd, sizeof( m_BDictNode ));
-    *nd = NULL;
-}
-
-M_VOID
-m_BDict_node_list_delete( m_BDictNode* nd )
+m_BDict_node_new(m_BDictNode** const nd,
+        const M_PTR key,
+        const M_SZ len,
+        const M_PTR const val)
 {
-    m_BDictNode* next;
-    assert( nd )
-    while ( nd )
-    {
-        next = nd->next;
-        m_BDict_node_delete( &nd );
-        nd = next;
-    }
+  assert(nd);
+  assert(key && len);
+  if (!nd || !key || !len) return M_FALSE;
+
+  *nd = M_MALLOC(m_BDictNode_size(len));
+  assert(*nd);
+  if (!*nd) return M_FALSE;
+
+  (*nd)->next = NULL;
+  (*nd)->val = (M_PTR) val;
+  (*nd)->key = (*nd)->data;
+  (*nd)->len = len;
+  memcpy((*nd)->data, key, len);
+  return M_TRUE;
 }
 
 M_BOOL
-m_BDict_node_init( m_BDictNode* nd,
-        const m_Array* key,
-        const M_PTR val )
+m_BDict_node_new_ro(m_BDictNode** const nd,
+        const M_PTR key,
+        const M_SZ len,
+        const M_PTR const val)
 {
-    assert( nd )
-    nd->next = NULL;
-    if ( !p_vector_init( &nd->key, key->len, key->unit, key->calc_space_fn ))
-        return M_FALSE;
-    if ( key->len )
-        memcpy( nd->key.data, key->data, key->len );
-    nd->key.len = key->len;
-    nd->val = (M_PTR) val;
-    return M_TRUE;
+  assert(nd);
+  assert(key && len && !(len & M_BDICTNODE_RO));
+  if (!nd || !key || !len) return M_FALSE;
+
+  *nd = M_MALLOC(sizeof(m_BDictNode));
+  assert(*nd);
+  if (!*nd) return M_FALSE;
+
+  (*nd)->next = NULL;
+  (*nd)->val = (M_PTR) val;
+  (*nd)->key = (const M_UCHAR*) key;
+  (*nd)->len = len | M_BDICTNODE_RO;
+  return M_TRUE;
 }
 
 M_VOID
-m_BDict_node_fini( m_BDictNode* nd )
+m_BDict_node_delete(m_BDictNode** const nd)
 {
-    assert( nd )
-    nd->next = NULL;
-    p_vector_fini( &nd->key );
-    nd->val = NULL;
-}
+  assert(nd && *nd);
+  if (!nd || !*nd) return;
 
-#if 0
-M_BOOL
-m_BDict_node_ro_new( m_BDictNode** nd,
-        const M_PTR data,
-        const M_SZ len,
-        const M_PTR val )
-{
-    assert( nd )
-    *nd = M_MALLOC( sizeof( m_BDictNode ));
-    assert( *nd )
-#ifdef NDEBUG
-    if ( !*nd )
-        return M_FALSE;
-#endif
-    return m_BDict_node_ro_init( *nd, data, len, val );
+  M_FREE(*nd, _m_BDictNode_alloc_size(*nd));
+  *nd = NULL;
 }
 
 M_VOID
-m_BDict_node_ro_delete( m_BDictNode** nd )
+m_BDict_node_list_delete(m_BDictNode* nd)
 {
-    assert( *nd )
-    m_BDict_node_ro_fini( *nd );
-    M_FREE( *nd, sizeof( m_BDictNode ));
-    *nd = NULL;
-}
+  m_BDictNode* next;
 
-M_VOID
-m_BDict_node_ro_list_delete( m_BDictNode* nd,
-        M_PTR userdata )
-{
-    m_BDictNode* next;
-    assert( nd )
-    while ( nd )
-    {
-        next = nd->next;
-        m_BDict_node_ro_delete( &nd );
-        nd = next;
-    }
-    M_UNUSED( userdata );
-}
+  assert(nd);
+  if (!nd) return;
 
-M_BOOL
-m_BDict_node_ro_init( m_BDictNode* nd,
-        const M_PTR data,
-        const M_SZ len,
-        const M_PTR val )
-{
-    assert( nd )
-    assert( data )
-    nd->next = NULL;
-    nd->key.data = (M_PTR) data;
-    nd->key.len = (M_SZ) len;
-    nd->key.unit = 1;
-    nd->key.capacity = 0;
-    nd->key.calc_space_fn = NULL;
-    nd->val = (M_PTR) val;
-    return M_TRUE;
-}
-
-M_BOOL
-m_BDict_ro_set( m_BDict* d,
-        const M_PTR data,
-        const M_SZ len,
-        const M_PTR val,
-        M_PTR* old )
-{
-    M_ID k;
-    m_BDictNode* nd;
-    assert( d )
-
-    if ( data == NULL || len == 0 )
-        return M_TRUE;
-    k = m_BDict_hash( data, len );
-    nd = m_BTree_get( (m_BTree*)d, k );
-    if ( nd == NULL )
-    {
-        if ( !m_BDict_node_ro_new( &nd, data, len, val ))
-            return M_FALSE;
-        if ( m_BTree_insert( (m_BTree*)d, k, nd ) != 1 )
-            return M_FALSE;
-        if ( old )
-            *old = (M_PTR) val;
-    }
-    else
-    {
-        m_BDictNode* last = NULL;
-        for ( ; nd; nd = nd->next )
-        {
-            if ( nd->key.len == len
-                && !memcmp( nd->key.data, data, len ))
-                break;
-            last = nd;
-        }
-        if ( nd == NULL )
-        {
-            assert( last )
-            if ( !m_BDict_node_ro_new( &nd, data, len, val ))
-                return M_FALSE;
-            last->next = nd;
-            if ( old )
-                *old = (M_PTR) val;
-        }
-        else
-        {
-            if ( old )
-                *old = nd->val;
-            nd->val = (M_PTR) val;
-        }
-    }
-    return M_TRUE;
+  for (; nd; nd = next)
+  {
+    next = nd->next;
+    m_BDict_node_delete(&nd);
+  }
 }
-#endif
 
-/* vi: set fenc=utf-8 ff=unix et sw=4 ts=4 sts=4 : */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -42,6 +42,7 @@ extern "C" {
 #include "m_btree.h"
 #include "m_dict.h"
 #include "m_h.h"
+#include "m_hash.h"
 #include "m_mempool.h"
 
 /**
@@ -51,18 +52,62 @@ typedef struct _m_BDictNode m_BDictNode;
 
 /**
  *  \struct _m_BDictNode
+ *
+ *  The key is either copied in the same allocation as the node (then key
+ *  points to data), or borrowed from the caller (then data is unused and
+ *  M_BDICTNODE_RO is set in len).
  */
 struct _m_BDictNode
 {
   m_BDictNode* next;
-  m_Array key;
   M_PTR val;
+  const M_UCHAR* key; /* key bytes */
+  M_SZ len; /* length of key, in bytes, with flag M_BDICTNODE_RO */
+  M_UCHAR data[];
 };
 
+/**
+ *  \brief Nodes with copied keys are allocated by multiples of this size.
+ */
+#define M_BDICTNODE_QUANTA  16
+
+/**
+ *  \brief Size of a node, for a key length.
+ */
+#define m_BDictNode_size(len) \
+  ((offsetof(m_BDictNode, data) + (len) + M_BDICTNODE_QUANTA - 1) \
+  / M_BDICTNODE_QUANTA * M_BDICTNODE_QUANTA)
+
+/**
+ *  \brief Flag set in the len of a node that borrows its key.
+ */
+#define M_BDICTNODE_RO  ((M_SZ)1 << (sizeof(M_SZ) * 8 - 1))
+
+/**
+ *  \brief Test if a node borrows its key.
+ */
+#define m_BDictNode_is_ro(nd)  ((nd)->len & M_BDICTNODE_RO)
+
+/**
+ *  \brief Length of a node key, in bytes.
+ */
+#define m_BDictNode_len(nd)  ((nd)->len & ~M_BDICTNODE_RO)
+
 /**
  *  \typedef m_BDict
  */
-typedef m_BTree m_BDict;
+typedef struct _m_BDict m_BDict;
+
+/**
+ *  \struct _m_BDict
+ */
+struct _m_BDict
+{
+  m_BTree tree;
+  M_VOID (*finalize_fn)(M_PTR);
+  m_hash_fn_t hash_fn;
+  M_ID seed;
+};
 
 /**
  *  \brief Allocate for a vdict.
@@ -70,8 +115,23 @@ typedef m_BTree m_BDict;
 M_DLLAPI M_BOOL
 m_BDict_new(m_BDict** const d);
 
+/**
+ *  \brief Initialize a bdict (extended version).
+ *  \param d The bdict.
+ *  \param hash_fn Hash function for keys, or NULL for M_HASH_DEFAULT.
+ *  \param seed Seed given to hash_fn.
+ *  \return M_TRUE, or M_FALSE on error.
+ *  \see m_hash_seed
+ */
+M_DLLAPI M_BOOL
+m_BDict_init2(m_BDict* const d,
+        const m_hash_fn_t hash_fn,
+        const M_ID seed);
+
 /**
  *  \brief Initialize a vdict.
+ *
+ *  Keys are hashed with M_HASH_DEFAULT, seed 0.
  */
 M_DLLAPI M_BOOL
 m_BDict_init(m_BDict* const d);
@@ -86,15 +146,14 @@ m_BDict_fini(m_BDict* const d);
  *  \brief Delete a vdict.
  */
 M_DLLAPI M_VOID
-m_BDict_delete( m_BDict** d );
-
-/**
- *  \brief Hash function.
- */
-#define m_BDict_hash m_Dict_hash
+m_BDict_delete(m_BDict** const d);
 
 /**
  *  \brief Get an element from the bdict.
+ *
+ *  Keys are compared as bytes: an array key stands for its len * unit
+ *  bytes of data.
+ *
  *  \param d The bdict.
  *  \param key The key array (not NULL nor empty).
  *  \return Element found, or NULL if nothing found (or key is invalid).
@@ -103,6 +162,18 @@ M_DLLAPI M_PTR
 m_BDict_get(const m_BDict* const d,
         const m_Array* const key);
 
+/**
+ *  \brief Get an element from the bdict.
+ *  \param d The bdict.
+ *  \param key The key bytes (not NULL).
+ *  \param len Length of key (not 0).
+ *  \return Element found, or NULL if nothing found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_BDict_get_len(const m_BDict* const d,
+        const M_PTR key,
+        const M_SZ len);
+
 /**
  *  \brief Set or insert an element in the bdict.
  *  \param d The vdict.
@@ -118,6 +189,46 @@ m_BDict_set(m_BDict* const d,
         const M_PTR const val,
         M_PTR* const prev);
 
+/**
+ *  \brief Set or insert an element in the bdict, with a copy of the key.
+ *  \param d The bdict.
+ *  \param key The key bytes (not NULL).
+ *  \param len Length of key (not 0).
+ *  \param val The element.
+ *  \param prev The pointer value if a new element was inserted,
+ *  or the pointer that was replaced (can be NULL).
+ *  \return M_TRUE, or M_FALSE on error (or key is invalid).
+ */
+M_DLLAPI M_BOOL
+m_BDict_set_len(m_BDict* const d,
+        const M_PTR key,
+        const M_SZ len,
+        const M_PTR const val,
+        M_PTR* const prev);
+
+/**
+ *  \brief Set or insert an element in the bdict, borrowing the key.
+ *
+ *  A new node references the key bytes instead of copying them: they
+ *  must stay valid and unchanged until the element is removed or the
+ *  bdict finalized. If the key is already present, only its value is
+ *  replaced and the node keeps its key.
+ *
+ *  \param d The bdict.
+ *  \param key The key bytes (not NULL).
+ *  \param len Length of key (not 0).
+ *  \param val The element.
+ *  \param prev The pointer value if a new element was inserted,
+ *  or the pointer that was replaced (can be NULL).
+ *  \return M_TRUE, or M_FALSE on error (or key is invalid).
+ */
+M_DLLAPI M_BOOL
+m_BDict_set_ro(m_BDict* const d,
+        const M_PTR key,
+        const M_SZ len,
+        const M_PTR const val,
+        M_PTR* const prev);
+
 /**
  *  \brief Remove an element from the bdict.
  *  \param d The bdict.
@@ -128,6 +239,18 @@ M_DLLAPI M_PTR
 m_BDict_unset(m_BDict* const d,
         const m_Array* const key);
 
+/**
+ *  \brief Remove an element from the bdict.
+ *  \param d The bdict.
+ *  \param key The key bytes (not NULL).
+ *  \param len Length of key (not 0).
+ *  \return Element that was removed, or NULL if not found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_BDict_unset_len(m_BDict* const d,
+        const M_PTR key,
+        const M_SZ len);
+
 /**
  *  \brief Apply a function to each value in the vdict.
  *  \param d The vdict.
@@ -150,6 +273,10 @@ m_BDict_traverse2(m_BDict* const d,
 
 /**
  *  \brief Apply a function to each key and value in the bdict.
+ *
+ *  Keys are given as views of the node keys, with a unit of 1 byte.
+ *  They must not be modified nor finalized.
+ *
  *  \param d The bdict.
  *  \param traverse_fn The function to apply.
  */
@@ -169,95 +296,36 @@ m_BDict_traverse_keyval2(m_BDict* const d,
         M_PTR const userdata);
 
 /**
- *  \brief Allocate for a vdict node.
+ *  \brief Allocate for a bdict node, with a copy of key.
  *  \return M_TRUE, or M_FALSE on error.
  */
 M_DLLAPI M_BOOL
-m_BDict_node_new( m_BDictNode** nd,
-        const m_Array* key,
-        const M_PTR val );
-
-/**
- *  \brief Deallocate a vdict node.
- */
-M_DLLAPI M_VOID
-m_BDict_node_delete( m_BDictNode** nd );
-
-/**
- *  \brief Deallocate a list of vdict nodes.
- */
-M_DLLAPI M_VOID
-m_BDict_node_list_delete( m_BDictNode* nd );
+m_BDict_node_new(m_BDictNode** const nd,
+        const M_PTR key,
+        const M_SZ len,
+        const M_PTR const val);
 
 /**
- *  \brief Initialize a vdict node.
+ *  \brief Allocate for a bdict node, borrowing key.
  *  \return M_TRUE, or M_FALSE on error.
  */
 M_DLLAPI M_BOOL
-m_BDict_node_init( m_BDictNode* nd,
-        const m_Array* key,
-        const M_PTR val );
-
-/**
- *  \brief Finalize a vdict node.
- */
-M_DLLAPI M_VOID
-m_BDict_node_fini( m_BDictNode* nd );
-
-#if 0
-/**
- *  \brief Allocate a vdict node with read-only data.
- */
-M_DLLAPI M_BOOL
-m_BDict_node_ro_new( m_BDictNode** nd,
-        const M_PTR data,
+m_BDict_node_new_ro(m_BDictNode** const nd,
+        const M_PTR key,
         const M_SZ len,
-        const M_PTR val );
+        const M_PTR const val);
 
 /**
- *  \brief Deallocate a vdict node with read-only data.
+ *  \brief Deallocate a bdict node.
  */
 M_DLLAPI M_VOID
-m_BDict_node_ro_delete( m_BDictNode** nd );
+m_BDict_node_delete(m_BDictNode** const nd);
 
 /**
- *  \brief Deallocate a list of vdict nodes with read-only data.
+ *  \brief Deallocate a list of bdict nodes.
  */
 M_DLLAPI M_VOID
-m_BDict_node_ro_list_delete( m_BDictNode* nd,
-        M_PTR userdata );
-
-/**
- *  \brief Initialize a vdict node with read-only data.
- */
-M_DLLAPI M_BOOL
-m_BDict_node_ro_init( m_BDictNode* nd,
-        const M_PTR data,
-        const M_SZ len,
-        const M_PTR val );
-
-/**
- *  \brief Finalize a vdict node with read-only data.
- */
-M_DLLAPI M_VOID
-m_BDict_node_ro_fini( m_BDictNode* nd );
-
-/**
- *  \brief Set an element in a vdict with read-only data.
- *  \param data The key array (will not be duplicated).
- *  \param len Size of data.
- *  \param val The element value.
- *  \param old The pointer value if a new element was inserted,
- *  or the pointer that was replaced (can be NULL).
- *  \return M_TRUE, or M_FALSE on error.
- */
-M_DLLAPI M_BOOL
-m_BDict_ro_set( m_BDict* d,
-        const M_PTR data,
-        const M_SZ len,
-        const M_PTR val,
-        M_PTR* old );
-#endif
+m_BDict_node_list_delete(m_BDictNode* nd);
 
 #ifndef NDEBUG
 #if 0
@@ -0,0 +1,744 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+#include "m_bptree.h"
+
+#include "m_mempool.h"
+
+#undef M_TRACE
+#if defined(M_TRACE_MODE) && defined(M_TRACE_BPTREE)
+#define M_TRACE(msg, ...) _M_TRACER("-- BPTree -- "msg, __VA_ARGS__)
+#else
+#define M_TRACE(moo, ...)
+#endif
+
+/* minimum number of keys in a node (except root) */
+#define M_BPTREE_MIN (M_BPTREE_ORDER / 2)
+
+M_BOOL
+m_BPTree_new(m_BPTree** const bt)
+{
+  assert(bt && !*bt);
+  M_TRACE("new ("M_PTR_FMT")", bt);
+  if (!bt) return M_FALSE;
+
+  *bt = M_MALLOC(sizeof(m_BPTree));
+  assert(*bt);
+  if (!*bt) return M_FALSE;
+  return m_BPTree_init(*bt);
+}
+
+M_VOID
+m_BPTree_delete(m_BPTree** const bt)
+{
+  assert(bt && *bt);
+  M_TRACE("delete ("M_PTR_FMT")", *bt);
+  if (!bt || !*bt) return;
+
+  m_BPTree_fini(*bt);
+  M_FREE(*bt, sizeof(m_BPTree));
+  *bt = NULL;
+}
+
+M_BOOL
+m_BPTree_init2(m_BPTree* const bt,
+        M_PTR (* const mallocdoer)(M_SZ),
+        M_VOID (* const freedoer)(M_PTR))
+{
+  assert(bt);
+  M_TRACE("init2 ("M_PTR_FMT")", bt);
+  if (!bt) return M_FALSE;
+
+  bt->root = NULL;
+  bt->num = 0;
+  bt->mallocdoer = mallocdoer ? mallocdoer : &malloc;
+  bt->freedoer = freedoer ? freedoer : &free;
+  bt->finalize_fn = NULL;
+  return M_TRUE;
+}
+
+M_BOOL
+m_BPTree_init(m_BPTree* const bt)
+{
+  assert(bt);
+  M_TRACE("init ("M_PTR_FMT")", bt);
+  if (!bt) return M_FALSE;
+
+  return m_BPTree_init2(bt, M_MALLOC_REF, _m_BPTNode_free_ref);
+}
+
+M_VOID
+_m_BPTNode_delete_all(m_BPTNode* const nd,
+        M_VOID (* const freedoer)(M_PTR))
+{
+  M_UINT32 i;
+
+  if (!nd->leaf)
+  {
+    for (i = 0; i <= nd->num; ++i)
+      _m_BPTNode_delete_all(nd->u.kids[i], freedoer);
+  }
+  (*freedoer)(nd);
+}
+
+M_VOID
+m_BPTree_fini(m_BPTree* const bt)
+{
+  assert(bt);
+  M_TRACE("fini ("M_PTR_FMT")", bt);
+  if (!bt) return;
+
+  if (bt->root)
+  {
+    if (bt->finalize_fn) m_BPTree_traverse(bt, bt->finalize_fn);
+    _m_BPTNode_delete_all(bt->root, bt->freedoer);
+    bt->root = NULL;
+  }
+  bt->num = 0;
+  bt->mallocdoer = NULL;
+  bt->freedoer = NULL;
+  bt->finalize_fn = NULL;
+}
+
+#ifndef M_NO_MEMPOOL
+M_VOID
+_m_BPTNode_free(M_PTR p)
+{
+  M_TRACE("Node -- free ("M_PTR_FMT")", p);
+  M_FREE(p, sizeof(m_BPTNode));
+}
+#endif
+
+/*
+ *  Index of the child to descend into.
+ */
+M_UINT32
+_m_BPTNode_child(const m_BPTNode* const nd,
+        const M_ID key)
+{
+  M_UINT32 i, n = 0;
+
+  /* counting instead of breaking lets the compiler unroll this */
+  for (i = 0; i < nd->num; ++i)
+    n += key >= nd->keys[i];
+  return n;
+}
+
+/*
+ *  Index of the first key not less than key.
+ */
+M_UINT32
+_m_BPTNode_lower(const m_BPTNode* const nd,
+        const M_ID key)
+{
+  M_UINT32 i, n = 0;
+
+  for (i = 0; i < nd->num; ++i)
+    n += nd->keys[i] < key;
+  return n;
+}
+
+/*
+ *  Request all cache lines of a node at once, so that their misses overlap
+ *  instead of being paid one after the other while scanning.
+ */
+#define _m_BPTNode_prefetch(nd) \
+  do { \
+    const M_CHAR* _p = (const M_CHAR*)(nd); \
+    M_SZ _i = 0; \
+    for (; _i < sizeof(m_BPTNode); _i += M_CACHELINE) M_PREFETCH(_p + _i); \
+  } while (0)
+
+m_BPTNode*
+_m_BPTree_leaf(const m_BPTree* const bt,
+        const M_ID key)
+{
+  const m_BPTNode* nd = bt->root;
+
+  if (!nd) return NULL;
+  while (!nd->leaf)
+  {
+    nd = nd->u.kids[_m_BPTNode_child(nd, key)];
+    _m_BPTNode_prefetch(nd);
+  }
+  return (m_BPTNode*) nd;
+}
+
+M_VOID
+_m_BPTNode_leaf_insert(m_BPTNode* const nd,
+        const M_UINT32 i,
+        const M_ID key,
+        const M_PTR val)
+{
+  assert(nd->num < M_BPTREE_ORDER);
+  memmove(&nd->keys[i+1], &nd->keys[i], (nd->num - i) * sizeof(M_ID));
+  memmove(&nd->u.vals[i+1], &nd->u.vals[i], (nd->num - i) * sizeof(M_PTR));
+  nd->keys[i] = key;
+  nd->u.vals[i] = (M_PTR) val;
+  nd->num += 1;
+}
+
+/*
+ *  Split a full leaf in two, inserting the new element on the way.
+ */
+M_VOID
+_m_BPTNode_leaf_split(m_BPTNode* const nd,
+        m_BPTNode* const sib,
+        const M_UINT32 i,
+        const M_ID key,
+        const M_PTR val)
+{
+  M_ID keys[M_BPTREE_ORDER + 1];
+  M_PTR vals[M_BPTREE_ORDER + 1];
+  const M_UINT32 left = (M_BPTREE_ORDER + 1) / 2;
+  const M_UINT32 right = M_BPTREE_ORDER + 1 - left;
+
+  assert(nd->num == M_BPTREE_ORDER);
+  memcpy(keys, nd->keys, i * sizeof(M_ID));
+  memcpy(vals, nd->u.vals, i * sizeof(M_PTR));
+  keys[i] = key;
+  vals[i] = (M_PTR) val;
+  memcpy(&keys[i+1], &nd->keys[i], (M_BPTREE_ORDER - i) * sizeof(M_ID));
+  memcpy(&vals[i+1], &nd->u.vals[i], (M_BPTREE_ORDER - i) * sizeof(M_PTR));
+
+  memcpy(nd->keys, keys, left * sizeof(M_ID));
+  memcpy(nd->u.vals, vals, left * sizeof(M_PTR));
+  nd->num = left;
+  memcpy(sib->keys, &keys[left], right * sizeof(M_ID));
+  memcpy(sib->u.vals, &vals[left], right * sizeof(M_PTR));
+  sib->num = right;
+  sib->leaf = 1;
+  sib->next = nd->next;
+  nd->next = sib;
+}
+
+M_VOID
+_m_BPTNode_inner_insert(m_BPTNode* const nd,
+        const M_UINT32 i,
+        const M_ID key,
+        m_BPTNode* const kid)
+{
+  assert(nd->num < M_BPTREE_ORDER);
+  memmove(&nd->keys[i+1], &nd->keys[i], (nd->num - i) * sizeof(M_ID));
+  memmove(&nd->u.kids[i+2], &nd->u.kids[i+1],
+      (nd->num - i) * sizeof(m_BPTNode*));
+  nd->keys[i] = key;
+  nd->u.kids[i+1] = kid;
+  nd->num += 1;
+}
+
+/*
+ *  Split a full inner node in two, inserting the new child on the way.
+ *  Returns the key moving up.
+ */
+M_ID
+_m_BPTNode_inner_split(m_BPTNode* const nd,
+        m_BPTNode* const sib,
+        const M_UINT32 i,
+        const M_ID key,
+        m_BPTNode* const kid)
+{
+  M_ID keys[M_BPTREE_ORDER + 1];
+  m_BPTNode* kids[M_BPTREE_ORDER + 2];
+  const M_UINT32 mid = (M_BPTREE_ORDER + 1) / 2;
+
+  assert(nd->num == M_BPTREE_ORDER);
+  memcpy(keys, nd->keys, i * sizeof(M_ID));
+  keys[i] = key;
+  memcpy(&keys[i+1], &nd->keys[i], (M_BPTREE_ORDER - i) * sizeof(M_ID));
+  memcpy(kids, nd->u.kids, (i + 1) * sizeof(m_BPTNode*));
+  kids[i+1] = kid;
+  memcpy(&kids[i+2], &nd->u.kids[i+1],
+      (M_BPTREE_ORDER - i) * sizeof(m_BPTNode*));
+
+  memcpy(nd->keys, keys, mid * sizeof(M_ID));
+  memcpy(nd->u.kids, kids, (mid + 1) * sizeof(m_BPTNode*));
+  nd->num = mid;
+  memcpy(sib->keys, &keys[mid+1], (M_BPTREE_ORDER - mid) * sizeof(M_ID));
+  memcpy(sib->u.kids, &kids[mid+1],
+      (M_BPTREE_ORDER - mid + 1) * sizeof(m_BPTNode*));
+  sib->num = M_BPTREE_ORDER - mid;
+  sib->leaf = 0;
+  sib->next = NULL;
+  return keys[mid];
+}
+
+/*
+ *  Remove key i and child i+1 from an inner node.
+ */
+M_VOID
+_m_BPTNode_inner_remove(m_BPTNode* const nd,
+        const M_UINT32 i)
+{
+  memmove(&nd->keys[i], &nd->keys[i+1], (nd->num - i - 1) * sizeof(M_ID));
+  memmove(&nd->u.kids[i+1], &nd->u.kids[i+2],
+      (nd->num - i - 1) * sizeof(m_BPTNode*));
+  nd->num -= 1;
+}
+
+M_INT8
+m_BPTree_insert(m_BPTree* const bt,
+        const M_ID key,
+        const M_PTR val)
+{
+  m_BPTNode* path[M_BPTREE_MAXDEPTH];
+  M_UINT32 slot[M_BPTREE_MAXDEPTH];
+  m_BPTNode* spare[M_BPTREE_MAXDEPTH + 1];
+  m_BPTNode* nd, *sib;
+  M_INT32 depth = 0, need, d;
+  M_UINT32 i;
+  M_ID up;
+
+  assert(bt);
+  M_TRACE("insert ("M_PTR_FMT") key ("M_ID_FMT") val ("M_PTR_FMT")",
+      bt, key, val);
+  if (!bt) return -1;
+
+  if (!bt->root)
+  {
+    nd = (*bt->mallocdoer)(sizeof(m_BPTNode));
+    assert(nd);
+    if (!nd) return -1;
+    nd->keys[0] = key;
+    nd->u.vals[0] = (M_PTR) val;
+    nd->num = 1;
+    nd->leaf = 1;
+    nd->next = NULL;
+    bt->root = nd;
+    bt->num = 1;
+    return 1;
+  }
+
+  nd = bt->root;
+  while (!nd->leaf)
+  {
+    assert(depth < M_BPTREE_MAXDEPTH);
+    i = _m_BPTNode_child(nd, key);
+    path[depth] = nd;
+    slot[depth++] = i;
+    nd = nd->u.kids[i];
+    _m_BPTNode_prefetch(nd);
+  }
+  i = _m_BPTNode_lower(nd, key);
+  if (i < nd->num && nd->keys[i] == key)
+  {
+    M_TRACE("insert ("M_PTR_FMT") duplicate key ("M_ID_FMT")", bt, key);
+    return 0;
+  }
+  if (nd->num < M_BPTREE_ORDER)
+  {
+    _m_BPTNode_leaf_insert(nd, i, key, val);
+    bt->num += 1;
+    return 1;
+  }
+
+  /* get all the nodes needed before touching anything */
+  need = 1;
+  for (d = depth - 1; d >= 0 && path[d]->num == M_BPTREE_ORDER; --d)
+    ++need;
+  if (d < 0) ++need; /* new root */
+  for (d = 0; d < need; ++d)
+  {
+    spare[d] = (*bt->mallocdoer)(sizeof(m_BPTNode));
+    assert(spare[d]);
+    if (!spare[d])
+    {
+      while (d--) (*bt->freedoer)(spare[d]);
+      return -1;
+    }
+  }
+
+  M_TRACE("insert ("M_PTR_FMT") splitting leaf", bt);
+  sib = spare[--need];
+  _m_BPTNode_leaf_split(nd, sib, i, key, val);
+  up = sib->keys[0];
+
+  while (depth > 0)
+  {
+    nd = path[--depth];
+    i = slot[depth];
+    if (nd->num < M_BPTREE_ORDER)
+    {
+      _m_BPTNode_inner_insert(nd, i, up, sib);
+      assert(need == 0);
+      bt->num += 1;
+      return 1;
+    }
+    up = _m_BPTNode_inner_split(nd, spare[--need], i, up, sib);
+    sib = spare[need];
+  }
+
+  /* grow a new root */
+  assert(need == 1);
+  nd = spare[0];
+  nd->keys[0] = up;
+  nd->u.kids[0] = bt->root;
+  nd->u.kids[1] = sib;
+  nd->num = 1;
+  nd->leaf = 0;
+  nd->next = NULL;
+  bt->root = nd;
+  bt->num += 1;
+  return 1;
+}
+
+M_VOID
+m_BPTree_remove(m_BPTree* const bt,
+        const M_ID key,
+        M_VOID (* const fn)(M_PTR))
+{
+  m_BPTNode* path[M_BPTREE_MAXDEPTH];
+  M_UINT32 slot[M_BPTREE_MAXDEPTH];
+  m_BPTNode* nd, *p, *left, *right;
+  M_INT32 depth = 0;
+  M_UINT32 i;
+
+  assert(bt);
+  M_TRACE("remove ("M_PTR_FMT") key ("M_ID_FMT")", bt, key);
+  if (!bt || !bt->root) return;
+
+  nd = bt->root;
+  while (!nd->leaf)
+  {
+    assert(depth < M_BPTREE_MAXDEPTH);
+    i = _m_BPTNode_child(nd, key);
+    path[depth] = nd;
+    slot[depth++] = i;
+    nd = nd->u.kids[i];
+    _m_BPTNode_prefetch(nd);
+  }
+  i = _m_BPTNode_lower(nd, key);
+  if (i >= nd->num || nd->keys[i] != key)
+  {
+    M_TRACE("remove key ("M_ID_FMT") not found", key);
+    return;
+  }
+  if (fn) (*fn)(nd->u.vals[i]);
+  memmove(&nd->keys[i], &nd->keys[i+1], (nd->num - i - 1) * sizeof(M_ID));
+  memmove(&nd->u.vals[i], &nd->u.vals[i+1], (nd->num - i - 1) * sizeof(M_PTR));
+  nd->num -= 1;
+  bt->num -= 1;
+
+  /* rebalance */
+  while (depth > 0 && nd->num < M_BPTREE_MIN)
+  {
+    p = path[--depth];
+    i = slot[depth];
+    left = i > 0 ? p->u.kids[i-1] : NULL;
+    right = i < p->num ? p->u.kids[i+1] : NULL;
+
+    if (nd->leaf)
+    {
+      if (left && left->num > M_BPTREE_MIN)
+      { /* borrow from left */
+        memmove(&nd->keys[1], nd->keys, nd->num * sizeof(M_ID));
+        memmove(&nd->u.vals[1], nd->u.vals, nd->num * sizeof(M_PTR));
+        nd->keys[0] = left->keys[left->num - 1];
+        nd->u.vals[0] = left->u.vals[left->num - 1];
+        left->num -= 1;
+        nd->num += 1;
+        p->keys[i-1] = nd->keys[0];
+        return;
+      }
+      if (right && right->num > M_BPTREE_MIN)
+      { /* borrow from right */
+        nd->keys[nd->num] = right->keys[0];
+        nd->u.vals[nd->num] = right->u.vals[0];
+        nd->num += 1;
+        right->num -= 1;
+        memmove(right->keys, &right->keys[1], right->num * sizeof(M_ID));
+        memmove(right->u.vals, &right->u.vals[1], right->num * sizeof(M_PTR));
+        p->keys[i] = right->keys[0];
+        return;
+      }
+      if (left)
+      { /* merge into left */
+        memcpy(&left->keys[left->num], nd->keys, nd->num * sizeof(M_ID));
+        memcpy(&left->u.vals[left->num], nd->u.vals, nd->num * sizeof(M_PTR));
+        left->num += nd->num;
+        left->next = nd->next;
+        (*bt->freedoer)(nd);
+        _m_BPTNode_inner_remove(p, i - 1);
+      }
+      else
+      { /* merge right into this */
+        assert(right);
+        memcpy(&nd->keys[nd->num], right->keys, right->num * sizeof(M_ID));
+        memcpy(&nd->u.vals[nd->num], right->u.vals,
+            right->num * sizeof(M_PTR));
+        nd->num += right->num;
+        nd->next = right->next;
+        (*bt->freedoer)(right);
+        _m_BPTNode_inner_remove(p, i);
+      }
+    }
+    else /* inner node */
+    {
+      if (left && left->num > M_BPTREE_MIN)
+      { /* rotate from left */
+        memmove(&nd->keys[1], nd->keys, nd->num * sizeof(M_ID));
+        memmove(&nd->u.kids[1], nd->u.kids,
+            (nd->num + 1) * sizeof(m_BPTNode*));
+        nd->keys[0] = p->keys[i-1];
+        nd->u.kids[0] = left->u.kids[left->num];
+        p->keys[i-1] = left->keys[left->num - 1];
+        left->num -= 1;
+        nd->num += 1;
+        return;
+      }
+      if (right && right->num > M_BPTREE_MIN)
+      { /* rotate from right */
+        nd->keys[nd->num] = p->keys[i];
+        nd->u.kids[nd->num + 1] = right->u.kids[0];
+        nd->num += 1;
+        p->keys[i] = right->keys[0];
+        right->num -= 1;
+        memmove(right->keys, &right->keys[1], right->num * sizeof(M_ID));
+        memmove(right->u.kids, &right->u.kids[1],
+            (right->num + 1) * sizeof(m_BPTNode*));
+        return;
+      }
+      if (left)
+      { /* merge into left */
+        left->keys[left->num] = p->keys[i-1];
+        memcpy(&left->keys[left->num + 1], nd->keys, nd->num * sizeof(M_ID));
+        memcpy(&left->u.kids[left->num + 1], nd->u.kids,
+            (nd->num + 1) * sizeof(m_BPTNode*));
+        left->num += nd->num + 1;
+        (*bt->freedoer)(nd);
+        _m_BPTNode_inner_remove(p, i - 1);
+      }
+      else
+      { /* merge right into this */
+        assert(right);
+        nd->keys[nd->num] = p->keys[i];
+        memcpy(&nd->keys[nd->num + 1], right->keys,
+            right->num * sizeof(M_ID));
+        memcpy(&nd->u.kids[nd->num + 1], right->u.kids,
+            (right->num + 1) * sizeof(m_BPTNode*));
+        nd->num += right->num + 1;
+        (*bt->freedoer)(right);
+        _m_BPTNode_inner_remove(p, i);
+      }
+    }
+    nd = p;
+  }
+
+  /* shrink root */
+  nd = bt->root;
+  if (nd->num == 0)
+  {
+    bt->root = nd->leaf ? NULL : nd->u.kids[0];
+    (*bt->freedoer)(nd);
+  }
+}
+
+M_PTR
+m_BPTree_get(const m_BPTree* const bt,
+        const M_ID key)
+{
+  const m_BPTNode* nd;
+  M_UINT32 i;
+
+  assert(bt);
+  if (!bt || !(nd = _m_BPTree_leaf(bt, key))) return NULL;
+
+  i = _m_BPTNode_lower(nd, key);
+  return i < nd->num && nd->keys[i] == key ? nd->u.vals[i] : NULL;
+}
+
+M_BOOL
+m_BPTree_set(m_BPTree* const bt,
+        const M_ID key,
+        const M_PTR val,
+        M_PTR* const prev)
+{
+  m_BPTNode* nd;
+  M_UINT32 i;
+
+  assert(bt);
+  if (!bt || !(nd = _m_BPTree_leaf(bt, key))) return M_FALSE;
+
+  i = _m_BPTNode_lower(nd, key);
+  if (i >= nd->num || nd->keys[i] != key) return M_FALSE;
+  if (prev) *prev = nd->u.vals[i];
+  nd->u.vals[i] = (M_PTR) val;
+  return M_TRUE;
+}
+
+M_VOID
+m_BPTree_traverse(m_BPTree* const bt,
+        M_VOID (* const func)(M_PTR))
+{
+  m_BPTNode* nd;
+  M_UINT32 i;
+
+  assert(bt);
+  assert(func);
+  if (!bt || !func) return;
+
+  for (nd = m_BPTree_least(bt); nd; nd = nd->next)
+  {
+    for (i = 0; i < nd->num; ++i)
+      (*func)(nd->u.vals[i]);
+  }
+}
+
+M_VOID
+m_BPTree_traverse2(m_BPTree* const bt,
+        M_VOID (* const func)(M_PTR, M_PTR),
+        M_PTR userdata)
+{
+  m_BPTNode* nd;
+  M_UINT32 i;
+
+  assert(bt);
+  assert(func);
+  if (!bt || !func) return;
+
+  for (nd = m_BPTree_least(bt); nd; nd = nd->next)
+  {
+    for (i = 0; i < nd->num; ++i)
+      (*func)(nd->u.vals[i], userdata);
+  }
+}
+
+m_BPTNode*
+m_BPTree_least(const m_BPTree* const bt)
+{
+  const m_BPTNode* nd;
+
+  assert(bt);
+  if (!bt || !(nd = bt->root)) return NULL;
+
+  while (!nd->leaf) nd = nd->u.kids[0];
+  return (m_BPTNode*) nd;
+}
+
+m_BPTNode*
+m_BPTree_most(const m_BPTree* const bt)
+{
+  const m_BPTNode* nd;
+
+  assert(bt);
+  if (!bt || !(nd = bt->root)) return NULL;
+
+  while (!nd->leaf) nd = nd->u.kids[nd->num];
+  return (m_BPTNode*) nd;
+}
+
+#ifndef NDEBUG
+
+M_SZ
+_m_BPTNode_check(const m_BPTNode* const nd,
+        const M_BOOL is_root,
+        const M_ID* const lo,
+        const M_ID* const hi,
+        const M_INT32 depth,
+        M_INT32* const leafdepth)
+{
+  M_SZ cnt = 0;
+  M_UINT32 i;
+
+  if (!is_root && nd->num < M_BPTREE_MIN)
+  {
+    printf("-- BPTree -- node ("M_PTR_FMT") underflow\n", (M_PTR)nd);
+    return (M_SZ)-1;
+  }
+  for (i = 0; i < nd->num; ++i)
+  {
+    if ((i && nd->keys[i-1] >= nd->keys[i])
+        || (lo && nd->keys[i] < *lo)
+        || (hi && nd->keys[i] >= *hi))
+    {
+      printf("-- BPTree -- node ("M_PTR_FMT") unordered\n", (M_PTR)nd);
+      return (M_SZ)-1;
+    }
+  }
+  if (nd->leaf)
+  {
+    if (*leafdepth < 0) *leafdepth = depth;
+    if (*leafdepth != depth)
+    {
+      printf("-- BPTree -- leaf ("M_PTR_FMT") at wrong depth\n", (M_PTR)nd);
+      return (M_SZ)-1;
+    }
+    return nd->num;
+  }
+  for (i = 0; i <= nd->num; ++i)
+  {
+    const M_SZ n = _m_BPTNode_check(nd->u.kids[i], M_FALSE,
+        i ? &nd->keys[i-1] : lo,
+        i < nd->num ? &nd->keys[i] : hi,
+        depth + 1, leafdepth);
+    if (n == (M_SZ)-1) return n;
+    cnt += n;
+  }
+  return cnt;
+}
+
+M_BOOL
+m_BPTree_check(const m_BPTree* const bt)
+{
+  const m_BPTNode* nd;
+  M_INT32 leafdepth = -1;
+  M_SZ cnt = 0;
+
+  assert(bt);
+  if (!bt->root) return bt->num == 0;
+
+  if (_m_BPTNode_check(bt->root, M_TRUE, NULL, NULL, 0, &leafdepth) != bt->num)
+    return M_FALSE;
+  for (nd = m_BPTree_least(bt); nd; nd = nd->next)
+  {
+    if (nd->next && nd->keys[nd->num - 1] >= nd->next->keys[0]) return M_FALSE;
+    cnt += nd->num;
+  }
+  return cnt == bt->num;
+}
+
+M_VOID
+m_BPTree_debug(const m_BPTree* const bt)
+{
+  const m_BPTNode* nd;
+  M_UINT32 i;
+
+  assert(bt);
+  printf("-- BPTree -- debug ("M_PTR_FMT"):\n"
+         "--     Count = "M_SZ_FMT"\n", (M_PTR)bt, bt->num);
+  for (nd = m_BPTree_least(bt); nd; nd = nd->next)
+  {
+    printf("--     Leaf ("M_PTR_FMT"):", (M_PTR)nd);
+    for (i = 0; i < nd->num; ++i)
+      printf(" "M_ID_FMT, nd->keys[i]);
+    printf("\n");
+  }
+  printf("-- end bptree debug\n");
+  fflush(stdout);
+}
+
+#endif /* !NDEBUG */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
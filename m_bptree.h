@@ -0,0 +1,297 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+/**
+ *  \file m_bptree.h
+ *  \brief B+tree, with wide nodes.
+ *  \author Stanislas Marquis <stan@astrorigin.com>
+ */
+
+/*
+ *  Same contract as m_BTree (M_ID keys, M_PTR values, malloc'doer and
+ *  free'doer), but keys are kept in sorted arrays of M_BPTREE_ORDER
+ *  elements per node, so that a lookup only touches a few cache lines
+ *  per level, and there are only a few levels.
+ *
+ *  Values are stored in the leaves, which are chained together for
+ *  in-order traversals.
+ */
+
+#ifndef M_BPTREE_H
+#define M_BPTREE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "m_h.h"
+
+#ifndef M_BPTREE_ORDER
+/**
+ *  \brief Maximum number of keys in one node.
+ *
+ *  Default is 32 keys, that is 4 cache lines of keys on 64-bit systems,
+ *  which are prefetched together when descending into a node.
+ */
+#define M_BPTREE_ORDER  32
+#elif M_BPTREE_ORDER < 4 || M_BPTREE_ORDER % 2
+#error "Invalid M_BPTREE_ORDER"
+#endif
+
+/**
+ *  \brief Maximum depth of a tree.
+ */
+#define M_BPTREE_MAXDEPTH  32
+
+/**
+ *  \typedef m_BPTNode
+ */
+typedef struct _m_BPTNode m_BPTNode;
+
+/**
+ *  \struct _m_BPTNode
+ *  \brief B+tree node (leaf or inner node).
+ *
+ *  In inner nodes, kids[i] holds keys lesser than keys[i],
+ *  and kids[i+1] holds keys greater or equal.
+ */
+struct _m_BPTNode
+{
+  M_UINT32 num; /* number of keys */
+  M_UINT32 leaf; /* leaf or inner node */
+  m_BPTNode* next; /* next leaf (or NULL) */
+  M_ID keys[M_BPTREE_ORDER];
+  union
+  {
+    M_PTR vals[M_BPTREE_ORDER]; /* leaf values */
+    m_BPTNode* kids[M_BPTREE_ORDER + 1]; /* inner node children */
+  } u;
+};
+
+/**
+ *  \typedef m_BPTree
+ */
+typedef struct _m_BPTree m_BPTree;
+
+/**
+ *  \struct _m_BPTree
+ *  \brief B+tree.
+ */
+struct _m_BPTree
+{
+  m_BPTNode* root;
+  M_SZ num; /* number of elements */
+  M_PTR (*mallocdoer)(M_SZ);
+  M_VOID (*freedoer)(M_PTR);
+  M_VOID (*finalize_fn)(M_PTR);
+};
+
+#ifndef M_NO_MEMPOOL
+/*
+ *  Our mempool'freedoer needs size of allocated memory.
+ */
+M_DLLAPI M_VOID
+_m_BPTNode_free(M_PTR p);
+
+#define _m_BPTNode_free_ref &_m_BPTNode_free
+#else
+#define _m_BPTNode_free(p) _M_FREE(p)
+#define _m_BPTNode_free_ref ((M_VOID(*)(M_PTR)) _M_FREE_REF)
+#endif /* !M_NO_MEMPOOL */
+
+/**
+ *  \brief Allocate for a new B+tree.
+ *  \param bt The tree.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_BPTree_new(m_BPTree** const bt);
+
+/**
+ *  \brief Initialize a B+tree (extended version).
+ *  \param bt The tree.
+ *  \param mallocdoer Allocation function for nodes, or NULL to use malloc.
+ *  \param freedoer Deallocation function for nodes, or NULL to use free.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_BPTree_init2(m_BPTree* const bt,
+        M_PTR (* const mallocdoer)(M_SZ),
+        M_VOID (* const freedoer)(M_PTR));
+
+/**
+ *  \brief Initialize a B+tree.
+ *  \param bt The tree.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_BPTree_init(m_BPTree* const bt);
+
+/**
+ *  \brief Finalize a B+tree.
+ *  \param bt The tree.
+ *
+ *  If not NULL, bt->finalize_fn is executed on the values.
+ */
+M_DLLAPI M_VOID
+m_BPTree_fini(m_BPTree* const bt);
+
+/**
+ *  \brief Deallocate a B+tree.
+ *  \param bt The tree.
+ *
+ *  If not NULL, bt->finalize_fn is executed on the values.
+ */
+M_DLLAPI M_VOID
+m_BPTree_delete(m_BPTree** const bt);
+
+/**
+ *  \brief Insert a new element in the tree.
+ *  \param bt The tree.
+ *  \param key The key.
+ *  \param val The value.
+ *  \return 1 on success, 0 if the key is duplicate, -1 on error.
+ */
+M_DLLAPI M_INT8
+m_BPTree_insert(m_BPTree* const bt,
+        const M_ID key,
+        const M_PTR val);
+
+/**
+ *  \brief Remove an element from the tree.
+ *  \param bt The tree.
+ *  \param key The key.
+ *  \param fn If not null, execute function on value of element found.
+ */
+M_DLLAPI M_VOID
+m_BPTree_remove(m_BPTree* const bt,
+        const M_ID key,
+        M_VOID (* const fn)(M_PTR));
+
+/**
+ *  \brief Get a value from the tree.
+ *  \param bt The tree.
+ *  \param key The key.
+ *  \return The value or NULL.
+ */
+M_DLLAPI M_PTR
+m_BPTree_get(const m_BPTree* const bt,
+        const M_ID key);
+
+/**
+ *  \brief Set the value for a given key in the tree.
+ *  \param bt The tree.
+ *  \param key The key.
+ *  \param val The value.
+ *  \param prev If not NULL, return value replaced.
+ *  \return M_TRUE if the key was found and value changed.
+ */
+M_DLLAPI M_BOOL
+m_BPTree_set(m_BPTree* const bt,
+        const M_ID key,
+        const M_PTR val,
+        M_PTR* const prev);
+
+/**
+ *  \brief Count the elements inside a tree.
+ *  \param bt The tree.
+ *  \return The count.
+ */
+#define m_BPTree_count( bt ) \
+        ((bt)->num)
+
+/**
+ *  \brief Traverse a tree and apply function to the values (in order).
+ *  \param bt The tree.
+ *  \param func The function to apply.
+ */
+M_DLLAPI M_VOID
+m_BPTree_traverse(m_BPTree* const bt,
+        M_VOID (* const func)(M_PTR));
+
+/**
+ *  \brief Traverse a tree and apply function to the values (userdata version).
+ *  \param bt The tree.
+ *  \param func The function to apply.
+ *  \param userdata Pointer passed to function.
+ */
+M_DLLAPI M_VOID
+m_BPTree_traverse2(m_BPTree* const bt,
+        M_VOID (* const func)(M_PTR, M_PTR),
+        M_PTR userdata);
+
+/**
+ *  \brief Get the leftmost leaf.
+ *  \param bt The tree.
+ *  \return The leaf, or NULL if tree is empty.
+ */
+M_DLLAPI m_BPTNode*
+m_BPTree_least(const m_BPTree* const bt);
+
+/**
+ *  \brief Get the rightmost leaf.
+ *  \param bt The tree.
+ *  \return The leaf, or NULL if tree is empty.
+ */
+M_DLLAPI m_BPTNode*
+m_BPTree_most(const m_BPTree* const bt);
+
+/**
+ *  \brief Get the lowest key in a (non-empty) tree.
+ */
+#define m_BPTree_min( bt ) \
+        (m_BPTree_least( bt )->keys[0])
+
+/**
+ *  \brief Get the highest key in a (non-empty) tree.
+ */
+#define m_BPTree_max( bt ) \
+        (m_BPTree_most( bt )->keys[m_BPTree_most( bt )->num - 1])
+
+#ifndef NDEBUG
+
+/**
+ *  \brief Check the tree structure (ordering, fill, depth).
+ *  \param bt The tree.
+ *  \return M_TRUE if the tree is valid.
+ */
+M_DLLAPI M_BOOL
+m_BPTree_check(const m_BPTree* const bt);
+
+/**
+ *  \brief Print debug to stdout.
+ *  \param bt The tree.
+ */
+M_DLLAPI M_VOID
+m_BPTree_debug(const m_BPTree* const bt);
+
+#endif /* !NDEBUG */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !M_BPTREE_H */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -26,6 +26,7 @@ SOFTWARE.
 
 #include "m_btree.h"
 
+#include "m_memcnt.h"
 #include "m_mempool.h"
 
 #undef M_TRACE
@@ -40,6 +41,123 @@ SOFTWARE.
 #define right_child(x) (x)->more
 #define BalanceFactor(x) (x)->bfactor
 
+#ifdef M_BTREE_RANK
+#define SIZE(x) ((x) ? (x)->size : 0)
+#define RESIZE(x) (x)->size = SIZE((x)->less) + SIZE((x)->more) + 1
+
+/*
+ *  Recompute subtree sizes, from a node up to the root.
+ */
+static M_VOID
+_m_BTNode_resize_up(m_BTNode* nd)
+{
+  for (; nd; nd = nd->parent)
+    RESIZE(nd);
+}
+#else
+#define RESIZE(x)
+#endif
+
+static M_VOID
+_m_BTNode_delete_all(m_BTNode** const bt,
+        M_VOID (* const freedoer)(M_PTR),
+        const m_BTNode* const slab,
+        const M_SZ slabnum);
+
+struct _m_BTPage
+{
+  m_BTPage* next;
+  M_SZ num; /* number of nodes */
+  M_SZ used; /* number of nodes handed out */
+  m_BTNode nodes[];
+};
+
+/* first page size, in nodes */
+#define M_BTREE_PAGEMIN 8
+
+/*
+ *  Add a page of num nodes to a tree.
+ */
+static m_BTPage*
+_m_BTree_new_page(m_BTree* const bt,
+        const M_SZ num)
+{
+  m_BTPage* pg;
+
+  M_TRACE("new page ("M_PTR_FMT") num ("M_SZ_FMT")", bt, num);
+  pg = _M_MALLOC(sizeof(m_BTPage) + num * sizeof(m_BTNode));
+  assert(pg);
+  if (!pg) return NULL;
+  pg->num = num;
+  pg->used = 0;
+  pg->next = bt->pages;
+  bt->pages = pg;
+  return pg;
+}
+
+/*
+ *  Release all pages of a tree.
+ */
+static M_VOID
+_m_BTree_free_pages(m_BTree* const bt)
+{
+  m_BTPage* pg, *nxt;
+
+  for (pg = bt->pages; pg; pg = nxt)
+  {
+    nxt = pg->next;
+    _M_FREE(pg);
+  }
+  bt->pages = NULL;
+  bt->freenodes = NULL;
+}
+
+/*
+ *  Get a node, from the tree pages, or from mallocdoer if it has one.
+ */
+static m_BTNode*
+_m_BTree_alloc(m_BTree* const bt)
+{
+  m_BTNode* nd;
+  m_BTPage* pg;
+
+  if (bt->mallocdoer) return (*bt->mallocdoer)(sizeof(m_BTNode));
+
+  if ((nd = bt->freenodes))
+  {
+    bt->freenodes = nd->parent;
+    return nd;
+  }
+  pg = bt->pages;
+  if (!pg || pg->used == pg->num)
+  {
+    /* pages grow with the tree */
+    M_SZ num = M_MAX(bt->num, (M_SZ) M_BTREE_PAGEMIN);
+    pg = _m_BTree_new_page(bt, M_MIN(num, (M_SZ) M_BTREE_PAGENODES));
+    if (!pg) return NULL;
+  }
+  return &pg->nodes[pg->used++];
+}
+
+/*
+ *  Give back a node, to the tree or to its freedoer.
+ */
+static M_VOID
+_m_BTree_free(m_BTree* const bt,
+        m_BTNode* const nd)
+{
+  const m_BTPage* const pg = bt->pages;
+
+  if (!bt->freedoer)
+  {
+    nd->parent = bt->freenodes;
+    bt->freenodes = nd;
+  }
+  /* with a freedoer, the only page is from m_BTree_build_sorted */
+  else if (!pg || nd < pg->nodes || nd >= pg->nodes + pg->num)
+    (*bt->freedoer)(nd);
+}
+
 M_BOOL
 m_BTree_new(m_BTree** const bt)
 {
@@ -50,7 +168,7 @@ m_BTree_new(m_BTree** const bt)
   *bt = M_MALLOC(sizeof(m_BTree));
   assert(*bt);
   if (!*bt) return M_FALSE;
-  return m_BTree_init2(*bt, M_MALLOC_REF, _m_BTNode_free_ref);
+  return m_BTree_init(*bt);
 }
 
 M_VOID
@@ -74,9 +192,13 @@ m_BTree_init2(m_BTree* const bt,
   M_TRACE("init2 ("M_PTR_FMT")", bt);
   if (!bt) return M_FALSE;
 
+  assert(!mallocdoer == !freedoer);
   bt->root = NULL;
-  bt->mallocdoer = mallocdoer ? mallocdoer : &malloc;
-  bt->freedoer = freedoer ? freedoer : &free;
+  bt->num = 0;
+  bt->pages = NULL;
+  bt->freenodes = NULL;
+  bt->mallocdoer = mallocdoer;
+  bt->freedoer = freedoer;
   bt->finalize_fn = NULL;
   return M_TRUE;
 }
@@ -88,7 +210,7 @@ m_BTree_init(m_BTree* const bt)
   M_TRACE("init ("M_PTR_FMT")", bt);
   if (!bt) return M_FALSE;
 
-  return m_BTree_init2(bt, M_MALLOC_REF, _m_BTNode_free_ref);
+  return m_BTree_init2(bt, NULL, NULL);
 }
 
 M_VOID
@@ -99,12 +221,39 @@ m_BTree_fini(m_BTree* const bt)
   if (!bt) return;
 
   if (bt->finalize_fn) m_BTree_traverse(bt, bt->finalize_fn);
-  m_BTNode_delete_all(&bt->root, bt->freedoer);
+  if (bt->freedoer)
+  {
+    _m_BTNode_delete_all(&bt->root, bt->freedoer,
+        bt->pages ? bt->pages->nodes : NULL, bt->pages ? bt->pages->num : 0);
+  }
+  bt->root = NULL;
+  bt->num = 0;
+  _m_BTree_free_pages(bt);
   bt->mallocdoer = NULL;
   bt->freedoer = NULL;
   bt->finalize_fn = NULL;
 }
 
+/*
+ *  Fill a new node.
+ */
+static M_VOID
+_m_BTNode_init(m_BTNode* const nd,
+        const M_ID key,
+        const M_PTR val,
+        const m_BTNode* const parent)
+{
+  nd->key = key;
+  nd->val = (M_PTR) val;
+  nd->parent = (m_BTNode*) parent;
+  nd->less = NULL;
+  nd->more = NULL;
+  nd->bfactor = 0;
+#ifdef M_BTREE_RANK
+  nd->size = 1;
+#endif
+}
+
 M_BOOL
 m_BTNode_new(m_BTNode** const bt,
         const M_ID key,
@@ -121,34 +270,54 @@ m_BTNode_new(m_BTNode** const bt,
   assert(*bt);
   if (!*bt) return M_FALSE;
 
-  (*bt)->key = key;
-  (*bt)->val = (M_PTR) val;
-  (*bt)->parent = (m_BTNode*) parent;
-  (*bt)->less = NULL;
-  (*bt)->more = NULL;
-  (*bt)->bfactor = 0;
+  _m_BTNode_init(*bt, key, val, parent);
   return M_TRUE;
 }
 
-M_VOID
-m_BTNode_delete_all(m_BTNode** const bt,
-        M_VOID (* const freedoer)(M_PTR))
+/*
+ *  Delete all nodes, except those in the slab given (if any).
+ */
+static M_VOID
+_m_BTNode_delete_all(m_BTNode** const bt,
+        M_VOID (* const freedoer)(M_PTR),
+        const m_BTNode* const slab,
+        const M_SZ slabnum)
 {
-  m_BTNode* nd, *next;
+  m_BTNode* nd, *parent;
 
   assert(bt);
   M_TRACE("delete_all ("M_PTR_FMT")", *bt);
   if (!*bt) return; /* Dont assert that */
 
-  next = m_BTNode_least(*bt);
-  while (next)
+  /* children first, parents are needed to climb back */
+  nd = *bt;
+  while (nd)
   {
-    nd = next;
-    next = m_BTNode_next(nd);
-    m_BTNode_delete(&nd, freedoer);
+    if (nd->less) nd = nd->less;
+    else if (nd->more) nd = nd->more;
+    else
+    {
+      parent = nd == *bt ? NULL : nd->parent;
+      if (parent)
+      {
+        if (parent->less == nd) parent->less = NULL;
+        else parent->more = NULL;
+      }
+      if (!parent) *bt = NULL;
+      if (nd < slab || nd >= slab + slabnum)
+        m_BTNode_delete(&nd, freedoer);
+      nd = parent;
+    }
   }
 }
 
+M_VOID
+m_BTNode_delete_all(m_BTNode** const bt,
+        M_VOID (* const freedoer)(M_PTR))
+{
+  _m_BTNode_delete_all(bt, freedoer, NULL, 0);
+}
+
 M_VOID
 m_BTNode_delete(m_BTNode** const bt,
         M_VOID (* const freedoer)(M_PTR))
@@ -193,6 +362,8 @@ m_BTNode_rotate_Left(m_BTNode* const X,
     BalanceFactor(X) = 0;
     BalanceFactor(Z) = 0;
   }
+  RESIZE(X);
+  RESIZE(Z);
   return Z; // return new root of rotated subtree
 }
 
@@ -219,6 +390,8 @@ m_BTNode_rotate_Right(m_BTNode* const X,
     BalanceFactor(X) = 0;
     BalanceFactor(Z) = 0;
   }
+  RESIZE(X);
+  RESIZE(Z);
   return Z; // return new root of rotated subtree
 }
 
@@ -260,6 +433,9 @@ m_BTNode_rotate_RightLeft(m_BTNode* const X,
     BalanceFactor(Z) = 1;  // t4 now higher
   }
   BalanceFactor(Y) = 0;
+  RESIZE(X);
+  RESIZE(Z);
+  RESIZE(Y);
   return Y; // return new root of rotated subtree
 }
 
@@ -301,6 +477,9 @@ m_BTNode_rotate_LeftRight(m_BTNode* const X,
     BalanceFactor(Z) = 0;  // t4 now higher
   }
   BalanceFactor(Y) = 0;
+  RESIZE(X);
+  RESIZE(Z);
+  RESIZE(Y);
   return Y; // return new root of rotated subtree
 }
 
@@ -376,11 +555,88 @@ m_BTNode_inserted(m_BTNode* Z)
   }
 }
 
-M_INT8
-m_BTNode_insert(m_BTNode** bt,
+/*
+ *  Height of a tree of sz nodes, built by splitting in the middle.
+ */
+static M_INT32
+_m_BTNode_height(M_SZ sz)
+{
+  M_INT32 h = 0;
+
+  for (; sz; sz >>= 1)
+    ++h;
+  return h;
+}
+
+/*
+ *  Link the nodes of slab[0..sz) into a subtree, middle node as root.
+ */
+static m_BTNode*
+_m_BTNode_build(m_BTNode* const slab,
+        const M_SZ sz,
+        m_BTNode* const parent)
+{
+  const M_SZ mid = sz / 2;
+  m_BTNode* const nd = &slab[mid];
+
+  nd->parent = parent;
+  nd->less = mid ? _m_BTNode_build(slab, mid, nd) : NULL;
+  nd->more = sz > mid + 1 ? _m_BTNode_build(nd + 1, sz - (mid + 1), nd) : NULL;
+  nd->bfactor = _m_BTNode_height(sz - (mid + 1)) - _m_BTNode_height(mid);
+#ifdef M_BTREE_RANK
+  nd->size = sz;
+#endif
+  return nd;
+}
+
+M_BOOL
+m_BTree_build_sorted(m_BTree* const bt,
+        const M_ID* const keys,
+        M_PTR const* const vals,
+        const M_SZ num)
+{
+  m_BTPage* pg;
+  M_SZ i;
+
+  assert(bt);
+  assert(!bt->root);
+  assert(keys || !num);
+  M_TRACE("build_sorted ("M_PTR_FMT") num ("M_SZ_FMT")", bt, num);
+  if (!bt || bt->root || (!keys && num)) return M_FALSE;
+
+  for (i = 1; i < num; ++i)
+  {
+    if (keys[i - 1] >= keys[i]) return M_FALSE;
+  }
+  /* the tree is empty, no page is in use */
+  _m_BTree_free_pages(bt);
+  if (!num) return M_TRUE;
+
+  /* never given to the freedoer, if any, it goes only at once */
+  pg = _m_BTree_new_page(bt, num);
+  if (!pg) return M_FALSE;
+  pg->used = num;
+
+  for (i = 0; i < num; ++i)
+  {
+    pg->nodes[i].key = keys[i];
+    pg->nodes[i].val = vals ? vals[i] : NULL;
+  }
+  bt->root = _m_BTNode_build(pg->nodes, num, NULL);
+  bt->num = num;
+  return M_TRUE;
+}
+
+/*
+ *  Insert from a node, with a new node from mallocdoer, or from the pages
+ *  of tree if not NULL.
+ */
+static M_INT8
+_m_BTNode_insert(m_BTNode** bt,
         const M_ID key,
         const M_PTR val,
-        M_PTR (* const mallocdoer)(M_SZ))
+        M_PTR (* const mallocdoer)(M_SZ),
+        m_BTree* const tree)
 {
   m_BTNode* parent = NULL;
 
@@ -393,9 +649,15 @@ m_BTNode_insert(m_BTNode** bt,
   {
     if (!*bt)
     {
-      if (!m_BTNode_new(bt, key, val, parent, mallocdoer))
-        return -1;
-      if (parent)
+      *bt = tree ? _m_BTree_alloc(tree) : (*mallocdoer)(sizeof(m_BTNode));
+      assert(*bt);
+      if (!*bt) return -1;
+      _m_BTNode_init(*bt, key, val, parent);
+#ifdef M_BTREE_RANK
+      for (; parent; parent = parent->parent)
+        parent->size += 1;
+#endif
+      if ((*bt)->parent)
         m_BTNode_inserted(*bt);
       return 1;
     }
@@ -421,6 +683,15 @@ m_BTNode_insert(m_BTNode** bt,
   /* not reached */
 }
 
+M_INT8
+m_BTNode_insert(m_BTNode** bt,
+        const M_ID key,
+        const M_PTR val,
+        M_PTR (* const mallocdoer)(M_SZ))
+{
+  return _m_BTNode_insert(bt, key, val, mallocdoer, NULL);
+}
+
 M_INT8
 m_BTree_insert(m_BTree* const bt,
         const M_ID key,
@@ -433,11 +704,14 @@ m_BTree_insert(m_BTree* const bt,
       bt, key, val);
   if (!bt) return -1;
 
-  i = m_BTNode_insert(&bt->root, key, val, bt->mallocdoer);
+  i = _m_BTNode_insert(&bt->root, key, val, NULL, bt);
   switch (i)
   {
   case -1: return -1;
-  case 1: bt->root = m_BTNode_root(bt->root);
+  case 1:
+    bt->num += 1;
+    bt->root = m_BTNode_root(bt->root);
+    /* fall through */
   default: return i;
   }
 }
@@ -599,17 +873,22 @@ m_BTNode_replace(m_BTNode* const bt,
   }
 }
 
-m_BTNode*
-m_BTNode_remove(m_BTNode* bt,
-        M_ID key,
-        M_VOID (* const freedoer)(M_PTR),
-        M_VOID (* const fn)(M_PTR))
+/*
+ *  Unlink the node holding key, returned in removed (or NULL if the key
+ *  is not found), and return the resulting root node.
+ */
+static m_BTNode*
+_m_BTNode_remove(m_BTNode* bt,
+        const M_ID key,
+        M_VOID (* const fn)(M_PTR),
+        m_BTNode** const removed)
 {
   m_BTNode* root, *parent;
   m_BTNode* subtree = NULL;
   m_BTNode* nd = NULL;
   M_INT8 from_child = 0;
 
+  *removed = NULL;
   assert(bt);
   assert(!bt->parent);
   M_TRACE("Node -- remove ("M_PTR_FMT") key ("M_ID_FMT")", bt, key);
@@ -724,24 +1003,102 @@ m_BTNode_remove(m_BTNode* bt,
   /* adjust subtree */
   if (root)
   {
+#ifdef M_BTREE_RANK
+    /* sizes first, from where retracing starts, rotations keep them */
+    _m_BTNode_resize_up(subtree ? subtree->parent : parent ? parent : root);
+#endif
     m_BTNode_removed(subtree, parent ? parent : root, from_child);
     root = m_BTNode_root(root != bt ? root : bt->less ? bt->less : bt->more);
   }
-  m_BTNode_delete(&bt, freedoer);
+  *removed = bt;
   return root;
 }
 
+m_BTNode*
+m_BTNode_remove(m_BTNode* bt,
+        M_ID key,
+        M_VOID (* const freedoer)(M_PTR),
+        M_VOID (* const fn)(M_PTR))
+{
+  m_BTNode* nd;
+
+  bt = _m_BTNode_remove(bt, key, fn, &nd);
+  if (nd) m_BTNode_delete(&nd, freedoer);
+  return bt;
+}
+
 M_VOID
 m_BTree_remove(m_BTree* const bt,
         const M_ID key,
         M_VOID (* const fn)(M_PTR))
 {
+  m_BTNode* nd;
+
   assert(bt);
   M_TRACE("remove ("M_PTR_FMT") key ("M_ID_FMT")", bt, key);
-  if (!bt) return;
-  bt->root = m_BTNode_remove(bt->root, key, bt->freedoer, fn);
+  if (!bt || !bt->root) return;
+
+  bt->root = _m_BTNode_remove(bt->root, key, fn, &nd);
+  if (!nd) return;
+  bt->num -= 1;
+  _m_BTree_free(bt, nd);
+}
+
+#ifdef M_BTREE_RANK
+
+M_SZ
+m_BTree_rank(const m_BTree* const bt,
+        const M_ID key)
+{
+  const m_BTNode* nd;
+  M_SZ rank = 0;
+
+  assert(bt);
+  if (!bt) return 0;
+
+  for (nd = bt->root; nd; )
+  {
+    if (key <= nd->key)
+    {
+      if (key == nd->key) return rank + SIZE(nd->less);
+      nd = nd->less;
+    }
+    else
+    {
+      rank += SIZE(nd->less) + 1;
+      nd = nd->more;
+    }
+  }
+  return rank;
 }
 
+m_BTNode*
+m_BTree_select(const m_BTree* const bt,
+        M_SZ i)
+{
+  const m_BTNode* nd;
+  M_SZ n;
+
+  assert(bt);
+  if (!bt) return NULL;
+
+  for (nd = bt->root; nd; )
+  {
+    n = SIZE(nd->less);
+    if (i == n) return (m_BTNode*) nd;
+    if (i < n)
+      nd = nd->less;
+    else
+    {
+      i -= n + 1;
+      nd = nd->more;
+    }
+  }
+  return NULL;
+}
+
+#endif /* M_BTREE_RANK */
+
 m_BTNode*
 m_BTNode_get_node(const m_BTNode* bt,
         const M_ID key)
@@ -766,6 +1123,56 @@ m_BTNode_get(const m_BTNode* bt,
   }
 }
 
+M_VOID
+m_BTree_get_many(const m_BTree* const bt,
+        const M_ID* const keys,
+        M_PTR* const vals,
+        const M_SZ num)
+{
+  const m_BTNode* nd[M_BTREE_GROUP];
+  const m_BTNode* p;
+  M_SZ i, j, n, left;
+
+  assert(bt);
+  assert(keys || !num);
+  assert(vals || !num);
+  M_TRACE("get many ("M_PTR_FMT") num ("M_SZ_FMT")", bt, num);
+  if (!bt || !keys || !vals) return;
+
+  for (i = 0; i < num; i += n)
+  {
+    n = M_MIN(num - i, (M_SZ) M_BTREE_GROUP);
+    for (j = 0; j < n; ++j)
+    {
+      nd[j] = bt->root;
+      vals[i + j] = NULL;
+    }
+    /* one level per key and round, each node asked for a round early */
+    for (left = n; left; )
+    {
+      left = 0;
+      for (j = 0; j < n; ++j)
+      {
+        p = nd[j];
+        if (!p) continue;
+        if (keys[i + j] == p->key)
+        {
+          vals[i + j] = p->val;
+          nd[j] = NULL;
+          continue;
+        }
+        p = keys[i + j] < p->key ? p->less : p->more;
+        if (p)
+        {
+          M_PREFETCH(p);
+          left += 1;
+        }
+        nd[j] = p;
+      }
+    }
+  }
+}
+
 M_BOOL
 m_BTNode_set(m_BTNode* const bt,
         const M_ID key,
@@ -869,6 +1276,157 @@ m_BTNode_prev(const m_BTNode* bt)
   return bt->parent;
 }
 
+M_BOOL
+m_BTreeIter_begin(m_BTreeIter* const it,
+        const m_BTree* const bt)
+{
+  m_BTNode* nd;
+
+  assert(it && bt);
+  M_TRACE("Iter -- begin ("M_PTR_FMT")", bt);
+
+  it->depth = 0;
+  for (nd = bt->root; nd; nd = nd->less)
+    it->path[it->depth++] = nd;
+  return it->depth != 0;
+}
+
+M_BOOL
+m_BTreeIter_last(m_BTreeIter* const it,
+        const m_BTree* const bt)
+{
+  m_BTNode* nd;
+
+  assert(it && bt);
+  M_TRACE("Iter -- last ("M_PTR_FMT")", bt);
+
+  it->depth = 0;
+  for (nd = bt->root; nd; nd = nd->more)
+    it->path[it->depth++] = nd;
+  return it->depth != 0;
+}
+
+M_BOOL
+m_BTreeIter_seek(m_BTreeIter* const it,
+        const m_BTree* const bt,
+        const M_ID key)
+{
+  m_BTNode* nd = bt->root;
+  M_UINT32 lb = 0; /* depth of the lowest node above key seen so far */
+
+  assert(it && bt);
+  M_TRACE("Iter -- seek ("M_PTR_FMT") key ("M_ID_FMT")", bt, key);
+
+  it->depth = 0;
+  while (nd)
+  {
+    it->path[it->depth++] = nd;
+    if (key == nd->key) return M_TRUE;
+    if (key < nd->key)
+    {
+      lb = it->depth;
+      nd = nd->less;
+    }
+    else
+      nd = nd->more;
+  }
+  it->depth = lb;
+  return lb != 0;
+}
+
+M_BOOL
+m_BTreeIter_next(m_BTreeIter* const it)
+{
+  m_BTNode* nd;
+
+  assert(it);
+  if (!it->depth) return M_FALSE;
+
+  nd = it->path[it->depth - 1]->more;
+  if (nd)
+  {
+    for (; nd; nd = nd->less)
+      it->path[it->depth++] = nd;
+    return M_TRUE;
+  }
+  /* climb until coming from a left child */
+  for (;;)
+  {
+    nd = it->path[--it->depth];
+    if (!it->depth) return M_FALSE;
+    if (it->path[it->depth - 1]->less == nd) return M_TRUE;
+  }
+}
+
+M_BOOL
+m_BTreeIter_prev(m_BTreeIter* const it)
+{
+  m_BTNode* nd;
+
+  assert(it);
+  if (!it->depth) return M_FALSE;
+
+  nd = it->path[it->depth - 1]->less;
+  if (nd)
+  {
+    for (; nd; nd = nd->more)
+      it->path[it->depth++] = nd;
+    return M_TRUE;
+  }
+  /* climb until coming from a right child */
+  for (;;)
+  {
+    nd = it->path[--it->depth];
+    if (!it->depth) return M_FALSE;
+    if (it->path[it->depth - 1]->more == nd) return M_TRUE;
+  }
+}
+
+M_SZ
+m_BTreeIter_read(m_BTreeIter* const it,
+        const M_ID hi,
+        M_ID* const keys,
+        M_PTR* const vals,
+        const M_SZ max)
+{
+  const m_BTNode* nd;
+  M_SZ i;
+
+  assert(it);
+
+  for (i = 0; i < max && it->depth; ++i)
+  {
+    nd = it->path[it->depth - 1];
+    if (nd->key > hi) break;
+    if (keys) keys[i] = nd->key;
+    if (vals) vals[i] = nd->val;
+    m_BTreeIter_next(it);
+  }
+  return i;
+}
+
+M_VOID
+m_BTree_traverse_range(const m_BTree* const bt,
+        const M_ID lo,
+        const M_ID hi,
+        M_VOID (* const func)(const M_ID*, M_PTR*, M_SZ, M_PTR),
+        M_PTR userdata)
+{
+  m_BTreeIter it;
+  M_ID keys[M_BTREE_BATCH];
+  M_PTR vals[M_BTREE_BATCH];
+  M_SZ num;
+
+  assert(bt);
+  assert(func);
+  M_TRACE("traverse_range ("M_PTR_FMT") ("M_ID_FMT") ("M_ID_FMT")", bt, lo, hi);
+  if (!bt || !func) return;
+
+  if (!m_BTreeIter_seek(&it, bt, lo)) return;
+  while ((num = m_BTreeIter_read(&it, hi, keys, vals, M_BTREE_BATCH)))
+    (*func)(keys, vals, num, userdata);
+}
+
 M_SZ
 m_BTNode_linearize(const m_BTNode* const bt,
         M_PTR* const arr)
@@ -921,6 +1479,10 @@ m_BTNode_unlinearize(m_BTNode** const bt,
       return M_FALSE;
     (*bt)->more = tmp;
   }
+  (*bt)->bfactor = _m_BTNode_height(sz - (mid + 1)) - _m_BTNode_height(mid);
+#ifdef M_BTREE_RANK
+  (*bt)->size = sz;
+#endif
   return M_TRUE;
 }
 
@@ -37,6 +37,10 @@ SOFTWARE.
  *
  *  We can optionaly rely on another memory pool, by changing the
  *  malloc'doer and free'doer accordingly.
+ *
+ *  By default though, nodes are carved from pages owned by the tree,
+ *  taken with _M_MALLOC, and freed nodes are kept in a list for reuse.
+ *  Pages are released all at once by m_BTree_fini.
  */
 
 #ifndef M_BTREE_H
@@ -48,6 +52,17 @@ extern "C" {
 
 #include "m_h.h"
 
+/**
+ *  \def M_BTREE_RANK
+ *  \brief Define this to keep subtree sizes in nodes.
+ *
+ *  It changes the layout of nodes: define it for the library and all of
+ *  its users alike (cmake option M_BTREE_RANK).
+ *
+ *  This costs one word per node, and a few updates per insert or remove,
+ *  for m_BTree_rank and m_BTree_select in O(log n).
+ */
+
 /**
  *  \typedef m_BTNode
  */
@@ -64,9 +79,25 @@ struct _m_BTNode
   m_BTNode* parent;
   m_BTNode* less;
   m_BTNode* more;
+#ifdef M_BTREE_RANK
+  M_SZ size; /* number of nodes in subtree */
+#endif
   M_INT8 bfactor : 2;
 };
 
+/**
+ *  \brief Maximum number of nodes in a page of a tree.
+ *
+ *  Pages start small and double with the size of the tree, up to that.
+ */
+#define M_BTREE_PAGENODES  1024
+
+/**
+ *  \typedef m_BTPage
+ *  \note Opaque type.
+ */
+typedef struct _m_BTPage m_BTPage;
+
 /**
  *  \typedef m_BTree
  */
@@ -79,9 +110,12 @@ typedef struct _m_BTree m_BTree;
 struct _m_BTree
 {
   m_BTNode* root;
+  M_SZ num; /* number of nodes */
   M_PTR (*mallocdoer)(M_SZ);
   M_VOID (*freedoer)(M_PTR);
   M_VOID (*finalize_fn)(M_PTR);
+  m_BTPage* pages; /* pages of nodes, newest first */
+  m_BTNode* freenodes; /* nodes for reuse, linked by parent */
 };
 
 /* Private functions */
@@ -98,8 +132,8 @@ m_BTree_new(m_BTree** const bt);
 /**
  *  \brief Initialize a btree (extended version).
  *  \param bt The binary tree.
- *  \param mallocdoer Allocation function for nodes, or NULL to use malloc.
- *  \param freedoer Deallocation function for nodes, or NULL to use free.
+ *  \param mallocdoer Allocation function for nodes, or NULL to use pages.
+ *  \param freedoer Deallocation function for nodes, or NULL to use pages.
  *  \return M_TRUE, or M_FALSE on error.
  */
 M_DLLAPI M_BOOL
@@ -108,7 +142,7 @@ m_BTree_init2(m_BTree* const bt,
         M_VOID (* const freedoer)(M_PTR));
 
 /**
- *  \brief Initialize a btree.
+ *  \brief Initialize a btree, with nodes from pages.
  *  \param bt The binary tree.
  *  \return M_TRUE, or M_FALSE on error.
  */
@@ -145,6 +179,24 @@ m_BTree_insert(m_BTree* const bt,
         const M_ID key,
         const M_PTR val);
 
+/**
+ *  \brief Build a btree from sorted keys, in linear time.
+ *  \param bt The binary tree (empty).
+ *  \param keys The keys, in strictly increasing order.
+ *  \param vals The values (or NULL for all NULL values).
+ *  \param num Number of keys.
+ *  \return M_TRUE, or M_FALSE on error (or if keys are not sorted).
+ *
+ *  The tree is perfectly balanced, and its nodes are allocated at once,
+ *  in key order, in one page that goes with m_BTree_fini. Nodes can
+ *  still be inserted and removed as usual after that.
+ */
+M_DLLAPI M_BOOL
+m_BTree_build_sorted(m_BTree* const bt,
+        const M_ID* const keys,
+        M_PTR const* const vals,
+        const M_SZ num);
+
 /**
  *  \brief Remove a node from the btree.
  *  \param bt The binary tree.
@@ -176,6 +228,28 @@ m_BTree_remove(m_BTree* const bt,
 #define m_BTree_get( bt, idx ) \
         m_BTNode_get( (bt)->root, idx )
 
+/**
+ *  \brief Number of lookups interleaved by m_BTree_get_many.
+ */
+#define M_BTREE_GROUP  16
+
+/**
+ *  \brief Get the values of many keys from the btree.
+ *  \param bt The binary tree.
+ *  \param keys The keys.
+ *  \param vals Set to the values, or NULL for keys not found.
+ *  \param num Number of keys.
+ *
+ *  Lookups go M_BTREE_GROUP at a time, one level down for each key in
+ *  turn, prefetching the next node of each, so that their cache misses
+ *  overlap instead of following one another.
+ */
+M_DLLAPI M_VOID
+m_BTree_get_many(const m_BTree* const bt,
+        const M_ID* const keys,
+        M_PTR* const vals,
+        const M_SZ num);
+
 /**
  *  \brief Set the value for a given key in the btree.
  *  \param bt The binary tree.
@@ -192,10 +266,35 @@ m_BTree_remove(m_BTree* const bt,
  *  \brief Count the nodes inside a btree.
  *  \param bt The binary tree.
  *  \return The count.
+ *  \note Only for trees changed through m_BTree functions.
  *  \see m_BTNode_count
  */
 #define m_BTree_count( bt ) \
-        m_BTNode_count( (bt)->root )
+        ((bt)->num)
+
+#ifdef M_BTREE_RANK
+
+/**
+ *  \brief Get the number of keys less than a key.
+ *  \param bt The binary tree.
+ *  \param key The key (not necessarily in the tree).
+ *  \return The rank, from 0 to m_BTree_count(bt).
+ */
+M_DLLAPI M_SZ
+m_BTree_rank(const m_BTree* const bt,
+        const M_ID key);
+
+/**
+ *  \brief Get the node of a rank.
+ *  \param bt The binary tree.
+ *  \param i The rank, from 0 (lowest key) to m_BTree_count(bt) - 1.
+ *  \return The node, or NULL if i is out of range.
+ */
+M_DLLAPI m_BTNode*
+m_BTree_select(const m_BTree* const bt,
+        M_SZ i);
+
+#endif /* M_BTREE_RANK */
 
 /**
  *  \brief Traverse a btree and apply function to the values.
@@ -269,6 +368,142 @@ m_BTree_remove(m_BTree* const bt,
 #define m_BTree_max( bt ) \
         m_BTNode_max( (bt)->root )
 
+/**
+ *  \brief Maximum depth of an m_BTree.
+ *
+ *  An AVL tree of n nodes is less than 1.44 log2(n + 2) high, that is
+ *  at most 92 levels with 64-bit counts.
+ */
+#define M_BTREE_MAXDEPTH  96
+
+/**
+ *  \brief Number of elements handed out at once by batched traversals.
+ */
+#define M_BTREE_BATCH  64
+
+/**
+ *  \typedef m_BTreeIter
+ */
+typedef struct _m_BTreeIter m_BTreeIter;
+
+/**
+ *  \struct _m_BTreeIter
+ *  \brief Iterator over a btree, in key order.
+ *
+ *  The iterator holds the path from the root to the current node, so that
+ *  it moves in both directions without comparing keys. It is valid as long
+ *  as the tree is not modified.
+ */
+struct _m_BTreeIter
+{
+  M_UINT32 depth; /* length of path, 0 when past either end */
+  m_BTNode* path[M_BTREE_MAXDEPTH]; /* current node is path[depth - 1] */
+};
+
+/**
+ *  \brief Get the current node of an iterator (or NULL).
+ */
+#define m_BTreeIter_node( it ) \
+        ((it)->depth ? (it)->path[(it)->depth - 1] : NULL)
+
+/**
+ *  \brief Get the key of the current node (iterator must be valid).
+ */
+#define m_BTreeIter_key( it ) \
+        ((it)->path[(it)->depth - 1]->key)
+
+/**
+ *  \brief Get the value of the current node (iterator must be valid).
+ */
+#define m_BTreeIter_val( it ) \
+        ((it)->path[(it)->depth - 1]->val)
+
+/**
+ *  \brief Place an iterator on the lowest key of a btree.
+ *  \param it The iterator.
+ *  \param bt The binary tree.
+ *  \return M_TRUE, or M_FALSE if the tree is empty.
+ */
+M_DLLAPI M_BOOL
+m_BTreeIter_begin(m_BTreeIter* const it,
+        const m_BTree* const bt);
+
+/**
+ *  \brief Place an iterator on the highest key of a btree.
+ *  \param it The iterator.
+ *  \param bt The binary tree.
+ *  \return M_TRUE, or M_FALSE if the tree is empty.
+ */
+M_DLLAPI M_BOOL
+m_BTreeIter_last(m_BTreeIter* const it,
+        const m_BTree* const bt);
+
+/**
+ *  \brief Place an iterator on the lowest key not less than a key.
+ *  \param it The iterator.
+ *  \param bt The binary tree.
+ *  \param key The key (lower bound).
+ *  \return M_TRUE, or M_FALSE if all keys are less than key.
+ */
+M_DLLAPI M_BOOL
+m_BTreeIter_seek(m_BTreeIter* const it,
+        const m_BTree* const bt,
+        const M_ID key);
+
+/**
+ *  \brief Move an iterator to the next key.
+ *  \return M_TRUE, or M_FALSE if there is no next key.
+ */
+M_DLLAPI M_BOOL
+m_BTreeIter_next(m_BTreeIter* const it);
+
+/**
+ *  \brief Move an iterator to the previous key.
+ *  \return M_TRUE, or M_FALSE if there is no previous key.
+ */
+M_DLLAPI M_BOOL
+m_BTreeIter_prev(m_BTreeIter* const it);
+
+/**
+ *  \brief Copy keys and values from an iterator, moving it forward.
+ *  \param it The iterator.
+ *  \param hi Highest key to copy.
+ *  \param keys Array for the keys (or NULL).
+ *  \param vals Array for the values (or NULL).
+ *  \param max Size of arrays.
+ *  \return The number of elements copied.
+ *
+ *  The iterator ends on the element after the last one copied.
+ */
+M_DLLAPI M_SZ
+m_BTreeIter_read(m_BTreeIter* const it,
+        const M_ID hi,
+        M_ID* const keys,
+        M_PTR* const vals,
+        const M_SZ max);
+
+/**
+ *  \brief Traverse a range of keys, M_BTREE_BATCH elements at a time.
+ *  \param bt The binary tree.
+ *  \param lo Lowest key.
+ *  \param hi Highest key.
+ *  \param func The function, given arrays of num keys and values in order.
+ *  \param userdata Pointer passed to function.
+ */
+M_DLLAPI M_VOID
+m_BTree_traverse_range(const m_BTree* const bt,
+        const M_ID lo,
+        const M_ID hi,
+        M_VOID (* const func)(const M_ID* keys, M_PTR* vals, M_SZ num, M_PTR udata),
+        M_PTR userdata);
+
+/**
+ *  \brief Traverse a btree, M_BTREE_BATCH elements at a time.
+ *  \see m_BTree_traverse_range
+ */
+#define m_BTree_traverse_batch( bt, func, udata ) \
+        m_BTree_traverse_range( (bt), 0, (M_ID) -1, (func), (udata) )
+
 /**
  *  \brief Copy the tree values into a linear array.
  *  \param node The root node.
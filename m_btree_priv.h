@@ -83,7 +83,7 @@ _m_BTNode_free(M_PTR p);
  *  We are relying on MemCnt if MemPool is disabled.
  */
 #define _m_BTNode_free(p) _M_FREE(p)
-#define _m_BTNode_free_ref _M_FREE_REF
+#define _m_BTNode_free_ref ((M_VOID(*)(M_PTR)) _M_FREE_REF)
 #endif /* !M_NO_MEMPOOL */
 
 m_BTNode*
@@ -0,0 +1,607 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+#include "m_cbtree.h"
+
+#include "m_memcnt.h"
+
+#undef M_TRACE
+#if defined(M_TRACE_MODE) && defined(M_TRACE_CBTREE)
+#define M_TRACE(msg, ...) _M_TRACER("-- CBTree -- "msg, __VA_ARGS__)
+#else
+#define M_TRACE(moo, ...)
+#endif
+
+#define M_CBTREE_HEAVY  0x80000000U
+#define M_CBTREE_INDEX  0x7FFFFFFFU
+
+/* initial size of the array of nodes */
+#define M_CBTREE_MINCAP 16
+
+#define LESS(n) ((n)->child[0] & M_CBTREE_INDEX)
+#define MORE(n) ((n)->child[1] & M_CBTREE_INDEX)
+
+static M_VOID
+_m_CBTNode_set_less(m_CBTNode* const n,
+        const M_UINT32 i)
+{
+  n->child[0] = (n->child[0] & M_CBTREE_HEAVY) | i;
+}
+
+static M_VOID
+_m_CBTNode_set_more(m_CBTNode* const n,
+        const M_UINT32 i)
+{
+  n->child[1] = (n->child[1] & M_CBTREE_HEAVY) | i;
+}
+
+/*
+ *  Balance factor, height of more subtree minus height of less subtree.
+ */
+static M_INT32
+_m_CBTNode_bf(const m_CBTNode* const n)
+{
+  return (M_INT32)(n->child[1] >> 31) - (M_INT32)(n->child[0] >> 31);
+}
+
+static M_VOID
+_m_CBTNode_set_bf(m_CBTNode* const n,
+        const M_INT32 b)
+{
+  n->child[0] = LESS(n) | (b < 0 ? M_CBTREE_HEAVY : 0);
+  n->child[1] = MORE(n) | (b > 0 ? M_CBTREE_HEAVY : 0);
+}
+
+/*
+ *  Rotations, around x higher by 2 on the side of its child z.
+ *  They return the new root of the subtree.
+ */
+static M_UINT32
+_m_CBTree_rotate_left(m_CBTNode* const nd,
+        const M_UINT32 x,
+        const M_UINT32 z)
+{
+  _m_CBTNode_set_more(&nd[x], LESS(&nd[z]));
+  _m_CBTNode_set_less(&nd[z], x);
+  if (_m_CBTNode_bf(&nd[z]) == 0) /* only after removal */
+  {
+    _m_CBTNode_set_bf(&nd[x], +1);
+    _m_CBTNode_set_bf(&nd[z], -1);
+  }
+  else
+  {
+    _m_CBTNode_set_bf(&nd[x], 0);
+    _m_CBTNode_set_bf(&nd[z], 0);
+  }
+  return z;
+}
+
+static M_UINT32
+_m_CBTree_rotate_right(m_CBTNode* const nd,
+        const M_UINT32 x,
+        const M_UINT32 z)
+{
+  _m_CBTNode_set_less(&nd[x], MORE(&nd[z]));
+  _m_CBTNode_set_more(&nd[z], x);
+  if (_m_CBTNode_bf(&nd[z]) == 0) /* only after removal */
+  {
+    _m_CBTNode_set_bf(&nd[x], -1);
+    _m_CBTNode_set_bf(&nd[z], +1);
+  }
+  else
+  {
+    _m_CBTNode_set_bf(&nd[x], 0);
+    _m_CBTNode_set_bf(&nd[z], 0);
+  }
+  return z;
+}
+
+static M_UINT32
+_m_CBTree_rotate_right_left(m_CBTNode* const nd,
+        const M_UINT32 x,
+        const M_UINT32 z)
+{
+  const M_UINT32 y = LESS(&nd[z]);
+  const M_INT32 b = _m_CBTNode_bf(&nd[y]);
+
+  _m_CBTNode_set_less(&nd[z], MORE(&nd[y]));
+  _m_CBTNode_set_more(&nd[y], z);
+  _m_CBTNode_set_more(&nd[x], LESS(&nd[y]));
+  _m_CBTNode_set_less(&nd[y], x);
+  _m_CBTNode_set_bf(&nd[x], b > 0 ? -1 : 0);
+  _m_CBTNode_set_bf(&nd[z], b < 0 ? +1 : 0);
+  _m_CBTNode_set_bf(&nd[y], 0);
+  return y;
+}
+
+static M_UINT32
+_m_CBTree_rotate_left_right(m_CBTNode* const nd,
+        const M_UINT32 x,
+        const M_UINT32 z)
+{
+  const M_UINT32 y = MORE(&nd[z]);
+  const M_INT32 b = _m_CBTNode_bf(&nd[y]);
+
+  _m_CBTNode_set_more(&nd[z], LESS(&nd[y]));
+  _m_CBTNode_set_less(&nd[y], z);
+  _m_CBTNode_set_less(&nd[x], MORE(&nd[y]));
+  _m_CBTNode_set_more(&nd[y], x);
+  _m_CBTNode_set_bf(&nd[x], b < 0 ? +1 : 0);
+  _m_CBTNode_set_bf(&nd[z], b > 0 ? -1 : 0);
+  _m_CBTNode_set_bf(&nd[y], 0);
+  return y;
+}
+
+/*
+ *  Rebalance x, higher by 2 on the more side (b > 0) or the less side.
+ *  Tell if the subtree got shorter, and return its new root.
+ */
+static M_UINT32
+_m_CBTree_rebalance(m_CBTNode* const nd,
+        const M_UINT32 x,
+        const M_INT32 b,
+        M_BOOL* const shorter)
+{
+  M_UINT32 z;
+  M_INT32 bz;
+
+  if (b > 0)
+  {
+    z = MORE(&nd[x]);
+    bz = _m_CBTNode_bf(&nd[z]);
+    *shorter = bz != 0;
+    return bz < 0 ? _m_CBTree_rotate_right_left(nd, x, z)
+        : _m_CBTree_rotate_left(nd, x, z);
+  }
+  z = LESS(&nd[x]);
+  bz = _m_CBTNode_bf(&nd[z]);
+  *shorter = bz != 0;
+  return bz > 0 ? _m_CBTree_rotate_left_right(nd, x, z)
+      : _m_CBTree_rotate_right(nd, x, z);
+}
+
+/*
+ *  Point the parent of path[depth] (or the root) to node i.
+ */
+static M_VOID
+_m_CBTree_relink(m_CBTree* const bt,
+        const M_UINT32* const path,
+        const M_INT8* const dirs,
+        const M_UINT32 depth,
+        const M_UINT32 i)
+{
+  if (!depth)
+    bt->root = i;
+  else if (dirs[depth - 1] < 0)
+    _m_CBTNode_set_less(&bt->nodes[path[depth - 1]], i);
+  else
+    _m_CBTNode_set_more(&bt->nodes[path[depth - 1]], i);
+}
+
+/*
+ *  Get the index of an unused node (the array may move), or 0.
+ */
+static M_UINT32
+_m_CBTree_alloc(m_CBTree* const bt)
+{
+  M_UINT32 i = bt->freenodes;
+
+  if (i)
+  {
+    bt->freenodes = bt->nodes[i].child[0];
+    return i;
+  }
+  if (bt->used >= bt->capacity
+      && (bt->used > M_CBTREE_MAXNODES
+      || !m_CBTree_reserve(bt,
+          M_MIN((M_SZ) bt->capacity * 2, (M_SZ) M_CBTREE_MAXNODES))))
+    return 0;
+  return bt->used++;
+}
+
+M_BOOL
+m_CBTree_new(m_CBTree** const bt)
+{
+  assert(bt);
+  M_TRACE("new ("M_PTR_FMT")", bt);
+  if (!bt) return M_FALSE;
+
+  *bt = _M_MALLOC(sizeof(m_CBTree));
+  assert(*bt);
+  if (!*bt) return M_FALSE;
+  return m_CBTree_init(*bt);
+}
+
+M_BOOL
+m_CBTree_init(m_CBTree* const bt)
+{
+  assert(bt);
+  M_TRACE("init ("M_PTR_FMT")", bt);
+  if (!bt) return M_FALSE;
+
+  bt->nodes = NULL;
+  bt->capacity = 0;
+  bt->used = 1; /* node 0 stands for none */
+  bt->root = 0;
+  bt->freenodes = 0;
+  bt->num = 0;
+  bt->finalize_fn = NULL;
+  return M_TRUE;
+}
+
+M_VOID
+m_CBTree_fini(m_CBTree* const bt)
+{
+  assert(bt);
+  M_TRACE("fini ("M_PTR_FMT")", bt);
+  if (!bt) return;
+
+  if (bt->finalize_fn) m_CBTree_traverse(bt, bt->finalize_fn);
+  if (bt->nodes) _M_FREE(bt->nodes);
+  m_CBTree_init(bt);
+}
+
+M_VOID
+m_CBTree_delete(m_CBTree** const bt)
+{
+  assert(bt && *bt);
+  M_TRACE("delete ("M_PTR_FMT")", *bt);
+  if (!bt || !*bt) return;
+
+  m_CBTree_fini(*bt);
+  _M_FREE(*bt);
+  *bt = NULL;
+}
+
+M_BOOL
+m_CBTree_reserve(m_CBTree* const bt,
+        const M_SZ num)
+{
+  m_CBTNode* nodes;
+  M_SZ cap;
+
+  assert(bt);
+  M_TRACE("reserve ("M_PTR_FMT") num ("M_SZ_FMT")", bt, num);
+  if (!bt) return M_FALSE;
+
+  if (num < bt->capacity) return M_TRUE;
+  if (num > M_CBTREE_MAXNODES) return M_FALSE;
+  cap = M_MAX(num + 1, (M_SZ) M_CBTREE_MINCAP);
+  cap = M_MIN(cap, (M_SZ) M_CBTREE_MAXNODES + 1);
+  nodes = bt->nodes ? _M_REALLOC(bt->nodes, cap * sizeof(m_CBTNode))
+      : _M_MALLOC(cap * sizeof(m_CBTNode));
+  assert(nodes);
+  if (!nodes) return M_FALSE;
+  bt->nodes = nodes;
+  bt->capacity = (M_UINT32) cap;
+  return M_TRUE;
+}
+
+M_INT8
+m_CBTree_insert(m_CBTree* const bt,
+        const M_ID key,
+        const M_PTR val)
+{
+  M_UINT32 path[M_CBTREE_MAXDEPTH];
+  M_INT8 dirs[M_CBTREE_MAXDEPTH];
+  M_UINT32 depth = 0, i, x;
+  m_CBTNode* nd;
+  M_BOOL shorter;
+  M_INT32 b;
+
+  assert(bt);
+  M_TRACE("insert ("M_PTR_FMT") key ("M_ID_FMT") val ("M_PTR_FMT")",
+      bt, key, val);
+  if (!bt) return -1;
+
+  for (i = bt->root; i; )
+  {
+    nd = &bt->nodes[i];
+    if (key == nd->key) return 0;
+    path[depth] = i;
+    if (key < nd->key)
+    {
+      dirs[depth++] = -1;
+      i = LESS(nd);
+    }
+    else
+    {
+      dirs[depth++] = +1;
+      i = MORE(nd);
+    }
+  }
+  i = _m_CBTree_alloc(bt);
+  if (!i) return -1;
+  nd = bt->nodes;
+  nd[i].key = key;
+  nd[i].val = (M_PTR) val;
+  nd[i].child[0] = 0;
+  nd[i].child[1] = 0;
+  _m_CBTree_relink(bt, path, dirs, depth, i);
+  bt->num += 1;
+
+  /* retrace, the subtree at path[depth] got higher on side dirs[depth] */
+  while (depth--)
+  {
+    x = path[depth];
+    b = _m_CBTNode_bf(&nd[x]) + dirs[depth];
+    if (b == 0)
+    {
+      _m_CBTNode_set_bf(&nd[x], 0);
+      break;
+    }
+    if (b == 1 || b == -1)
+    {
+      _m_CBTNode_set_bf(&nd[x], b);
+      continue;
+    }
+    _m_CBTree_relink(bt, path, dirs, depth,
+        _m_CBTree_rebalance(nd, x, b, &shorter));
+    break;
+  }
+  return 1;
+}
+
+M_BOOL
+m_CBTree_remove(m_CBTree* const bt,
+        const M_ID key,
+        M_VOID (* const fn)(M_PTR))
+{
+  M_UINT32 path[M_CBTREE_MAXDEPTH];
+  M_INT8 dirs[M_CBTREE_MAXDEPTH];
+  M_UINT32 depth = 0, i, s, x;
+  m_CBTNode* nd;
+  M_BOOL shorter;
+  M_INT32 b;
+
+  assert(bt);
+  M_TRACE("remove ("M_PTR_FMT") key ("M_ID_FMT")", bt, key);
+  if (!bt) return M_FALSE;
+
+  nd = bt->nodes;
+  for (i = bt->root; i && key != nd[i].key; )
+  {
+    path[depth] = i;
+    if (key < nd[i].key)
+    {
+      dirs[depth++] = -1;
+      i = LESS(&nd[i]);
+    }
+    else
+    {
+      dirs[depth++] = +1;
+      i = MORE(&nd[i]);
+    }
+  }
+  if (!i) return M_FALSE;
+  if (fn) (*fn)(nd[i].val);
+
+  if (LESS(&nd[i]) && MORE(&nd[i]))
+  {
+    /* take the place of the successor, and remove that one instead */
+    path[depth] = i;
+    dirs[depth++] = +1;
+    for (s = MORE(&nd[i]); LESS(&nd[s]); s = LESS(&nd[s]))
+    {
+      path[depth] = s;
+      dirs[depth++] = -1;
+    }
+    nd[i].key = nd[s].key;
+    nd[i].val = nd[s].val;
+    i = s;
+  }
+  _m_CBTree_relink(bt, path, dirs, depth,
+      LESS(&nd[i]) ? LESS(&nd[i]) : MORE(&nd[i]));
+  nd[i].child[0] = bt->freenodes;
+  bt->freenodes = i;
+  bt->num -= 1;
+
+  /* retrace, the subtree at path[depth] got shorter on side dirs[depth] */
+  while (depth--)
+  {
+    x = path[depth];
+    b = _m_CBTNode_bf(&nd[x]) - dirs[depth];
+    if (b == 1 || b == -1)
+    {
+      _m_CBTNode_set_bf(&nd[x], b);
+      break;
+    }
+    if (b == 0)
+    {
+      _m_CBTNode_set_bf(&nd[x], 0);
+      continue;
+    }
+    _m_CBTree_relink(bt, path, dirs, depth,
+        _m_CBTree_rebalance(nd, x, b, &shorter));
+    if (!shorter) break;
+  }
+  return M_TRUE;
+}
+
+M_PTR
+m_CBTree_get(const m_CBTree* const bt,
+        const M_ID key)
+{
+  const m_CBTNode* const nd = bt->nodes;
+  M_UINT32 i = bt->root;
+
+  while (i)
+  {
+    const m_CBTNode* const n = &nd[i];
+    if (key == n->key) return n->val;
+    /* index rather than branch, the branch is mispredicted half the time */
+    i = n->child[key > n->key] & M_CBTREE_INDEX;
+  }
+  return NULL;
+}
+
+M_BOOL
+m_CBTree_set(m_CBTree* const bt,
+        const M_ID key,
+        const M_PTR val,
+        M_PTR* const prev)
+{
+  m_CBTNode* const nd = bt->nodes;
+  M_UINT32 i = bt->root;
+
+  while (i)
+  {
+    if (key == nd[i].key)
+    {
+      if (prev) *prev = nd[i].val;
+      nd[i].val = (M_PTR) val;
+      return M_TRUE;
+    }
+    i = nd[i].child[key > nd[i].key] & M_CBTREE_INDEX;
+  }
+  return M_FALSE;
+}
+
+M_VOID
+m_CBTree_traverse(const m_CBTree* const bt,
+        M_VOID (* const func)(M_PTR))
+{
+  m_CBTreeIter it;
+
+  for (m_CBTreeIter_begin(&it, bt); it.depth; m_CBTreeIter_next(&it))
+    (*func)(m_CBTreeIter_node(&it)->val);
+}
+
+M_VOID
+m_CBTree_traverse2(const m_CBTree* const bt,
+        M_VOID (* const func)(M_PTR, M_PTR),
+        M_PTR userdata)
+{
+  m_CBTreeIter it;
+
+  for (m_CBTreeIter_begin(&it, bt); it.depth; m_CBTreeIter_next(&it))
+    (*func)(m_CBTreeIter_node(&it)->val, userdata);
+}
+
+M_BOOL
+m_CBTreeIter_begin(m_CBTreeIter* const it,
+        const m_CBTree* const bt)
+{
+  M_UINT32 i;
+
+  assert(it && bt);
+
+  it->bt = bt;
+  it->depth = 0;
+  for (i = bt->root; i; i = LESS(&bt->nodes[i]))
+    it->path[it->depth++] = i;
+  return it->depth != 0;
+}
+
+M_BOOL
+m_CBTreeIter_seek(m_CBTreeIter* const it,
+        const m_CBTree* const bt,
+        const M_ID key)
+{
+  const m_CBTNode* const nd = bt->nodes;
+  M_UINT32 i, lb = 0;
+
+  assert(it && bt);
+
+  it->bt = bt;
+  it->depth = 0;
+  for (i = bt->root; i; )
+  {
+    it->path[it->depth++] = i;
+    if (key == nd[i].key) return M_TRUE;
+    if (key < nd[i].key)
+    {
+      lb = it->depth;
+      i = LESS(&nd[i]);
+    }
+    else
+      i = MORE(&nd[i]);
+  }
+  it->depth = lb;
+  return lb != 0;
+}
+
+M_BOOL
+m_CBTreeIter_next(m_CBTreeIter* const it)
+{
+  const m_CBTNode* const nd = it->bt->nodes;
+  M_UINT32 i;
+
+  if (!it->depth) return M_FALSE;
+
+  i = MORE(&nd[it->path[it->depth - 1]]);
+  if (i)
+  {
+    for (; i; i = LESS(&nd[i]))
+      it->path[it->depth++] = i;
+    return M_TRUE;
+  }
+  /* climb until coming from a left child */
+  for (;;)
+  {
+    i = it->path[--it->depth];
+    if (!it->depth) return M_FALSE;
+    if (LESS(&nd[it->path[it->depth - 1]]) == i) return M_TRUE;
+  }
+}
+
+#ifndef NDEBUG
+
+/*
+ *  Height of subtree i, or -1 if it is broken.
+ */
+static M_INT32
+_m_CBTree_check(const m_CBTree* const bt,
+        const M_UINT32 i,
+        M_SZ* const cnt)
+{
+  const m_CBTNode* const n = &bt->nodes[i];
+  M_INT32 l, r;
+
+  if (!i) return 0;
+  if (i >= bt->used) return -1;
+  if ((n->child[0] & M_CBTREE_HEAVY) && (n->child[1] & M_CBTREE_HEAVY)) return -1;
+  if (LESS(n) && bt->nodes[LESS(n)].key >= n->key) return -1;
+  if (MORE(n) && bt->nodes[MORE(n)].key <= n->key) return -1;
+  *cnt += 1;
+  l = _m_CBTree_check(bt, LESS(n), cnt);
+  r = _m_CBTree_check(bt, MORE(n), cnt);
+  if (l < 0 || r < 0 || r - l != _m_CBTNode_bf(n)) return -1;
+  return 1 + M_MAX(l, r);
+}
+
+M_BOOL
+m_CBTree_check(const m_CBTree* const bt)
+{
+  M_SZ cnt = 0;
+
+  assert(bt);
+  if (_m_CBTree_check(bt, bt->root, &cnt) < 0) return M_FALSE;
+  return cnt == bt->num;
+}
+
+#endif /* NDEBUG */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,268 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+/**
+ *  \file m_cbtree.h
+ *  \brief AVL binary-tree, self-balanced, with compact nodes.
+ *  \author Stanislas Marquis <stan@astrorigin.com>
+ */
+
+/*
+ *  Same as m_BTree, for up to 2^31 - 1 nodes, in about half the memory.
+ *
+ *  All nodes live in one array owned by the tree, and are linked by
+ *  32-bit indices instead of pointers (0 is none). There is no parent
+ *  link: paths are kept on the stack while inserting or removing. The
+ *  balance factor takes the high bit of each child link, so a node is
+ *  only its key, its value and two words (24 bytes on 64-bit targets,
+ *  against 48 for m_BTNode).
+ *
+ *  Nodes move when the array grows: only keys and values are handed out.
+ */
+
+#ifndef M_CBTREE_H
+#define M_CBTREE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "m_h.h"
+
+/**
+ *  \brief Maximum depth of an m_CBTree (for 2^31 nodes).
+ */
+#define M_CBTREE_MAXDEPTH  48
+
+/**
+ *  \brief Maximum number of nodes in an m_CBTree.
+ */
+#define M_CBTREE_MAXNODES  0x7FFFFFFE
+
+/**
+ *  \typedef m_CBTNode
+ */
+typedef struct _m_CBTNode m_CBTNode;
+
+/**
+ *  \struct _m_CBTNode
+ *  \brief Compact binary tree node.
+ */
+struct _m_CBTNode
+{
+  M_ID key;
+  M_PTR val;
+  M_UINT32 child[2]; /* less and more, high bit set if heavy on that side */
+};
+
+/**
+ *  \typedef m_CBTree
+ */
+typedef struct _m_CBTree m_CBTree;
+
+/**
+ *  \struct _m_CBTree
+ *  \brief Compact binary tree.
+ */
+struct _m_CBTree
+{
+  m_CBTNode* nodes; /* array of nodes, first one unused */
+  M_UINT32 capacity; /* size of array */
+  M_UINT32 used; /* number of array entries ever used */
+  M_UINT32 root; /* index of root node, or 0 */
+  M_UINT32 freenodes; /* first node for reuse, linked by child[0] */
+  M_SZ num; /* number of nodes */
+  M_VOID (*finalize_fn)(M_PTR);
+};
+
+/**
+ *  \brief Allocate for a new compact btree.
+ *  \param bt The tree.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_CBTree_new(m_CBTree** const bt);
+
+/**
+ *  \brief Initialize a compact btree.
+ *  \param bt The tree.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_CBTree_init(m_CBTree* const bt);
+
+/**
+ *  \brief Finalize a compact btree.
+ *
+ *  If not NULL, bt->finalize_fn is executed on the nodes values.
+ */
+M_DLLAPI M_VOID
+m_CBTree_fini(m_CBTree* const bt);
+
+/**
+ *  \brief Deallocate a compact btree.
+ */
+M_DLLAPI M_VOID
+m_CBTree_delete(m_CBTree** const bt);
+
+/**
+ *  \brief Make room for a number of nodes.
+ *  \param bt The tree.
+ *  \param num Total number of nodes expected.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_CBTree_reserve(m_CBTree* const bt,
+        const M_SZ num);
+
+/**
+ *  \brief Insert a new node.
+ *  \param bt The tree.
+ *  \param key The key.
+ *  \param val The value.
+ *  \return 1 on success, 0 if the key is duplicate, -1 on error.
+ */
+M_DLLAPI M_INT8
+m_CBTree_insert(m_CBTree* const bt,
+        const M_ID key,
+        const M_PTR val);
+
+/**
+ *  \brief Remove a node.
+ *  \param bt The tree.
+ *  \param key The key.
+ *  \param fn If not null, execute function on value of found node.
+ *  \return M_TRUE if the key was found.
+ */
+M_DLLAPI M_BOOL
+m_CBTree_remove(m_CBTree* const bt,
+        const M_ID key,
+        M_VOID (* const fn)(M_PTR));
+
+/**
+ *  \brief Get a value, or NULL.
+ */
+M_DLLAPI M_PTR
+m_CBTree_get(const m_CBTree* const bt,
+        const M_ID key);
+
+/**
+ *  \brief Set the value for a key already in the tree.
+ *  \param bt The tree.
+ *  \param key The key.
+ *  \param val The value.
+ *  \param prev If not NULL, return value replaced.
+ *  \return M_TRUE if the key was found and value changed.
+ */
+M_DLLAPI M_BOOL
+m_CBTree_set(m_CBTree* const bt,
+        const M_ID key,
+        const M_PTR val,
+        M_PTR* const prev);
+
+/**
+ *  \brief Count the nodes inside a tree.
+ */
+#define m_CBTree_count( bt ) \
+        ((bt)->num)
+
+/**
+ *  \brief Apply a function to each value, in key order.
+ */
+M_DLLAPI M_VOID
+m_CBTree_traverse(const m_CBTree* const bt,
+        M_VOID (* const func)(M_PTR));
+
+/**
+ *  \brief Apply a function to each value, in key order (userdata version).
+ */
+M_DLLAPI M_VOID
+m_CBTree_traverse2(const m_CBTree* const bt,
+        M_VOID (* const func)(M_PTR, M_PTR),
+        M_PTR userdata);
+
+/**
+ *  \typedef m_CBTreeIter
+ */
+typedef struct _m_CBTreeIter m_CBTreeIter;
+
+/**
+ *  \struct _m_CBTreeIter
+ *  \brief Iterator over a compact btree, in key order.
+ *  \see m_BTreeIter
+ */
+struct _m_CBTreeIter
+{
+  const m_CBTree* bt;
+  M_UINT32 depth; /* length of path, 0 when past either end */
+  M_UINT32 path[M_CBTREE_MAXDEPTH];
+};
+
+/**
+ *  \brief Get the current node of an iterator (or NULL).
+ */
+#define m_CBTreeIter_node( it ) \
+        ((it)->depth ? &(it)->bt->nodes[(it)->path[(it)->depth - 1]] : NULL)
+
+/**
+ *  \brief Place an iterator on the lowest key of a tree.
+ *  \return M_TRUE, or M_FALSE if the tree is empty.
+ */
+M_DLLAPI M_BOOL
+m_CBTreeIter_begin(m_CBTreeIter* const it,
+        const m_CBTree* const bt);
+
+/**
+ *  \brief Place an iterator on the lowest key not less than a key.
+ *  \return M_TRUE, or M_FALSE if all keys are less than key.
+ */
+M_DLLAPI M_BOOL
+m_CBTreeIter_seek(m_CBTreeIter* const it,
+        const m_CBTree* const bt,
+        const M_ID key);
+
+/**
+ *  \brief Move an iterator to the next key.
+ *  \return M_TRUE, or M_FALSE if there is no next key.
+ */
+M_DLLAPI M_BOOL
+m_CBTreeIter_next(m_CBTreeIter* const it);
+
+#ifndef NDEBUG
+
+/**
+ *  \brief Check order, balance and count of the tree.
+ */
+M_DLLAPI M_BOOL
+m_CBTree_check(const m_CBTree* const bt);
+
+#endif /* NDEBUG */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !M_CBTREE_H */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
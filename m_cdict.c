@@ -0,0 +1,359 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+#ifndef _MSC_VER
+#define _POSIX_C_SOURCE 200112L /* for pthread_rwlock_t */
+#endif
+
+#include "m_cdict.h"
+
+#include "m_hdict.h"
+#include "m_memcnt.h"
+#include "m_mempool.h"
+#include "m_mutex.h"
+
+#undef M_TRACE
+#if defined(M_TRACE_MODE) && defined(M_TRACE_CDICT)
+#define M_TRACE(msg, ...) _M_TRACER("-- CDict -- "msg, __VA_ARGS__)
+#else
+#define M_TRACE(moo, ...)
+#endif
+
+struct _m_CDictShard
+{
+  M_RWLOCK lock;
+  m_HDict dict;
+#ifndef M_NO_MEMPOOL
+  m_MemPool* pool;
+#endif
+};
+
+/* distance between shards, so that no two share a cache line */
+#define M_CDICT_STRIDE \
+  ((sizeof(m_CDictShard) + M_CACHELINE - 1) / M_CACHELINE * M_CACHELINE)
+
+#define M_CDICT_SHARD(d, i) \
+  ((m_CDictShard*)((M_CHAR*)(d)->shards + (M_SZ)(i) * M_CDICT_STRIDE))
+
+/*
+ *  Switch to the pool of a shard, for the time its write lock is held.
+ */
+#ifndef M_NO_MEMPOOL
+#define M_CDICT_POOL_ENTER(sh) \
+  m_MemPool* const _pool = *m_MemPool_get(); m_MemPool_set((sh)->pool)
+#define M_CDICT_POOL_LEAVE() m_MemPool_set(_pool)
+#else
+#define M_CDICT_POOL_ENTER(sh)
+#define M_CDICT_POOL_LEAVE()
+#endif
+
+/*
+ *  Shard for a hash, from its high bits (the low bits are used by the
+ *  shard itself). Shifting one bit first gives 0 when there is one shard.
+ */
+static m_CDictShard*
+_m_CDict_shard(const m_CDict* const d,
+        const M_ID hash)
+{
+  return M_CDICT_SHARD(d, (hash >> 1) >> d->shift);
+}
+
+M_BOOL
+m_CDict_new(m_CDict** const d)
+{
+  assert(d);
+  M_TRACE("new ("M_PTR_FMT")", d);
+  if (!d) return M_FALSE;
+
+  /* not from the mempool of this thread, the dict is shared */
+  *d = _M_MALLOC(sizeof(m_CDict));
+  assert(*d);
+  if (!*d) return M_FALSE;
+  if (!m_CDict_init(*d))
+  {
+    _M_FREE(*d);
+    *d = NULL;
+    return M_FALSE;
+  }
+  return M_TRUE;
+}
+
+M_BOOL
+m_CDict_init2(m_CDict* const d,
+        const M_UINT32 nshards,
+        const m_hash_fn_t hash_fn,
+        const M_ID seed)
+{
+  const M_UINT32 n = nshards ? nshards : M_CDICT_SHARDS;
+  M_UINT32 i, bits = 0;
+
+  assert(d);
+  assert(n <= M_CDICT_MAXSHARDS && !(n & (n - 1)));
+  M_TRACE("init2 ("M_PTR_FMT") shards (%u)", d, (unsigned) n);
+  if (!d || n > M_CDICT_MAXSHARDS || (n & (n - 1))) return M_FALSE;
+
+  while ((1U << bits) < n) ++bits;
+
+  d->block = _M_MALLOC(n * M_CDICT_STRIDE + M_CACHELINE);
+  assert(d->block);
+  if (!d->block) return M_FALSE;
+  d->shards = (m_CDictShard*)(((M_SZ) d->block + M_CACHELINE - 1)
+      / M_CACHELINE * M_CACHELINE);
+  d->nshards = n;
+  d->shift = sizeof(M_ID) * 8 - 1 - bits;
+  d->finalize_fn = NULL;
+  d->hash_fn = hash_fn ? hash_fn : &M_HASH_DEFAULT;
+  d->seed = seed;
+
+  for (i = 0; i < n; ++i)
+  {
+    m_CDictShard* const sh = M_CDICT_SHARD(d, i);
+#ifndef M_NO_MEMPOOL
+    if (!m_MemPool_new(&sh->pool, 0))
+    {
+      while (i--)
+      {
+        m_RWLock_fini(M_CDICT_SHARD(d, i)->lock);
+        m_MemPool_delete(&M_CDICT_SHARD(d, i)->pool);
+      }
+      _M_FREE(d->block);
+      return M_FALSE;
+    }
+#endif
+    m_RWLock_init(sh->lock);
+    m_HDict_init2(&sh->dict, d->hash_fn, seed);
+  }
+  return M_TRUE;
+}
+
+M_BOOL
+m_CDict_init(m_CDict* const d)
+{
+  return m_CDict_init2(d, 0, NULL, 0);
+}
+
+M_VOID
+m_CDict_fini(m_CDict* const d)
+{
+  M_UINT32 i;
+
+  assert(d);
+  M_TRACE("fini ("M_PTR_FMT")", d);
+  if (!d) return;
+
+  for (i = 0; i < d->nshards; ++i)
+  {
+    m_CDictShard* const sh = M_CDICT_SHARD(d, i);
+#ifndef M_NO_MEMPOOL
+    /* everything in the shard came from its pool, dropped at once */
+    if (d->finalize_fn) m_HDict_traverse(&sh->dict, d->finalize_fn);
+    m_MemPool_delete(&sh->pool);
+#else
+    sh->dict.finalize_fn = d->finalize_fn;
+    m_HDict_fini(&sh->dict);
+#endif
+    m_RWLock_fini(sh->lock);
+  }
+  _M_FREE(d->block);
+  d->block = NULL;
+  d->shards = NULL;
+  d->nshards = 0;
+}
+
+M_VOID
+m_CDict_delete(m_CDict** const d)
+{
+  assert(d && *d);
+  M_TRACE("delete ("M_PTR_FMT")", *d);
+  if (!d || !*d) return;
+
+  m_CDict_fini(*d);
+  _M_FREE(*d);
+  *d = NULL;
+}
+
+M_SZ
+m_CDict_count(m_CDict* const d)
+{
+  M_SZ cnt = 0;
+  M_UINT32 i;
+
+  assert(d);
+  if (!d) return 0;
+
+  for (i = 0; i < d->nshards; ++i)
+  {
+    m_CDictShard* const sh = M_CDICT_SHARD(d, i);
+    m_RWLock_rdlock(sh->lock);
+    cnt += m_HDict_count(&sh->dict);
+    m_RWLock_rdunlock(sh->lock);
+  }
+  return cnt;
+}
+
+M_PTR
+m_CDict_get(m_CDict* const d,
+        const M_CHAR* const key)
+{
+  m_CDictShard* sh;
+  M_PTR val;
+  M_SZ len;
+  M_ID hash;
+
+  assert(d);
+  assert(key && *key);
+  M_TRACE("get ("M_PTR_FMT") key ("M_STR_FMT")", d, key);
+  if (!d || !key || !*key) return NULL;
+
+  len = strlen(key);
+  hash = (*d->hash_fn)(key, len, d->seed);
+  sh = _m_CDict_shard(d, hash);
+  m_RWLock_rdlock(sh->lock);
+  val = m_HDict_get_hashed(&sh->dict, key, len, hash);
+  m_RWLock_rdunlock(sh->lock);
+  return val;
+}
+
+M_BOOL
+m_CDict_set(m_CDict* const d,
+        const M_CHAR* const key,
+        const M_PTR const val,
+        M_PTR* const prev)
+{
+  m_CDictShard* sh;
+  M_BOOL ret;
+  M_SZ len;
+  M_ID hash;
+
+  assert(d);
+  assert(key && *key);
+  M_TRACE("set ("M_PTR_FMT") key ("M_STR_FMT") val ("M_PTR_FMT")", d, key, val);
+  if (!d || !key || !*key) return M_FALSE;
+
+  len = strlen(key);
+  hash = (*d->hash_fn)(key, len, d->seed);
+  sh = _m_CDict_shard(d, hash);
+  m_RWLock_wrlock(sh->lock);
+  {
+    M_CDICT_POOL_ENTER(sh);
+    ret = m_HDict_set_hashed(&sh->dict, key, len, hash, val, prev);
+    M_CDICT_POOL_LEAVE();
+  }
+  m_RWLock_wrunlock(sh->lock);
+  return ret;
+}
+
+M_PTR
+m_CDict_unset(m_CDict* const d,
+        const M_CHAR* const key)
+{
+  m_CDictShard* sh;
+  M_PTR val;
+  M_SZ len;
+  M_ID hash;
+
+  assert(d);
+  assert(key && *key);
+  M_TRACE("unset ("M_PTR_FMT") key ("M_STR_FMT")", d, key);
+  if (!d || !key || !*key) return NULL;
+
+  len = strlen(key);
+  hash = (*d->hash_fn)(key, len, d->seed);
+  sh = _m_CDict_shard(d, hash);
+  m_RWLock_wrlock(sh->lock);
+  {
+    M_CDICT_POOL_ENTER(sh);
+    val = m_HDict_unset_hashed(&sh->dict, key, len, hash);
+    M_CDICT_POOL_LEAVE();
+  }
+  m_RWLock_wrunlock(sh->lock);
+  return val;
+}
+
+M_VOID
+m_CDict_traverse2(m_CDict* const d,
+        M_VOID (* const func)(M_PTR, M_PTR),
+        M_PTR const udata)
+{
+  M_UINT32 i;
+
+  assert(d);
+  assert(func);
+  M_TRACE("traverse2 ("M_PTR_FMT")", d);
+  if (!d || !func) return;
+
+  for (i = 0; i < d->nshards; ++i)
+  {
+    m_CDictShard* const sh = M_CDICT_SHARD(d, i);
+    m_RWLock_rdlock(sh->lock);
+    m_HDict_traverse2(&sh->dict, func, udata);
+    m_RWLock_rdunlock(sh->lock);
+  }
+}
+
+M_VOID
+m_CDict_traverse_keyval2(m_CDict* const d,
+        M_VOID (* const func)(m_String*, M_PTR, M_PTR),
+        M_PTR const udata)
+{
+  M_UINT32 i;
+
+  assert(d);
+  assert(func);
+  M_TRACE("traverse_keyval2 ("M_PTR_FMT")", d);
+  if (!d || !func) return;
+
+  for (i = 0; i < d->nshards; ++i)
+  {
+    m_CDictShard* const sh = M_CDICT_SHARD(d, i);
+    m_RWLock_rdlock(sh->lock);
+    m_HDict_traverse_keyval2(&sh->dict, func, udata);
+    m_RWLock_rdunlock(sh->lock);
+  }
+}
+
+#ifndef NDEBUG
+
+M_BOOL
+m_CDict_check(m_CDict* const d)
+{
+  M_UINT32 i;
+  M_BOOL ok = M_TRUE;
+
+  assert(d);
+
+  for (i = 0; i < d->nshards && ok; ++i)
+  {
+    m_CDictShard* const sh = M_CDICT_SHARD(d, i);
+    m_RWLock_rdlock(sh->lock);
+    ok = m_HDict_check(&sh->dict);
+    m_RWLock_rdunlock(sh->lock);
+  }
+  return ok;
+}
+
+#endif /* NDEBUG */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
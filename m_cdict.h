@@ -0,0 +1,218 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+/**
+ *  \file m_cdict.h
+ *  \brief Hash table for strings, shared between threads.
+ *  \author Stanislas Marquis <stan@astrorigin.com>
+ */
+
+/*
+ *  Same API as m_HDict, but elements are spread over a number of shards,
+ *  each one an m_HDict with its own read-write lock, chosen by the high
+ *  bits of the hash of the key.
+ *
+ *  Readers only share a lock with readers of the same shard, and writers
+ *  only block the shard they write to, so that lookups from many threads
+ *  run in parallel, instead of queuing behind one mutex.
+ *
+ *  Each shard allocates from its own memory pool, set while the write
+ *  lock is held, since memory pools are per thread.
+ *
+ *  The dict does not hold references to its values: a value returned by
+ *  get may be removed by another thread at any time after that, and must
+ *  be kept alive by the caller until no reader can use it.
+ */
+
+#ifndef M_CDICT_H
+#define M_CDICT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "m_h.h"
+#include "m_hash.h"
+#include "m_string.h"
+
+/**
+ *  \brief Default number of shards (a power of 2).
+ */
+#define M_CDICT_SHARDS  64
+
+/**
+ *  \brief Maximum number of shards.
+ */
+#define M_CDICT_MAXSHARDS  4096
+
+/**
+ *  \typedef m_CDictShard
+ *  \note Opaque type.
+ */
+typedef struct _m_CDictShard m_CDictShard;
+
+/**
+ *  \typedef m_CDict
+ */
+typedef struct _m_CDict m_CDict;
+
+/**
+ *  \struct _m_CDict
+ */
+struct _m_CDict
+{
+  M_PTR block; /* memory holding the shards */
+  m_CDictShard* shards; /* shards, each on its own cache lines */
+  M_UINT32 nshards; /* number of shards (a power of 2) */
+  M_UINT32 shift; /* for the shard index, from the hash */
+  M_VOID (*finalize_fn)(M_PTR);
+  m_hash_fn_t hash_fn;
+  M_ID seed;
+};
+
+/**
+ *  \brief Allocate for a new concurrent dict.
+ *  \param d The dict.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_CDict_new(m_CDict** const d);
+
+/**
+ *  \brief Initialize a concurrent dict (extended version).
+ *  \param d The dict.
+ *  \param nshards Number of shards (a power of 2), or 0 for M_CDICT_SHARDS.
+ *  \param hash_fn Hash function for keys, or NULL for M_HASH_DEFAULT.
+ *  \param seed Seed given to hash_fn.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_CDict_init2(m_CDict* const d,
+        const M_UINT32 nshards,
+        const m_hash_fn_t hash_fn,
+        const M_ID seed);
+
+/**
+ *  \brief Initialize a concurrent dict, with M_CDICT_SHARDS shards.
+ */
+M_DLLAPI M_BOOL
+m_CDict_init(m_CDict* const d);
+
+/**
+ *  \brief Finalize a concurrent dict.
+ *  \note No other thread may use the dict at that time.
+ */
+M_DLLAPI M_VOID
+m_CDict_fini(m_CDict* const d);
+
+/**
+ *  \brief Delete a concurrent dict.
+ */
+M_DLLAPI M_VOID
+m_CDict_delete(m_CDict** const d);
+
+/**
+ *  \brief Get number of elements in the dict.
+ *
+ *  Shards are counted one after the other, so the result may be out of
+ *  date while other threads write.
+ */
+M_DLLAPI M_SZ
+m_CDict_count(m_CDict* const d);
+
+/**
+ *  \brief Get an elem from the dict or NULL.
+ *  \param d The dict (not NULL).
+ *  \param key The key string (not NULL nor empty).
+ *  \return Element found, or NULL if nothing found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_CDict_get(m_CDict* const d,
+        const M_CHAR* const key);
+
+/**
+ *  \brief Set or insert an element in the dict.
+ *  \param d The dict (not NULL).
+ *  \param key The key string (not NULL nor empty).
+ *  \param val The pointer value.
+ *  \param prev If not NULL, return value replaced, or value set if there was none.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_CDict_set(m_CDict* const d,
+        const M_CHAR* const key,
+        const M_PTR const val,
+        M_PTR* const prev);
+
+/**
+ *  \brief Remove an element from the dict.
+ *  \param d The dict.
+ *  \param key The key string.
+ *  \return Element that was removed, or NULL if not found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_CDict_unset(m_CDict* const d,
+        const M_CHAR* const key);
+
+/**
+ *  \brief Apply a function to each value in the dict (with userdata).
+ *  \param d The dict.
+ *  \param traverse_fn The function to apply.
+ *  \param userdata Data passed to traverse_fn.
+ *  \note Each shard is read-locked while traverse_fn runs on its elements:
+ *  traverse_fn must not call the dict at all. Taking the read lock again
+ *  from the same thread can deadlock once a writer waits (SRW locks,
+ *  writer-preferring rwlocks).
+ */
+M_DLLAPI M_VOID
+m_CDict_traverse2(m_CDict* const d,
+        M_VOID (* const traverse_fn)(M_PTR val, M_PTR udata),
+        M_PTR const userdata);
+
+/**
+ *  \brief Apply a function to each key and value in the dict (with userdata).
+ *  \see m_CDict_traverse2
+ */
+M_DLLAPI M_VOID
+m_CDict_traverse_keyval2(m_CDict* const d,
+        M_VOID (* const traverse_fn)(m_String* key, M_PTR val, M_PTR udata),
+        M_PTR const userdata);
+
+#ifndef NDEBUG
+
+/**
+ *  \brief Check all shards are consistent.
+ */
+M_DLLAPI M_BOOL
+m_CDict_check(m_CDict* const d);
+
+#endif /* NDEBUG */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !M_CDICT_H */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
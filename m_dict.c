@@ -42,17 +42,31 @@ m_Dict_new(m_Dict** const d)
   M_TRACE("new ("M_PTR_FMT")", d);
   if (!d) return M_FALSE;
 
-  return m_BTree_new(d);
+  *d = M_MALLOC(sizeof(m_Dict));
+  assert(*d);
+  if (!*d) return M_FALSE;
+  return m_Dict_init(*d);
 }
 
 M_BOOL
-m_Dict_init(m_Dict* const d)
+m_Dict_init2(m_Dict* const d,
+        const m_hash_fn_t hash_fn,
+        const M_ID seed)
 {
   assert(d);
-  M_TRACE("init ("M_PTR_FMT")", d);
+  M_TRACE("init2 ("M_PTR_FMT")", d);
   if (!d) return M_FALSE;
 
-  return m_BTree_init((m_BTree*)d);
+  d->finalize_fn = NULL;
+  d->hash_fn = hash_fn ? hash_fn : &M_HASH_DEFAULT;
+  d->seed = seed;
+  return m_BTree_init(&d->tree);
+}
+
+M_BOOL
+m_Dict_init(m_Dict* const d)
+{
+  return m_Dict_init2(d, NULL, 0);
 }
 
 M_VOID
@@ -67,8 +81,8 @@ m_Dict_fini(m_Dict* const d)
     m_Dict_traverse(d, d->finalize_fn);
     d->finalize_fn = NULL;
   }
-  m_BTree_traverse((m_BTree*)d, (M_VOID(*)(M_PTR))&m_DictNode_list_delete);
-  m_BTree_fini((m_BTree*)d);
+  m_BTree_traverse(&d->tree, (M_VOID(*)(M_PTR))&m_DictNode_list_delete);
+  m_BTree_fini(&d->tree);
 }
 
 M_VOID
@@ -86,64 +100,159 @@ m_Dict_delete(m_Dict** const d)
 M_ID
 m_Dict_hash(const M_PTR k,
         const M_SZ len)
-{ /* this function is public domain */
-  M_UCHAR* p = (M_UCHAR*) k;
-  M_ID h = 0;
-  M_SZ i;
-
-  for (i = 0; i < len; i++)
-  {
-    h += p[i];
-    h += ( h << 10 );
-    h ^= ( h >> 6 );
-  }
-  h += ( h << 3 );
-  h ^= ( h >> 11 );
-  h += ( h << 15 );
-  return h;
+{
+  return m_hash_oaat(k, len, 0);
 }
 
+/*
+ *  Compare a node key with a key of known length.
+ *  Lengths are compared first, so that most mismatches are cheap.
+ */
+#define _m_DictNode_is(nd, k, l) \
+  ((nd)->len == (l) && !memcmp((nd)->key, (k), (l)))
+
 M_PTR
 m_Dict_get(const m_Dict* const d,
         const M_CHAR* const key)
+{
+  assert(key && *key);
+  if (!key || !*key) return NULL;
+
+  return m_Dict_get_len(d, key, strlen(key));
+}
+
+M_PTR
+m_Dict_get_len(const m_Dict* const d,
+        const M_CHAR* const key,
+        const M_SZ len)
 {
   m_DictNode* nd;
-  M_ID k;
 
   assert(d);
-  assert(key && *key);
-  M_TRACE("get ("M_PTR_FMT") key ("M_STR_FMT")", d, key);
-  if (!d || !key || !*key) return NULL;
+  assert(key && len);
+  M_TRACE("get ("M_PTR_FMT") key (%.*s)", d, (int) len, key);
+  if (!d || !key || !len) return NULL;
 
-  k = m_Dict_hash(key, strlen(key));
-  nd = m_BTree_get((m_BTree*)d, k);
+  nd = m_BTree_get(&d->tree, (*d->hash_fn)(key, len, d->seed));
   for (; nd; nd = nd->next)
   {
-    if (!strcmp(nd->key.data, key)) return nd->val;
+    if (_m_DictNode_is(nd, key, len)) return nd->val;
   }
   return NULL;
 }
 
+/*
+ *  Hash a group of keys, look them all up in the tree at once, then ask
+ *  for the nodes found before comparing keys.
+ */
+static M_VOID
+_m_Dict_get_many(const m_Dict* const d,
+        const M_CHAR* const* const keys,
+        const M_SZ* const lens,
+        M_PTR* const vals,
+        const M_SZ num)
+{
+  M_ID hashes[M_BTREE_GROUP];
+  M_PTR found[M_BTREE_GROUP];
+  M_SZ len[M_BTREE_GROUP];
+  m_DictNode* nd;
+  M_SZ i, j, n;
+
+  assert(d);
+  assert(keys || !num);
+  assert(vals || !num);
+  M_TRACE("get many ("M_PTR_FMT") num ("M_SZ_FMT")", d, num);
+  if (!d || !keys || !vals) return;
+
+  for (i = 0; i < num; i += n)
+  {
+    n = M_MIN(num - i, (M_SZ) M_BTREE_GROUP);
+    for (j = 0; j < n; ++j)
+    {
+      len[j] = !keys[i + j] ? 0 : lens ? lens[i + j] : strlen(keys[i + j]);
+      hashes[j] = len[j] ? (*d->hash_fn)((M_PTR) keys[i + j], len[j], d->seed)
+          : 0;
+    }
+    m_BTree_get_many(&d->tree, hashes, found, n);
+    for (j = 0; j < n; ++j)
+    {
+      if (found[j]) M_PREFETCH(found[j]);
+    }
+    for (j = 0; j < n; ++j)
+    {
+      vals[i + j] = NULL;
+      if (!len[j]) continue;
+      for (nd = found[j]; nd; nd = nd->next)
+      {
+        if (_m_DictNode_is(nd, keys[i + j], len[j]))
+        {
+          vals[i + j] = nd->val;
+          break;
+        }
+      }
+    }
+  }
+}
+
+M_VOID
+m_Dict_get_many(const m_Dict* const d,
+        const M_CHAR* const* const keys,
+        M_PTR* const vals,
+        const M_SZ num)
+{
+  _m_Dict_get_many(d, keys, NULL, vals, num);
+}
+
+M_VOID
+m_Dict_get_many_len(const m_Dict* const d,
+        const M_CHAR* const* const keys,
+        const M_SZ* const lens,
+        M_PTR* const vals,
+        const M_SZ num)
+{
+  assert(lens || !num);
+  if (!lens && num) return;
+
+  _m_Dict_get_many(d, keys, lens, vals, num);
+}
+
 M_BOOL
 m_Dict_set(m_Dict* const d,
         const M_CHAR* const key,
         const M_PTR const val,
         M_PTR* const prev)
+{
+  assert(key && *key);
+  if (!key || !*key) return M_FALSE;
+
+  return m_Dict_set_len(d, key, strlen(key), val, prev);
+}
+
+M_BOOL
+m_Dict_set_len(m_Dict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_PTR const val,
+        M_PTR* const prev)
 {
   M_ID k;
   m_DictNode* nd;
 
   assert(d);
-  assert(key && *key);
-  M_TRACE("set ("M_PTR_FMT") key ("M_STR_FMT") val ("M_PTR_FMT")", d, key, val);
-  if (!d || !key || !*key) return M_FALSE;
+  assert(key && len);
+  M_TRACE("set ("M_PTR_FMT") key (%.*s) val ("M_PTR_FMT")", d, (int) len, key, val);
+  if (!d || !key || !len) return M_FALSE;
 
-  k = m_Dict_hash(key, strlen(key));
-  nd = m_BTree_get((m_BTree*)d, k);
+  k = (*d->hash_fn)(key, len, d->seed);
+  nd = m_BTree_get(&d->tree, k);
   if (nd == NULL)
   {
-    if (!m_DictNode_new(&nd, key, val)) return M_FALSE;
-    if (m_BTree_insert((m_BTree*)d, k, nd) != 1) return M_FALSE;
+    if (!m_DictNode_new(&nd, key, len, val)) return M_FALSE;
+    if (m_BTree_insert(&d->tree, k, nd) != 1)
+    {
+      m_DictNode_delete(&nd);
+      return M_FALSE;
+    }
     if (prev) *prev = (M_PTR) val;
   }
   else
@@ -151,13 +260,13 @@ m_Dict_set(m_Dict* const d,
     m_DictNode* last = NULL;
     for (; nd; nd = nd->next)
     {
-      if (!strcmp(nd->key.data, key)) break;
+      if (_m_DictNode_is(nd, key, len)) break;
       last = nd;
     }
     if (nd == NULL)
     {
       assert(last);
-      if (!m_DictNode_new(&nd, key, val)) return M_FALSE;
+      if (!m_DictNode_new(&nd, key, len, val)) return M_FALSE;
       last->next = nd;
       if (prev) *prev = (M_PTR) val;
     }
@@ -173,24 +282,35 @@ m_Dict_set(m_Dict* const d,
 M_PTR
 m_Dict_unset(m_Dict* const d,
         const M_CHAR* const key)
+{
+  assert(key && *key);
+  if (!key || !*key) return NULL;
+
+  return m_Dict_unset_len(d, key, strlen(key));
+}
+
+M_PTR
+m_Dict_unset_len(m_Dict* const d,
+        const M_CHAR* const key,
+        const M_SZ len)
 {
   m_DictNode* nd, *first, *prev = NULL;
   M_ID k;
 
   assert(d);
-  assert(key && *key);
-  M_TRACE("unset ("M_PTR_FMT") key ("M_STR_FMT")", d, key);
-  if (!d || !key || !*key) return NULL;
+  assert(key && len);
+  M_TRACE("unset ("M_PTR_FMT") key (%.*s)", d, (int) len, key);
+  if (!d || !key || !len) return NULL;
 
-  k = m_Dict_hash(key, strlen(key));
-  nd = m_BTree_get((m_BTree*)d, k);
+  k = (*d->hash_fn)(key, len, d->seed);
+  nd = m_BTree_get(&d->tree, k);
   if (!nd) return NULL;
   if (!nd->next)
   {
-    if (!strcmp(nd->key.data, key))
+    if (_m_DictNode_is(nd, key, len))
     {
       M_PTR val = nd->val;
-      m_BTree_remove((m_BTree*)d, k, NULL);
+      m_BTree_remove(&d->tree, k, NULL);
       m_DictNode_delete(&nd);
       return val;
     }
@@ -199,10 +319,10 @@ m_Dict_unset(m_Dict* const d,
   first = nd;
   for (; nd; nd = nd->next)
   {
-    if (!strcmp(nd->key.data, key))
+    if (_m_DictNode_is(nd, key, len))
     {
       M_PTR val = nd->val;
-      if (nd == first) m_BTree_set((m_BTree*)d, k, nd->next, NULL);
+      if (nd == first) m_BTree_set(&d->tree, k, nd->next, NULL);
       m_SLList_TAKE(&first, nd, prev);
       m_DictNode_delete(&nd);
       return val;
@@ -223,7 +343,7 @@ m_Dict_traverse(m_Dict* const d,
   assert(func);
   if (!d || !func) return;
 
-  nd = m_BTree_least((m_BTree*)d);
+  nd = m_BTree_least(&d->tree);
   for (; nd; nd = m_BTree_next(nd))
   {
     n = (m_DictNode*) nd->val;
@@ -246,7 +366,7 @@ m_Dict_traverse2(m_Dict* const d,
   assert(func);
   if (!d || !func) return;
 
-  nd = m_BTree_least((m_BTree*)d);
+  nd = m_BTree_least(&d->tree);
   for (; nd; nd = m_BTree_next(nd))
   {
     n = (m_DictNode*) nd->val;
@@ -263,18 +383,20 @@ m_Dict_traverse_keyval(m_Dict* const d,
 {
   m_BTNode* nd;
   m_DictNode* n;
+  m_String key;
 
   assert(d);
   assert(func);
   if (!d || !func) return;
 
-  nd = m_BTree_least((m_BTree*)d);
+  nd = m_BTree_least(&d->tree);
   for (; nd; nd = m_BTree_next(nd))
   {
     n = (m_DictNode*) nd->val;
     for (; n; n = n->next)
     {
-      (*func)(&n->key, n->val);
+      m_String_view(&key, n->key, n->len);
+      (*func)(&key, n->val);
     }
   }
 }
@@ -286,18 +408,20 @@ m_Dict_traverse_keyval2(m_Dict* const d,
 {
   m_BTNode* nd;
   m_DictNode* n;
+  m_String key;
 
   assert(d);
   assert(func);
   if (!d || !func) return;
 
-  nd = m_BTree_least((m_BTree*)d);
+  nd = m_BTree_least(&d->tree);
   for (; nd; nd = m_BTree_next(nd))
   {
     n = (m_DictNode*) nd->val;
     for (; n; n = n->next)
     {
-      (*func)(&n->key, n->val, userdata);
+      m_String_view(&key, n->key, n->len);
+      (*func)(&key, n->val, userdata);
     }
   }
 }
@@ -305,16 +429,23 @@ m_Dict_traverse_keyval2(m_Dict* const d,
 M_BOOL
 m_DictNode_new(m_DictNode** const nd,
         const M_CHAR* const key,
+        const M_SZ len,
         const M_PTR const val)
 {
   assert(nd);
-  if (!nd) return M_FALSE;
+  assert(key && len);
+  if (!nd || !key || !len) return M_FALSE;
 
-  *nd = M_MALLOC(sizeof(m_DictNode));
+  *nd = M_MALLOC(m_DictNode_size(len));
   assert(*nd);
   if (!*nd) return M_FALSE;
 
-  return m_DictNode_init(*nd, key, val);
+  (*nd)->next = NULL;
+  (*nd)->val = (M_PTR) val;
+  (*nd)->len = len;
+  memcpy((*nd)->key, key, len);
+  (*nd)->key[len] = '\0';
+  return M_TRUE;
 }
 
 M_VOID
@@ -323,8 +454,7 @@ m_DictNode_delete(m_DictNode** const nd)
   assert(nd && *nd);
   if (!nd || !*nd) return;
 
-  m_DictNode_fini(*nd);
-  M_FREE(*nd, sizeof(m_DictNode));
+  M_FREE(*nd, m_DictNode_size((*nd)->len));
   *nd = NULL;
 }
 
@@ -343,31 +473,6 @@ m_DictNode_list_delete(m_DictNode* nd)
   }
 }
 
-M_BOOL
-m_DictNode_init(m_DictNode* const nd,
-        const M_CHAR* const key,
-        const M_PTR const val)
-{
-  assert(nd);
-  if (!nd) return M_FALSE;
-
-  nd->next = NULL;
-  if (!m_String_init(&nd->key, key)) return M_FALSE;
-  nd->val = (M_PTR) val;
-  return M_TRUE;
-}
-
-M_VOID
-m_DictNode_fini(m_DictNode* const nd)
-{
-  assert(nd);
-  if (!nd) return;
-
-  nd->next = NULL;
-  m_String_fini(&nd->key);
-  nd->val = NULL;
-}
-
 #ifndef NDEBUG
 
 M_VOID
@@ -380,14 +485,14 @@ m_Dict_debug(const m_Dict* const d)
 
   printf("-- Dict -- debug ("M_PTR_FMT"):\n", d);
 
-  btn = m_BTree_least((m_BTree*)d);
+  btn = m_BTree_least(&d->tree);
   for (; btn; btn = m_BTree_next(btn))
   {
     dn = btn->val;
     for (; dn; dn = dn->next)
     {
       printf("--     \"%s\": ("M_PTR_FMT")\n",
-          (char*)dn->key.data, dn->val);
+          dn->key, dn->val);
     }
   }
 
@@ -40,6 +40,7 @@ extern "C" {
 
 #include "m_btree.h"
 #include "m_h.h"
+#include "m_hash.h"
 #include "m_mempool.h"
 #include "m_string.h"
 
@@ -50,18 +51,42 @@ typedef struct _m_DictNode m_DictNode;
 
 /**
  *  \struct _m_DictNode
+ *
+ *  The key is stored in the same allocation as the node, null-terminated.
  */
 struct _m_DictNode
 {
   m_DictNode* next;
-  m_String key;
   M_PTR val;
+  M_SZ len; /* length of key */
+  M_CHAR key[];
 };
 
+/**
+ *  \brief Nodes are allocated by multiples of this size.
+ *
+ *  With the mempool, that makes nodes of similar key lengths share
+ *  the same bucket.
+ */
+#define M_DICTNODE_QUANTA  16
+
 /**
  *  \typedef m_Dict
  */
-typedef m_BTree m_Dict;
+typedef struct _m_Dict m_Dict;
+
+/**
+ *  \struct _m_Dict
+ *
+ *  A tree of hashes, each holding the list of nodes with keys of that hash.
+ */
+struct _m_Dict
+{
+  m_BTree tree;
+  M_VOID (*finalize_fn)(M_PTR);
+  m_hash_fn_t hash_fn;
+  M_ID seed;
+};
 
 #include "m_dict_priv.h"
 
@@ -73,8 +98,23 @@ typedef m_BTree m_Dict;
 M_DLLAPI M_BOOL
 m_Dict_new(m_Dict** const d);
 
+/**
+ *  \brief Initialize a dict (extended version).
+ *  \param d The dict.
+ *  \param hash_fn Hash function for keys, or NULL for M_HASH_DEFAULT.
+ *  \param seed Seed given to hash_fn.
+ *  \return M_TRUE, or M_FALSE on error.
+ *  \see m_hash_seed
+ */
+M_DLLAPI M_BOOL
+m_Dict_init2(m_Dict* const d,
+        const m_hash_fn_t hash_fn,
+        const M_ID seed);
+
 /**
  *  \brief Initialize a dict.
+ *
+ *  Keys are hashed with M_HASH_DEFAULT, seed 0.
  */
 M_DLLAPI M_BOOL
 m_Dict_init(m_Dict* const d);
@@ -92,7 +132,8 @@ M_DLLAPI M_VOID
 m_Dict_delete(m_Dict** const d);
 
 /**
- *  \brief Our hash function.
+ *  \brief Our former hash function.
+ *  \see m_hash_oaat
  */
 M_DLLAPI M_ID
 m_Dict_hash(const M_PTR k,
@@ -108,6 +149,49 @@ M_DLLAPI M_PTR
 m_Dict_get(const m_Dict* const d,
         const M_CHAR* const key);
 
+/**
+ *  \brief Get an elem from the dict or NULL (key of known length).
+ *  \param d The dict (not NULL).
+ *  \param key The key (not NULL, without null chars).
+ *  \param len Length of key (not 0).
+ *  \return Element found, or NULL if nothing found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_Dict_get_len(const m_Dict* const d,
+        const M_CHAR* const key,
+        const M_SZ len);
+
+/**
+ *  \brief Get the elems of many keys from the dict.
+ *  \param d The dict (not NULL).
+ *  \param keys The key strings.
+ *  \param vals Set to the elements found, or NULL.
+ *  \param num Number of keys.
+ *
+ *  Faster than as many calls to m_Dict_get, by overlapping the lookups
+ *  M_BTREE_GROUP at a time (see m_BTree_get_many).
+ */
+M_DLLAPI M_VOID
+m_Dict_get_many(const m_Dict* const d,
+        const M_CHAR* const* const keys,
+        M_PTR* const vals,
+        const M_SZ num);
+
+/**
+ *  \brief Get the elems of many keys from the dict (keys of known length).
+ *  \param d The dict (not NULL).
+ *  \param keys The keys.
+ *  \param lens The lengths of keys.
+ *  \param vals Set to the elements found, or NULL.
+ *  \param num Number of keys.
+ */
+M_DLLAPI M_VOID
+m_Dict_get_many_len(const m_Dict* const d,
+        const M_CHAR* const* const keys,
+        const M_SZ* const lens,
+        M_PTR* const vals,
+        const M_SZ num);
+
 /**
  *  \brief Set or insert an element in the dict.
  *  \param d The dict (not NULL).
@@ -122,6 +206,22 @@ m_Dict_set(m_Dict* const d,
         const M_PTR const val,
         M_PTR* const prev);
 
+/**
+ *  \brief Set or insert an element in the dict (key of known length).
+ *  \param d The dict (not NULL).
+ *  \param key The key (not NULL, without null chars).
+ *  \param len Length of key (not 0).
+ *  \param val The pointer value.
+ *  \param prev If not NULL, return value replaced, or value set if there was none.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_Dict_set_len(m_Dict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_PTR const val,
+        M_PTR* const prev);
+
 /**
  *  \brief Remove an element from the dict.
  *  \param d The dict.
@@ -132,6 +232,18 @@ M_DLLAPI M_PTR
 m_Dict_unset(m_Dict* const d,
         const M_CHAR* const key);
 
+/**
+ *  \brief Remove an element from the dict (key of known length).
+ *  \param d The dict.
+ *  \param key The key (not NULL, without null chars).
+ *  \param len Length of key (not 0).
+ *  \return Element that was removed, or NULL if not found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_Dict_unset_len(m_Dict* const d,
+        const M_CHAR* const key,
+        const M_SZ len);
+
 /**
  *  \brief Apply a function to each value in the dict.
  *  \param d The dict.
@@ -154,6 +266,10 @@ m_Dict_traverse2(m_Dict* const d,
 
 /**
  *  \brief Apply a function to each key and value in the dict.
+ *
+ *  The key given is a temporary view of the node key, not to be modified
+ *  nor kept.
+ *
  *  \param d The dict.
  *  \param traverse_fn The function to apply.
  */
@@ -32,12 +32,24 @@ extern "C" {
 #endif
 
 /**
- *  \brief Allocate for a dict node.
+ *  \brief Size of a node, for a key length.
+ */
+#define m_DictNode_size(len) \
+  ((offsetof(m_DictNode, key) + (len) + 1 + M_DICTNODE_QUANTA - 1) \
+  / M_DICTNODE_QUANTA * M_DICTNODE_QUANTA)
+
+/**
+ *  \brief Allocate for a dict node, with a copy of key.
+ *  \param nd The node.
+ *  \param key The key.
+ *  \param len Length of key.
+ *  \param val The value.
  *  \return M_TRUE, or M_FALSE on error.
  */
 M_DLLAPI M_BOOL
 m_DictNode_new(m_DictNode** const nd,
         const M_CHAR* const key,
+        const M_SZ len,
         const M_PTR const val);
 
 /**
@@ -52,21 +64,6 @@ m_DictNode_delete(m_DictNode** const nd);
 M_DLLAPI M_VOID
 m_DictNode_list_delete(m_DictNode* nd);
 
-/**
- *  \brief Initialize a dict node.
- *  \return M_TRUE, or M_FALSE on error.
- */
-M_DLLAPI M_BOOL
-m_DictNode_init(m_DictNode* const nd,
-        const M_CHAR* const key,
-        const M_PTR const val);
-
-/**
- *  \brief Finalize a dict node.
- */
-M_DLLAPI M_VOID
-m_DictNode_fini(m_DictNode* const nd);
-
 #ifndef NDEBUG
 
 M_DLLAPI M_VOID
@@ -0,0 +1,365 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+#include "m_fdict.h"
+
+#undef M_TRACE
+#if defined(M_TRACE_MODE) && defined(M_TRACE_FDICT)
+#define M_TRACE(msg, ...) _M_TRACER("-- FDict -- "msg, __VA_ARGS__)
+#else
+#define M_TRACE(moo, ...)
+#endif
+
+static M_VOID
+_m_FDict_clear(m_FDict* const fd)
+{
+  fd->hashes = NULL;
+  fd->entries = NULL;
+  fd->arena = NULL;
+  fd->num = 0;
+  fd->size = 0;
+  fd->finalize_fn = NULL;
+  fd->mph.seed = 0;
+  fd->mph.num = 0;
+  fd->mph.nbuckets = 0;
+  fd->mph.disp = NULL;
+}
+
+/*
+ *  Start of the allocation.
+ */
+#define _m_FDict_block(fd) \
+  ((fd)->mph.disp ? (M_PTR)(fd)->entries : (M_PTR)(fd)->hashes)
+
+M_BOOL
+m_FDict_freeze(m_FDict* const fd,
+        const m_Dict* const d)
+{
+  m_BTNode* btn;
+  m_DictNode* n;
+  M_SZ i = 0, num = 0, arenasz = 0;
+  M_UINT32 off = 0;
+
+  assert(fd);
+  assert(d);
+  M_TRACE("freeze ("M_PTR_FMT") dict ("M_PTR_FMT")", fd, d);
+  if (!fd || !d) return M_FALSE;
+
+  _m_FDict_clear(fd);
+  fd->hash_fn = d->hash_fn;
+  fd->seed = d->seed;
+
+  for (btn = m_BTree_least(&d->tree); btn; btn = m_BTree_next(btn))
+  {
+    for (n = (m_DictNode*) btn->val; n; n = n->next)
+    {
+      num += 1;
+      arenasz += n->len + 1;
+    }
+  }
+  if (!num) return M_TRUE;
+  if (arenasz > 0xFFFFFFFFU) return M_FALSE;
+
+  fd->size = num * (sizeof(M_ID) + sizeof(m_FDictEntry)) + arenasz;
+  fd->hashes = M_MALLOC(fd->size);
+  assert(fd->hashes);
+  if (!fd->hashes)
+  {
+    fd->size = 0;
+    return M_FALSE;
+  }
+  fd->entries = (m_FDictEntry*)(fd->hashes + num);
+  fd->arena = (M_CHAR*)(fd->entries + num);
+  fd->num = num;
+
+  /* the tree is in hash order already */
+  for (btn = m_BTree_least(&d->tree); btn; btn = m_BTree_next(btn))
+  {
+    for (n = (m_DictNode*) btn->val; n; n = n->next, ++i)
+    {
+      fd->hashes[i] = btn->key;
+      fd->entries[i].val = n->val;
+      fd->entries[i].off = off;
+      fd->entries[i].len = (M_UINT32) n->len;
+      memcpy(fd->arena + off, n->key, n->len + 1);
+      off += (M_UINT32) n->len + 1;
+    }
+  }
+  return M_TRUE;
+}
+
+M_BOOL
+m_FDict_freeze_mph(m_FDict* const fd,
+        const m_Dict* const d)
+{
+  m_BTNode* btn;
+  m_DictNode* n;
+  const M_CHAR** keys = NULL;
+  M_SZ* lens = NULL;
+  M_PTR* vals = NULL;
+  M_UINT32* inv = NULL;
+  M_SZ i = 0, num = 0, arenasz = 0;
+  M_UINT32 off = 0;
+  M_BOOL ok = M_FALSE;
+
+  assert(fd);
+  assert(d);
+  M_TRACE("freeze_mph ("M_PTR_FMT") dict ("M_PTR_FMT")", fd, d);
+  if (!fd || !d) return M_FALSE;
+
+  _m_FDict_clear(fd);
+  fd->hash_fn = d->hash_fn;
+  fd->seed = d->seed;
+
+  for (btn = m_BTree_least(&d->tree); btn; btn = m_BTree_next(btn))
+  {
+    for (n = (m_DictNode*) btn->val; n; n = n->next)
+    {
+      num += 1;
+      arenasz += n->len + 1;
+    }
+  }
+  if (!num) return M_TRUE;
+  if (arenasz > 0xFFFFFFFFU || num > M_MPH_MAXKEYS) return M_FALSE;
+
+  keys = M_MALLOC(num * sizeof(M_CHAR*));
+  lens = M_MALLOC(num * sizeof(M_SZ));
+  vals = M_MALLOC(num * sizeof(M_PTR));
+  inv = M_MALLOC(num * sizeof(M_UINT32));
+  assert(keys && lens && vals && inv);
+  if (!keys || !lens || !vals || !inv) goto done;
+
+  for (btn = m_BTree_least(&d->tree); btn; btn = m_BTree_next(btn))
+  {
+    for (n = (m_DictNode*) btn->val; n; n = n->next, ++i)
+    {
+      keys[i] = n->key;
+      lens[i] = n->len;
+      vals[i] = n->val;
+    }
+  }
+  if (!m_MPH_build(&fd->mph, keys, lens, num)) goto done;
+
+  fd->size = num * sizeof(m_FDictEntry) + arenasz;
+  fd->entries = M_MALLOC(fd->size);
+  assert(fd->entries);
+  if (!fd->entries)
+  {
+    m_MPH_fini(&fd->mph);
+    fd->size = 0;
+    goto done;
+  }
+  fd->arena = (M_CHAR*)(fd->entries + num);
+  fd->num = num;
+
+  /* entries and keys in the order of the function */
+  for (i = 0; i < num; ++i)
+    inv[m_MPH_index(&fd->mph, keys[i], lens[i])] = (M_UINT32) i;
+  for (i = 0; i < num; ++i)
+  {
+    const M_UINT32 j = inv[i];
+    fd->entries[i].val = vals[j];
+    fd->entries[i].off = off;
+    fd->entries[i].len = (M_UINT32) lens[j];
+    memcpy(fd->arena + off, keys[j], lens[j] + 1);
+    off += (M_UINT32) lens[j] + 1;
+  }
+  ok = M_TRUE;
+
+done:
+  if (keys) M_FREE(keys, num * sizeof(M_CHAR*));
+  if (lens) M_FREE(lens, num * sizeof(M_SZ));
+  if (vals) M_FREE(vals, num * sizeof(M_PTR));
+  if (inv) M_FREE(inv, num * sizeof(M_UINT32));
+  return ok;
+}
+
+M_BOOL
+m_FDict_unfreeze(const m_FDict* const fd,
+        m_Dict* const d)
+{
+  M_ID* keys = NULL;
+  M_PTR* vals = NULL;
+  m_DictNode* n, *last = NULL;
+  M_SZ i, num = 0;
+
+  assert(fd);
+  assert(d);
+  M_TRACE("unfreeze ("M_PTR_FMT") dict ("M_PTR_FMT")", fd, d);
+  if (!fd || !d) return M_FALSE;
+
+  if (!m_Dict_init2(d, fd->hash_fn, fd->seed)) return M_FALSE;
+  if (!fd->num) return M_TRUE;
+
+  if (fd->mph.disp)
+  {
+    /* no hashes to build the tree with */
+    for (i = 0; i < fd->num; ++i)
+    {
+      const m_FDictEntry* const e = &fd->entries[i];
+      if (!m_Dict_set_len(d, fd->arena + e->off, e->len, e->val, NULL))
+      {
+        m_Dict_fini(d);
+        return M_FALSE;
+      }
+    }
+    return M_TRUE;
+  }
+
+  keys = M_MALLOC(fd->num * sizeof(M_ID));
+  vals = M_MALLOC(fd->num * sizeof(M_PTR));
+  assert(keys && vals);
+  if (!keys || !vals) goto error;
+
+  /* one list of nodes for each hash, then a tree of them at once */
+  for (i = 0; i < fd->num; ++i)
+  {
+    const m_FDictEntry* const e = &fd->entries[i];
+    if (!m_DictNode_new(&n, fd->arena + e->off, e->len, e->val))
+      goto error;
+    if (num && keys[num - 1] == fd->hashes[i])
+      last->next = n;
+    else
+    {
+      keys[num] = fd->hashes[i];
+      vals[num++] = n;
+    }
+    last = n;
+  }
+  if (!m_BTree_build_sorted(&d->tree, keys, vals, num)) goto error;
+
+  M_FREE(keys, fd->num * sizeof(M_ID));
+  M_FREE(vals, fd->num * sizeof(M_PTR));
+  return M_TRUE;
+
+error:
+  for (i = 0; i < num; ++i)
+    m_DictNode_list_delete((m_DictNode*) vals[i]);
+  if (keys) M_FREE(keys, fd->num * sizeof(M_ID));
+  if (vals) M_FREE(vals, fd->num * sizeof(M_PTR));
+  m_Dict_fini(d);
+  return M_FALSE;
+}
+
+M_VOID
+m_FDict_fini(m_FDict* const fd)
+{
+  assert(fd);
+  M_TRACE("fini ("M_PTR_FMT")", fd);
+  if (!fd) return;
+
+  if (fd->finalize_fn) m_FDict_traverse(fd, fd->finalize_fn);
+  if (fd->size) M_FREE(_m_FDict_block(fd), fd->size);
+  if (fd->mph.disp) m_MPH_fini(&fd->mph);
+  _m_FDict_clear(fd);
+}
+
+M_PTR
+m_FDict_get(const m_FDict* const fd,
+        const M_CHAR* const key)
+{
+  assert(key && *key);
+  if (!key || !*key) return NULL;
+
+  return m_FDict_get_len(fd, key, strlen(key));
+}
+
+M_PTR
+m_FDict_get_len(const m_FDict* const fd,
+        const M_CHAR* const key,
+        const M_SZ len)
+{
+  const M_ID* p;
+  const m_FDictEntry* e;
+  M_ID h;
+  M_SZ n, half;
+
+  assert(fd);
+  assert(key && len);
+  if (!fd || !key || !len) return NULL;
+
+  n = fd->num;
+  if (!n) return NULL;
+  if (fd->mph.disp)
+  {
+    e = &fd->entries[m_MPH_index(&fd->mph, key, len)];
+    return e->len == len && !memcmp(fd->arena + e->off, key, len)
+        ? e->val : NULL;
+  }
+  h = (*fd->hash_fn)(key, len, fd->seed);
+  /* last hash not greater than h, with no branch to mispredict */
+  p = fd->hashes;
+  while (n > 1)
+  {
+    half = n / 2;
+    p = p[half] <= h ? p + half : p;
+    n -= half;
+  }
+  /* keys of equal hashes are before it */
+  for (; *p == h; --p)
+  {
+    e = &fd->entries[p - fd->hashes];
+    if (e->len == len && !memcmp(fd->arena + e->off, key, len))
+      return e->val;
+    if (p == fd->hashes) break;
+  }
+  return NULL;
+}
+
+M_VOID
+m_FDict_traverse(const m_FDict* const fd,
+        M_VOID (* const func)(M_PTR))
+{
+  M_SZ i;
+
+  assert(fd);
+  assert(func);
+  if (!fd || !func) return;
+
+  for (i = 0; i < fd->num; ++i)
+    (*func)(fd->entries[i].val);
+}
+
+M_VOID
+m_FDict_traverse_keyval2(const m_FDict* const fd,
+        M_VOID (* const func)(m_String*, M_PTR, M_PTR),
+        M_PTR const userdata)
+{
+  m_String key;
+  M_SZ i;
+
+  assert(fd);
+  assert(func);
+  if (!fd || !func) return;
+
+  for (i = 0; i < fd->num; ++i)
+  {
+    m_String_view(&key, fd->arena + fd->entries[i].off, fd->entries[i].len);
+    (*func)(&key, fd->entries[i].val, userdata);
+  }
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
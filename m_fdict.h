@@ -0,0 +1,202 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+/**
+ *  \file m_fdict.h
+ *  \brief Frozen dict, an immutable and compact copy of an m_Dict.
+ *  \author Stanislas Marquis <stan@astrorigin.com>
+ */
+
+/*
+ *  For tables built once and then only read (translations, config).
+ *
+ *  Freezing an m_Dict takes one allocation, in three parts:
+ *
+ *    hashes    num key hashes, sorted (those of the dict, same function
+ *              and seed), keys of equal hashes next to each other
+ *    entries   num values, with the offset and length of their key
+ *    arena     all keys, each followed by a null char
+ *
+ *  There are no nodes nor per-key headers: a key costs its hash, its
+ *  entry and its bytes. Lookups search the hashes with a binary search
+ *  without branches, then compare keys in the arena. They allocate
+ *  nothing. Keys are limited to 4 GB in all.
+ *
+ *  Frozen with a minimal perfect hash (m_FDict_freeze_mph), there are no
+ *  hashes: entries are in the order of the function, and a lookup is one
+ *  hash and one compare.
+ */
+
+#ifndef M_FDICT_H
+#define M_FDICT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "m_h.h"
+#include "m_dict.h"
+#include "m_hash.h"
+#include "m_mph.h"
+#include "m_string.h"
+
+/**
+ *  \typedef m_FDictEntry
+ */
+typedef struct _m_FDictEntry m_FDictEntry;
+
+/**
+ *  \struct _m_FDictEntry
+ */
+struct _m_FDictEntry
+{
+  M_PTR val;
+  M_UINT32 off; /* offset of key in arena */
+  M_UINT32 len; /* length of key */
+};
+
+/**
+ *  \typedef m_FDict
+ */
+typedef struct _m_FDict m_FDict;
+
+/**
+ *  \struct _m_FDict
+ */
+struct _m_FDict
+{
+  M_ID* hashes; /* start of the allocation, or NULL */
+  m_FDictEntry* entries; /* start of the allocation with a perfect hash */
+  M_CHAR* arena;
+  M_SZ num; /* number of keys */
+  M_SZ size; /* size of the allocation */
+  M_VOID (*finalize_fn)(M_PTR);
+  m_hash_fn_t hash_fn;
+  M_ID seed;
+  m_MPH mph; /* perfect hash, if mph.disp is not NULL */
+};
+
+/**
+ *  \brief Freeze a dict.
+ *
+ *  The dict is left as it is, and its values are shared. The frozen dict
+ *  does not own them, unless given a finalize_fn.
+ *
+ *  \param fd The frozen dict (uninitialized).
+ *  \param d The dict.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_FDict_freeze(m_FDict* const fd,
+        const m_Dict* const d);
+
+/**
+ *  \brief Freeze a dict, with a minimal perfect hash of its keys.
+ *
+ *  Slower to freeze than m_FDict_freeze, for faster lookups.
+ *
+ *  \param fd The frozen dict (uninitialized).
+ *  \param d The dict.
+ *  \return M_TRUE, or M_FALSE on error.
+ *  \see m_MPH_build
+ */
+M_DLLAPI M_BOOL
+m_FDict_freeze_mph(m_FDict* const fd,
+        const m_Dict* const d);
+
+/**
+ *  \brief Make a mutable dict of a frozen dict.
+ *
+ *  The dict gets the same hash function and seed, and shares the values.
+ *
+ *  \param fd The frozen dict.
+ *  \param d The dict (uninitialized).
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_FDict_unfreeze(const m_FDict* const fd,
+        m_Dict* const d);
+
+/**
+ *  \brief Finalize a frozen dict.
+ *
+ *  If not NULL, fd->finalize_fn is executed on the values.
+ */
+M_DLLAPI M_VOID
+m_FDict_fini(m_FDict* const fd);
+
+/**
+ *  \brief Get an element from the frozen dict or NULL.
+ *  \param fd The frozen dict.
+ *  \param key The key string (not NULL nor empty).
+ *  \return Element found, or NULL if nothing found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_FDict_get(const m_FDict* const fd,
+        const M_CHAR* const key);
+
+/**
+ *  \brief Get an element from the frozen dict or NULL (key of known length).
+ *  \param fd The frozen dict.
+ *  \param key The key (not NULL).
+ *  \param len Length of key (not 0).
+ *  \return Element found, or NULL if nothing found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_FDict_get_len(const m_FDict* const fd,
+        const M_CHAR* const key,
+        const M_SZ len);
+
+/**
+ *  \brief Count the keys of a frozen dict.
+ */
+#define m_FDict_count( fd ) \
+        ((fd)->num)
+
+/**
+ *  \brief Apply a function to each value in the frozen dict.
+ */
+M_DLLAPI M_VOID
+m_FDict_traverse(const m_FDict* const fd,
+        M_VOID (* const traverse_fn)(M_PTR val));
+
+/**
+ *  \brief Apply a function to each key and value in the frozen dict
+ *  (with userdata).
+ *
+ *  The key given is a temporary view of the key in the arena, not to be
+ *  modified nor kept.
+ */
+M_DLLAPI M_VOID
+m_FDict_traverse_keyval2(const m_FDict* const fd,
+        M_VOID (* const traverse_fn)(m_String* key, M_PTR val, M_PTR udata),
+        M_PTR const userdata);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !M_FDICT_H */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
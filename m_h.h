@@ -45,6 +45,7 @@ extern "C" {
 #include <errno.h>
 #include <signal.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -80,8 +81,9 @@ extern "C" {
 /*
  *  Basic debugging macros
  */
-#ifndef NDEBUG
 #include <assert.h>
+
+#ifndef NDEBUG
 /**
  *  \def M_DEBUG( code )
  *  \brief Conditional compilation.
@@ -159,6 +161,24 @@ extern "C" {
  */
 #define M_UNUSED(var) ((void)var)
 
+/**
+ *  \def M_CACHELINE
+ *  \brief Assumed size of a cache line.
+ */
+#ifndef M_CACHELINE
+#define M_CACHELINE 64
+#endif
+
+/**
+ *  \def M_PREFETCH( addr )
+ *  \brief Hint the processor that memory at addr will soon be read.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define M_PREFETCH(addr) __builtin_prefetch((addr), 0, 3)
+#else
+#define M_PREFETCH(addr) ((void)(addr))
+#endif
+
 /*
  *  Types macros
  */
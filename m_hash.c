@@ -0,0 +1,246 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+#include "m_hash.h"
+
+#include "m_mutex.h"
+
+#ifdef _MSC_VER
+#include <bcrypt.h>
+#elif defined(__linux__) && defined(__GLIBC__) \
+    && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 25))
+#define M_HASH_GETRANDOM
+#include <sys/random.h>
+#endif
+
+#define M_HASH_P0 0xa0761d6478bd642fULL
+#define M_HASH_P1 0xe7037ed1a0b428dbULL
+#define M_HASH_P2 0x8ebc6af09c88c6e3ULL
+#define M_HASH_P3 0x589965cc75374cc3ULL
+
+M_ID
+m_hash_oaat(const M_PTR k,
+        const M_SZ len,
+        const M_ID seed)
+{ /* this function is public domain */
+  const M_UCHAR* p = (const M_UCHAR*) k;
+  M_ID h = seed;
+  M_SZ i;
+
+  for (i = 0; i < len; i++)
+  {
+    h += p[i];
+    h += ( h << 10 );
+    h ^= ( h >> 6 );
+  }
+  h += ( h << 3 );
+  h ^= ( h >> 11 );
+  h += ( h << 15 );
+  return h;
+}
+
+M_ID
+m_hash_fnv1a(const M_PTR k,
+        const M_SZ len,
+        const M_ID seed)
+{
+  const M_UCHAR* p = (const M_UCHAR*) k;
+  M_UINT64 h = 0xcbf29ce484222325ULL ^ (M_UINT64) seed;
+  M_SZ i;
+
+  for (i = 0; i < len; i++)
+  {
+    h ^= p[i];
+    h *= 0x100000001b3ULL;
+  }
+  return (M_ID) h;
+}
+
+/*
+ *  Full 128 bits product of a and b, low half in a, high half in b.
+ */
+static M_VOID
+_m_hash_mum(M_UINT64* const a,
+        M_UINT64* const b)
+{
+#if defined(__SIZEOF_INT128__)
+  const __uint128_t r = (__uint128_t) *a * *b;
+  *a = (M_UINT64) r;
+  *b = (M_UINT64) (r >> 64);
+#else
+  const M_UINT64 ha = *a >> 32, hb = *b >> 32;
+  const M_UINT64 la = (M_UINT32) *a, lb = (M_UINT32) *b;
+  const M_UINT64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  const M_UINT64 t = rl + (rm0 << 32);
+  const M_UINT64 lo = t + (rm1 << 32);
+  M_UINT64 c = t < rl;
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static M_UINT64
+_m_hash_mix(M_UINT64 a,
+        M_UINT64 b)
+{
+  _m_hash_mum(&a, &b);
+  return a ^ b;
+}
+
+static M_UINT64
+_m_hash_r8(const M_UCHAR* const p)
+{
+  M_UINT64 v;
+  memcpy(&v, p, 8);
+  return v;
+}
+
+static M_UINT64
+_m_hash_r4(const M_UCHAR* const p)
+{
+  M_UINT32 v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+M_ID
+m_hash_wy(const M_PTR k,
+        const M_SZ len,
+        const M_ID seed)
+{
+  const M_UCHAR* p = (const M_UCHAR*) k;
+  M_UINT64 s = (M_UINT64) seed;
+  M_UINT64 a, b;
+  M_SZ i = len;
+
+  s ^= _m_hash_mix(s ^ M_HASH_P0, M_HASH_P1);
+  if (len <= 16)
+  {
+    if (len >= 4)
+    {
+      /* two overlapping reads from each end */
+      const M_SZ q = (len >> 3) << 2;
+      a = (_m_hash_r4(p) << 32) | _m_hash_r4(p + q);
+      b = (_m_hash_r4(p + len - 4) << 32) | _m_hash_r4(p + len - 4 - q);
+    }
+    else if (len > 0)
+    {
+      a = ((M_UINT64) p[0] << 16) | ((M_UINT64) p[len >> 1] << 8) | p[len - 1];
+      b = 0;
+    }
+    else
+      a = b = 0;
+  }
+  else
+  {
+    if (i > 48)
+    {
+      M_UINT64 s1 = s, s2 = s;
+      do
+      {
+        s = _m_hash_mix(_m_hash_r8(p) ^ M_HASH_P1, _m_hash_r8(p + 8) ^ s);
+        s1 = _m_hash_mix(_m_hash_r8(p + 16) ^ M_HASH_P2, _m_hash_r8(p + 24) ^ s1);
+        s2 = _m_hash_mix(_m_hash_r8(p + 32) ^ M_HASH_P3, _m_hash_r8(p + 40) ^ s2);
+        p += 48;
+        i -= 48;
+      }
+      while (i > 48);
+      s ^= s1 ^ s2;
+    }
+    while (i > 16)
+    {
+      s = _m_hash_mix(_m_hash_r8(p) ^ M_HASH_P1, _m_hash_r8(p + 8) ^ s);
+      p += 16;
+      i -= 16;
+    }
+    a = _m_hash_r8(p + i - 16);
+    b = _m_hash_r8(p + i - 8);
+  }
+  a ^= M_HASH_P1;
+  b ^= s;
+  _m_hash_mum(&a, &b);
+  return (M_ID) _m_hash_mix(a ^ M_HASH_P0 ^ len, b ^ M_HASH_P1);
+}
+
+/*
+ *  Fill a seed from the system random source, or return M_FALSE.
+ */
+static M_BOOL
+_m_hash_random(M_UINT64* const s)
+{
+#ifdef _MSC_VER
+  return BCryptGenRandom(NULL, (PUCHAR) s, sizeof(*s),
+      BCRYPT_USE_SYSTEM_PREFERRED_RNG) == 0;
+#else
+  FILE* f;
+  M_BOOL ok;
+
+#ifdef M_HASH_GETRANDOM
+  if (getrandom(s, sizeof(*s), 0) == (ssize_t) sizeof(*s)) return M_TRUE;
+#endif
+  f = fopen("/dev/urandom", "rb");
+  if (!f) return M_FALSE;
+  ok = fread(s, sizeof(*s), 1, f) == 1;
+  fclose(f);
+  return ok;
+#endif /* !_MSC_VER */
+}
+
+/* the seed, kept as a pointer for the atomic macros (NULL until set) */
+static M_PTR
+_m_hash_seed = NULL;
+
+M_ID
+m_hash_seed(M_VOID)
+{
+  M_PTR cur = m_Atomic_load_ptr(&_m_hash_seed);
+  M_UINT64 s;
+
+  if (cur) return (M_ID)(size_t) cur;
+
+  if (!_m_hash_random(&s))
+  {
+    /* no random source: different for each run, but not secret */
+    s = (M_UINT64) time(NULL);
+    s = _m_hash_mix(s ^ M_HASH_P0, (M_UINT64) clock() ^ M_HASH_P1);
+    s = _m_hash_mix(s ^ M_HASH_P2, (M_UINT64)(size_t) &s ^ M_HASH_P3);
+  }
+  if (!(M_ID) s) s = 1;
+
+  /* the first thread to get there sets it for all */
+  do
+  {
+    cur = NULL;
+    if (m_Atomic_cas_ptr(&_m_hash_seed, cur, (M_PTR)(size_t)(M_ID) s))
+      return (M_ID) s;
+    cur = m_Atomic_load_ptr(&_m_hash_seed);
+  }
+  while (!cur);
+  return (M_ID)(size_t) cur;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
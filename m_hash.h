@@ -0,0 +1,102 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+/**
+ *  \file m_hash.h
+ *  \brief Hash functions.
+ *  \author Stanislas Marquis <stan@astrorigin.com>
+ */
+
+#ifndef M_HASH_H
+#define M_HASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "m_h.h"
+
+/**
+ *  \brief Function type for hashing keys.
+ *  \param k The key.
+ *  \param len Length of key, in bytes.
+ *  \param seed Value mixed with the key, to make hashes unpredictable.
+ */
+typedef M_ID (*m_hash_fn_t)(const M_PTR k, const M_SZ len, const M_ID seed);
+
+/**
+ *  \brief Jenkins' one-at-a-time hash, one byte at a time.
+ *
+ *  With seed 0, this is the same as m_Dict_hash used to be.
+ */
+M_DLLAPI M_ID
+m_hash_oaat(const M_PTR k,
+        const M_SZ len,
+        const M_ID seed);
+
+/**
+ *  \brief FNV-1a hash (64 bits), one byte at a time.
+ */
+M_DLLAPI M_ID
+m_hash_fnv1a(const M_PTR k,
+        const M_SZ len,
+        const M_ID seed);
+
+/**
+ *  \brief Hash in the style of wyhash, 8 or 16 bytes at a time.
+ *
+ *  Reads words in native byte order, so hashes differ between little
+ *  and big endian machines.
+ */
+M_DLLAPI M_ID
+m_hash_wy(const M_PTR k,
+        const M_SZ len,
+        const M_ID seed);
+
+/**
+ *  \brief Get a random seed, the same for the whole process.
+ *
+ *  Give it to dicts holding keys from untrusted input, so that nobody can
+ *  guess keys colliding on purpose. It comes from the system random
+ *  source (getrandom or /dev/urandom, BCryptGenRandom on Windows). Only
+ *  when none can be read is it made of the time and an address, which
+ *  differs between runs but can be guessed.
+ */
+M_DLLAPI M_ID
+m_hash_seed(M_VOID);
+
+#ifndef M_HASH_DEFAULT
+/**
+ *  \brief Hash function used by dicts, unless told otherwise.
+ */
+#define M_HASH_DEFAULT  m_hash_wy
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !M_HASH_H */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,965 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+#include "m_hdict.h"
+
+#include "m_mempool.h"
+
+#if !defined(M_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define M_HDICT_SIMD 1
+#include <immintrin.h>
+#else
+#define M_HDICT_SIMD 0
+#endif
+
+#undef M_TRACE
+#if defined(M_TRACE_MODE) && defined(M_TRACE_HDICT)
+#define M_TRACE(msg, ...) _M_TRACER("-- HDict -- "msg, __VA_ARGS__)
+#else
+#define M_TRACE(moo, ...)
+#endif
+
+/* control bytes */
+#define M_HDICT_EMPTY   ((M_UINT8) 0x80)
+#define M_HDICT_DELETED ((M_UINT8) 0xFE)
+
+/* parts of the hash, for position in table, and for the control byte */
+#define M_HDICT_H1(h) ((h) >> 7)
+#define M_HDICT_H2(h) ((M_UINT8)((h) & 0x7F))
+
+#define M_HDICT_LSB 0x0101010101010101ULL
+#define M_HDICT_MSB 0x8080808080808080ULL
+
+/* maximum number of elements for a capacity (7/8) */
+#define M_HDICT_MAXLOAD(cap) ((cap) - (cap) / 8)
+
+/* size of the block holding slots and control bytes */
+#define M_HDICT_BLOCKSZ(cap) \
+  ((cap) * sizeof(m_HDictSlot) + (cap) + M_HDICT_GROUP)
+
+/* number of control bytes in a word, for the portable probes */
+#define M_HDICT_SWAR 8
+
+/*
+ *  Load a word of control bytes, first byte in lowest bits.
+ */
+static M_UINT64
+_m_HDict_word(const M_UINT8* const p)
+{
+  return (M_UINT64) p[0]
+      | ((M_UINT64) p[1] << 8)
+      | ((M_UINT64) p[2] << 16)
+      | ((M_UINT64) p[3] << 24)
+      | ((M_UINT64) p[4] << 32)
+      | ((M_UINT64) p[5] << 40)
+      | ((M_UINT64) p[6] << 48)
+      | ((M_UINT64) p[7] << 56);
+}
+
+/*
+ *  Bytes of a word equal to h2, as a mask of their high bits.
+ *  This can have false positives (next to a true one), that are
+ *  sorted out when comparing hashes.
+ */
+static M_UINT64
+_m_HDict_match(const M_UINT64 g,
+        const M_UINT8 h2)
+{
+  const M_UINT64 x = g ^ (M_HDICT_LSB * h2);
+  return (x - M_HDICT_LSB) & ~x & M_HDICT_MSB;
+}
+
+/*
+ *  Empty bytes of a word.
+ */
+static M_UINT64
+_m_HDict_match_empty(const M_UINT64 g)
+{
+  return g & (~g << 6) & M_HDICT_MSB;
+}
+
+/*
+ *  Empty or deleted bytes of a word.
+ */
+static M_UINT64
+_m_HDict_match_free(const M_UINT64 g)
+{
+  return g & (~g << 7) & M_HDICT_MSB;
+}
+
+/*
+ *  Index of first byte set in mask (not 0).
+ */
+static M_SZ
+_m_HDict_first(const M_UINT64 m)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return (M_SZ) __builtin_ctzll(m) >> 3;
+#else
+  M_SZ i = 0;
+  while (!(m & ((M_UINT64) 0x80 << (i << 3)))) ++i;
+  return i;
+#endif
+}
+
+/*
+ *  Set a control byte, and its mirror past the end of the table.
+ */
+static M_VOID
+_m_HDict_set_ctrl(m_HDict* const d,
+        const M_SZ i,
+        const M_UINT8 c)
+{
+  d->ctrl[i] = c;
+  if (i < M_HDICT_GROUP) d->ctrl[d->capacity + i] = c;
+}
+
+/*
+ *  Compare a slot with a key.
+ */
+#define _m_HDict_slot_is(slot, key, len, hash) \
+  ((slot)->hash == (hash) \
+  && m_HDictSlot_len(slot) == (len) \
+  && !memcmp(m_HDictSlot_key(slot), (key), (len)))
+
+/*
+ *  Copy a key into a slot, or into a buffer of its own if long.
+ */
+static M_BOOL
+_m_HDictSlot_set_key(m_HDictSlot* const slot,
+        const M_CHAR* const key,
+        const M_SZ len)
+{
+  M_CHAR* p;
+
+  if (len < M_HDICT_INLINE)
+  {
+    slot->key.in.len = (M_UINT32) len;
+    p = slot->key.in.data;
+  }
+  else
+  {
+    p = M_MALLOC(len + 1);
+    assert(p);
+    if (!p) return M_FALSE;
+    slot->key.out.len = (M_UINT32) len;
+    slot->key.out.data = p;
+  }
+  memcpy(p, key, len);
+  p[len] = '\0';
+  return M_TRUE;
+}
+
+/*
+ *  Free the key of a slot, if it has a buffer.
+ */
+#define _m_HDictSlot_fini_key(slot) \
+  do { \
+    if ((slot)->key.in.len >= M_HDICT_INLINE) \
+      M_FREE((slot)->key.out.data, (slot)->key.out.len + 1); \
+  } while (0)
+
+/*
+ *  Find the slot holding a key, or NULL (portable version).
+ */
+static m_HDictSlot*
+_m_HDict_find_swar(const m_HDict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_ID hash)
+{
+  const M_SZ mask = d->capacity - 1;
+  const M_UINT8 h2 = M_HDICT_H2(hash);
+  M_SZ pos = M_HDICT_H1(hash) & mask;
+  M_SZ stride = 0;
+  M_UINT64 g, m;
+  m_HDictSlot* slot;
+
+  for (;;)
+  {
+    g = _m_HDict_word(d->ctrl + pos);
+    for (m = _m_HDict_match(g, h2); m; m &= m - 1)
+    {
+      slot = &d->slots[(pos + _m_HDict_first(m)) & mask];
+      if (_m_HDict_slot_is(slot, key, len, hash)) return slot;
+    }
+    if (_m_HDict_match_empty(g)) return NULL;
+    /* triangular probing visits every group once */
+    stride += M_HDICT_SWAR;
+    pos = (pos + stride) & mask;
+  }
+}
+
+/*
+ *  Find a free (empty or deleted) slot for a hash (portable version).
+ */
+static M_SZ
+_m_HDict_find_free_swar(const m_HDict* const d,
+        const M_ID hash)
+{
+  const M_SZ mask = d->capacity - 1;
+  M_SZ pos = M_HDICT_H1(hash) & mask;
+  M_SZ stride = 0;
+  M_UINT64 m;
+
+  for (;;)
+  {
+    m = _m_HDict_match_free(_m_HDict_word(d->ctrl + pos));
+    if (m) return (pos + _m_HDict_first(m)) & mask;
+    stride += M_HDICT_SWAR;
+    pos = (pos + stride) & mask;
+  }
+}
+
+#if M_HDICT_SIMD
+
+/*
+ *  Same with SSE2, 16 control bytes at once.
+ *  The high bit of a control byte is set if the slot is free.
+ */
+static m_HDictSlot*
+_m_HDict_find_sse2(const m_HDict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_ID hash)
+{
+  const M_SZ mask = d->capacity - 1;
+  const __m128i h2 = _mm_set1_epi8((char) M_HDICT_H2(hash));
+  const __m128i empty = _mm_set1_epi8((char) M_HDICT_EMPTY);
+  M_SZ pos = M_HDICT_H1(hash) & mask;
+  M_SZ stride = 0;
+  M_UINT32 m;
+  __m128i g;
+  m_HDictSlot* slot;
+
+  for (;;)
+  {
+    g = _mm_loadu_si128((const __m128i*)(d->ctrl + pos));
+    m = (M_UINT32) _mm_movemask_epi8(_mm_cmpeq_epi8(g, h2));
+    for (; m; m &= m - 1)
+    {
+      slot = &d->slots[(pos + __builtin_ctz(m)) & mask];
+      if (_m_HDict_slot_is(slot, key, len, hash)) return slot;
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(g, empty))) return NULL;
+    stride += 16;
+    pos = (pos + stride) & mask;
+  }
+}
+
+static M_SZ
+_m_HDict_find_free_sse2(const m_HDict* const d,
+        const M_ID hash)
+{
+  const M_SZ mask = d->capacity - 1;
+  M_SZ pos = M_HDICT_H1(hash) & mask;
+  M_SZ stride = 0;
+  M_UINT32 m;
+
+  for (;;)
+  {
+    m = (M_UINT32) _mm_movemask_epi8(
+        _mm_loadu_si128((const __m128i*)(d->ctrl + pos)));
+    if (m) return (pos + __builtin_ctz(m)) & mask;
+    stride += 16;
+    pos = (pos + stride) & mask;
+  }
+}
+
+/*
+ *  Same with AVX2, 32 control bytes at once.
+ */
+__attribute__((target("avx2")))
+static m_HDictSlot*
+_m_HDict_find_avx2(const m_HDict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_ID hash)
+{
+  const M_SZ mask = d->capacity - 1;
+  const __m256i h2 = _mm256_set1_epi8((char) M_HDICT_H2(hash));
+  const __m256i empty = _mm256_set1_epi8((char) M_HDICT_EMPTY);
+  M_SZ pos = M_HDICT_H1(hash) & mask;
+  M_SZ stride = 0;
+  M_UINT32 m;
+  __m256i g;
+  m_HDictSlot* slot;
+
+  for (;;)
+  {
+    g = _mm256_loadu_si256((const __m256i*)(d->ctrl + pos));
+    m = (M_UINT32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(g, h2));
+    for (; m; m &= m - 1)
+    {
+      slot = &d->slots[(pos + __builtin_ctz(m)) & mask];
+      if (_m_HDict_slot_is(slot, key, len, hash)) return slot;
+    }
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(g, empty))) return NULL;
+    stride += 32;
+    pos = (pos + stride) & mask;
+  }
+}
+
+__attribute__((target("avx2")))
+static M_SZ
+_m_HDict_find_free_avx2(const m_HDict* const d,
+        const M_ID hash)
+{
+  const M_SZ mask = d->capacity - 1;
+  M_SZ pos = M_HDICT_H1(hash) & mask;
+  M_SZ stride = 0;
+  M_UINT32 m;
+
+  for (;;)
+  {
+    m = (M_UINT32) _mm256_movemask_epi8(
+        _mm256_loadu_si256((const __m256i*)(d->ctrl + pos)));
+    if (m) return (pos + __builtin_ctz(m)) & mask;
+    stride += 32;
+    pos = (pos + stride) & mask;
+  }
+}
+
+#endif /* M_HDICT_SIMD */
+
+/*
+ *  Widest probe the cpu can do (checked once).
+ */
+static M_UINT32
+_m_HDict_simd_width(M_VOID)
+{
+#if M_HDICT_SIMD
+  static volatile M_UINT32 width = 0;
+
+  if (!width)
+  {
+    __builtin_cpu_init();
+    width = __builtin_cpu_supports("avx2") ? 32 : 16;
+  }
+  return width;
+#else
+  return M_HDICT_SWAR;
+#endif
+}
+
+/*
+ *  Find the slot holding a key, or NULL.
+ */
+static m_HDictSlot*
+_m_HDict_find(const m_HDict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_ID hash)
+{
+  if (!d->capacity) return NULL;
+#if M_HDICT_SIMD
+  if (d->group == 32) return _m_HDict_find_avx2(d, key, len, hash);
+  if (d->group == 16) return _m_HDict_find_sse2(d, key, len, hash);
+#endif
+  return _m_HDict_find_swar(d, key, len, hash);
+}
+
+/*
+ *  Find a free (empty or deleted) slot for a hash.
+ */
+static M_SZ
+_m_HDict_find_free(const m_HDict* const d,
+        const M_ID hash)
+{
+#if M_HDICT_SIMD
+  if (d->group == 32) return _m_HDict_find_free_avx2(d, hash);
+  if (d->group == 16) return _m_HDict_find_free_sse2(d, hash);
+#endif
+  return _m_HDict_find_free_swar(d, hash);
+}
+
+/*
+ *  Number of non-empty control bytes next to a slot, from the slot
+ *  onwards (dir = 1) or before it (dir = -1), up to the probe width.
+ */
+static M_SZ
+_m_HDict_full_run(const m_HDict* const d,
+        const M_SZ i,
+        const M_INT32 dir)
+{
+  const M_SZ mask = d->capacity - 1;
+  M_SZ n = 0;
+  M_SZ j = dir > 0 ? i : (i - 1) & mask;
+
+  while (n < d->group && d->ctrl[j] != M_HDICT_EMPTY)
+  {
+    ++n;
+    j = (j + dir) & mask;
+  }
+  return n;
+}
+
+/*
+ *  A view of the old table, to probe it with the same functions.
+ */
+static M_VOID
+_m_HDict_old(const m_HDict* const d,
+        m_HDict* const old)
+{
+  old->ctrl = d->octrl;
+  old->slots = d->oslots;
+  old->capacity = d->ocapacity;
+  old->group = M_MIN(_m_HDict_simd_width(), (M_UINT32) d->ocapacity);
+}
+
+#define _m_HDict_in_old(d, slot) \
+  ((d)->oslots && (slot) >= (d)->oslots \
+  && (slot) < (d)->oslots + (d)->ocapacity)
+
+/*
+ *  Find the slot holding a key in either table, or NULL.
+ */
+static m_HDictSlot*
+_m_HDict_lookup(const m_HDict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_ID hash)
+{
+  m_HDictSlot* slot = _m_HDict_find(d, key, len, hash);
+  m_HDict old;
+
+  if (slot || !d->oslots) return slot;
+  _m_HDict_old(d, &old);
+  return _m_HDict_find(&old, key, len, hash);
+}
+
+/*
+ *  Move up to num slots of the old table, and free it when done.
+ *  Moved slots are marked deleted in the old table, so that lookups
+ *  only find them in the new one.
+ */
+static M_VOID
+_m_HDict_migrate(m_HDict* const d,
+        M_SZ num)
+{
+  m_HDict old;
+  M_SZ j;
+
+  if (!d->oslots) return;
+  _m_HDict_old(d, &old);
+  for (; num && d->moved < d->ocapacity; --num, ++d->moved)
+  {
+    const M_UINT8 c = d->octrl[d->moved];
+    if (c & M_HDICT_EMPTY) continue;
+    j = _m_HDict_find_free(d, d->oslots[d->moved].hash);
+    /* room was kept for it, unless it reuses a deleted slot */
+    if (d->ctrl[j] != M_HDICT_EMPTY) d->growth_left += 1;
+    _m_HDict_set_ctrl(d, j, c);
+    d->slots[j] = d->oslots[d->moved];
+    _m_HDict_set_ctrl(&old, d->moved, M_HDICT_DELETED);
+  }
+  if (d->moved < d->ocapacity) return;
+  M_TRACE("migrated ("M_PTR_FMT") "M_SZ_FMT, d, d->ocapacity);
+  M_FREE(d->oslots, M_HDICT_BLOCKSZ(d->ocapacity));
+  d->octrl = NULL;
+  d->oslots = NULL;
+  d->ocapacity = 0;
+  d->moved = 0;
+}
+
+/*
+ *  Start moving all elements to a new table. The old table must be gone.
+ */
+static M_BOOL
+_m_HDict_grow(m_HDict* const d,
+        const M_SZ capacity)
+{
+  m_HDictSlot* slots;
+
+  assert(capacity >= M_HDICT_MINCAP);
+  assert(!(capacity & (capacity - 1)));
+  assert(M_HDICT_MAXLOAD(capacity) >= d->num);
+  assert(!d->oslots);
+  M_TRACE("grow ("M_PTR_FMT") "M_SZ_FMT" -> "M_SZ_FMT,
+      d, d->capacity, capacity);
+
+  slots = M_MALLOC(M_HDICT_BLOCKSZ(capacity));
+  assert(slots);
+  if (!slots) return M_FALSE;
+  if (d->capacity)
+  {
+    d->octrl = d->ctrl;
+    d->oslots = d->slots;
+    d->ocapacity = d->capacity;
+    d->moved = 0;
+  }
+  d->slots = slots;
+  d->ctrl = (M_UINT8*) (slots + capacity);
+  d->capacity = capacity;
+  d->group = M_MIN(_m_HDict_simd_width(), (M_UINT32) capacity);
+  /* room for the elements still in the old table too */
+  d->growth_left = M_HDICT_MAXLOAD(capacity) - d->num;
+  memset(d->ctrl, M_HDICT_EMPTY, capacity + M_HDICT_GROUP);
+  return M_TRUE;
+}
+
+/*
+ *  Element i of both tables (new then old), or NULL if that slot is free.
+ */
+static m_HDictSlot*
+_m_HDict_nth(const m_HDict* const d,
+        const M_SZ i)
+{
+  if (i < d->capacity)
+    return d->ctrl[i] & M_HDICT_EMPTY ? NULL : &d->slots[i];
+  return d->octrl[i - d->capacity] & M_HDICT_EMPTY ? NULL
+      : &d->oslots[i - d->capacity];
+}
+
+M_BOOL
+m_HDict_new(m_HDict** const d)
+{
+  assert(d);
+  M_TRACE("new ("M_PTR_FMT")", d);
+  if (!d) return M_FALSE;
+
+  *d = M_MALLOC(sizeof(m_HDict));
+  assert(*d);
+  if (!*d) return M_FALSE;
+  return m_HDict_init(*d);
+}
+
+M_BOOL
+m_HDict_init2(m_HDict* const d,
+        const m_hash_fn_t hash_fn,
+        const M_ID seed)
+{
+  assert(d);
+  M_TRACE("init2 ("M_PTR_FMT")", d);
+  if (!d) return M_FALSE;
+
+  d->ctrl = NULL;
+  d->slots = NULL;
+  d->capacity = 0;
+  d->num = 0;
+  d->growth_left = 0;
+  d->group = 0;
+  d->octrl = NULL;
+  d->oslots = NULL;
+  d->ocapacity = 0;
+  d->moved = 0;
+  d->finalize_fn = NULL;
+  d->hash_fn = hash_fn ? hash_fn : &M_HASH_DEFAULT;
+  d->seed = seed;
+  return M_TRUE;
+}
+
+M_BOOL
+m_HDict_init(m_HDict* const d)
+{
+  return m_HDict_init2(d, NULL, 0);
+}
+
+M_VOID
+m_HDict_fini(m_HDict* const d)
+{
+  M_SZ i;
+
+  assert(d);
+  M_TRACE("fini ("M_PTR_FMT")", d);
+  if (!d) return;
+
+  for (i = 0; i < d->capacity + d->ocapacity; ++i)
+  {
+    m_HDictSlot* const slot = _m_HDict_nth(d, i);
+    if (!slot) continue;
+    if (d->finalize_fn) (*d->finalize_fn)(slot->val);
+    _m_HDictSlot_fini_key(slot);
+  }
+  if (d->slots) M_FREE(d->slots, M_HDICT_BLOCKSZ(d->capacity));
+  if (d->oslots) M_FREE(d->oslots, M_HDICT_BLOCKSZ(d->ocapacity));
+  m_HDict_init2(d, d->hash_fn, d->seed);
+}
+
+M_VOID
+m_HDict_delete(m_HDict** const d)
+{
+  assert(d && *d);
+  M_TRACE("delete ("M_PTR_FMT")", *d);
+  if (!d || !*d) return;
+
+  m_HDict_fini(*d);
+  M_FREE(*d, sizeof(m_HDict));
+  *d = NULL;
+}
+
+M_BOOL
+m_HDict_reserve(m_HDict* const d,
+        const M_SZ num)
+{
+  M_SZ cap = M_HDICT_MINCAP;
+
+  assert(d);
+  M_TRACE("reserve ("M_PTR_FMT") num ("M_SZ_FMT")", d, num);
+  if (!d) return M_FALSE;
+
+  while (M_HDICT_MAXLOAD(cap) < num)
+  {
+    if (cap > ((M_SZ) -1) / 2 / sizeof(m_HDictSlot)) return M_FALSE;
+    cap *= 2;
+  }
+  if (cap <= d->capacity) return M_TRUE;
+  _m_HDict_migrate(d, (M_SZ) -1);
+  if (!_m_HDict_grow(d, cap)) return M_FALSE;
+  _m_HDict_migrate(d, (M_SZ) -1);
+  return M_TRUE;
+}
+
+M_PTR
+m_HDict_get(const m_HDict* const d,
+        const M_CHAR* const key)
+{
+  M_SZ len;
+
+  assert(d);
+  assert(key && *key);
+  M_TRACE("get ("M_PTR_FMT") key ("M_STR_FMT")", d, key);
+  if (!d || !key || !*key) return NULL;
+
+  len = strlen(key);
+  return m_HDict_get_hashed(d, key, len, (*d->hash_fn)(key, len, d->seed));
+}
+
+M_PTR
+m_HDict_get_hashed(const m_HDict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_ID hash)
+{
+  m_HDictSlot* slot;
+
+  assert(d);
+  assert(key && len);
+  if (!d || !key || !len) return NULL;
+
+  slot = _m_HDict_lookup(d, key, len, hash);
+  return slot ? slot->val : NULL;
+}
+
+M_BOOL
+m_HDict_set(m_HDict* const d,
+        const M_CHAR* const key,
+        const M_PTR const val,
+        M_PTR* const prev)
+{
+  M_SZ len;
+
+  assert(d);
+  assert(key && *key);
+  M_TRACE("set ("M_PTR_FMT") key ("M_STR_FMT") val ("M_PTR_FMT")", d, key, val);
+  if (!d || !key || !*key) return M_FALSE;
+
+  len = strlen(key);
+  return m_HDict_set_hashed(d, key, len, (*d->hash_fn)(key, len, d->seed),
+      val, prev);
+}
+
+M_BOOL
+m_HDict_set_hashed(m_HDict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_ID hash,
+        const M_PTR const val,
+        M_PTR* const prev)
+{
+  m_HDictSlot* slot;
+  M_SZ i;
+
+  assert(d);
+  assert(key && len);
+  assert(len <= (M_UINT32) -1);
+  if (!d || !key || !len || len > (M_UINT32) -1) return M_FALSE;
+
+  _m_HDict_migrate(d, M_HDICT_MIGRATE);
+  slot = _m_HDict_lookup(d, key, len, hash);
+  if (slot)
+  {
+    if (prev) *prev = slot->val;
+    slot->val = (M_PTR) val;
+    return M_TRUE;
+  }
+  if (d->growth_left == 0)
+  {
+    /* the last move should be over already, unless many were deleted */
+    _m_HDict_migrate(d, (M_SZ) -1);
+  }
+  if (d->growth_left == 0)
+  {
+    /* grow, or just sweep deleted slots if there are many */
+    const M_SZ cap = !d->capacity ? M_HDICT_MINCAP
+        : (d->num < M_HDICT_MAXLOAD(d->capacity) / 2 ? d->capacity
+        : d->capacity * 2);
+    if (!_m_HDict_grow(d, cap)) return M_FALSE;
+  }
+  i = _m_HDict_find_free(d, hash);
+  slot = &d->slots[i];
+  if (!_m_HDictSlot_set_key(slot, key, len)) return M_FALSE;
+  slot->hash = hash;
+  slot->val = (M_PTR) val;
+  if (d->ctrl[i] == M_HDICT_EMPTY) d->growth_left -= 1;
+  _m_HDict_set_ctrl(d, i, M_HDICT_H2(hash));
+  d->num += 1;
+  if (prev) *prev = (M_PTR) val;
+  return M_TRUE;
+}
+
+M_PTR
+m_HDict_unset(m_HDict* const d,
+        const M_CHAR* const key)
+{
+  M_SZ len;
+
+  assert(d);
+  assert(key && *key);
+  M_TRACE("unset ("M_PTR_FMT") key ("M_STR_FMT")", d, key);
+  if (!d || !key || !*key) return NULL;
+
+  len = strlen(key);
+  return m_HDict_unset_hashed(d, key, len, (*d->hash_fn)(key, len, d->seed));
+}
+
+M_PTR
+m_HDict_unset_hashed(m_HDict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_ID hash)
+{
+  m_HDictSlot* slot;
+  m_HDict old;
+  M_SZ i, before, after;
+  M_PTR val;
+
+  assert(d);
+  assert(key && len);
+  if (!d || !key || !len) return NULL;
+
+  _m_HDict_migrate(d, M_HDICT_MIGRATE);
+  slot = _m_HDict_lookup(d, key, len, hash);
+  if (!slot) return NULL;
+
+  val = slot->val;
+  _m_HDictSlot_fini_key(slot);
+  d->num -= 1;
+  if (_m_HDict_in_old(d, slot))
+  {
+    /* its room in the new table is free again */
+    _m_HDict_old(d, &old);
+    _m_HDict_set_ctrl(&old, slot - d->oslots, M_HDICT_DELETED);
+    d->growth_left += 1;
+    return val;
+  }
+  i = slot - d->slots;
+  /*
+   *  The slot can be marked empty again if no probe ever went past it,
+   *  that is if there is no full window of non-empty bytes around it.
+   */
+  after = _m_HDict_full_run(d, i, 1);
+  before = _m_HDict_full_run(d, i, -1);
+  if (after < d->group && before < d->group && after + before < d->group)
+  {
+    _m_HDict_set_ctrl(d, i, M_HDICT_EMPTY);
+    d->growth_left += 1;
+  }
+  else
+    _m_HDict_set_ctrl(d, i, M_HDICT_DELETED);
+  return val;
+}
+
+M_VOID
+m_HDict_traverse(m_HDict* const d,
+        M_VOID (* const func)(M_PTR))
+{
+  M_SZ i;
+
+  assert(d);
+  assert(func);
+  if (!d || !func) return;
+
+  for (i = 0; i < d->capacity + d->ocapacity; ++i)
+  {
+    const m_HDictSlot* const slot = _m_HDict_nth(d, i);
+    if (slot) (*func)(slot->val);
+  }
+}
+
+M_VOID
+m_HDict_traverse2(m_HDict* const d,
+        M_VOID (* const func)(M_PTR, M_PTR),
+        M_PTR const userdata)
+{
+  M_SZ i;
+
+  assert(d);
+  assert(func);
+  if (!d || !func) return;
+
+  for (i = 0; i < d->capacity + d->ocapacity; ++i)
+  {
+    const m_HDictSlot* const slot = _m_HDict_nth(d, i);
+    if (slot) (*func)(slot->val, userdata);
+  }
+}
+
+M_VOID
+m_HDict_traverse_keyval(m_HDict* const d,
+        M_VOID (* const func)(m_String*, M_PTR))
+{
+  m_String key;
+  M_SZ i;
+
+  assert(d);
+  assert(func);
+  if (!d || !func) return;
+
+  for (i = 0; i < d->capacity + d->ocapacity; ++i)
+  {
+    m_HDictSlot* const slot = _m_HDict_nth(d, i);
+    if (!slot) continue;
+    m_String_view(&key, m_HDictSlot_key(slot), m_HDictSlot_len(slot));
+    (*func)(&key, slot->val);
+  }
+}
+
+M_VOID
+m_HDict_traverse_keyval2(m_HDict* const d,
+        M_VOID (* const func)(m_String*, M_PTR, M_PTR),
+        M_PTR const userdata)
+{
+  m_String key;
+  M_SZ i;
+
+  assert(d);
+  assert(func);
+  if (!d || !func) return;
+
+  for (i = 0; i < d->capacity + d->ocapacity; ++i)
+  {
+    m_HDictSlot* const slot = _m_HDict_nth(d, i);
+    if (!slot) continue;
+    m_String_view(&key, m_HDictSlot_key(slot), m_HDictSlot_len(slot));
+    (*func)(&key, slot->val, userdata);
+  }
+}
+
+#ifndef NDEBUG
+
+M_BOOL
+m_HDict_check(const m_HDict* const d)
+{
+  m_HDict old;
+  M_SZ i, num = 0, deleted = 0, onum = 0;
+
+  assert(d);
+
+  if (!d->capacity)
+    return d->num == 0 && d->growth_left == 0 && !d->slots && !d->oslots;
+  if (d->capacity < M_HDICT_MINCAP || (d->capacity & (d->capacity - 1)))
+    return M_FALSE;
+  if (d->group != M_MIN(_m_HDict_simd_width(), (M_UINT32) d->capacity))
+    return M_FALSE;
+  for (i = 0; i < d->capacity + M_MIN(d->capacity, M_HDICT_GROUP); ++i)
+  {
+    const M_UINT8 c = d->ctrl[i];
+    if (i >= d->capacity)
+    {
+      if (c != d->ctrl[i - d->capacity]) return M_FALSE;
+      continue;
+    }
+    if (c == M_HDICT_DELETED) ++deleted;
+    else if (c != M_HDICT_EMPTY)
+    {
+      const m_HDictSlot* slot = &d->slots[i];
+      if (c & M_HDICT_EMPTY) return M_FALSE;
+      if (c != M_HDICT_H2(slot->hash)) return M_FALSE;
+      if (slot->hash != (*d->hash_fn)(m_HDictSlot_key(slot),
+          m_HDictSlot_len(slot), d->seed))
+        return M_FALSE;
+      if (_m_HDict_find(d, m_HDictSlot_key(slot), m_HDictSlot_len(slot),
+          slot->hash) != slot)
+        return M_FALSE;
+      ++num;
+    }
+  }
+  /* elements not moved yet are in the old table only */
+  if (d->oslots)
+  {
+    _m_HDict_old(d, &old);
+    if (d->moved >= d->ocapacity) return M_FALSE;
+    for (i = 0; i < d->ocapacity; ++i)
+    {
+      const m_HDictSlot* slot = &d->oslots[i];
+      const M_UINT8 c = d->octrl[i];
+      if (c & M_HDICT_EMPTY) continue;
+      if (i < d->moved) return M_FALSE;
+      if (c != M_HDICT_H2(slot->hash)) return M_FALSE;
+      if (_m_HDict_find(&old, m_HDictSlot_key(slot), m_HDictSlot_len(slot),
+          slot->hash) != slot)
+        return M_FALSE;
+      if (_m_HDict_find(d, m_HDictSlot_key(slot), m_HDictSlot_len(slot),
+          slot->hash))
+        return M_FALSE;
+      ++onum;
+    }
+  }
+  else if (d->octrl || d->ocapacity || d->moved)
+    return M_FALSE;
+  return num + onum == d->num
+      && num + deleted + onum + d->growth_left
+        == M_HDICT_MAXLOAD(d->capacity);
+}
+
+M_VOID
+m_HDict_debug(const m_HDict* const d)
+{
+  M_SZ i;
+
+  assert(d);
+
+  printf("-- HDict -- debug ("M_PTR_FMT"): "M_SZ_FMT"/"M_SZ_FMT" group %u\n",
+      d, d->num, d->capacity, (unsigned) d->group);
+  if (d->oslots)
+    printf("--     growing from "M_SZ_FMT", "M_SZ_FMT" moved\n",
+        d->ocapacity, d->moved);
+
+  for (i = 0; i < d->capacity + d->ocapacity; ++i)
+  {
+    const m_HDictSlot* const slot = _m_HDict_nth(d, i);
+    if (!slot) continue;
+    printf("--     ["M_SZ_FMT"] \"%s\": ("M_PTR_FMT")\n",
+        i, m_HDictSlot_key(slot), slot->val);
+  }
+
+  printf("-- end hdict debug\n");
+}
+
+#endif /* NDEBUG */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
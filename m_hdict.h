@@ -0,0 +1,338 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+/**
+ *  \file m_hdict.h
+ *  \brief Hash table for strings, with open addressing.
+ *  \author Stanislas Marquis <stan@astrorigin.com>
+ */
+
+/*
+ *  Same API as m_Dict, but elements are kept in one flat array of slots,
+ *  instead of a tree of hashes and lists of nodes.
+ *
+ *  Each slot has a control byte, that is either empty, deleted, or holds
+ *  7 bits of the hash of its key. Control bytes are scanned a group at a
+ *  time, and keys are compared only when these 7 bits match, so that a
+ *  lookup mostly touches one line of control bytes and one slot. Short
+ *  keys are kept in the slot itself, longer ones add their own buffer.
+ *
+ *  The table grows a little at a time: a new table is allocated, and
+ *  elements go over from the old one M_HDICT_MIGRATE slots per set or
+ *  unset, while lookups look in both. No single insert pays for moving
+ *  the whole table. Lookups move nothing, so that readers still share
+ *  the dict without writing to it.
+ */
+
+#ifndef M_HDICT_H
+#define M_HDICT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "m_h.h"
+#include "m_hash.h"
+#include "m_string.h"
+
+/**
+ *  \brief Maximum number of control bytes scanned at once.
+ *
+ *  Groups of 16 (SSE2) or 32 (AVX2) control bytes are compared in one
+ *  instruction when the cpu has it, checked at runtime. Elsewhere, or if
+ *  M_NO_SIMD is defined, 8 bytes are compared in a 64-bit word.
+ */
+#define M_HDICT_GROUP  32
+
+/**
+ *  \brief Minimum number of slots (a power of 2).
+ */
+#define M_HDICT_MINCAP  16
+
+/**
+ *  \brief Number of slots of the old table moved on each set or unset,
+ *  while the table grows.
+ */
+#define M_HDICT_MIGRATE 16
+
+/**
+ *  \brief Keys shorter than this are kept in their slot (with their
+ *  null char), longer ones in a buffer of their own.
+ */
+#define M_HDICT_INLINE 12
+
+/**
+ *  \typedef m_HDictSlot
+ */
+typedef struct _m_HDictSlot m_HDictSlot;
+
+/**
+ *  \struct _m_HDictSlot
+ *  \brief An element (32 bytes on 64-bit machines, two per cache line).
+ */
+struct _m_HDictSlot
+{
+  M_ID hash;
+  M_PTR val;
+  union
+  {
+    struct
+    {
+      M_UINT32 len;
+      M_CHAR data[M_HDICT_INLINE];
+    } in; /* len < M_HDICT_INLINE */
+    struct
+    {
+      M_UINT32 len;
+      M_CHAR* data;
+    } out; /* len >= M_HDICT_INLINE */
+  } key;
+};
+
+/**
+ *  \brief Get the length of a slot key.
+ */
+#define m_HDictSlot_len(slot) ((slot)->key.in.len)
+
+/**
+ *  \brief Get the null-terminated key of a slot.
+ */
+#define m_HDictSlot_key(slot) \
+  ((slot)->key.in.len < M_HDICT_INLINE \
+  ? (slot)->key.in.data : (slot)->key.out.data)
+
+/**
+ *  \typedef m_HDict
+ */
+typedef struct _m_HDict m_HDict;
+
+/**
+ *  \struct _m_HDict
+ */
+struct _m_HDict
+{
+  M_UINT8* ctrl; /* control bytes (capacity + M_HDICT_GROUP) */
+  m_HDictSlot* slots; /* slots (capacity) */
+  M_SZ capacity; /* number of slots (0, or a power of 2) */
+  M_SZ num; /* number of elements */
+  M_SZ growth_left; /* number of empty slots usable before growing */
+  M_UINT32 group; /* number of control bytes scanned at once */
+  M_UINT8* octrl; /* control bytes of the old table, while growing */
+  m_HDictSlot* oslots; /* slots of the old table, or NULL */
+  M_SZ ocapacity; /* number of slots of the old table */
+  M_SZ moved; /* number of slots of the old table already moved */
+  M_VOID (*finalize_fn)(M_PTR);
+  m_hash_fn_t hash_fn;
+  M_ID seed;
+};
+
+/**
+ *  \brief Allocate for a new hash dict.
+ *  \param d The dict.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_HDict_new(m_HDict** const d);
+
+/**
+ *  \brief Initialize a hash dict (extended version).
+ *  \param d The dict.
+ *  \param hash_fn Hash function for keys, or NULL for M_HASH_DEFAULT.
+ *  \param seed Seed given to hash_fn.
+ *  \return M_TRUE, or M_FALSE on error.
+ *  \see m_hash_seed
+ */
+M_DLLAPI M_BOOL
+m_HDict_init2(m_HDict* const d,
+        const m_hash_fn_t hash_fn,
+        const M_ID seed);
+
+/**
+ *  \brief Initialize a hash dict.
+ *
+ *  Nothing is allocated until the first element is set.
+ *  Keys are hashed with M_HASH_DEFAULT, seed 0.
+ */
+M_DLLAPI M_BOOL
+m_HDict_init(m_HDict* const d);
+
+/**
+ *  \brief Finalize a hash dict.
+ */
+M_DLLAPI M_VOID
+m_HDict_fini(m_HDict* const d);
+
+/**
+ *  \brief Delete a hash dict.
+ */
+M_DLLAPI M_VOID
+m_HDict_delete(m_HDict** const d);
+
+/**
+ *  \brief Make room for a number of elements, without growing again.
+ *  \param d The dict.
+ *  \param num Number of elements.
+ *  \return M_TRUE, or M_FALSE on error.
+ *
+ *  Elements already in the dict are all moved at once, if any.
+ */
+M_DLLAPI M_BOOL
+m_HDict_reserve(m_HDict* const d,
+        const M_SZ num);
+
+/**
+ *  \brief Get number of elements in the dict.
+ */
+#define m_HDict_count(d)  ((d)->num)
+
+/**
+ *  \brief Get an elem from the dict or NULL.
+ *  \param d The dict (not NULL).
+ *  \param key The key string (not NULL nor empty).
+ *  \return Element found, or NULL if nothing found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_HDict_get(const m_HDict* const d,
+        const M_CHAR* const key);
+
+/**
+ *  \brief Set or insert an element in the dict.
+ *  \param d The dict (not NULL).
+ *  \param key The key string (not NULL nor empty, less than 2^32 chars).
+ *  \param val The pointer value.
+ *  \param prev If not NULL, return value replaced, or value set if there was none.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_HDict_set(m_HDict* const d,
+        const M_CHAR* const key,
+        const M_PTR const val,
+        M_PTR* const prev);
+
+/**
+ *  \brief Remove an element from the dict.
+ *  \param d The dict.
+ *  \param key The key string.
+ *  \return Element that was removed, or NULL if not found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_HDict_unset(m_HDict* const d,
+        const M_CHAR* const key);
+
+/**
+ *  \brief Get an elem from the dict, for a key already hashed.
+ *  \param d The dict (not NULL).
+ *  \param key The key (not NULL).
+ *  \param len Length of key (not 0, less than 2^32).
+ *  \param hash Hash of key, computed with the hash function and seed of d.
+ *  \return Element found, or NULL.
+ */
+M_DLLAPI M_PTR
+m_HDict_get_hashed(const m_HDict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_ID hash);
+
+/**
+ *  \brief Set or insert an element, for a key already hashed.
+ *  \see m_HDict_set, m_HDict_get_hashed
+ */
+M_DLLAPI M_BOOL
+m_HDict_set_hashed(m_HDict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_ID hash,
+        const M_PTR const val,
+        M_PTR* const prev);
+
+/**
+ *  \brief Remove an element, for a key already hashed.
+ *  \see m_HDict_unset, m_HDict_get_hashed
+ */
+M_DLLAPI M_PTR
+m_HDict_unset_hashed(m_HDict* const d,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_ID hash);
+
+/**
+ *  \brief Apply a function to each value in the dict.
+ *  \param d The dict.
+ *  \param traverse_fn The function to apply.
+ */
+M_DLLAPI M_VOID
+m_HDict_traverse(m_HDict* const d,
+        M_VOID (* const traverse_fn)(M_PTR val));
+
+/**
+ *  \brief Apply a function to each value in the dict (with userdata).
+ *  \param d The dict.
+ *  \param traverse_fn The function to apply.
+ *  \param userdata Data passed to traverse_fn.
+ */
+M_DLLAPI M_VOID
+m_HDict_traverse2(m_HDict* const d,
+        M_VOID (* const traverse_fn)(M_PTR val, M_PTR udata),
+        M_PTR const userdata);
+
+/**
+ *  \brief Apply a function to each key and value in the dict.
+ *  \param d The dict.
+ *  \param traverse_fn The function to apply.
+ */
+M_DLLAPI M_VOID
+m_HDict_traverse_keyval(m_HDict* const d,
+        M_VOID (* const traverse_fn)(m_String* key, M_PTR val));
+
+/**
+ *  \brief Apply a function to each key and value in the dict (with userdata).
+ *  \param d The dict.
+ *  \param traverse_fn The function to apply.
+ *  \param userdata Data passed to traverse_fn.
+ */
+M_DLLAPI M_VOID
+m_HDict_traverse_keyval2(m_HDict* const d,
+        M_VOID (* const traverse_fn)(m_String* key, M_PTR val, M_PTR udata),
+        M_PTR const userdata);
+
+#ifndef NDEBUG
+
+/**
+ *  \brief Check the table is consistent.
+ */
+M_DLLAPI M_BOOL
+m_HDict_check(const m_HDict* const d);
+
+M_DLLAPI M_VOID
+m_HDict_debug(const m_HDict* const d);
+
+#endif /* NDEBUG */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !M_HDICT_H */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
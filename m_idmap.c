@@ -0,0 +1,403 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+#include "m_idmap.h"
+
+#include "m_memcnt.h"
+
+#undef M_TRACE
+#if defined(M_TRACE_MODE) && defined(M_TRACE_IDMAP)
+#define M_TRACE(msg, ...) _M_TRACER("-- IdMap -- "msg, __VA_ARGS__)
+#else
+#define M_TRACE(moo, ...)
+#endif
+
+/*
+ *  Home slot of a key: the finalizer of MurmurHash3 (64 bits), so that
+ *  keys in sequence or by multiples of a power of 2 spread evenly.
+ */
+static M_SZ
+_m_IdMap_home(const M_ID key,
+        const M_SZ mask)
+{
+  M_UINT64 x = (M_UINT64) key;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return (M_SZ) x & mask;
+}
+
+/*
+ *  Slot holding key (not 0), or NULL.
+ */
+static m_IdMapSlot*
+_m_IdMap_find(const m_IdMap* const m,
+        const M_ID key)
+{
+  M_SZ i, mask;
+
+  if (!m->capacity) return NULL;
+  mask = m->capacity - 1;
+  for (i = _m_IdMap_home(key, mask); m->slots[i].key; i = (i + 1) & mask)
+  {
+    if (m->slots[i].key == key) return &m->slots[i];
+  }
+  return NULL;
+}
+
+/*
+ *  Replace the array of slots, moving keys over.
+ */
+static M_BOOL
+_m_IdMap_resize(m_IdMap* const m,
+        const M_SZ capacity)
+{
+  m_IdMapSlot* slots;
+  M_SZ i, j, mask = capacity - 1;
+
+  assert(capacity && !(capacity & mask));
+  M_TRACE("resize ("M_PTR_FMT") capacity ("M_SZ_FMT")", m, capacity);
+
+  slots = _M_MALLOC(capacity * sizeof(m_IdMapSlot));
+  assert(slots);
+  if (!slots) return M_FALSE;
+  memset(slots, 0, capacity * sizeof(m_IdMapSlot));
+
+  for (i = 0; i < m->capacity; ++i)
+  {
+    if (!m->slots[i].key) continue;
+    j = _m_IdMap_home(m->slots[i].key, mask);
+    while (slots[j].key) j = (j + 1) & mask;
+    slots[j] = m->slots[i];
+  }
+  if (m->slots) _M_FREE(m->slots);
+  m->slots = slots;
+  m->capacity = capacity;
+  return M_TRUE;
+}
+
+/*
+ *  Array size for a number of keys, at most 3/4 full.
+ */
+static M_SZ
+_m_IdMap_capacity_for(const M_SZ num)
+{
+  M_SZ cap = M_IDMAP_MINCAP;
+  while (cap - cap / 4 < num) cap *= 2;
+  return cap;
+}
+
+M_BOOL
+m_IdMap_new(m_IdMap** const m)
+{
+  assert(m);
+  M_TRACE("new ("M_PTR_FMT")", m);
+  if (!m) return M_FALSE;
+
+  *m = _M_MALLOC(sizeof(m_IdMap));
+  assert(*m);
+  if (!*m) return M_FALSE;
+  return m_IdMap_init(*m);
+}
+
+M_BOOL
+m_IdMap_init(m_IdMap* const m)
+{
+  assert(m);
+  M_TRACE("init ("M_PTR_FMT")", m);
+  if (!m) return M_FALSE;
+
+  m->slots = NULL;
+  m->capacity = 0;
+  m->num = 0;
+  m->haszero = M_FALSE;
+  m->zeroval = NULL;
+  m->finalize_fn = NULL;
+  return M_TRUE;
+}
+
+M_VOID
+m_IdMap_fini(m_IdMap* const m)
+{
+  assert(m);
+  M_TRACE("fini ("M_PTR_FMT")", m);
+  if (!m) return;
+
+  if (m->finalize_fn) m_IdMap_traverse(m, m->finalize_fn);
+  if (m->slots) _M_FREE(m->slots);
+  m_IdMap_init(m);
+}
+
+M_VOID
+m_IdMap_delete(m_IdMap** const m)
+{
+  assert(m && *m);
+  M_TRACE("delete ("M_PTR_FMT")", *m);
+  if (!m || !*m) return;
+
+  m_IdMap_fini(*m);
+  _M_FREE(*m);
+  *m = NULL;
+}
+
+M_BOOL
+m_IdMap_reserve(m_IdMap* const m,
+        const M_SZ num)
+{
+  M_SZ cap;
+
+  assert(m);
+  M_TRACE("reserve ("M_PTR_FMT") num ("M_SZ_FMT")", m, num);
+  if (!m) return M_FALSE;
+
+  cap = _m_IdMap_capacity_for(num);
+  if (cap <= m->capacity) return M_TRUE;
+  return _m_IdMap_resize(m, cap);
+}
+
+M_INT8
+m_IdMap_insert(m_IdMap* const m,
+        const M_ID key,
+        const M_PTR val)
+{
+  M_SZ i, mask;
+
+  assert(m);
+  M_TRACE("insert ("M_PTR_FMT") key ("M_ID_FMT")", m, key);
+  if (!m) return -1;
+
+  if (!key)
+  {
+    if (m->haszero) return 0;
+    m->haszero = M_TRUE;
+    m->zeroval = (M_PTR) val;
+    m->num += 1;
+    return 1;
+  }
+  if (!m->capacity
+      || m->num + 1 > m->capacity - m->capacity / 4)
+  {
+    if (_m_IdMap_find(m, key)) return 0;
+    if (!_m_IdMap_resize(m, m->capacity ? m->capacity * 2 : M_IDMAP_MINCAP))
+      return -1;
+  }
+  mask = m->capacity - 1;
+  for (i = _m_IdMap_home(key, mask); m->slots[i].key; i = (i + 1) & mask)
+  {
+    if (m->slots[i].key == key) return 0;
+  }
+  m->slots[i].key = key;
+  m->slots[i].val = (M_PTR) val;
+  m->num += 1;
+  return 1;
+}
+
+M_BOOL
+m_IdMap_remove(m_IdMap* const m,
+        const M_ID key,
+        M_VOID (* const fn)(M_PTR))
+{
+  m_IdMapSlot* s;
+  M_SZ i, j, mask;
+
+  assert(m);
+  M_TRACE("remove ("M_PTR_FMT") key ("M_ID_FMT")", m, key);
+  if (!m) return M_FALSE;
+
+  if (!key)
+  {
+    if (!m->haszero) return M_FALSE;
+    if (fn) (*fn)(m->zeroval);
+    m->haszero = M_FALSE;
+    m->zeroval = NULL;
+    m->num -= 1;
+    return M_TRUE;
+  }
+  s = _m_IdMap_find(m, key);
+  if (!s) return M_FALSE;
+  if (fn) (*fn)(s->val);
+
+  /* shift back the keys that probed past the hole */
+  mask = m->capacity - 1;
+  i = (M_SZ)(s - m->slots);
+  for (j = (i + 1) & mask; m->slots[j].key; j = (j + 1) & mask)
+  {
+    const M_SZ h = _m_IdMap_home(m->slots[j].key, mask);
+    if (((j - h) & mask) >= ((j - i) & mask))
+    {
+      m->slots[i] = m->slots[j];
+      i = j;
+    }
+  }
+  m->slots[i].key = 0;
+  m->slots[i].val = NULL;
+  m->num -= 1;
+  return M_TRUE;
+}
+
+M_PTR
+m_IdMap_get(const m_IdMap* const m,
+        const M_ID key)
+{
+  m_IdMapSlot* s;
+
+  assert(m);
+  if (!m) return NULL;
+
+  if (!key) return m->haszero ? m->zeroval : NULL;
+  s = _m_IdMap_find(m, key);
+  return s ? s->val : NULL;
+}
+
+M_BOOL
+m_IdMap_set(m_IdMap* const m,
+        const M_ID key,
+        const M_PTR val,
+        M_PTR* const prev)
+{
+  m_IdMapSlot* s;
+  M_PTR* p;
+
+  assert(m);
+  M_TRACE("set ("M_PTR_FMT") key ("M_ID_FMT")", m, key);
+  if (!m) return M_FALSE;
+
+  if (!key)
+  {
+    if (!m->haszero) return M_FALSE;
+    p = &m->zeroval;
+  }
+  else
+  {
+    s = _m_IdMap_find(m, key);
+    if (!s) return M_FALSE;
+    p = &s->val;
+  }
+  if (prev) *prev = *p;
+  *p = (M_PTR) val;
+  return M_TRUE;
+}
+
+M_VOID
+m_IdMap_traverse(const m_IdMap* const m,
+        M_VOID (* const func)(M_PTR))
+{
+  M_SZ i;
+
+  assert(m);
+  assert(func);
+  if (!m || !func) return;
+
+  for (i = 0; i < m->capacity; ++i)
+  {
+    if (m->slots[i].key) (*func)(m->slots[i].val);
+  }
+  if (m->haszero) (*func)(m->zeroval);
+}
+
+M_VOID
+m_IdMap_traverse2(const m_IdMap* const m,
+        M_VOID (* const func)(M_PTR, M_PTR),
+        M_PTR userdata)
+{
+  M_SZ i;
+
+  assert(m);
+  assert(func);
+  if (!m || !func) return;
+
+  for (i = 0; i < m->capacity; ++i)
+  {
+    if (m->slots[i].key) (*func)(m->slots[i].val, userdata);
+  }
+  if (m->haszero) (*func)(m->zeroval, userdata);
+}
+
+/*
+ *  Move an iterator to the first entry from its position on.
+ */
+static M_BOOL
+_m_IdMapIter_settle(m_IdMapIter* const it)
+{
+  const m_IdMap* const m = it->m;
+
+  for (; it->pos < m->capacity; ++it->pos)
+  {
+    if (m->slots[it->pos].key) return M_TRUE;
+  }
+  if (it->pos == m->capacity && m->haszero) return M_TRUE;
+  it->pos = m->capacity + 1;
+  return M_FALSE;
+}
+
+M_BOOL
+m_IdMapIter_begin(m_IdMapIter* const it,
+        const m_IdMap* const m)
+{
+  assert(it);
+  assert(m);
+  if (!it || !m) return M_FALSE;
+
+  it->m = m;
+  it->pos = 0;
+  return _m_IdMapIter_settle(it);
+}
+
+M_BOOL
+m_IdMapIter_next(m_IdMapIter* const it)
+{
+  assert(it);
+  if (!it || it->pos > it->m->capacity) return M_FALSE;
+
+  it->pos += 1;
+  return _m_IdMapIter_settle(it);
+}
+
+#ifndef NDEBUG
+
+M_BOOL
+m_IdMap_check(const m_IdMap* const m)
+{
+  M_SZ i, num = 0;
+
+  assert(m);
+
+  for (i = 0; i < m->capacity; ++i)
+  {
+    if (!m->slots[i].key) continue;
+    if (_m_IdMap_find(m, m->slots[i].key) != &m->slots[i]) return M_FALSE;
+    num += 1;
+  }
+  if (m->haszero) num += 1;
+  if (num != m->num) return M_FALSE;
+  if (m->capacity && m->num > m->capacity - m->capacity / 4) return M_FALSE;
+  return M_TRUE;
+}
+
+#endif /* NDEBUG */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
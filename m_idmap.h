@@ -0,0 +1,258 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+/**
+ *  \file m_idmap.h
+ *  \brief Hash map of M_ID keys, with open addressing.
+ *  \author Stanislas Marquis <stan@astrorigin.com>
+ */
+
+/*
+ *  For M_ID -> M_PTR maps without order: no rotations, and most lookups
+ *  read a single cache line.
+ *
+ *  Slots are pairs of key and value in one array, whose size is a power
+ *  of 2. Keys are scrambled by an integer mixer and probed linearly. Key 0
+ *  marks empty slots, so the value of key 0 is kept aside. Removal shifts
+ *  the following keys back instead of leaving tombstones.
+ *
+ *  The array is taken from the system allocator (or memcnt), never from
+ *  the mempool, so that the mempool can index its buckets with it.
+ */
+
+#ifndef M_IDMAP_H
+#define M_IDMAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "m_h.h"
+
+/**
+ *  \brief Smallest size of the array of slots.
+ */
+#define M_IDMAP_MINCAP  8
+
+/**
+ *  \typedef m_IdMapSlot
+ */
+typedef struct _m_IdMapSlot m_IdMapSlot;
+
+/**
+ *  \struct _m_IdMapSlot
+ */
+struct _m_IdMapSlot
+{
+  M_ID key; /* 0 if empty */
+  M_PTR val;
+};
+
+/**
+ *  \typedef m_IdMap
+ */
+typedef struct _m_IdMap m_IdMap;
+
+/**
+ *  \struct _m_IdMap
+ */
+struct _m_IdMap
+{
+  m_IdMapSlot* slots; /* array of slots, or NULL */
+  M_SZ capacity; /* size of array, a power of 2 (or 0) */
+  M_SZ num; /* number of keys, key 0 included */
+  M_BOOL haszero; /* if key 0 is present */
+  M_PTR zeroval; /* value of key 0 */
+  M_VOID (*finalize_fn)(M_PTR);
+};
+
+/**
+ *  \brief Allocate for a new idmap.
+ *  \param m The idmap.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_IdMap_new(m_IdMap** const m);
+
+/**
+ *  \brief Initialize an idmap.
+ *  \param m The idmap.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_IdMap_init(m_IdMap* const m);
+
+/**
+ *  \brief Finalize an idmap.
+ *
+ *  If not NULL, m->finalize_fn is executed on the values.
+ */
+M_DLLAPI M_VOID
+m_IdMap_fini(m_IdMap* const m);
+
+/**
+ *  \brief Deallocate an idmap.
+ */
+M_DLLAPI M_VOID
+m_IdMap_delete(m_IdMap** const m);
+
+/**
+ *  \brief Make room for a number of keys.
+ *  \param m The idmap.
+ *  \param num Total number of keys expected.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_IdMap_reserve(m_IdMap* const m,
+        const M_SZ num);
+
+/**
+ *  \brief Insert a new key.
+ *  \param m The idmap.
+ *  \param key The key.
+ *  \param val The value.
+ *  \return 1 on success, 0 if the key is duplicate, -1 on error.
+ */
+M_DLLAPI M_INT8
+m_IdMap_insert(m_IdMap* const m,
+        const M_ID key,
+        const M_PTR val);
+
+/**
+ *  \brief Remove a key.
+ *  \param m The idmap.
+ *  \param key The key.
+ *  \param fn If not null, execute function on value of found key.
+ *  \return M_TRUE if the key was found.
+ */
+M_DLLAPI M_BOOL
+m_IdMap_remove(m_IdMap* const m,
+        const M_ID key,
+        M_VOID (* const fn)(M_PTR));
+
+/**
+ *  \brief Get a value, or NULL.
+ */
+M_DLLAPI M_PTR
+m_IdMap_get(const m_IdMap* const m,
+        const M_ID key);
+
+/**
+ *  \brief Set the value for a key already in the idmap.
+ *  \param m The idmap.
+ *  \param key The key.
+ *  \param val The value.
+ *  \param prev If not NULL, return value replaced.
+ *  \return M_TRUE if the key was found and value changed.
+ */
+M_DLLAPI M_BOOL
+m_IdMap_set(m_IdMap* const m,
+        const M_ID key,
+        const M_PTR val,
+        M_PTR* const prev);
+
+/**
+ *  \brief Count the keys inside an idmap.
+ */
+#define m_IdMap_count( m ) \
+        ((m)->num)
+
+/**
+ *  \brief Apply a function to each value, in no particular order.
+ */
+M_DLLAPI M_VOID
+m_IdMap_traverse(const m_IdMap* const m,
+        M_VOID (* const func)(M_PTR));
+
+/**
+ *  \brief Apply a function to each value, in no particular order
+ *  (userdata version).
+ */
+M_DLLAPI M_VOID
+m_IdMap_traverse2(const m_IdMap* const m,
+        M_VOID (* const func)(M_PTR, M_PTR),
+        M_PTR userdata);
+
+/**
+ *  \typedef m_IdMapIter
+ */
+typedef struct _m_IdMapIter m_IdMapIter;
+
+/**
+ *  \struct _m_IdMapIter
+ *  \brief Iterator over an idmap, in no particular order.
+ *
+ *  It is valid as long as the idmap is not modified.
+ */
+struct _m_IdMapIter
+{
+  const m_IdMap* m;
+  M_SZ pos; /* index of slot, or capacity for key 0 */
+};
+
+/**
+ *  \brief Get the key of the current entry (iterator must be valid).
+ */
+#define m_IdMapIter_key( it ) \
+        ((it)->pos < (it)->m->capacity ? (it)->m->slots[(it)->pos].key : 0)
+
+/**
+ *  \brief Get the value of the current entry (iterator must be valid).
+ */
+#define m_IdMapIter_val( it ) \
+        ((it)->pos < (it)->m->capacity ? (it)->m->slots[(it)->pos].val \
+        : (it)->m->zeroval)
+
+/**
+ *  \brief Place an iterator on the first entry of an idmap.
+ *  \return M_TRUE, or M_FALSE if the idmap is empty.
+ */
+M_DLLAPI M_BOOL
+m_IdMapIter_begin(m_IdMapIter* const it,
+        const m_IdMap* const m);
+
+/**
+ *  \brief Move an iterator to the next entry.
+ *  \return M_TRUE, or M_FALSE if there is no next entry.
+ */
+M_DLLAPI M_BOOL
+m_IdMapIter_next(m_IdMapIter* const it);
+
+#ifndef NDEBUG
+
+/**
+ *  \brief Check that all keys can be found, and the count.
+ */
+M_DLLAPI M_BOOL
+m_IdMap_check(const m_IdMap* const m);
+
+#endif /* NDEBUG */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !M_IDMAP_H */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
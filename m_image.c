@@ -0,0 +1,577 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+#ifndef _MSC_VER
+#define _POSIX_C_SOURCE 200112L /* for mmap, fstat */
+#endif
+
+#include "m_image.h"
+
+#include "m_hash.h"
+#include "m_memcnt.h"
+
+#ifdef _MSC_VER
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#undef M_TRACE
+#if defined(M_TRACE_MODE) && defined(M_TRACE_IMAGE)
+#define M_TRACE(msg, ...) _M_TRACER("-- Image -- "msg, __VA_ARGS__)
+#else
+#define M_TRACE(moo, ...)
+#endif
+
+#define M_IMAGE_BYTEORDER 0x01020304U
+
+/* hash of keys in dict images, not to change without M_IMAGE_VERSION */
+#define _m_Image_hash(k, len) \
+        m_hash_wy((M_PTR)(k), (len), 0)
+
+/* round up to a multiple of 8 bytes */
+#define _m_Image_align(n) \
+        (((n) + 7) & ~(M_UINT64) 7)
+
+#define _m_Image_keys(img) \
+        ((const M_UINT64*)((img)->base + sizeof(m_ImageHeader)))
+
+#define _m_Image_refs(img) \
+        ((const m_ImageRef*)((img)->base + sizeof(m_ImageHeader) \
+        + m_Image_count(img) * sizeof(M_UINT64)))
+
+#define _m_Image_slots(img) \
+        ((const m_ImageSlot*)((img)->base + sizeof(m_ImageHeader)))
+
+#define M_IMAGE_FNV_BASIS 0xCBF29CE484222325ULL
+#define M_IMAGE_FNV_PRIME 0x100000001B3ULL
+
+/*
+ *  FNV-1a over 64-bit words (len is a multiple of 8).
+ */
+static M_UINT64
+_m_Image_sum(M_UINT64 h,
+        const M_UINT8* const p,
+        const M_SZ len)
+{
+  M_UINT64 w;
+  M_SZ i;
+
+  for (i = 0; i < len; i += 8)
+  {
+    memcpy(&w, p + i, 8);
+    h = (h ^ w) * M_IMAGE_FNV_PRIME;
+  }
+  return h;
+}
+
+/*
+ *  Buffered writes after the header, summed as they go.
+ */
+
+#define M_IMAGE_BUFSZ 65536 /* a multiple of 8 */
+
+typedef struct
+{
+  FILE* f;
+  M_UINT64 sum;
+  M_UINT64 pos; /* offset in the image */
+  M_SZ used;
+  M_UINT8 buf[M_IMAGE_BUFSZ];
+}
+_m_ImageWriter;
+
+static M_BOOL
+_m_ImageWriter_flush(_m_ImageWriter* const w)
+{
+  w->sum = _m_Image_sum(w->sum, w->buf, w->used);
+  if (w->used && fwrite(w->buf, w->used, 1, w->f) != 1) return M_FALSE;
+  w->used = 0;
+  return M_TRUE;
+}
+
+static M_BOOL
+_m_ImageWriter_write(_m_ImageWriter* const w,
+        const M_PTR data,
+        M_SZ len)
+{
+  const M_UINT8* p = data;
+  M_SZ n;
+
+  while (len)
+  {
+    if (w->used == M_IMAGE_BUFSZ && !_m_ImageWriter_flush(w)) return M_FALSE;
+    n = M_MIN(len, M_IMAGE_BUFSZ - w->used);
+    memcpy(w->buf + w->used, p, n);
+    w->used += n;
+    w->pos += n;
+    p += n;
+    len -= n;
+  }
+  return M_TRUE;
+}
+
+/*
+ *  Write bytes followed by zeros, up to the next multiple of 8.
+ */
+static M_BOOL
+_m_ImageWriter_blob(_m_ImageWriter* const w,
+        const M_PTR data,
+        const M_SZ len)
+{
+  static const M_UINT8 zeros[8] = {0};
+
+  return _m_ImageWriter_write(w, data, len)
+      && _m_ImageWriter_write(w, (M_PTR) zeros,
+        (M_SZ)(_m_Image_align(len + 1) - len));
+}
+
+static M_SZ
+_m_Image_val(const m_image_val_fn_t val_fn,
+        M_PTR const* const val,
+        M_PTR* const data)
+{
+  if (val_fn) return (*val_fn)(*val, data);
+  *data = (M_PTR) val;
+  return sizeof(M_PTR);
+}
+
+static _m_ImageWriter*
+_m_Image_begin(const M_CHAR* const path,
+        m_ImageHeader* const h,
+        const M_UINT32 kind)
+{
+  _m_ImageWriter* w = _M_MALLOC(sizeof(_m_ImageWriter));
+
+  assert(w);
+  if (!w) return NULL;
+  memset(h, 0, sizeof(m_ImageHeader));
+  memcpy(h->magic, M_IMAGE_MAGIC, sizeof(M_IMAGE_MAGIC));
+  h->version = M_IMAGE_VERSION;
+  h->kind = kind;
+  h->byteorder = M_IMAGE_BYTEORDER;
+  w->f = fopen(path, "wb");
+  if (!w->f
+      || fwrite(h, sizeof(m_ImageHeader), 1, w->f) != 1)
+  {
+    if (w->f) fclose(w->f);
+    _M_FREE(w);
+    return NULL;
+  }
+  w->sum = M_IMAGE_FNV_BASIS;
+  w->pos = sizeof(m_ImageHeader);
+  w->used = 0;
+  return w;
+}
+
+/*
+ *  Flush, write the final header, and close. Remove the file on error.
+ */
+static M_BOOL
+_m_Image_end(_m_ImageWriter* const w,
+        m_ImageHeader* const h,
+        const M_CHAR* const path,
+        M_BOOL ok)
+{
+  ok = ok && _m_ImageWriter_flush(w);
+  if (ok)
+  {
+    assert(w->pos == h->size);
+    h->checksum = w->sum;
+    ok = fseek(w->f, 0, SEEK_SET) == 0
+        && fwrite(h, sizeof(m_ImageHeader), 1, w->f) == 1;
+  }
+  ok = fclose(w->f) == 0 && ok;
+  if (!ok) remove(path);
+  _M_FREE(w);
+  return ok;
+}
+
+M_BOOL
+m_Image_write_btree(const m_BTree* const bt,
+        const M_CHAR* const path,
+        const m_image_val_fn_t val_fn)
+{
+  m_ImageHeader h;
+  m_ImageRef ref;
+  _m_ImageWriter* w;
+  const m_BTNode* nd;
+  M_PTR data;
+  M_UINT64 key;
+  M_SZ len;
+  M_BOOL ok = M_TRUE;
+
+  assert(bt && path);
+  M_TRACE("write btree ("M_PTR_FMT") path (%s)", bt, path);
+  if (!bt || !path) return M_FALSE;
+
+  w = _m_Image_begin(path, &h, M_IMAGE_BTREE);
+  if (!w) return M_FALSE;
+  h.num = m_BTree_count(bt);
+  h.data = sizeof(m_ImageHeader)
+      + h.num * (sizeof(M_UINT64) + sizeof(m_ImageRef));
+
+  for (nd = m_BTree_least(bt); ok && nd; nd = m_BTree_next(nd))
+  {
+    key = nd->key;
+    ok = _m_ImageWriter_write(w, &key, sizeof(key));
+  }
+  ref.off = h.data;
+  for (nd = m_BTree_least(bt); ok && nd; nd = m_BTree_next(nd))
+  {
+    ref.len = _m_Image_val(val_fn, &nd->val, &data);
+    ok = _m_ImageWriter_write(w, &ref, sizeof(ref));
+    ref.off += _m_Image_align(ref.len + 1);
+  }
+  h.size = ref.off;
+  for (nd = m_BTree_least(bt); ok && nd; nd = m_BTree_next(nd))
+  {
+    len = _m_Image_val(val_fn, &nd->val, &data);
+    ok = _m_ImageWriter_blob(w, data, len);
+  }
+  return _m_Image_end(w, &h, path, ok);
+}
+
+M_BOOL
+m_Image_write_dict(const m_Dict* const d,
+        const M_CHAR* const path,
+        const m_image_val_fn_t val_fn)
+{
+  m_ImageHeader h;
+  m_ImageSlot* slots;
+  m_ImageSlot* s;
+  _m_ImageWriter* w;
+  const m_BTNode* nd;
+  const m_DictNode* n;
+  M_PTR data;
+  M_UINT64 off, hash, mask;
+  M_SZ len;
+  M_BOOL ok = M_TRUE;
+
+  assert(d && path);
+  M_TRACE("write dict ("M_PTR_FMT") path (%s)", d, path);
+  if (!d || !path) return M_FALSE;
+
+  w = _m_Image_begin(path, &h, M_IMAGE_DICT);
+  if (!w) return M_FALSE;
+
+  for (nd = m_BTree_least(&d->tree); nd; nd = m_BTree_next(nd))
+  {
+    for (n = nd->val; n; n = n->next) h.num += 1;
+  }
+  /* at most half full, so that probes end soon on an empty slot */
+  for (h.nslots = 2; h.nslots < 2 * h.num; h.nslots *= 2) ;
+  h.data = sizeof(m_ImageHeader) + h.nslots * sizeof(m_ImageSlot);
+  slots = _M_MALLOC((M_SZ) h.nslots * sizeof(m_ImageSlot));
+  assert(slots);
+  if (!slots) return _m_Image_end(w, &h, path, M_FALSE);
+  memset(slots, 0, (M_SZ) h.nslots * sizeof(m_ImageSlot));
+
+  /* place entries, their key then their value in the data */
+  mask = h.nslots - 1;
+  off = h.data;
+  for (nd = m_BTree_least(&d->tree); ok && nd; nd = m_BTree_next(nd))
+  {
+    for (n = nd->val; ok && n; n = n->next)
+    {
+      len = _m_Image_val(val_fn, &n->val, &data);
+      if (n->len > 0xFFFFFFFFU || len > 0xFFFFFFFFU)
+      {
+        ok = M_FALSE;
+        break;
+      }
+      hash = _m_Image_hash(n->key, n->len);
+      for (s = &slots[hash & mask]; s->key; )
+        s = &slots[(s - slots + 1) & mask];
+      s->hash = hash;
+      s->key = off;
+      s->keylen = (M_UINT32) n->len;
+      off += _m_Image_align(n->len + 1);
+      s->val = off;
+      s->vallen = (M_UINT32) len;
+      off += _m_Image_align(len + 1);
+    }
+  }
+  h.size = off;
+  ok = ok && _m_ImageWriter_write(w, slots,
+      (M_SZ) h.nslots * sizeof(m_ImageSlot));
+  _M_FREE(slots);
+
+  for (nd = m_BTree_least(&d->tree); ok && nd; nd = m_BTree_next(nd))
+  {
+    for (n = nd->val; ok && n; n = n->next)
+    {
+      len = _m_Image_val(val_fn, &n->val, &data);
+      ok = _m_ImageWriter_blob(w, (M_PTR) n->key, n->len)
+          && _m_ImageWriter_blob(w, data, len);
+    }
+  }
+  return _m_Image_end(w, &h, path, ok);
+}
+
+/*
+ *  Check that the header and the index fit in the image.
+ */
+static M_BOOL
+_m_Image_check(const m_Image* const img)
+{
+  const m_ImageHeader* const h = m_Image_header(img);
+  M_UINT64 index;
+
+  if (img->size < sizeof(m_ImageHeader)
+      || ((M_SZ) img->base & 7)
+      || memcmp(h->magic, M_IMAGE_MAGIC, sizeof(M_IMAGE_MAGIC))
+      || h->version != M_IMAGE_VERSION
+      || h->byteorder != M_IMAGE_BYTEORDER
+      || h->size != img->size
+      || h->data > h->size
+      || (h->data & 7)
+      || (h->size & 7))
+    return M_FALSE;
+
+  switch (h->kind)
+  {
+  case M_IMAGE_BTREE:
+    if (h->num > h->size / (sizeof(M_UINT64) + sizeof(m_ImageRef)))
+      return M_FALSE;
+    index = h->num * (sizeof(M_UINT64) + sizeof(m_ImageRef));
+    break;
+  case M_IMAGE_DICT:
+    if (h->nslots < 2
+        || (h->nslots & (h->nslots - 1))
+        || h->nslots > h->size / sizeof(m_ImageSlot)
+        || h->num >= h->nslots)
+      return M_FALSE;
+    index = h->nslots * sizeof(m_ImageSlot);
+    break;
+  default:
+    return M_FALSE;
+  }
+  return sizeof(m_ImageHeader) + index <= h->data;
+}
+
+M_BOOL
+m_Image_open_mem(m_Image* const img,
+        const M_PTR data,
+        const M_SZ size)
+{
+  assert(img && data);
+  M_TRACE("open mem ("M_PTR_FMT") data ("M_PTR_FMT")", img, data);
+  if (!img || !data) return M_FALSE;
+
+  img->base = data;
+  img->size = size;
+  img->mapped = M_FALSE;
+  if (_m_Image_check(img)) return M_TRUE;
+  img->base = NULL;
+  img->size = 0;
+  return M_FALSE;
+}
+
+M_BOOL
+m_Image_open(m_Image* const img,
+        const M_CHAR* const path)
+{
+  M_PTR p;
+  M_SZ size;
+#ifdef _MSC_VER
+  HANDLE file, map;
+  LARGE_INTEGER sz;
+#else
+  struct stat st;
+  int fd;
+#endif
+
+  assert(img && path);
+  M_TRACE("open ("M_PTR_FMT") path (%s)", img, path);
+  if (!img || !path) return M_FALSE;
+
+  img->base = NULL;
+  img->size = 0;
+#ifdef _MSC_VER
+  file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) return M_FALSE;
+  if (!GetFileSizeEx(file, &sz)
+      || sz.QuadPart < (LONGLONG) sizeof(m_ImageHeader)
+      || (ULONGLONG) sz.QuadPart > (SIZE_T) -1)
+  {
+    CloseHandle(file);
+    return M_FALSE;
+  }
+  size = (M_SZ) sz.QuadPart;
+  map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!map) return M_FALSE;
+  p = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(map);
+  if (!p) return M_FALSE;
+#else
+  fd = open(path, O_RDONLY);
+  if (fd < 0) return M_FALSE;
+  if (fstat(fd, &st) != 0
+      || st.st_size < (off_t) sizeof(m_ImageHeader)
+      || (M_UINT64) st.st_size > (M_SZ) -1)
+  {
+    close(fd);
+    return M_FALSE;
+  }
+  size = (M_SZ) st.st_size;
+  p = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return M_FALSE;
+#endif
+  img->base = p;
+  img->size = size;
+  img->mapped = M_TRUE;
+  if (_m_Image_check(img)) return M_TRUE;
+  m_Image_close(img);
+  return M_FALSE;
+}
+
+M_VOID
+m_Image_close(m_Image* const img)
+{
+  assert(img);
+  M_TRACE("close ("M_PTR_FMT")", img);
+  if (!img) return;
+
+  if (img->base && img->mapped)
+  {
+#ifdef _MSC_VER
+    UnmapViewOfFile(img->base);
+#else
+    munmap((M_PTR) img->base, img->size);
+#endif
+  }
+  img->base = NULL;
+  img->size = 0;
+  img->mapped = M_FALSE;
+}
+
+M_BOOL
+m_Image_verify(const m_Image* const img)
+{
+  assert(img && img->base);
+  if (!img || !img->base) return M_FALSE;
+
+  return _m_Image_sum(M_IMAGE_FNV_BASIS, img->base + sizeof(m_ImageHeader),
+      img->size - sizeof(m_ImageHeader)) == m_Image_header(img)->checksum;
+}
+
+/*
+ *  Get bytes of the data, or NULL if they are not all in the image.
+ */
+static M_PTR
+_m_Image_data(const m_Image* const img,
+        const M_UINT64 off,
+        const M_UINT64 len)
+{
+  if (off >= img->size || len >= img->size - off) return NULL;
+  return (M_PTR)(img->base + off);
+}
+
+M_PTR
+m_Image_btree_get(const m_Image* const img,
+        const M_ID key,
+        M_SZ* const len)
+{
+  const M_UINT64* p;
+  const m_ImageRef* ref;
+  M_UINT64 n, half;
+
+  assert(img && img->base);
+  assert(m_Image_header(img)->kind == M_IMAGE_BTREE);
+  if (!img || !img->base || m_Image_header(img)->kind != M_IMAGE_BTREE)
+    return NULL;
+
+  n = m_Image_count(img);
+  if (!n) return NULL;
+  /* last key not greater than key, with no branch to mispredict */
+  p = _m_Image_keys(img);
+  while (n > 1)
+  {
+    half = n / 2;
+    p = p[half] <= key ? p + half : p;
+    n -= half;
+  }
+  if (*p != key) return NULL;
+  ref = &_m_Image_refs(img)[p - _m_Image_keys(img)];
+  if (len) *len = (M_SZ) ref->len;
+  return _m_Image_data(img, ref->off, ref->len);
+}
+
+M_PTR
+m_Image_dict_get(const m_Image* const img,
+        const M_CHAR* const key,
+        M_SZ* const len)
+{
+  assert(key);
+  if (!key) return NULL;
+
+  return m_Image_dict_get_len(img, key, strlen(key), len);
+}
+
+M_PTR
+m_Image_dict_get_len(const m_Image* const img,
+        const M_CHAR* const key,
+        const M_SZ keylen,
+        M_SZ* const len)
+{
+  const m_ImageSlot* slots;
+  const m_ImageSlot* s;
+  const M_CHAR* k;
+  M_UINT64 hash, mask, i, j;
+
+  assert(img && img->base);
+  assert(m_Image_header(img)->kind == M_IMAGE_DICT);
+  assert(key && keylen);
+  if (!img || !img->base || m_Image_header(img)->kind != M_IMAGE_DICT
+      || !key || !keylen)
+    return NULL;
+
+  slots = _m_Image_slots(img);
+  hash = _m_Image_hash(key, keylen);
+  mask = m_Image_header(img)->nslots - 1;
+  for (i = hash & mask, j = 0; j <= mask; i = (i + 1) & mask, ++j)
+  {
+    s = &slots[i];
+    if (!s->key) return NULL;
+    if (s->hash != hash || s->keylen != keylen) continue;
+    k = _m_Image_data(img, s->key, s->keylen);
+    if (k && !memcmp(k, key, keylen))
+    {
+      if (len) *len = s->vallen;
+      return _m_Image_data(img, s->val, s->vallen);
+    }
+  }
+  return NULL; /* no empty slot, the image is damaged */
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
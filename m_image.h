@@ -0,0 +1,283 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+/**
+ *  \file m_image.h
+ *  \brief Read-only images of trees and dicts, to map from files.
+ *  \author Stanislas Marquis <stan@astrorigin.com>
+ */
+
+/*
+ *  An image is a file written once from an m_BTree or an m_Dict, and then
+ *  mapped in memory and searched as it is: opening it reads nothing but
+ *  the header, lookups allocate nothing, and the pages of the file are
+ *  loaded by the system as they are touched.
+ *
+ *  All positions in an image are offsets from its start, so it can be
+ *  mapped anywhere. Numbers are in native byte order, and the header
+ *  tells which, so that an image from another kind of machine is refused.
+ *
+ *  Layout, every part aligned on 8 bytes:
+ *
+ *    header    (64 bytes, see m_ImageHeader)
+ *    index     tree: num sorted keys (8 bytes each), then num values
+ *                    (m_ImageRef each)
+ *              dict: nslots slots (m_ImageSlot each), open addressing
+ *                    with linear probing, a slot with key 0 is empty
+ *    data      keys of a dict and all values, each followed by a zero
+ *              byte, so that strings can be used as they are
+ *
+ *  Values are whatever bytes a function tells for each value of the tree
+ *  or dict. Without that function, the value pointers themselves are
+ *  written (for trees and dicts holding numbers).
+ *
+ *  The checksum covers everything after the header. Checking it reads
+ *  the whole file, so it is left to m_Image_verify.
+ */
+
+#ifndef M_IMAGE_H
+#define M_IMAGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "m_h.h"
+#include "m_btree.h"
+#include "m_dict.h"
+
+/**
+ *  \def M_IMAGE_MAGIC
+ *  \brief First 8 bytes of an image.
+ */
+#define M_IMAGE_MAGIC   "muimage"
+
+/**
+ *  \def M_IMAGE_VERSION
+ *  \brief Version of the format, changed with any change in the layout
+ *  or in the hash function of dict images.
+ */
+#define M_IMAGE_VERSION 1
+
+/**
+ *  \def M_IMAGE_BTREE
+ *  \brief Kind of image, of an m_BTree.
+ */
+#define M_IMAGE_BTREE   1
+
+/**
+ *  \def M_IMAGE_DICT
+ *  \brief Kind of image, of an m_Dict.
+ */
+#define M_IMAGE_DICT    2
+
+typedef struct _m_ImageHeader m_ImageHeader;
+
+/**
+ *  \struct _m_ImageHeader
+ */
+struct _m_ImageHeader
+{
+  M_CHAR magic[8];
+  M_UINT32 version;
+  M_UINT32 kind;
+  M_UINT32 byteorder; /* 0x01020304, as written by the machine */
+  M_UINT32 reserved;
+  M_UINT64 num; /* number of entries */
+  M_UINT64 nslots; /* number of slots of a dict, a power of 2 */
+  M_UINT64 data; /* offset of the data */
+  M_UINT64 size; /* size of the image */
+  M_UINT64 checksum; /* FNV-1a of everything after the header */
+};
+
+typedef struct _m_ImageRef m_ImageRef;
+
+/**
+ *  \struct _m_ImageRef
+ *  \brief Bytes in the data of an image.
+ */
+struct _m_ImageRef
+{
+  M_UINT64 off;
+  M_UINT64 len;
+};
+
+typedef struct _m_ImageSlot m_ImageSlot;
+
+/**
+ *  \struct _m_ImageSlot
+ *  \brief Entry of a dict image.
+ */
+struct _m_ImageSlot
+{
+  M_UINT64 hash;
+  M_UINT64 key; /* offset of the key, or 0 */
+  M_UINT64 val; /* offset of the value */
+  M_UINT32 keylen;
+  M_UINT32 vallen;
+};
+
+typedef struct _m_Image m_Image;
+
+/**
+ *  \struct _m_Image
+ *  \brief An opened image.
+ */
+struct _m_Image
+{
+  const M_UINT8* base;
+  M_SZ size;
+  M_BOOL mapped; /* else given by m_Image_open_mem */
+};
+
+/**
+ *  \brief Function type giving the bytes to write for a value.
+ *  \param val The value.
+ *  \param data Set to the bytes of the value.
+ *  \return The number of bytes.
+ *
+ *  It is called twice for each value, and must give the same bytes.
+ */
+typedef M_SZ (*m_image_val_fn_t)(const M_PTR val, M_PTR* data);
+
+/**
+ *  \brief Write the image of a tree to a file.
+ *  \param bt The tree.
+ *  \param path The file, replaced if it exists.
+ *  \param val_fn The function giving the bytes of values, or NULL.
+ *  \return M_FALSE on error (see errno).
+ */
+M_DLLAPI M_BOOL
+m_Image_write_btree(const m_BTree* const bt,
+        const M_CHAR* const path,
+        const m_image_val_fn_t val_fn);
+
+/**
+ *  \brief Write the image of a dict to a file.
+ *  \param d The dict.
+ *  \param path The file, replaced if it exists.
+ *  \param val_fn The function giving the bytes of values, or NULL.
+ *  \return M_FALSE on error (see errno), or if a key is longer than 4GB.
+ */
+M_DLLAPI M_BOOL
+m_Image_write_dict(const m_Dict* const d,
+        const M_CHAR* const path,
+        const m_image_val_fn_t val_fn);
+
+/**
+ *  \brief Map an image file in memory, read-only.
+ *  \param img The image.
+ *  \param path The file.
+ *  \return M_FALSE on error, or if the header is not valid.
+ */
+M_DLLAPI M_BOOL
+m_Image_open(m_Image* const img,
+        const M_CHAR* const path);
+
+/**
+ *  \brief Use an image already in memory, aligned on 8 bytes.
+ *  \param img The image.
+ *  \param data Start of the image, kept until m_Image_close.
+ *  \param size Number of bytes.
+ *  \return M_FALSE if the header is not valid.
+ */
+M_DLLAPI M_BOOL
+m_Image_open_mem(m_Image* const img,
+        const M_PTR data,
+        const M_SZ size);
+
+/**
+ *  \brief Unmap an image. Pointers got from it are no more valid.
+ */
+M_DLLAPI M_VOID
+m_Image_close(m_Image* const img);
+
+/**
+ *  \brief Check the checksum of an image.
+ */
+M_DLLAPI M_BOOL
+m_Image_verify(const m_Image* const img);
+
+/**
+ *  \def m_Image_header( img )
+ *  \brief Get the header of an image.
+ */
+#define m_Image_header( img ) \
+        ((const m_ImageHeader*)(img)->base)
+
+/**
+ *  \def m_Image_count( img )
+ *  \brief Get the number of entries of an image.
+ */
+#define m_Image_count( img ) \
+        (m_Image_header( img )->num)
+
+/**
+ *  \brief Get a value from the image of a tree.
+ *  \param img The image.
+ *  \param key The key.
+ *  \param len Set to the length of the value, if not NULL.
+ *  \return The bytes of the value, followed by a zero byte, or NULL if not
+ *  found (or the image is not of a tree).
+ */
+M_DLLAPI M_PTR
+m_Image_btree_get(const m_Image* const img,
+        const M_ID key,
+        M_SZ* const len);
+
+/**
+ *  \brief Get a value from the image of a dict.
+ *  \param img The image.
+ *  \param key The key, null-terminated.
+ *  \param len Set to the length of the value, if not NULL.
+ *  \return The bytes of the value, followed by a zero byte, or NULL if not
+ *  found (or the image is not of a dict).
+ */
+M_DLLAPI M_PTR
+m_Image_dict_get(const m_Image* const img,
+        const M_CHAR* const key,
+        M_SZ* const len);
+
+/**
+ *  \brief Get a value from the image of a dict.
+ *  \param img The image.
+ *  \param key The key.
+ *  \param keylen Length of key.
+ *  \param len Set to the length of the value, if not NULL.
+ *  \return The bytes of the value, followed by a zero byte, or NULL if not
+ *  found (or the image is not of a dict).
+ */
+M_DLLAPI M_PTR
+m_Image_dict_get_len(const m_Image* const img,
+        const M_CHAR* const key,
+        const M_SZ keylen,
+        M_SZ* const len);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !M_IMAGE_H */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -77,11 +77,11 @@ m_MemCnt_free(const M_PTR p)
 
   M_TRACE("freeing tracked ("M_PTR_FMT"):", p);
 
-  assert(_m_MemCnt_nodes);
   assert(p);
   if (!p) return;
 
   m_MemCnt_lock();
+  assert(_m_MemCnt_nodes);
   for (nd = _m_MemCnt_nodes; nd; nd = nd->next)
   {
     if (nd->data == p)
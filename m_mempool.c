@@ -26,10 +26,24 @@ SOFTWARE.
 
 #ifndef M_NO_MEMPOOL
 
+#ifndef _MSC_VER
+#define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE /* for MAP_ANONYMOUS */
+#endif
+
 #include "m_mempool.h"
 
 #include "m_memcnt.h"
-#include "m_sllist.h"
+#include "m_mutex.h"
+
+#ifdef _MSC_VER
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
 
 #undef M_TRACE
 #if defined(M_TRACE_MODE) && defined(M_TRACE_MEMPOOL)
@@ -41,6 +55,107 @@ SOFTWARE.
 M_TLS m_MemPool*
 _m_MemPool_global = NULL;
 
+/* size of each class */
+static const M_UINT16
+_m_MemPool_sizes[M_MEMPOOL_CLASSES] =
+{
+  8, 16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448,
+  512, 640, 768, 896, 1024, 1280, 1536, 1792, 2048, 2560, 3072, 3584, 4096,
+  5120, 6144, 7168, 8192, 10240, 12288, 14336, 16384
+};
+
+/* class by size up to 1024, in steps of 8 */
+static const M_UINT8
+_m_MemPool_class8[129] =
+{
+  0, 0, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 9, 9, 10, 10, 10,
+  10, 11, 11, 11, 11, 12, 12, 12, 12, 13, 13, 13, 13, 13, 13, 13, 13, 14, 14,
+  14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 16, 16, 16, 16, 16,
+  16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+  18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19,
+  19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 20, 20, 20, 20, 20, 20,
+  20, 20, 20, 20, 20, 20, 20, 20, 20, 20
+};
+
+/* class by size up to 16384, in steps of 128 */
+static const M_UINT8
+_m_MemPool_class128[129] =
+{
+  0, 8, 12, 14, 16, 17, 18, 19, 20, 21, 21, 22, 22, 23, 23, 24, 24, 25, 25,
+  25, 25, 26, 26, 26, 26, 27, 27, 27, 27, 28, 28, 28, 28, 29, 29, 29, 29, 29,
+  29, 29, 29, 30, 30, 30, 30, 30, 30, 30, 30, 31, 31, 31, 31, 31, 31, 31, 31,
+  32, 32, 32, 32, 32, 32, 32, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+  33, 33, 33, 33, 33, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34, 34,
+  34, 34, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 36,
+  36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36
+};
+
+#define _m_MemPool_class(sz) \
+  ((sz) <= 1024 ? _m_MemPool_class8[((sz) + 7) >> 3] \
+  : _m_MemPool_class128[((sz) + 127) >> 7])
+
+/* the bucket serving requests of size sz */
+#define _m_MemPool_bucket(mp, sz) \
+  ((sz) > M_MEMPOOL_MAXCLASS ? &(mp)->large \
+  : &(mp)->classes[_m_MemPool_class(sz)])
+
+/* get a slab aligned on its size from the system */
+static M_PTR
+_m_MemPool_map(M_VOID)
+{
+#ifdef _MSC_VER
+  /* aligned on the allocation granularity */
+  return VirtualAlloc(NULL, M_MEMPOOL_SLAB, MEM_RESERVE | MEM_COMMIT,
+      PAGE_READWRITE);
+#else
+  M_UCHAR* p;
+  M_SZ lead;
+
+  p = mmap(NULL, M_MEMPOOL_SLAB, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return NULL;
+  if (((uintptr_t) p & (M_MEMPOOL_SLAB - 1)) == 0) return p;
+  munmap(p, M_MEMPOOL_SLAB);
+
+  /* map twice the size and trim */
+  p = mmap(NULL, 2 * M_MEMPOOL_SLAB, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return NULL;
+  lead = M_MEMPOOL_SLAB - ((uintptr_t) p & (M_MEMPOOL_SLAB - 1));
+  munmap(p, lead);
+  munmap(p + lead + M_MEMPOOL_SLAB, M_MEMPOOL_SLAB - lead);
+  return p + lead;
+#endif
+}
+
+static M_VOID
+_m_MemPool_unmap(M_PTR p)
+{
+#ifdef _MSC_VER
+  VirtualFree(p, 0, MEM_RELEASE);
+#else
+  munmap(p, M_MEMPOOL_SLAB);
+#endif
+}
+
+/* give the spare slabs back */
+static M_VOID
+_m_MemPool_spare_fini(m_MemPool* const mp)
+{
+  m_MemSlab* slab;
+  m_MemSlab* nxt;
+
+  for (slab = mp->spare; slab; slab = nxt)
+  {
+    nxt = slab->next;
+    _m_MemPool_unmap(slab);
+    assert(mp->used >= M_MEMPOOL_SLAB);
+    mp->used -= M_MEMPOOL_SLAB;
+  }
+  mp->spare = NULL;
+  mp->nspare = 0;
+}
+
 m_MemPool**
 m_MemPool_get(M_VOID)
 {
@@ -54,6 +169,13 @@ m_MemPool_set(const m_MemPool* const mp)
   _m_MemPool_global = (m_MemPool*) mp;
 }
 
+M_SZ
+m_MemPool_class_size(const M_SZ sz)
+{
+  if (sz == 0 || sz > M_MEMPOOL_MAXCLASS) return sz;
+  return _m_MemPool_sizes[_m_MemPool_class(sz)];
+}
+
 M_BOOL
 m_MemPool_new(m_MemPool** const mp,
         const M_SZ max)
@@ -70,12 +192,22 @@ M_BOOL
 m_MemPool_init(m_MemPool* const mp,
         const M_SZ max)
 {
+  M_UINT32 i;
+
   assert(mp);
   M_TRACE("init ("M_PTR_FMT") max: ("M_SZ_FMT")", mp, max);
   mp->max = max;
   mp->used = 0;
   mp->record = 0;
-  return m_BTree_init2(&mp->buckets, _M_MALLOC_REF, (M_VOID(*)(M_PTR))_M_FREE_REF);
+  memset(mp->classes, 0, sizeof(mp->classes));
+  memset(&mp->large, 0, sizeof(m_MemBucket));
+  mp->spare = NULL;
+  mp->nspare = 0;
+  mp->remote = NULL;
+  mp->remotelarge = NULL;
+  for (i = 0; i < M_MEMPOOL_CLASSES; ++i)
+    mp->classes[i].size = _m_MemPool_sizes[i];
+  return M_TRUE;
 }
 
 M_DLLAPI M_VOID
@@ -91,126 +223,428 @@ m_MemPool_delete(m_MemPool** const mp)
 M_VOID
 m_MemPool_fini(m_MemPool* const mp)
 {
+  M_UINT32 i;
+
   assert(mp);
   M_TRACE("fini ("M_PTR_FMT")", mp);
-  m_BTree_traverse(&mp->buckets, &_m_MemPool_buckets_fini);
-  m_BTree_fini(&mp->buckets);
+  /* chunks freed by other threads go with their slab or large list */
+  mp->remote = NULL;
+  mp->remotelarge = NULL;
+  for (i = 0; i < M_MEMPOOL_CLASSES; ++i)
+    _m_MemPool_bucket_fini(&mp->classes[i]);
+  _m_MemPool_bucket_fini(&mp->large);
+  _m_MemPool_spare_fini(mp);
+  mp->used = 0;
 }
 
 M_VOID
-_m_MemPool_buckets_fini(M_PTR bucket)
+_m_MemPool_bucket_fini(m_MemBucket* const bkt)
+{
+  m_MemSlab* slab;
+  m_MemSlab* nxt;
+  m_MemChunk* chk;
+  m_MemChunk* next;
+
+  assert(bkt);
+  for (slab = bkt->partial; slab; slab = nxt)
+  {
+    nxt = slab->next;
+    _m_MemPool_unmap(slab);
+  }
+  for (slab = bkt->full; slab; slab = nxt)
+  {
+    nxt = slab->next;
+    _m_MemPool_unmap(slab);
+  }
+  for (chk = bkt->alive; chk; chk = next)
+  {
+    next = chk->next;
+    _M_FREE(chk);
+  }
+  bkt->cache = NULL;
+  bkt->ncache = 0;
+  bkt->partial = NULL;
+  bkt->full = NULL;
+  bkt->alive = NULL;
+  bkt->slabs = 0;
+  bkt->inuse = 0;
+  bkt->requested = 0;
+  bkt->remote = 0;
+}
+
+/* lists of slabs */
+#define _m_MemSlab_unlink(lst, slab) \
+  do { \
+    if ((slab)->prev) (slab)->prev->next = (slab)->next; \
+    else *(lst) = (slab)->next; \
+    if ((slab)->next) (slab)->next->prev = (slab)->prev; \
+  } while (0)
+
+#define _m_MemSlab_push(lst, slab) \
+  do { \
+    (slab)->prev = NULL; \
+    (slab)->next = *(lst); \
+    if (*(lst)) (*(lst))->prev = (slab); \
+    *(lst) = (slab); \
+  } while (0)
+
+#ifndef NDEBUG
+/* flip the bit of a chunk in its slab map, return the previous state */
+static M_BOOL
+_m_MemSlab_flip(m_MemSlab* const slab,
+        const M_PTR p)
+{
+  const M_SZ idx = ((M_UCHAR*) p - (M_UCHAR*) slab - M_MEMSLAB_HEADER)
+      / slab->bucket->size;
+  const M_UINT8 bit = (M_UINT8)(1 << (idx & 7));
+  const M_BOOL was = (slab->map[idx >> 3] & bit) != 0;
+
+  slab->map[idx >> 3] ^= bit;
+  return was;
+}
+#endif
+
+static m_MemSlab*
+_m_MemPool_slab_new(m_MemPool* const mp,
+        m_MemBucket* const bkt)
+{
+  m_MemSlab* slab;
+
+  M_TRACE("new slab ("M_SZ_FMT")", bkt->size);
+  if (mp->spare)
+  {
+    slab = mp->spare;
+    mp->spare = slab->next;
+    mp->nspare -= 1;
+  }
+  else
+  {
+    slab = _m_MemPool_map();
+    if (!slab) return NULL;
+    mp->used += M_MEMPOOL_SLAB;
+
+    /* update record */
+    if (mp->used > mp->record)
+      mp->record = mp->used;
+  }
+  slab->pool = mp;
+  slab->bucket = bkt;
+  slab->free = NULL;
+  slab->top = (M_UCHAR*) slab + M_MEMSLAB_HEADER;
+  slab->inuse = 0;
+  slab->capacity =
+      (M_UINT32)((M_MEMPOOL_SLAB - M_MEMSLAB_HEADER) / bkt->size);
+#ifndef NDEBUG
+  memset(slab->map, 0, sizeof(slab->map));
+#endif
+  _m_MemSlab_push(&bkt->partial, slab);
+  bkt->slabs += 1;
+  return slab;
+}
+
+static M_VOID
+_m_MemPool_slab_delete(m_MemPool* const mp,
+        m_MemSlab* const slab,
+        const M_BOOL keep)
+{
+  m_MemBucket* const bkt = slab->bucket;
+
+  M_TRACE("delete slab ("M_SZ_FMT")", bkt->size);
+  assert(slab->inuse == 0);
+  _m_MemSlab_unlink(&bkt->partial, slab);
+  bkt->slabs -= 1;
+  if (keep && mp->nspare < M_MEMPOOL_SPARE)
+  {
+    slab->next = mp->spare;
+    mp->spare = slab;
+    mp->nspare += 1;
+    return;
+  }
+  _m_MemPool_unmap(slab);
+  assert(mp->used >= M_MEMPOOL_SLAB);
+  mp->used -= M_MEMPOOL_SLAB;
+}
+
+/* give a chunk back to its slab */
+static M_VOID
+_m_MemPool_slab_put(m_MemPool* const mp,
+        m_MemChunk* const chk)
+{
+  m_MemSlab* const slab = m_MemSlab_of(chk);
+  m_MemBucket* const bkt = slab->bucket;
+
+#ifndef NDEBUG
+  if (!_m_MemSlab_flip(slab, chk))
+  {
+    M_FATAL_ERRMSG("-- MemPool -- chunk ("M_PTR_FMT") freed twice",
+        (M_PTR) chk);
+  }
+#endif
+  if (slab->inuse == slab->capacity)
+  {
+    _m_MemSlab_unlink(&bkt->full, slab);
+    _m_MemSlab_push(&bkt->partial, slab);
+  }
+  chk->next = slab->free;
+  slab->free = chk;
+
+  /* keep the last slab with room for the next malloc */
+  if (--slab->inuse == 0 && (slab->prev || slab->next))
+    _m_MemPool_slab_delete(mp, slab, M_TRUE);
+}
+
+/* give the older half of the cache back to the slabs, or all of it */
+static M_VOID
+_m_MemPool_flush(m_MemPool* const mp,
+        m_MemBucket* const bkt,
+        const M_UINT32 keep)
 {
+  m_MemChunk* chk = bkt->cache;
   m_MemChunk* nxt;
-  m_MemChunk* chk = ((m_MemBucket*)bucket)->alive;
+  M_UINT32 i;
+
+  if (!chk) return;
+  if (keep)
+  {
+    for (i = 1; i < keep && chk->next; ++i)
+      chk = chk->next;
+    nxt = chk->next;
+    chk->next = NULL;
+    chk = nxt;
+    bkt->ncache = i;
+  }
+  else
+  {
+    bkt->cache = NULL;
+    bkt->ncache = 0;
+  }
   for (; chk; chk = nxt)
   {
     nxt = chk->next;
-    _M_FREE(chk);
+    _m_MemPool_slab_put(mp, chk);
   }
-  chk = ((m_MemBucket*)bucket)->trash;
+}
+
+/* take back the chunks other threads have freed */
+static M_VOID
+_m_MemPool_drain(m_MemPool* const mp)
+{
+  m_MemChunk* chk;
+  m_MemChunk* nxt;
+  m_MemBucket* bkt;
+
+  chk = (m_MemChunk*) m_Atomic_xchg_ptr(&mp->remote, NULL);
   for (; chk; chk = nxt)
   {
     nxt = chk->next;
+    bkt = m_MemSlab_of(chk)->bucket;
+    assert(bkt->inuse);
+    bkt->inuse -= 1;
+    chk->next = bkt->cache;
+    bkt->cache = chk;
+    if (++bkt->ncache >= M_MEMPOOL_MAGAZINE)
+      _m_MemPool_flush(mp, bkt, M_MEMPOOL_MAGAZINE / 2);
+  }
+
+  chk = (m_MemChunk*) m_Atomic_xchg_ptr(&mp->remotelarge, NULL);
+  for (bkt = &mp->large; chk; chk = nxt)
+  {
+    nxt = chk->u.remote;
+    if (chk->prev)
+      chk->prev->next = chk->next;
+    else
+      bkt->alive = chk->next;
+    if (chk->next)
+      chk->next->prev = chk->prev;
+    assert(bkt->inuse);
+    bkt->inuse -= 1;
+    mp->used -= chk->size;
     _M_FREE(chk);
   }
-  _M_FREE(bucket);
+}
+
+/* let the pool of a chunk take it back later */
+static M_VOID
+_m_MemPool_free_remote(m_MemChunk** const lst,
+        m_MemChunk* const chk,
+        m_MemChunk** const link)
+{
+  m_MemChunk* old;
+
+  do
+  {
+    old = (m_MemChunk*) m_Atomic_load_ptr(lst);
+    *link = old;
+  }
+  while (!m_Atomic_cas_ptr(lst, old, chk));
 }
 
 M_PTR
 m_MemPool_malloc(const M_SZ sz)
 {
+  m_MemPool* const mp = _m_MemPool_global;
   m_MemBucket* bkt;
+  m_MemSlab* slab;
   m_MemChunk* chk;
 
-  assert(_m_MemPool_global);
+  assert(mp);
   M_TRACE("malloc ("M_SZ_FMT")", sz);
 
   if (sz == 0) return NULL;
 
-  bkt = (m_MemBucket*) m_BTree_get(&_m_MemPool_global->buckets, sz);
-  if (!bkt)
+  if (sz > M_MEMPOOL_MAXCLASS)
+  {
+    bkt = &mp->large;
+    if (m_Atomic_load_ptr(&mp->remotelarge))
+      _m_MemPool_drain(mp);
+    /* check limit */
+    if (mp->max && mp->used + sz > mp->max)
+      m_MemPool_purge(mp, 0);
+    chk = _M_MALLOC(sizeof(m_MemChunk) + sz);
+    if (!chk) return NULL;
+    chk->prev = NULL;
+    chk->next = bkt->alive;
+    if (bkt->alive)
+      bkt->alive->prev = chk;
+    bkt->alive = chk;
+    chk->u.pool = mp;
+    chk->size = sz;
+    bkt->inuse += 1;
+    bkt->requested += sz;
+    mp->used += sz;
+    if (mp->used > mp->record)
+      mp->record = mp->used;
+    return (M_PTR) chk->chunk;
+  }
+
+  bkt = &mp->classes[_m_MemPool_class(sz)];
+  if (!bkt->cache && !bkt->partial
+      && (m_Atomic_load_ptr(&mp->remote)
+      || m_Atomic_load_ptr(&mp->remotelarge)))
   {
-    M_TRACE("new bucket ("M_SZ_FMT")", sz);
-    bkt = _M_MALLOC(sizeof(m_MemBucket));
-    if (!bkt) return NULL;
-    bkt->alive = NULL;
-    bkt->trash = NULL;
-    if (m_BTree_insert(&_m_MemPool_global->buckets, sz, bkt) < 0) return NULL;
-    /*m_BTree_debug(_m_MemPool_global->buckets.root);*/
+    _m_MemPool_drain(mp);
   }
 
-  if (bkt->trash)
+  if (bkt->cache)
   {
-    chk = (m_MemChunk*) m_SLList_PULL(&bkt->trash);
+    chk = bkt->cache;
+    bkt->cache = chk->next;
+    bkt->ncache -= 1;
   }
   else
   {
-    M_TRACE("new chunk ("M_SZ_FMT")", sz);
-    chk = _M_MALLOC(sizeof(m_MemChunk) + sz);
-    if (!chk) return NULL;
-    _m_MemPool_global->used += sz;
-
-    /* update record */
-    if (_m_MemPool_global->used > _m_MemPool_global->record)
-      _m_MemPool_global->record = _m_MemPool_global->used;
+    slab = bkt->partial;
+    if (!slab)
+    {
+      /* check limit */
+      if (mp->max && mp->used + M_MEMPOOL_SLAB > mp->max)
+      {
+        m_MemPool_purge(mp, 0);
+      }
+      slab = _m_MemPool_slab_new(mp, bkt);
+      if (!slab) return NULL;
+    }
 
-    /* check limit */
-    if (_m_MemPool_global->max
-        && _m_MemPool_global->used > _m_MemPool_global->max)
+    if (slab->free)
     {
-      m_MemPool_purge(_m_MemPool_global, 0);
+      chk = slab->free;
+      slab->free = chk->next;
     }
+    else
+    {
+      chk = (m_MemChunk*) slab->top;
+      slab->top += bkt->size;
+    }
+    if (++slab->inuse == slab->capacity)
+    {
+      _m_MemSlab_unlink(&bkt->partial, slab);
+      _m_MemSlab_push(&bkt->full, slab);
+    }
+#ifndef NDEBUG
+    _m_MemSlab_flip(slab, chk);
+#endif
   }
+  bkt->inuse += 1;
+  bkt->requested += sz;
+  M_TRACE("malloced ("M_PTR_FMT")", chk);
 
-  assert(chk);
-  m_SLList_PUSH(&bkt->alive, chk);
-  M_TRACE("malloced ("M_PTR_FMT")", chk->chunk);
-
-  return (M_PTR) chk->chunk;
+  return (M_PTR) chk;
 }
 
 M_VOID
 m_MemPool_free(const M_PTR p,
         const M_SZ sz)
 {
+  m_MemPool* mp;
   m_MemBucket* bkt;
+  m_MemSlab* slab;
   m_MemChunk* chk;
-  m_MemChunk* prev = NULL;
 
-  assert(_m_MemPool_global);
   assert(p);
   assert(sz);
   M_TRACE("free ("M_PTR_FMT") ("M_SZ_FMT")", p, sz);
 
   if (!p || sz == 0) return;
 
-  bkt = (m_MemBucket*) m_BTree_get(&_m_MemPool_global->buckets, sz);
-  if (!bkt)
+  if (sz > M_MEMPOOL_MAXCLASS)
   {
-    M_FATAL_ERRMSG("-- MemPool -- unable to find bucket ("M_SZ_FMT")", sz);
+    chk = m_MemChunk_of(p);
+    mp = chk->u.pool;
+    bkt = &mp->large;
+    assert(chk->size == sz);
+    if (mp != _m_MemPool_global)
+    {
+      m_Atomic_add_sz(&bkt->remote, sz);
+      _m_MemPool_free_remote(&mp->remotelarge, chk, &chk->u.remote);
+      return;
+    }
+    if (chk->prev)
+      chk->prev->next = chk->next;
+    else
+      bkt->alive = chk->next;
+    if (chk->next)
+      chk->next->prev = chk->prev;
+    assert(bkt->inuse && bkt->requested >= sz);
+    bkt->inuse -= 1;
+    bkt->requested -= sz;
+    mp->used -= sz;
+    _M_FREE(chk);
+    return;
   }
-  else
-  if (!bkt->alive)
+
+  slab = m_MemSlab_of(p);
+  mp = slab->pool;
+  bkt = slab->bucket;
+  chk = (m_MemChunk*) p;
+#ifndef NDEBUG
+  if (bkt->size != m_MemPool_class_size(sz)
+      || ((M_UCHAR*) p - (M_UCHAR*) slab - M_MEMSLAB_HEADER) % bkt->size)
   {
-    M_FATAL_ERRMSG("-- MemPool -- unable to find living chunk ("M_PTR_FMT")"
+    M_FATAL_ERRMSG("-- MemPool -- unable to find chunk ("M_PTR_FMT")"
         " in bucket ("M_SZ_FMT")", p, sz);
   }
-  chk = bkt->alive;
-
-  do
+#endif
+  if (mp != _m_MemPool_global)
   {
-    if (&chk->chunk == p)
-    {
-      m_SLList_TAKE(&bkt->alive, chk, prev);
-      m_SLList_PUSH(&bkt->trash, chk);
-      return;
-    }
-    prev = chk;
-    chk = chk->next;
+    m_Atomic_add_sz(&bkt->remote, sz);
+    _m_MemPool_free_remote(&mp->remote, chk, &chk->next);
+    return;
   }
-  while (chk);
-  /* not reached */
-  M_FATAL_ERRMSG("-- MemPool -- unable to find chunk in bucket ("M_SZ_FMT")", sz);
+#ifndef NDEBUG
+  {
+    const m_MemChunk* c;
+    for (c = bkt->cache; c; c = c->next)
+      if (c == chk)
+        M_FATAL_ERRMSG("-- MemPool -- chunk ("M_PTR_FMT") freed twice", p);
+  }
+#endif
+  assert(bkt->inuse && bkt->requested >= sz);
+  bkt->inuse -= 1;
+  bkt->requested -= sz;
+  chk->next = bkt->cache;
+  bkt->cache = chk;
+  if (++bkt->ncache >= M_MEMPOOL_MAGAZINE)
+    _m_MemPool_flush(mp, bkt, M_MEMPOOL_MAGAZINE / 2);
 }
 
 M_PTR
@@ -234,6 +668,17 @@ m_MemPool_realloc(const M_PTR p,
   }
   if (sz == oldsz) return (M_PTR) p;
 
+  /* still fits in its class, in a pool of this thread */
+  if (sz <= M_MEMPOOL_MAXCLASS && oldsz <= M_MEMPOOL_MAXCLASS
+      && _m_MemPool_class(sz) == _m_MemPool_class(oldsz)
+      && m_MemSlab_of(p)->pool == _m_MemPool_global)
+  {
+    m_MemBucket* const bkt = m_MemSlab_of(p)->bucket;
+    assert(bkt == &_m_MemPool_global->classes[_m_MemPool_class(oldsz)]);
+    bkt->requested = bkt->requested - oldsz + sz;
+    return (M_PTR) p;
+  }
+
   tmp = m_MemPool_malloc(sz);
   assert(tmp);
   if (!tmp) return NULL;
@@ -246,76 +691,119 @@ M_VOID
 m_MemPool_purge(m_MemPool* const mp,
         const M_SZ bucket)
 {
+  M_UINT32 i;
+
+  assert(mp);
   M_TRACE("purge ("M_SZ_FMT")", bucket);
+  _m_MemPool_drain(mp);
   if (bucket)
   {
-    m_MemBucket* bkt = (m_MemBucket*) m_BTree_get(&mp->buckets, bucket);
-    if (!bkt) return;
-    m_MemPool_purge_bucket(bkt);
+    if (bucket > M_MEMPOOL_MAXCLASS) return;
+    m_MemPool_purge_bucket(&mp->classes[_m_MemPool_class(bucket)], mp);
   }
   else
-    m_BTree_traverse(&mp->buckets, (M_VOID(*)(M_PTR))&m_MemPool_purge_bucket);
+  {
+    for (i = 0; i < M_MEMPOOL_CLASSES; ++i)
+      m_MemPool_purge_bucket(&mp->classes[i], mp);
+  }
+  _m_MemPool_spare_fini(mp);
 }
 
 M_VOID
-m_MemPool_purge_bucket(m_MemBucket* const bkt)
+m_MemPool_purge_bucket(m_MemBucket* const bkt,
+        m_MemPool* const mp)
 {
+  m_MemSlab* slab;
+  m_MemSlab* nxt;
+
   assert(bkt);
+  assert(mp);
 
-  if (bkt->trash)
+  _m_MemPool_flush(mp, bkt, 0);
+  for (slab = bkt->partial; slab; slab = nxt)
   {
-    m_MemChunk* nxt;
-    m_MemChunk* chk = bkt->trash;
-    do
-    {
-      nxt = chk->next;
-      _M_FREE(chk);
-      chk = nxt;
-    }
-    while (chk);
-    bkt->trash = NULL;
+    nxt = slab->next;
+    if (slab->inuse == 0)
+      _m_MemPool_slab_delete(mp, slab, M_FALSE);
   }
 }
 
-#ifndef NDEBUG
-
 M_VOID
-m_MemPool_debug(const m_MemPool* const mp)
+m_MemPool_stats(const m_MemPool* const mp)
 {
-  m_MemBucket* bkt;
-  m_MemChunk* chk;
-  M_SZ numAlive;
-  M_SZ numTrash;
-  M_SZ numBuckets = 0;
-  m_BTNode* bktnd;
+  const m_MemBucket* bkt;
+  M_SZ requested;
+  M_UINT32 i;
 
-  printf("-- MemPool -- debug ("M_PTR_FMT"):\n", (M_PTR)mp);
-  if (!mp || !mp->buckets.root)
+  printf("-- MemPool -- stats ("M_PTR_FMT"):\n", (M_PTR)mp);
+  if (!mp)
   {
-    printf("--     Total buckets = 0\n"
-           "-- end mempool debug\n");
+    printf("-- end mempool stats\n");
     return;
   }
-
-  bktnd = m_BTree_least(&mp->buckets);
-  for (; bktnd; bktnd = m_BTree_next(bktnd))
+  printf("--     used "M_SZ_FMT" bytes, record "M_SZ_FMT" bytes, "
+      M_SZ_FMT" spare slabs\n", mp->used, mp->record, mp->nspare);
+  printf("--     %6s %10s %7s %10s %7s %6s %6s\n",
+      "class", "in use", "cached", "free", "slabs", "occup", "fill");
+  for (i = 0; i < M_MEMPOOL_CLASSES; ++i)
   {
-    bkt = (m_MemBucket*) bktnd->val;
-    numAlive = 0;
-    numTrash = 0;
+    M_SZ held;
+
+    bkt = &mp->classes[i];
+    if (!bkt->slabs) continue;
+    held = bkt->slabs * ((M_MEMPOOL_SLAB - M_MEMSLAB_HEADER) / bkt->size);
+    /* chunks freed by other threads are in use until the pool takes them
+       back, but their bytes are no longer requested */
+    requested = bkt->requested
+        - m_Atomic_add_sz((M_SZ*) &bkt->remote, 0);
+    /* occup: chunks in use of chunks the slabs hold,
+       fill: bytes requested of bytes in use */
+    printf("--     %6lu %10lu %7lu %10lu %7lu %5.1f%% %5.1f%%\n",
+        (unsigned long) bkt->size, (unsigned long) bkt->inuse,
+        (unsigned long) bkt->ncache,
+        (unsigned long)(held - bkt->inuse - bkt->ncache),
+        (unsigned long) bkt->slabs,
+        100.0 * bkt->inuse / held,
+        bkt->inuse ? 100.0 * requested / (bkt->inuse * bkt->size)
+          : 100.0);
+  }
+  bkt = &mp->large;
+  if (bkt->inuse)
+    printf("--     %6s %10lu %7s %10s %7s %6s %6s\n", "large",
+        (unsigned long) bkt->inuse, "-", "-", "-", "-", "-");
+  printf("-- end mempool stats\n");
+}
 
-    for (chk = bkt->alive; chk; chk = chk->next)
-      numAlive += 1;
-    for (chk = bkt->trash; chk; chk = chk->next)
-      numTrash += 1;
+#ifndef NDEBUG
 
-    printf("--     Bucket ("M_ID_FMT"): "M_SZ_FMT" alive, "M_SZ_FMT" trash\n",
-          bktnd->key, numAlive, numTrash);
+M_VOID
+m_MemPool_debug(const m_MemPool* const mp)
+{
+  const m_MemBucket* bkt;
+  const m_MemSlab* slab;
+  M_SZ numAlive;
+  M_SZ numSlabs;
+  M_UINT32 i;
 
-    numBuckets += 1;
+  if (mp)
+  {
+    for (i = 0; i < M_MEMPOOL_CLASSES; ++i)
+    {
+      bkt = &mp->classes[i];
+      numAlive = 0;
+      numSlabs = 0;
+      for (slab = bkt->partial; slab; slab = slab->next, ++numSlabs)
+        numAlive += slab->inuse;
+      for (slab = bkt->full; slab; slab = slab->next, ++numSlabs)
+        numAlive += slab->inuse;
+      if (numAlive != bkt->inuse + bkt->ncache || numSlabs != bkt->slabs)
+        printf("-- MemPool -- bucket ("M_SZ_FMT") counts "M_SZ_FMT" alive,"
+            " "M_SZ_FMT" slabs, found "M_SZ_FMT" and "M_SZ_FMT"\n",
+            bkt->size, bkt->inuse + bkt->ncache, bkt->slabs,
+            numAlive, numSlabs);
+    }
   }
-  printf("--     Total buckets = "M_SZ_FMT"\n", numBuckets);
-  printf("-- end mempool debug\n");
+  m_MemPool_stats(mp);
 }
 
 #endif /* !NDEBUG */
@@ -60,7 +60,6 @@ extern "C" {
 #else /* using memory pool */
 
 #include "m_h.h"
-#include "m_btree.h"
 
 /**
  *  \brief Request memory from the pool.
@@ -84,25 +83,73 @@ extern "C" {
 #define M_REALLOC_REF &m_MemPool_realloc
 #define M_FREE_REF    &m_MemPool_free
 
+/**
+ *  \def M_MEMPOOL_CLASSES
+ *  \brief Number of size classes.
+ *
+ *  Requests are rounded up to 8, then 16 to 128 by steps of 16, then
+ *  four classes per power of two up to M_MEMPOOL_MAXCLASS.
+ */
+#define M_MEMPOOL_CLASSES 37
+
+/**
+ *  \def M_MEMPOOL_MAXCLASS
+ *  \brief Largest size class. Bigger chunks are allocated on their own.
+ */
+#define M_MEMPOOL_MAXCLASS 16384
+
+/**
+ *  \def M_MEMPOOL_SLAB
+ *  \brief Size of the slabs chunks are cut from (a power of 2, at least
+ *  64 KiB, the allocation granularity of Windows).
+ */
+#define M_MEMPOOL_SLAB 65536
+
+/**
+ *  \def M_MEMPOOL_MAGAZINE
+ *  \brief Number of freed chunks a class keeps at hand before giving
+ *  the older half back to their slabs.
+ */
+#define M_MEMPOOL_MAGAZINE 64
+
+/**
+ *  \def M_MEMPOOL_SPARE
+ *  \brief Number of empty slabs kept for any class before giving them
+ *  back to the system.
+ */
+#define M_MEMPOOL_SPARE 16
+
 /**
  *  \typedef m_MemPool
  */
 typedef struct _m_MemPool m_MemPool;
 
+#include "m_mempool_priv.h"
+
 /**
  *  \struct _m_MemPool
  *  \brief The memory pool.
+ *
+ *  A pool serves one thread at a time, the one that set it with
+ *  m_MemPool_set. Its chunks may be freed from any thread though, they
+ *  come back to the pool through lock-free lists, taken when the pool
+ *  runs out of room in a class, allocates above the largest class, or
+ *  is purged.
  */
 struct _m_MemPool
 {
   M_SZ max;
   M_SZ used;
   M_SZ record;
-  m_BTree buckets;
+  m_MemBucket classes[M_MEMPOOL_CLASSES]; /* buckets by size class */
+  m_MemBucket large; /* chunks above the largest class */
+  m_MemSlab* spare; /* empty slabs */
+  M_SZ nspare;
+  M_UCHAR pad[M_CACHELINE]; /* keep other threads off the line above */
+  m_MemChunk* remote; /* chunks freed by other threads (atomic) */
+  m_MemChunk* remotelarge; /* same, above the largest class */
 };
 
-#include "m_mempool_priv.h"
-
 /**
  *  \brief Get the local mempool.
  */
@@ -133,6 +180,21 @@ m_MemPool_new(m_MemPool** const pool,
 M_DLLAPI M_VOID
 m_MemPool_delete(m_MemPool** const pool);
 
+/**
+ *  \brief Get the size of chunk the pool uses for a request.
+ *  \param sz Size of memory requested.
+ *  \return Size of its class, or sz when above the largest class.
+ */
+M_DLLAPI M_SZ
+m_MemPool_class_size(const M_SZ sz);
+
+/**
+ *  \brief Print the size of the pool and the occupancy of each class.
+ *  \param pool The memory pool.
+ */
+M_DLLAPI M_VOID
+m_MemPool_stats(const m_MemPool* const pool);
+
 /**
  *  \brief Boilerplate to create and set a global mempool.
  */
@@ -44,29 +44,92 @@ extern "C" {
  */
 typedef struct _m_MemChunk m_MemChunk;
 
+/**
+ *  \typedef m_MemSlab
+ */
+typedef struct _m_MemSlab m_MemSlab;
+
+/**
+ *  \typedef m_MemBucket
+ */
+typedef struct _m_MemBucket m_MemBucket;
+
 /**
  *  \struct _m_MemChunk
  *  \brief A chunk of "reusable" memory.
+ *
+ *  Chunks in slabs have no header, a free one only holds the link to
+ *  the next free chunk of its slab or bucket cache. Chunks above the
+ *  largest class are allocated on their own behind the whole header.
  */
 struct _m_MemChunk
 {
   m_MemChunk* next;
+  m_MemChunk* prev;
+  union
+  {
+    m_MemPool* pool; /* in use */
+    m_MemChunk* remote; /* freed by another thread */
+  } u;
+  M_SZ size;
   M_PTR chunk[];
 };
 
 /**
- *  \typedef m_MemBucket
+ *  \brief Get the header of a chunk above the largest class.
  */
-typedef struct _m_MemBucket m_MemBucket;
+#define m_MemChunk_of(p) \
+  ((m_MemChunk*)((M_UCHAR*)(p) - sizeof(m_MemChunk)))
+
+/**
+ *  \struct _m_MemSlab
+ *  \brief A slab of M_MEMPOOL_SLAB bytes, aligned on its size, cut in
+ *  chunks of one size class.
+ *
+ *  The slab of a chunk is found by masking the chunk address.
+ */
+struct _m_MemSlab
+{
+  m_MemSlab* prev;
+  m_MemSlab* next;
+  m_MemPool* pool;
+  m_MemBucket* bucket;
+  m_MemChunk* free; /* freed chunks */
+  M_UCHAR* top; /* chunks never handed out start here */
+  M_UINT32 inuse; /* chunks in use */
+  M_UINT32 capacity; /* chunks in the slab */
+#ifndef NDEBUG
+  M_UINT8 map[M_MEMPOOL_SLAB / 64]; /* chunks in use, one bit each */
+#endif
+};
+
+/**
+ *  \brief Offset of the first chunk in a slab.
+ */
+#define M_MEMSLAB_HEADER ((sizeof(m_MemSlab) + 15) & ~(M_SZ) 15)
+
+/**
+ *  \brief Get the slab of a chunk.
+ */
+#define m_MemSlab_of(p) \
+  ((m_MemSlab*)((uintptr_t)(p) & ~(uintptr_t)(M_MEMPOOL_SLAB - 1)))
 
 /**
  *  \struct _m_MemBucket
- *  \brief A memory "bucket".
+ *  \brief A memory "bucket", holding the slabs of one size class.
  */
 struct _m_MemBucket
 {
-  m_MemChunk* alive;
-  m_MemChunk* trash;
+  M_SZ size; /* size of chunks, 0 above the largest class */
+  m_MemChunk* cache; /* chunks freed lately, newest first */
+  M_UINT32 ncache;
+  m_MemSlab* partial; /* slabs with free chunks */
+  m_MemSlab* full; /* slabs without */
+  m_MemChunk* alive; /* chunks above the largest class */
+  M_SZ slabs; /* slabs held */
+  M_SZ inuse; /* chunks in use */
+  M_SZ requested; /* bytes requested for the chunks in use */
+  M_SZ remote; /* of which freed by other threads (atomic) */
 };
 
 /**
@@ -94,11 +157,11 @@ M_DLLAPI M_VOID
 m_MemPool_fini(m_MemPool* const pool);
 
 /**
- *  \brief Function to release buckets and all chunks.
+ *  \brief Release all chunks of a bucket.
  *  \param bucket The bucket.
  */
 M_DLLAPI M_VOID
-_m_MemPool_buckets_fini(M_PTR bucket);
+_m_MemPool_bucket_fini(m_MemBucket* const bucket);
 
 /**
  *  \brief Let the memory pool find some memory to use.
@@ -130,20 +193,24 @@ m_MemPool_realloc(const M_PTR p,
         const M_SZ oldsz);
 
 /**
- *  \brief Really frees one or all buckets of memory.
+ *  \brief Take back the chunks freed by other threads, and give the
+ *  empty slabs of one or all buckets back to the system.
  *  \param mp The memory pool.
- *  \param bucket The bucket size, or 0 for all buckets.
+ *  \param bucket A size in the class to purge, or 0 for all classes.
  */
 M_DLLAPI M_VOID
 m_MemPool_purge(m_MemPool* const mp,
         const M_SZ bucket);
 
 /**
- *  \brief Empty the trash of the bucket.
+ *  \brief Give the empty slabs of the bucket (and its cache) back to
+ *  the system.
  *  \param bucket The memory bucket.
+ *  \param pool The memory pool owning the bucket.
  */
 M_DLLAPI M_VOID
-m_MemPool_purge_bucket(m_MemBucket* const bucket);
+m_MemPool_purge_bucket(m_MemBucket* const bucket,
+        m_MemPool* const pool);
 
 #ifndef NDEBUG
 
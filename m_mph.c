@@ -0,0 +1,357 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+#include "m_mph.h"
+
+#include "m_hash.h"
+#include "m_mempool.h"
+
+#undef M_TRACE
+#if defined(M_TRACE_MODE) && defined(M_TRACE_MPH)
+#define M_TRACE(msg, ...) _M_TRACER("-- MPH -- "msg, __VA_ARGS__)
+#else
+#define M_TRACE(moo, ...)
+#endif
+
+/* displacements tried for a bucket, before trying another seed */
+#define M_MPH_MAXDISP   0x100000
+/* seeds tried before giving up */
+#define M_MPH_MAXSEEDS  16
+/* more keys in a bucket than that is bad luck: try another seed */
+#define M_MPH_MAXBUCKET 255
+
+#define M_MPH_GOLDEN    0x9e3779b97f4a7c15ULL
+
+/*
+ *  Finalizer of MurmurHash3 (64 bits).
+ */
+static M_UINT64
+_m_MPH_mix(M_UINT64 x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+/*
+ *  Map the high 32 bits of x to [0, n), with a product instead of a
+ *  division.
+ */
+#define _m_MPH_range(x, n) \
+  ((M_UINT32)((((x) >> 32) * (M_UINT64)(n)) >> 32))
+
+#define _m_MPH_bucket(h, nb) \
+  _m_MPH_range(_m_MPH_mix(h), (nb))
+
+#define _m_MPH_pos(h, d, n) \
+  _m_MPH_range(_m_MPH_mix((h) + (M_UINT64)(d) * M_MPH_GOLDEN), (n))
+
+/*
+ *  Memory used while building.
+ */
+typedef struct
+{
+  M_UINT64* hashes; /* num */
+  M_UINT32* start; /* nbuckets + 1, first key of each bucket in order */
+  M_UINT32* order; /* num, keys by bucket */
+  M_UINT32* buckets; /* nbuckets, by decreasing size */
+  M_UINT32* count; /* M_MPH_MAXBUCKET + 2 */
+  M_UCHAR* taken; /* num */
+} _m_MPH_work;
+
+/*
+ *  Try to place all keys with a seed.
+ */
+static M_BOOL
+_m_MPH_try(m_MPH* const mph,
+        const M_CHAR* const* const keys,
+        const M_SZ* const lens,
+        _m_MPH_work* const w)
+{
+  const M_UINT32 num = mph->num, nb = mph->nbuckets;
+  M_UINT32 pos[M_MPH_MAXBUCKET];
+  M_UINT32 i, j, k, b, sz, d, next = 0;
+
+  /* keys by bucket */
+  memset(w->start, 0, (nb + 1) * sizeof(M_UINT32));
+  for (i = 0; i < num; ++i)
+  {
+    w->hashes[i] = (M_UINT64) m_hash_wy(keys[i], lens[i], mph->seed);
+    w->start[_m_MPH_bucket(w->hashes[i], nb) + 1] += 1;
+  }
+  for (b = 0; b < nb; ++b)
+  {
+    if (w->start[b + 1] > M_MPH_MAXBUCKET) return M_FALSE;
+    w->start[b + 1] += w->start[b];
+  }
+  memcpy(w->buckets, w->start, nb * sizeof(M_UINT32));
+  for (i = 0; i < num; ++i)
+    w->order[w->buckets[_m_MPH_bucket(w->hashes[i], nb)]++] = i;
+
+  /* buckets by decreasing size */
+  memset(w->count, 0, (M_MPH_MAXBUCKET + 2) * sizeof(M_UINT32));
+  for (b = 0; b < nb; ++b)
+    w->count[M_MPH_MAXBUCKET - (w->start[b + 1] - w->start[b]) + 1] += 1;
+  for (sz = 0; sz <= M_MPH_MAXBUCKET; ++sz)
+    w->count[sz + 1] += w->count[sz];
+  for (b = 0; b < nb; ++b)
+    w->buckets[w->count[M_MPH_MAXBUCKET - (w->start[b + 1] - w->start[b])]++] = b;
+
+  memset(w->taken, 0, num);
+  for (k = 0; k < nb; ++k)
+  {
+    const M_UINT32* const bk = &w->order[w->start[w->buckets[k]]];
+    b = w->buckets[k];
+    sz = w->start[b + 1] - w->start[b];
+    if (sz == 0)
+    {
+      mph->disp[b] = 0;
+      continue;
+    }
+    if (sz == 1)
+    {
+      while (w->taken[next]) next += 1;
+      w->taken[next] = 1;
+      mph->disp[b] = M_MPH_DIRECT | next;
+      continue;
+    }
+    /* keys of equal hashes never part */
+    for (i = 1; i < sz; ++i)
+      for (j = 0; j < i; ++j)
+        if (w->hashes[bk[i]] == w->hashes[bk[j]]) return M_FALSE;
+
+    for (d = 1; d <= M_MPH_MAXDISP; ++d)
+    {
+      for (i = 0; i < sz; ++i)
+      {
+        pos[i] = _m_MPH_pos(w->hashes[bk[i]], d, num);
+        if (w->taken[pos[i]]) break;
+        for (j = 0; j < i && pos[j] != pos[i]; ++j) ;
+        if (j < i) break;
+      }
+      if (i == sz) break;
+    }
+    if (d > M_MPH_MAXDISP) return M_FALSE;
+    for (i = 0; i < sz; ++i)
+      w->taken[pos[i]] = 1;
+    mph->disp[b] = d;
+  }
+  return M_TRUE;
+}
+
+M_BOOL
+m_MPH_build(m_MPH* const mph,
+        const M_CHAR* const* const keys,
+        const M_SZ* const lens,
+        const M_SZ num)
+{
+  _m_MPH_work w;
+  M_SZ nb;
+  M_BOOL ok = M_FALSE;
+
+  assert(mph);
+  assert(keys && lens);
+  assert(num && num <= M_MPH_MAXKEYS);
+  M_TRACE("build ("M_PTR_FMT") num ("M_SZ_FMT")", mph, num);
+  if (!mph || !keys || !lens || !num || num > M_MPH_MAXKEYS) return M_FALSE;
+
+  nb = (num + M_MPH_LAMBDA - 1) / M_MPH_LAMBDA;
+  mph->num = (M_UINT32) num;
+  mph->nbuckets = (M_UINT32) nb;
+  mph->disp = M_MALLOC(nb * sizeof(M_UINT32));
+  w.hashes = M_MALLOC(num * sizeof(M_UINT64));
+  w.start = M_MALLOC((nb + 1) * sizeof(M_UINT32));
+  w.order = M_MALLOC(num * sizeof(M_UINT32));
+  w.buckets = M_MALLOC(nb * sizeof(M_UINT32));
+  w.count = M_MALLOC((M_MPH_MAXBUCKET + 2) * sizeof(M_UINT32));
+  w.taken = M_MALLOC(num);
+
+  if (mph->disp && w.hashes && w.start && w.order && w.buckets && w.count
+      && w.taken)
+  {
+    for (mph->seed = 0; mph->seed < M_MPH_MAXSEEDS; ++mph->seed)
+    {
+      M_TRACE("build ("M_PTR_FMT") seed ("M_ID_FMT")", mph, mph->seed);
+      if ((ok = _m_MPH_try(mph, keys, lens, &w))) break;
+    }
+  }
+
+  if (w.hashes) M_FREE(w.hashes, num * sizeof(M_UINT64));
+  if (w.start) M_FREE(w.start, (nb + 1) * sizeof(M_UINT32));
+  if (w.order) M_FREE(w.order, num * sizeof(M_UINT32));
+  if (w.buckets) M_FREE(w.buckets, nb * sizeof(M_UINT32));
+  if (w.count) M_FREE(w.count, (M_MPH_MAXBUCKET + 2) * sizeof(M_UINT32));
+  if (w.taken) M_FREE(w.taken, num);
+  if (!ok)
+  {
+    if (mph->disp) M_FREE(mph->disp, nb * sizeof(M_UINT32));
+    mph->disp = NULL;
+    mph->num = mph->nbuckets = 0;
+  }
+  return ok;
+}
+
+M_VOID
+m_MPH_fini(m_MPH* const mph)
+{
+  assert(mph);
+  M_TRACE("fini ("M_PTR_FMT")", mph);
+  if (!mph) return;
+
+  if (mph->disp) M_FREE(mph->disp, mph->nbuckets * sizeof(M_UINT32));
+  mph->disp = NULL;
+  mph->num = mph->nbuckets = 0;
+}
+
+M_UINT32
+m_MPH_index(const m_MPH* const mph,
+        const M_CHAR* const key,
+        const M_SZ len)
+{
+  M_UINT64 h;
+  M_UINT32 d;
+
+  assert(mph && mph->num);
+
+  h = (M_UINT64) m_hash_wy(key, len, mph->seed);
+  d = mph->disp[_m_MPH_bucket(h, mph->nbuckets)];
+  if (d & M_MPH_DIRECT) return d & ~M_MPH_DIRECT;
+  return _m_MPH_pos(h, d, mph->num);
+}
+
+/*
+ *  Write bytes as a C string literal (with '?' escaped, against
+ *  trigraphs).
+ */
+static M_VOID
+_m_MPH_write_str(FILE* const f,
+        const M_CHAR* const s,
+        const M_SZ len)
+{
+  M_SZ i;
+
+  fputc('"', f);
+  for (i = 0; i < len; ++i)
+  {
+    const M_UCHAR c = (M_UCHAR) s[i];
+    if (c == '"' || c == '\\' || c == '?') fprintf(f, "\\%c", c);
+    else if (c < 0x20 || c > 0x7E) fprintf(f, "\\%03o", c);
+    else fputc(c, f);
+  }
+  fputc('"', f);
+}
+
+M_BOOL
+m_MPH_write_c(const m_MPH* const mph,
+        const M_CHAR* const* const keys,
+        const M_SZ* const lens,
+        const M_CHAR* const* const vals,
+        const M_CHAR* const name,
+        const M_CHAR* const path)
+{
+  FILE* f;
+  M_UINT32* inv;
+  M_UINT32 i;
+  M_BOOL ok;
+
+  assert(mph && mph->num);
+  assert(keys && lens);
+  assert(name && path);
+  M_TRACE("write_c ("M_PTR_FMT") path (%s)", mph, path);
+  if (!mph || !mph->num || !keys || !lens || !name || !path) return M_FALSE;
+
+  /* keys by index */
+  inv = M_MALLOC(mph->num * sizeof(M_UINT32));
+  assert(inv);
+  if (!inv) return M_FALSE;
+  for (i = 0; i < mph->num; ++i)
+    inv[m_MPH_index(mph, keys[i], lens[i])] = i;
+
+  f = fopen(path, "w");
+  if (!f)
+  {
+    M_FREE(inv, mph->num * sizeof(M_UINT32));
+    return M_FALSE;
+  }
+  fprintf(f, "/* Generated by m_MPH_write_c, do not edit. */\n\n"
+      "#include \"m_mph.h\"\n\n");
+
+  fprintf(f, "static M_UINT32 %s_disp[%lu] =\n{", name,
+      (unsigned long) mph->nbuckets);
+  for (i = 0; i < mph->nbuckets; ++i)
+    fprintf(f, "%s0x%08lx,", i % 6 ? " " : "\n  ", (unsigned long) mph->disp[i]);
+  fprintf(f, "\n};\n\n");
+
+  fprintf(f, "const m_MPH %s = {%lu, %lu, %lu, %s_disp};\n\n", name,
+      (unsigned long) mph->seed, (unsigned long) mph->num,
+      (unsigned long) mph->nbuckets, name);
+
+  fprintf(f, "const M_CHAR* const %s_keys[%lu] =\n{\n", name,
+      (unsigned long) mph->num);
+  for (i = 0; i < mph->num; ++i)
+  {
+    fprintf(f, "  ");
+    _m_MPH_write_str(f, keys[inv[i]], lens[inv[i]]);
+    fprintf(f, ",\n");
+  }
+  fprintf(f, "};\n\n");
+
+  fprintf(f, "const M_SZ %s_lens[%lu] =\n{", name, (unsigned long) mph->num);
+  for (i = 0; i < mph->num; ++i)
+    fprintf(f, "%s%lu,", i % 10 ? " " : "\n  ", (unsigned long) lens[inv[i]]);
+  fprintf(f, "\n};\n\n");
+
+  if (vals)
+  {
+    fprintf(f, "const M_CHAR* const %s_vals[%lu] =\n{\n", name,
+        (unsigned long) mph->num);
+    for (i = 0; i < mph->num; ++i)
+    {
+      fprintf(f, "  ");
+      if (vals[inv[i]])
+        _m_MPH_write_str(f, vals[inv[i]], strlen(vals[inv[i]]));
+      else
+        fprintf(f, "NULL");
+      fprintf(f, ",\n");
+    }
+    fprintf(f, "};\n\n");
+  }
+
+  fprintf(f, "M_INT32\n%s_find(const M_CHAR* key,\n        M_SZ len)\n{\n"
+      "  const M_UINT32 i = m_MPH_index(&%s, key, len);\n"
+      "  return %s_lens[i] == len && !memcmp(%s_keys[i], key, len)\n"
+      "      ? (M_INT32) i : -1;\n}\n", name, name, name, name);
+
+  M_FREE(inv, mph->num * sizeof(M_UINT32));
+  ok = !ferror(f);
+  ok = fclose(f) == 0 && ok;
+  return ok;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
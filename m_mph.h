@@ -0,0 +1,150 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+/**
+ *  \file m_mph.h
+ *  \brief Minimal perfect hash functions for static sets of keys.
+ *  \author Stanislas Marquis <stan@astrorigin.com>
+ */
+
+/*
+ *  A minimal perfect hash maps each of n known keys to its own index,
+ *  from 0 to n - 1, with no collisions: a table in that order is looked
+ *  up with one hash of the key and one compare.
+ *
+ *  Built in the manner of CHD (hash, displace and compress). Keys are
+ *  hashed once (m_hash_wy) and spread over buckets of about
+ *  M_MPH_LAMBDA keys. Buckets are placed from the largest, each finding
+ *  a displacement that sends all its keys to free indexes. Buckets of
+ *  one key take the next free index directly. A lookup reads the
+ *  displacement of the bucket and mixes it with the hash.
+ *
+ *  Any other key gets some index too, so the key found there must be
+ *  compared. The function takes 4 bytes per bucket, about 1 byte per key.
+ */
+
+#ifndef M_MPH_H
+#define M_MPH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "m_h.h"
+
+/**
+ *  \brief Average number of keys per bucket.
+ */
+#define M_MPH_LAMBDA  4
+
+/**
+ *  \brief Flag of a displacement that is an index.
+ */
+#define M_MPH_DIRECT  0x80000000U
+
+/**
+ *  \brief Maximum number of keys.
+ */
+#define M_MPH_MAXKEYS  0x7FFFFFFFU
+
+/**
+ *  \typedef m_MPH
+ */
+typedef struct _m_MPH m_MPH;
+
+/**
+ *  \struct _m_MPH
+ */
+struct _m_MPH
+{
+  M_ID seed; /* seed of the key hash */
+  M_UINT32 num; /* number of keys */
+  M_UINT32 nbuckets; /* number of buckets */
+  M_UINT32* disp; /* displacement of each bucket */
+};
+
+/**
+ *  \brief Build a minimal perfect hash function.
+ *  \param mph The function (uninitialized).
+ *  \param keys The keys (all different).
+ *  \param lens Lengths of keys.
+ *  \param num Number of keys (not 0).
+ *  \return M_TRUE, or M_FALSE on error (or if keys are not all different).
+ */
+M_DLLAPI M_BOOL
+m_MPH_build(m_MPH* const mph,
+        const M_CHAR* const* const keys,
+        const M_SZ* const lens,
+        const M_SZ num);
+
+/**
+ *  \brief Finalize a function made by m_MPH_build.
+ */
+M_DLLAPI M_VOID
+m_MPH_fini(m_MPH* const mph);
+
+/**
+ *  \brief Get the index of a key.
+ *  \param mph The function.
+ *  \param key The key.
+ *  \param len Length of key.
+ *  \return Index of key (from 0 to num - 1), or of another key if key is
+ *  not one of the set.
+ */
+M_DLLAPI M_UINT32
+m_MPH_index(const m_MPH* const mph,
+        const M_CHAR* const key,
+        const M_SZ len);
+
+/**
+ *  \brief Write a C source file with a function and its table of keys.
+ *
+ *  The file holds static arrays NAME_keys, NAME_lens and (if vals is not
+ *  NULL) NAME_vals, in index order, the m_MPH named NAME, and the function
+ *  M_INT32 NAME_find(const M_CHAR* key, M_SZ len), giving the index of a
+ *  key or -1. It includes m_mph.h and needs the library for m_MPH_index.
+ *
+ *  \param mph The function.
+ *  \param keys The keys it was built with.
+ *  \param lens Lengths of keys.
+ *  \param vals Strings for the keys (or NULL).
+ *  \param name Prefix of all names (a C identifier).
+ *  \param path The file, replaced if it exists.
+ *  \return M_FALSE on error (see errno).
+ */
+M_DLLAPI M_BOOL
+m_MPH_write_c(const m_MPH* const mph,
+        const M_CHAR* const* const keys,
+        const M_SZ* const lens,
+        const M_CHAR* const* const vals,
+        const M_CHAR* const name,
+        const M_CHAR* const path);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !M_MPH_H */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -26,7 +26,7 @@ SOFTWARE.
 
 /**
  *  \file m_mutex.h
- *  \brief Simple mutex macros.
+ *  \brief Simple mutex, read-write lock and atomic pointer macros.
  *  \copyright GNU Lesser General Public License
  *  \author Stanislas Marquis <stan@astrorigin.com>
  */
@@ -59,6 +59,48 @@ extern "C" {
 #define m_Mutex_fini(mtx) \
         do{CloseHandle(mtx);mtx=NULL;}while(0)
 
+#define M_RWLOCK SRWLOCK
+
+#define m_RWLock_init(lck) \
+        InitializeSRWLock(&lck)
+
+#define m_RWLock_rdlock(lck) \
+        AcquireSRWLockShared(&lck)
+
+#define m_RWLock_rdunlock(lck) \
+        ReleaseSRWLockShared(&lck)
+
+#define m_RWLock_wrlock(lck) \
+        AcquireSRWLockExclusive(&lck)
+
+#define m_RWLock_wrunlock(lck) \
+        ReleaseSRWLockExclusive(&lck)
+
+#define m_RWLock_fini(lck)
+
+/*
+ *  Atomic pointers (full barriers). A failed m_Atomic_cas_ptr may or may
+ *  not update old, reload it before trying again.
+ */
+#define m_Atomic_load_ptr(p) \
+        InterlockedCompareExchangePointer((PVOID volatile*)(p),NULL,NULL)
+
+#define m_Atomic_xchg_ptr(p, v) \
+        InterlockedExchangePointer((PVOID volatile*)(p),(PVOID)(v))
+
+#define m_Atomic_cas_ptr(p, old, v) \
+        (InterlockedCompareExchangePointer((PVOID volatile*)(p),\
+        (PVOID)(v),(PVOID)(old))==(PVOID)(old))
+
+/* M_SZ is 4 bytes on 32-bit Windows */
+#ifdef _WIN64
+#define m_Atomic_add_sz(p, v) \
+        ((M_SZ)InterlockedExchangeAdd64((LONG64 volatile*)(p),(LONG64)(v)))
+#else
+#define m_Atomic_add_sz(p, v) \
+        ((M_SZ)InterlockedExchangeAdd((LONG volatile*)(p),(LONG)(v)))
+#endif
+
 #else /* Posix */
 #include <pthread.h>
 
@@ -78,6 +120,47 @@ extern "C" {
 #define m_Mutex_fini(mtx) \
         pthread_mutex_destroy(&mtx)
 
+/*
+ *  Read-write locks need _POSIX_C_SOURCE >= 200112L (or _XOPEN_SOURCE)
+ *  to be declared by pthread.h, when compiling with -std=c99.
+ */
+#define M_RWLOCK pthread_rwlock_t
+
+#define m_RWLock_init(lck) \
+        pthread_rwlock_init(&lck, NULL)
+
+#define m_RWLock_rdlock(lck) \
+        pthread_rwlock_rdlock(&lck)
+
+#define m_RWLock_rdunlock(lck) \
+        pthread_rwlock_unlock(&lck)
+
+#define m_RWLock_wrlock(lck) \
+        pthread_rwlock_wrlock(&lck)
+
+#define m_RWLock_wrunlock(lck) \
+        pthread_rwlock_unlock(&lck)
+
+#define m_RWLock_fini(lck) \
+        pthread_rwlock_destroy(&lck)
+
+/*
+ *  Atomic pointers (GCC and Clang builtins). A failed m_Atomic_cas_ptr
+ *  may or may not update old, reload it before trying again.
+ */
+#define m_Atomic_load_ptr(p) \
+        __atomic_load_n(p, __ATOMIC_ACQUIRE)
+
+#define m_Atomic_xchg_ptr(p, v) \
+        __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL)
+
+#define m_Atomic_cas_ptr(p, old, v) \
+        __atomic_compare_exchange_n(p, &(old), v, 1, \
+        __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+
+#define m_Atomic_add_sz(p, v) \
+        __atomic_fetch_add(p, v, __ATOMIC_RELAXED)
+
 #endif /* !_MSC_VER */
 
 #ifdef __cplusplus
@@ -67,7 +67,7 @@ m_SLList_take(m_SLList** const lst,
 {
   assert(lst && *lst);
   assert(el);
-  assert(!prev && (el == *lst));
+  assert(prev ? prev->next == el : el == *lst);
   if (!lst || !*lst || !el) return M_FALSE;
 
   if (prev) prev->next = el->next;
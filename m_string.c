@@ -81,12 +81,21 @@ M_CHAR*
 m_String_new_len(m_String** const s,
         const M_CHAR* const content,
         const M_SZ len)
+{
+  return m_String_new2(s, content, len, NULL);
+}
+
+M_CHAR*
+m_String_new2(m_String** const s,
+        const M_CHAR* const content,
+        const M_SZ len,
+        const m_Allocator* const alloc)
 {
   assert(s);
   if (!s) return NULL;
 
-  if (!m_Array_new((m_Array**)s, len + 1, sizeof(M_CHAR),
-      (m_array_calc_space_fn_t) &_m_String_calc_space_fn))
+  if (!m_Array_new2((m_Array**)s, len + 1, sizeof(M_CHAR),
+      (m_array_calc_space_fn_t) &_m_String_calc_space_fn, alloc))
   {
     return NULL;
   }
@@ -110,12 +119,21 @@ M_CHAR*
 m_String_init_len(m_String* const s,
         const M_CHAR* const content,
         const M_SZ len)
+{
+  return m_String_init2(s, content, len, NULL);
+}
+
+M_CHAR*
+m_String_init2(m_String* const s,
+        const M_CHAR* const content,
+        const M_SZ len,
+        const m_Allocator* const alloc)
 {
   assert(s);
   if (!s) return NULL;
 
-  if (!m_Array_init((m_Array*)s, len + 1, sizeof(M_CHAR),
-      (m_array_calc_space_fn_t) &_m_String_calc_space_fn))
+  if (!m_Array_init2((m_Array*)s, len + 1, sizeof(M_CHAR),
+      (m_array_calc_space_fn_t) &_m_String_calc_space_fn, alloc))
   {
     return NULL;
   }
@@ -265,7 +283,7 @@ m_String_replace(m_String* const s,
     /* prepare buffer */
     sz = s->len + ((len2 - len1) * cnt);
     req = s->calc_space_fn ? (*s->calc_space_fn)(s, sz) : sz;
-    buf = b = M_MALLOC(req);
+    buf = b = m_Array_MALLOC(s, req);
     if (!buf) return NULL;
     memset(buf, 0, req);
     /* read and rewrite */
@@ -283,7 +301,7 @@ m_String_replace(m_String* const s,
     /* switch data */
     p = s->data;
     s->data = buf;
-    M_FREE(p, s->capacity);
+    m_Array_FREE(s, p, s->capacity);
     s->len += cnt * (len2 - len1);
     s->capacity = req;
   }
@@ -302,8 +320,10 @@ m_String_debug(const m_String* const s)
          "--     unit = "M_SZ_FMT"\n"
          "--     capacity = "M_SZ_FMT"\n"
          "--     calc_space_fn = ("M_PTR_FMT")\n"
+         "--     allocator = ("M_PTR_FMT")\n"
          "-- end string debug\n",
-      s, (char*)s->data, s->len, s->unit, s->capacity, s->calc_space_fn);
+      s, (char*)s->data, s->len, s->unit, s->capacity, s->calc_space_fn,
+      s->allocator);
 }
 
 #endif /* !NDEBUG */
@@ -77,6 +77,21 @@ m_String_new_len(m_String** const s,
         const M_CHAR* const content,
         const M_SZ len);
 
+/**
+ *  \brief Allocate for a new string (extended version).
+ *  \param s The string (by ref, initialized to NULL).
+ *  \param content String to copy (or NULL).
+ *  \param len Length of string to copy.
+ *  \param allocator Allocation functions for the string and its data,
+ *  or NULL for M_MALLOC.
+ *  \return Address of the string data, or NULL on error.
+ */
+M_DLLAPI M_CHAR*
+m_String_new2(m_String** const s,
+        const M_CHAR* const content,
+        const M_SZ len,
+        const m_Allocator* const allocator);
+
 /**
  *  \brief Delete string.
  */
@@ -105,6 +120,21 @@ m_String_init_len(m_String* const s,
         const M_CHAR* const content,
         const M_SZ len);
 
+/**
+ *  \brief Initialize a string (extended version).
+ *  \param s The string.
+ *  \param content String to copy (or NULL).
+ *  \param len Length of string to copy.
+ *  \param allocator Allocation functions for the string data, or NULL
+ *  for M_MALLOC.
+ *  \return Address of the string data, or NULL on error.
+ */
+M_DLLAPI M_CHAR*
+m_String_init2(m_String* const s,
+        const M_CHAR* const content,
+        const M_SZ len,
+        const m_Allocator* const allocator);
+
 /**
  *  \brief Finalize a string.
  */
@@ -127,6 +157,16 @@ m_String_fini(m_String* const s);
  */
 #define m_String_LEN(s) ((s)->len-1)
 
+/**
+ *  \brief Make a string of the len chars at p (followed by a null char),
+ *  without copying.
+ *
+ *  The string does not own the chars, it must not be modified nor
+ *  finalized.
+ */
+#define m_String_view(s, p, len) \
+  m_Array_view((s), (p), (len) + 1, sizeof(M_CHAR))
+
 /**
  *  \brief Set string content.
  *  \param s The string.
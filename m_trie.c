@@ -0,0 +1,550 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+#include "m_trie.h"
+
+#undef M_TRACE
+#if defined(M_TRACE_MODE) && defined(M_TRACE_TRIE)
+#define M_TRACE(msg, ...) _M_TRACER("-- Trie -- "msg, __VA_ARGS__)
+#else
+#define M_TRACE(moo, ...)
+#endif
+
+/* leaves are allocated by multiples of this size */
+#define M_TRIELEAF_QUANTA 16
+
+#define _m_TrieLeaf_size(len) \
+  ((offsetof(m_TrieLeaf, key) + (len) + 1 + M_TRIELEAF_QUANTA - 1) \
+  / M_TRIELEAF_QUANTA * M_TRIELEAF_QUANTA)
+
+/*
+ *  Internal nodes have the lowest bit of their pointers set.
+ */
+#define _m_Trie_is_node(p)  ((uintptr_t)(p) & 1)
+#define _m_Trie_node(p)     ((m_TrieNode*)((uintptr_t)(p) - 1))
+#define _m_Trie_tag(n)      ((M_PTR)((uintptr_t)(n) + 1))
+
+/*
+ *  Byte of a key, with null chars past its end.
+ */
+#define _m_Trie_byte(k, l, i) \
+  ((i) < (l) ? (M_UCHAR)(k)[i] : 0)
+
+/*
+ *  Side of a node a key goes to: 1 if it has the critical bit.
+ */
+#define _m_Trie_dir(n, k, l) \
+  ((1 + ((n)->otherbits | _m_Trie_byte(k, l, (n)->byte))) >> 8)
+
+/*
+ *  Leaf a key leads to (not necessarily with that key).
+ */
+static m_TrieLeaf*
+_m_Trie_best(M_PTR p,
+        const M_CHAR* const key,
+        const M_SZ len)
+{
+  while (_m_Trie_is_node(p))
+  {
+    const m_TrieNode* const n = _m_Trie_node(p);
+    p = n->child[_m_Trie_dir(n, key, len)];
+  }
+  return (m_TrieLeaf*) p;
+}
+
+/*
+ *  Leaf of the lowest key under p.
+ */
+static m_TrieLeaf*
+_m_Trie_least(M_PTR p)
+{
+  while (_m_Trie_is_node(p))
+    p = _m_Trie_node(p)->child[0];
+  return (m_TrieLeaf*) p;
+}
+
+/*
+ *  First bit on which a leaf key and a key differ.
+ *  Return M_FALSE if the keys are the same.
+ */
+static M_BOOL
+_m_Trie_crit(const m_TrieLeaf* const l,
+        const M_CHAR* const key,
+        const M_SZ len,
+        M_UINT32* const byte,
+        M_UCHAR* const otherbits)
+{
+  const M_SZ n = len > l->len ? len : l->len;
+  M_SZ i;
+  M_UINT32 c;
+
+  for (i = 0; i < n; ++i)
+  {
+    c = _m_Trie_byte(l->key, l->len, i) ^ _m_Trie_byte(key, len, i);
+    if (!c) continue;
+    /* keep the highest bit set */
+    c |= c >> 1;
+    c |= c >> 2;
+    c |= c >> 4;
+    *byte = (M_UINT32) i;
+    *otherbits = (M_UCHAR)((c & ~(c >> 1)) ^ 0xFF);
+    return M_TRUE;
+  }
+  return M_FALSE;
+}
+
+/*
+ *  Leaf of the lowest key not less than key (greater if strict).
+ */
+static m_TrieLeaf*
+_m_Trie_bound(const m_Trie* const t,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_BOOL strict)
+{
+  const m_TrieNode* n;
+  m_TrieLeaf* l;
+  M_PTR p;
+  M_PTR right = NULL;
+  M_UINT32 byte = 0;
+  M_UCHAR otherbits = 0;
+  M_BOOL found;
+  M_UINT32 d;
+
+  if (!t->root) return NULL;
+  l = _m_Trie_best(t->root, key, len);
+  found = !_m_Trie_crit(l, key, len, &byte, &otherbits);
+  if (found && !strict) return l;
+
+  /* down to the leaf, or to where key would be, keeping the last subtree
+     on the right of the path */
+  for (p = t->root; _m_Trie_is_node(p); p = n->child[d])
+  {
+    n = _m_Trie_node(p);
+    if (!found && (n->byte > byte
+        || (n->byte == byte && n->otherbits > otherbits)))
+      break;
+    d = _m_Trie_dir(n, key, len);
+    if (d == 0) right = n->child[1];
+  }
+  /* keys under p are less than key if key has the critical bit */
+  if (!found && !((1 + (otherbits | _m_Trie_byte(key, len, byte))) >> 8))
+    return _m_Trie_least(p);
+  return right ? _m_Trie_least(right) : NULL;
+}
+
+static M_VOID
+_m_Trie_free(M_PTR p)
+{
+  while (_m_Trie_is_node(p))
+  {
+    m_TrieNode* const n = _m_Trie_node(p);
+    _m_Trie_free(n->child[0]);
+    p = n->child[1];
+    M_FREE(n, sizeof(m_TrieNode));
+  }
+  M_FREE(p, _m_TrieLeaf_size(((m_TrieLeaf*) p)->len));
+}
+
+static M_SZ
+_m_Trie_walk(M_PTR p,
+        M_VOID (* const func)(m_String*, M_PTR, M_PTR),
+        M_PTR const userdata)
+{
+  m_TrieLeaf* l;
+  m_String key;
+  M_SZ num = 0;
+
+  while (_m_Trie_is_node(p))
+  {
+    num += _m_Trie_walk(_m_Trie_node(p)->child[0], func, userdata);
+    p = _m_Trie_node(p)->child[1];
+  }
+  l = (m_TrieLeaf*) p;
+  m_String_view(&key, l->key, l->len);
+  (*func)(&key, l->val, userdata);
+  return num + 1;
+}
+
+M_BOOL
+m_Trie_new(m_Trie** const t)
+{
+  assert(t);
+  M_TRACE("new ("M_PTR_FMT")", t);
+  if (!t) return M_FALSE;
+
+  *t = M_MALLOC(sizeof(m_Trie));
+  assert(*t);
+  if (!*t) return M_FALSE;
+  return m_Trie_init(*t);
+}
+
+M_BOOL
+m_Trie_init(m_Trie* const t)
+{
+  assert(t);
+  M_TRACE("init ("M_PTR_FMT")", t);
+  if (!t) return M_FALSE;
+
+  t->root = NULL;
+  t->num = 0;
+  t->finalize_fn = NULL;
+  return M_TRUE;
+}
+
+M_VOID
+m_Trie_fini(m_Trie* const t)
+{
+  assert(t);
+  M_TRACE("fini ("M_PTR_FMT")", t);
+  if (!t) return;
+
+  if (t->finalize_fn) m_Trie_traverse(t, t->finalize_fn);
+  if (t->root) _m_Trie_free(t->root);
+  m_Trie_init(t);
+}
+
+M_VOID
+m_Trie_delete(m_Trie** const t)
+{
+  assert(t && *t);
+  M_TRACE("delete ("M_PTR_FMT")", *t);
+  if (!t || !*t) return;
+
+  m_Trie_fini(*t);
+  M_FREE(*t, sizeof(m_Trie));
+  *t = NULL;
+}
+
+M_PTR
+m_Trie_get(const m_Trie* const t,
+        const M_CHAR* const key)
+{
+  assert(key && *key);
+  if (!key || !*key) return NULL;
+
+  return m_Trie_get_len(t, key, strlen(key));
+}
+
+M_PTR
+m_Trie_get_len(const m_Trie* const t,
+        const M_CHAR* const key,
+        const M_SZ len)
+{
+  const m_TrieLeaf* l;
+
+  assert(t);
+  assert(key && len);
+  M_TRACE("get ("M_PTR_FMT") key (%.*s)", t, (int) len, key);
+  if (!t || !key || !len || !t->root) return NULL;
+
+  l = _m_Trie_best(t->root, key, len);
+  return l->len == len && !memcmp(l->key, key, len) ? l->val : NULL;
+}
+
+M_BOOL
+m_Trie_set(m_Trie* const t,
+        const M_CHAR* const key,
+        const M_PTR const val,
+        M_PTR* const prev)
+{
+  assert(key && *key);
+  if (!key || !*key) return M_FALSE;
+
+  return m_Trie_set_len(t, key, strlen(key), val, prev);
+}
+
+M_BOOL
+m_Trie_set_len(m_Trie* const t,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_PTR const val,
+        M_PTR* const prev)
+{
+  m_TrieLeaf* l = NULL;
+  m_TrieLeaf* nl;
+  m_TrieNode* nn, *n;
+  M_PTR* wherep;
+  M_UINT32 byte = 0;
+  M_UCHAR otherbits = 0;
+  M_UINT32 d;
+
+  assert(t);
+  assert(key && len);
+  M_TRACE("set ("M_PTR_FMT") key (%.*s) val ("M_PTR_FMT")",
+      t, (int) len, key, val);
+  if (!t || !key || !len || len > 0xFFFFFFFFU) return M_FALSE;
+
+  if (t->root)
+  {
+    l = _m_Trie_best(t->root, key, len);
+    if (!_m_Trie_crit(l, key, len, &byte, &otherbits))
+    {
+      if (prev) *prev = l->val;
+      l->val = (M_PTR) val;
+      return M_TRUE;
+    }
+  }
+
+  nl = M_MALLOC(_m_TrieLeaf_size(len));
+  assert(nl);
+  if (!nl) return M_FALSE;
+  nl->val = (M_PTR) val;
+  nl->len = len;
+  memcpy(nl->key, key, len);
+  nl->key[len] = '\0';
+  if (prev) *prev = (M_PTR) val;
+
+  if (!t->root)
+  {
+    t->root = nl;
+    t->num = 1;
+    return M_TRUE;
+  }
+
+  nn = M_MALLOC(sizeof(m_TrieNode));
+  assert(nn);
+  if (!nn)
+  {
+    M_FREE(nl, _m_TrieLeaf_size(len));
+    return M_FALSE;
+  }
+  nn->byte = byte;
+  nn->otherbits = otherbits;
+  /* side of the keys already there */
+  d = (1 + (otherbits | _m_Trie_byte(l->key, l->len, byte))) >> 8;
+  nn->child[1 - d] = nl;
+
+  /* nodes are in order of critical bits along any path */
+  for (wherep = &t->root; _m_Trie_is_node(*wherep);
+      wherep = &n->child[_m_Trie_dir(n, key, len)])
+  {
+    n = _m_Trie_node(*wherep);
+    if (n->byte > byte || (n->byte == byte && n->otherbits > otherbits))
+      break;
+  }
+  nn->child[d] = *wherep;
+  *wherep = _m_Trie_tag(nn);
+  t->num += 1;
+  return M_TRUE;
+}
+
+M_PTR
+m_Trie_unset(m_Trie* const t,
+        const M_CHAR* const key)
+{
+  assert(key && *key);
+  if (!key || !*key) return NULL;
+
+  return m_Trie_unset_len(t, key, strlen(key));
+}
+
+M_PTR
+m_Trie_unset_len(m_Trie* const t,
+        const M_CHAR* const key,
+        const M_SZ len)
+{
+  m_TrieLeaf* l;
+  m_TrieNode* q = NULL;
+  M_PTR* wherep;
+  M_PTR* whereq = NULL;
+  M_PTR val;
+  M_UINT32 d = 0;
+
+  assert(t);
+  assert(key && len);
+  M_TRACE("unset ("M_PTR_FMT") key (%.*s)", t, (int) len, key);
+  if (!t || !key || !len || !t->root) return NULL;
+
+  for (wherep = &t->root; _m_Trie_is_node(*wherep); wherep = &q->child[d])
+  {
+    whereq = wherep;
+    q = _m_Trie_node(*wherep);
+    d = _m_Trie_dir(q, key, len);
+  }
+  l = (m_TrieLeaf*) *wherep;
+  if (l->len != len || memcmp(l->key, key, len)) return NULL;
+
+  val = l->val;
+  M_FREE(l, _m_TrieLeaf_size(len));
+  if (!whereq)
+    t->root = NULL;
+  else
+  {
+    *whereq = q->child[1 - d];
+    M_FREE(q, sizeof(m_TrieNode));
+  }
+  t->num -= 1;
+  return val;
+}
+
+/*
+ *  Walk callback calling a function on values only (passed by address).
+ */
+static M_VOID
+_m_Trie_apply(m_String* key,
+        M_PTR val,
+        M_PTR udata)
+{
+  M_UNUSED(key);
+  (**(M_VOID (**)(M_PTR)) udata)(val);
+}
+
+M_VOID
+m_Trie_traverse(const m_Trie* const t,
+        M_VOID (* const func)(M_PTR))
+{
+  assert(t);
+  assert(func);
+  if (!t || !func || !t->root) return;
+
+  _m_Trie_walk(t->root, &_m_Trie_apply, (M_PTR) &func);
+}
+
+M_VOID
+m_Trie_traverse_keyval2(const m_Trie* const t,
+        M_VOID (* const func)(m_String*, M_PTR, M_PTR),
+        M_PTR const userdata)
+{
+  assert(t);
+  assert(func);
+  if (!t || !func || !t->root) return;
+
+  _m_Trie_walk(t->root, func, userdata);
+}
+
+M_SZ
+m_Trie_traverse_prefix(const m_Trie* const t,
+        const M_CHAR* const prefix,
+        const M_SZ len,
+        M_VOID (* const func)(m_String*, M_PTR, M_PTR),
+        M_PTR const userdata)
+{
+  const m_TrieLeaf* l;
+  M_PTR p;
+
+  assert(t);
+  assert(prefix || !len);
+  assert(func);
+  M_TRACE("traverse_prefix ("M_PTR_FMT") prefix (%.*s)", t, (int) len,
+      prefix ? prefix : "");
+  if (!t || (!prefix && len) || !func || !t->root) return 0;
+
+  /* down to the first node testing a bit past the prefix: the keys under
+     it are all the same over the length of the prefix */
+  p = t->root;
+  while (_m_Trie_is_node(p) && _m_Trie_node(p)->byte < len)
+    p = _m_Trie_node(p)->child[_m_Trie_dir(_m_Trie_node(p), prefix, len)];
+  l = _m_Trie_least(p);
+  if (l->len < len || memcmp(l->key, prefix, len)) return 0;
+  return _m_Trie_walk(p, func, userdata);
+}
+
+m_TrieLeaf*
+m_Trie_lower_bound(const m_Trie* const t,
+        const M_CHAR* const key,
+        const M_SZ len)
+{
+  assert(t);
+  assert(key || !len);
+  if (!t || (!key && len)) return NULL;
+
+  return _m_Trie_bound(t, key, len, M_FALSE);
+}
+
+M_BOOL
+m_TrieIter_begin(m_TrieIter* const it,
+        const m_Trie* const t)
+{
+  assert(it);
+  assert(t);
+  if (!it || !t) return M_FALSE;
+
+  it->t = t;
+  it->leaf = t->root ? _m_Trie_least(t->root) : NULL;
+  return it->leaf != NULL;
+}
+
+M_BOOL
+m_TrieIter_seek(m_TrieIter* const it,
+        const m_Trie* const t,
+        const M_CHAR* const key,
+        const M_SZ len)
+{
+  assert(it);
+  assert(t);
+  if (!it || !t) return M_FALSE;
+
+  it->t = t;
+  it->leaf = m_Trie_lower_bound(t, key, len);
+  return it->leaf != NULL;
+}
+
+M_BOOL
+m_TrieIter_next(m_TrieIter* const it)
+{
+  assert(it);
+  if (!it || !it->leaf) return M_FALSE;
+
+  it->leaf = _m_Trie_bound(it->t, it->leaf->key, it->leaf->len, M_TRUE);
+  return it->leaf != NULL;
+}
+
+#ifndef NDEBUG
+
+typedef struct
+{
+  const M_CHAR* key; /* previous key, or NULL */
+  M_BOOL ok;
+} _m_Trie_check_state;
+
+static M_VOID
+_m_Trie_check_fn(m_String* key,
+        M_PTR val,
+        M_PTR udata)
+{
+  _m_Trie_check_state* const st = (_m_Trie_check_state*) udata;
+
+  M_UNUSED(val);
+  /* strcmp compares as unsigned chars */
+  if (st->key && strcmp(st->key, key->data) >= 0) st->ok = M_FALSE;
+  st->key = key->data;
+}
+
+M_BOOL
+m_Trie_check(const m_Trie* const t)
+{
+  _m_Trie_check_state st = {NULL, M_TRUE};
+  M_SZ num = 0;
+
+  assert(t);
+
+  if (t->root) num = _m_Trie_walk(t->root, &_m_Trie_check_fn, &st);
+  return num == t->num && st.ok;
+}
+
+#endif /* NDEBUG */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,322 @@
+/*
+    mulib
+    Copyright 2014-2018 Stanislas Marquis <stan@astrorigin.com>
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ */
+
+/**
+ *  \file m_trie.h
+ *  \brief Ordered map of string keys (crit-bit tree).
+ *  \author Stanislas Marquis <stan@astrorigin.com>
+ */
+
+/*
+ *  Same calls as m_Dict, with keys kept in order (bytes compared as
+ *  unsigned chars, a key before the keys it is a prefix of), so that keys
+ *  can be walked by prefix, or from any key on.
+ *
+ *  A crit-bit tree: a binary trie where each internal node tells the
+ *  first bit on which the keys under its two sides differ, and leaves
+ *  hold the keys. Paths skip all bits that are the same, so there are
+ *  n - 1 internal nodes for n keys, whatever their lengths, and a lookup
+ *  tests one bit per node and compares one key at the end. There is no
+ *  rebalancing: the shape only depends on the set of keys.
+ *
+ *  Keys must not hold null chars. Internal nodes are told from leaves by
+ *  the lowest bit of their pointers.
+ */
+
+#ifndef M_TRIE_H
+#define M_TRIE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "m_h.h"
+#include "m_mempool.h"
+#include "m_string.h"
+
+/**
+ *  \typedef m_TrieLeaf
+ */
+typedef struct _m_TrieLeaf m_TrieLeaf;
+
+/**
+ *  \struct _m_TrieLeaf
+ *
+ *  The key is stored in the same allocation, null-terminated.
+ */
+struct _m_TrieLeaf
+{
+  M_PTR val;
+  M_SZ len; /* length of key */
+  M_CHAR key[];
+};
+
+/**
+ *  \typedef m_TrieNode
+ */
+typedef struct _m_TrieNode m_TrieNode;
+
+/**
+ *  \struct _m_TrieNode
+ */
+struct _m_TrieNode
+{
+  M_PTR child[2]; /* node (tagged) or leaf */
+  M_UINT32 byte; /* index of the critical byte */
+  M_UCHAR otherbits; /* all bits but the critical one */
+};
+
+/**
+ *  \typedef m_Trie
+ */
+typedef struct _m_Trie m_Trie;
+
+/**
+ *  \struct _m_Trie
+ */
+struct _m_Trie
+{
+  M_PTR root; /* node (tagged) or leaf, or NULL */
+  M_SZ num; /* number of keys */
+  M_VOID (*finalize_fn)(M_PTR);
+};
+
+/**
+ *  \brief Allocate for a trie.
+ */
+M_DLLAPI M_BOOL
+m_Trie_new(m_Trie** const t);
+
+/**
+ *  \brief Initialize a trie.
+ */
+M_DLLAPI M_BOOL
+m_Trie_init(m_Trie* const t);
+
+/**
+ *  \brief Finalize a trie.
+ *
+ *  If not NULL, t->finalize_fn is executed on the values.
+ */
+M_DLLAPI M_VOID
+m_Trie_fini(m_Trie* const t);
+
+/**
+ *  \brief Delete a trie.
+ */
+M_DLLAPI M_VOID
+m_Trie_delete(m_Trie** const t);
+
+/**
+ *  \brief Get an elem from the trie or NULL.
+ *  \param t The trie.
+ *  \param key The key string (not NULL nor empty).
+ *  \return Element found, or NULL if nothing found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_Trie_get(const m_Trie* const t,
+        const M_CHAR* const key);
+
+/**
+ *  \brief Get an elem from the trie or NULL (key of known length).
+ *  \param t The trie.
+ *  \param key The key (not NULL, without null chars).
+ *  \param len Length of key (not 0).
+ *  \return Element found, or NULL if nothing found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_Trie_get_len(const m_Trie* const t,
+        const M_CHAR* const key,
+        const M_SZ len);
+
+/**
+ *  \brief Set or insert an element in the trie.
+ *  \param t The trie.
+ *  \param key The key string (not NULL nor empty).
+ *  \param val The pointer value.
+ *  \param prev If not NULL, return value replaced, or value set if there was none.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_Trie_set(m_Trie* const t,
+        const M_CHAR* const key,
+        const M_PTR const val,
+        M_PTR* const prev);
+
+/**
+ *  \brief Set or insert an element in the trie (key of known length).
+ *  \param t The trie.
+ *  \param key The key (not NULL, without null chars).
+ *  \param len Length of key (not 0).
+ *  \param val The pointer value.
+ *  \param prev If not NULL, return value replaced, or value set if there was none.
+ *  \return M_TRUE, or M_FALSE on error.
+ */
+M_DLLAPI M_BOOL
+m_Trie_set_len(m_Trie* const t,
+        const M_CHAR* const key,
+        const M_SZ len,
+        const M_PTR const val,
+        M_PTR* const prev);
+
+/**
+ *  \brief Remove an element from the trie.
+ *  \param t The trie.
+ *  \param key The key string.
+ *  \return Element that was removed, or NULL if not found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_Trie_unset(m_Trie* const t,
+        const M_CHAR* const key);
+
+/**
+ *  \brief Remove an element from the trie (key of known length).
+ *  \param t The trie.
+ *  \param key The key (not NULL, without null chars).
+ *  \param len Length of key (not 0).
+ *  \return Element that was removed, or NULL if not found (or key is invalid).
+ */
+M_DLLAPI M_PTR
+m_Trie_unset_len(m_Trie* const t,
+        const M_CHAR* const key,
+        const M_SZ len);
+
+/**
+ *  \brief Count the keys of a trie.
+ */
+#define m_Trie_count( t ) \
+        ((t)->num)
+
+/**
+ *  \brief Apply a function to each value in the trie, in key order.
+ */
+M_DLLAPI M_VOID
+m_Trie_traverse(const m_Trie* const t,
+        M_VOID (* const traverse_fn)(M_PTR val));
+
+/**
+ *  \brief Apply a function to each key and value in the trie, in key order
+ *  (with userdata).
+ *
+ *  The key given is a temporary view of the leaf key, not to be modified
+ *  nor kept.
+ */
+M_DLLAPI M_VOID
+m_Trie_traverse_keyval2(const m_Trie* const t,
+        M_VOID (* const traverse_fn)(m_String* key, M_PTR val, M_PTR udata),
+        M_PTR const userdata);
+
+/**
+ *  \brief Apply a function to each key starting with a prefix, and its
+ *  value, in key order (with userdata).
+ *
+ *  Only the subtree of the prefix is visited.
+ *
+ *  \param t The trie.
+ *  \param prefix The prefix (can be empty, for all keys).
+ *  \param len Length of prefix.
+ *  \param traverse_fn The function to apply.
+ *  \param userdata Data passed to traverse_fn.
+ *  \return Number of keys visited.
+ */
+M_DLLAPI M_SZ
+m_Trie_traverse_prefix(const m_Trie* const t,
+        const M_CHAR* const prefix,
+        const M_SZ len,
+        M_VOID (* const traverse_fn)(m_String* key, M_PTR val, M_PTR udata),
+        M_PTR const userdata);
+
+/**
+ *  \brief Get the leaf of the lowest key not less than a key.
+ *  \param t The trie.
+ *  \param key The key (can be empty).
+ *  \param len Length of key.
+ *  \return The leaf, or NULL if all keys are less than key.
+ */
+M_DLLAPI m_TrieLeaf*
+m_Trie_lower_bound(const m_Trie* const t,
+        const M_CHAR* const key,
+        const M_SZ len);
+
+/**
+ *  \typedef m_TrieIter
+ */
+typedef struct _m_TrieIter m_TrieIter;
+
+/**
+ *  \struct _m_TrieIter
+ *  \brief Iterator over a trie, in key order.
+ *
+ *  Moving to the next key searches it from the root (a walk down the tree,
+ *  without comparing keys but once). It is valid as long as the trie is
+ *  not modified.
+ */
+struct _m_TrieIter
+{
+  const m_Trie* t;
+  m_TrieLeaf* leaf; /* current leaf, NULL when past the end */
+};
+
+/**
+ *  \brief Place an iterator on the lowest key of a trie.
+ *  \return M_TRUE, or M_FALSE if the trie is empty.
+ */
+M_DLLAPI M_BOOL
+m_TrieIter_begin(m_TrieIter* const it,
+        const m_Trie* const t);
+
+/**
+ *  \brief Place an iterator on the lowest key not less than a key.
+ *  \return M_TRUE, or M_FALSE if all keys are less than key.
+ */
+M_DLLAPI M_BOOL
+m_TrieIter_seek(m_TrieIter* const it,
+        const m_Trie* const t,
+        const M_CHAR* const key,
+        const M_SZ len);
+
+/**
+ *  \brief Move an iterator to the next key.
+ *  \return M_TRUE, or M_FALSE if there is no next key.
+ */
+M_DLLAPI M_BOOL
+m_TrieIter_next(m_TrieIter* const it);
+
+#ifndef NDEBUG
+
+/**
+ *  \brief Check the order of keys and the count.
+ */
+M_DLLAPI M_BOOL
+m_Trie_check(const m_Trie* const t);
+
+#endif /* NDEBUG */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !M_TRIE_H */
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
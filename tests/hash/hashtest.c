@@ -1,109 +1,210 @@
 /*
- *  Test different hashing functions.
+ *  Benchmark the hash functions of m_hash.h.
  *
+ *  Reports the throughput of each function for several key sizes,
+ *  and how keys spread in a table of 2^ARRPOWER buckets.
+ *
+ *  Usage: hashtest [file of keys, one per line]
+ *
+ *  Without a file, keys are generated: numbered paths, and random strings
+ *  like those of makestrings.
  */
 
-#include <assert.h>
+#include <m_hash.h>
+
 #include <math.h>
-#include <stdio.h>
-#include <string.h>
 
 #define INPUTSIZE 128 /* stdin line size */
 #define ARRPOWER 18 /* array size = 2 pow ARRPOWER */
+#define NUMKEYS 200000 /* generated keys */
+#define MINLEN 6 /* random strings minimum length (few duplicates) */
+#define MAXLEN 14 /* random strings maximum length */
+#define CHARS " abcdefghijklmnopqrstuvwxyz0123456789"
+#define BYTES (1 << 28) /* bytes hashed per function and size */
 
-#if 1 /* FNV1a */
-size_t
-hash_func(const void* k,
-        const size_t len)
+static const struct
 {
-  unsigned char* p = (unsigned char*) k;
-  size_t i, hash = 0x811c9dc5;
+  const M_CHAR* name;
+  m_hash_fn_t fn;
+}
+funcs[] = {
+  { "oaat", &m_hash_oaat },
+  { "fnv1a", &m_hash_fnv1a },
+  { "wy", &m_hash_wy }
+};
 
-  for (i = 0; i < len; ++i) {
-    hash ^= p[i];
-    hash *= 16777619;
-  }
+#define NUMFUNCS (sizeof(funcs) / sizeof(funcs[0]))
+
+static const M_SZ sizes[] = { 4, 8, 16, 32, 64, 256, 4096 };
 
-  // modulo
-  hash &= 0xffffffff >> (32 - ARRPOWER);
+#define NUMSIZES (sizeof(sizes) / sizeof(sizes[0]))
 
-  return hash;
+static M_CHAR** keys;
+static M_SZ numkeys;
+
+static M_DOUBLE
+elapsed(const clock_t start)
+{
+  return (M_DOUBLE)(clock() - start) / CLOCKS_PER_SEC;
 }
-#endif /* end FNV1a */
 
+static M_VOID
+add_key(const M_CHAR* const s)
+{
+  static M_SZ space = 0;
 
-#if 0 /* unknown */
-size_t
-hash_func(const void* k,
-        const size_t len)
+  if (numkeys == space)
+  {
+    space = space ? space * 2 : 1024;
+    keys = realloc(keys, space * sizeof(M_CHAR*));
+    m_assert(keys);
+  }
+  keys[numkeys] = malloc(strlen(s) + 1);
+  m_assert(keys[numkeys]);
+  strcpy(keys[numkeys++], s);
+}
+
+static M_VOID
+read_keys(FILE* const f)
+{
+  M_CHAR input[INPUTSIZE + 1];
+  M_CHAR* p;
+
+  while (fgets(input, INPUTSIZE + 1, f) != NULL)
+  {
+    /* remove trailing newline */
+    if ((p = strrchr(input, '\n'))) *p = '\0';
+    if (*input) add_key(input);
+  }
+}
+
+static M_VOID
+make_keys(M_VOID)
 {
-  unsigned char* p = (unsigned char*) k;
-  size_t i, h = 0;
+  M_CHAR buf[INPUTSIZE];
+  M_SZ i, j, len;
 
-  for (i = 0; i < len; ++i)
+  srand(1);
+  for (i = 0; i < NUMKEYS / 2; ++i)
+  {
+    sprintf(buf, "/usr/share/locale/"M_SZ_FMT"/messages.mo", i);
+    add_key(buf);
+  }
+  for (i = 0; i < NUMKEYS / 2; ++i)
   {
-    h += p[i];
-    h += ( h << 10 );
-    h ^= ( h >> 6 );
+    len = MINLEN + rand() % (MAXLEN - MINLEN + 1);
+    for (j = 0; j < len; ++j)
+      buf[j] = CHARS[rand() % (sizeof(CHARS) - 1)];
+    buf[j] = '\0';
+    add_key(buf);
   }
-  h += ( h << 3 );
-  h ^= ( h >> 11 );
-  h += ( h << 15 );
+}
+
+static M_VOID
+throughput(M_VOID)
+{
+  M_UCHAR* buf;
+  M_SZ f, s, i, n;
+  M_ID acc = 0;
+  M_DOUBLE t;
+  clock_t start;
 
-  // modulo
-  h &= 0xffffffff >> (32 - ARRPOWER);
+  buf = malloc(sizes[NUMSIZES - 1]);
+  m_assert(buf);
+  for (i = 0; i < sizes[NUMSIZES - 1]; ++i) buf[i] = (M_UCHAR) rand();
 
-  return h;
+  printf("-- throughput (GB/s)\n%-8s", "bytes");
+  for (s = 0; s < NUMSIZES; ++s) printf(" %8lu", (unsigned long) sizes[s]);
+  printf("\n");
+
+  for (f = 0; f < NUMFUNCS; ++f)
+  {
+    printf("%-8s", funcs[f].name);
+    for (s = 0; s < NUMSIZES; ++s)
+    {
+      n = BYTES / sizes[s];
+      start = clock();
+      for (i = 0; i < n; ++i)
+      {
+        /* chain results, so that calls can not overlap nor vanish */
+        acc = (*funcs[f].fn)(buf, sizes[s], acc);
+      }
+      t = elapsed(start);
+      printf(" %8.2f", t > 0 ? (M_DOUBLE) BYTES / t / 1e9 : 0);
+      fflush(stdout);
+    }
+    printf("\n");
+  }
+  printf("-- ("M_SZ_FMT")\n", (M_SZ)(acc & 1));
+  free(buf);
 }
-#endif /* end personal */
 
-int main(int argc, char *argv[])
+static M_VOID
+distribution(M_VOID)
 {
-  const size_t sz = pow(2, ARRPOWER); /* num buckets */
-  size_t i, h;
-  size_t wasted = 0, max = 0, maxindex, overten = 0, overtennum = 0;
-  char *p = NULL;
-  char input[INPUTSIZE+1];
-  size_t arr[sz]; /* the array of buckets */
-
-  memset(arr, 0, sizeof(size_t) * sz);
-
-  while (fgets(input, INPUTSIZE+1, stdin) != NULL) {
-    /* have read a line */
-    if ((p = strrchr(input, '\n'))) {
-      /* remove trailing newline */
-      *p = '\0';
+  const M_SZ sz = (M_SZ) 1 << ARRPOWER;
+  M_SZ* arr;
+  M_SZ f, i, h, empty, max, over;
+  M_DOUBLE expected;
+
+  arr = malloc(sz * sizeof(M_SZ));
+  m_assert(arr);
+
+  /* for uniform hashes, a bucket is empty with probability e^(-keys/buckets) */
+  expected = sz * exp(-(M_DOUBLE) numkeys / sz);
+  printf("-- distribution of "M_SZ_FMT" keys in "M_SZ_FMT" buckets"
+      " (%.0f empty expected)\n", numkeys, sz, expected);
+  printf("%-8s %10s %10s %10s %10s\n", "", "empty", "max", "over 10", "seconds");
+
+  for (f = 0; f < NUMFUNCS; ++f)
+  {
+    clock_t start = clock();
+    M_DOUBLE t;
+
+    memset(arr, 0, sz * sizeof(M_SZ));
+    for (i = 0; i < numkeys; ++i)
+    {
+      h = (*funcs[f].fn)(keys[i], strlen(keys[i]), 0);
+      arr[h & (sz - 1)]++;
     }
-    /* compute hash */
-    h = hash_func(input, strlen(input));
-    /* insert in bucket */
-    arr[h]++;
-    if (p == NULL) {
-      /* last line? */
-      break;
+    t = elapsed(start);
+    empty = max = over = 0;
+    for (i = 0; i < sz; ++i)
+    {
+      if (arr[i] == 0) ++empty;
+      if (arr[i] > max) max = arr[i];
+      if (arr[i] > 10) ++over;
     }
+    printf("%-8s %10lu %10lu %10lu %10.3f\n", funcs[f].name,
+        (unsigned long) empty, (unsigned long) max, (unsigned long) over, t);
   }
+  free(arr);
+}
 
-  /* make some stats */
-  for (i = 0; i < sz; ++i) {
-      printf("h[%lu] = %lu\n", i, arr[i]);
-      if (arr[i] == 0) {
-          wasted++;
-      }
-      if (arr[i] > max) {
-        max = arr[i];
-        maxindex = i;
-      }
-      if (arr[i] > 10) {
-        overten++;
-        overtennum += arr[i];
-      }
+int main(int argc, char* argv[])
+{
+  M_SZ i;
+
+  if (argc > 1)
+  {
+    FILE* f = fopen(argv[1], "r");
+    if (!f)
+    {
+      fprintf(stderr, "unable to open %s\n", argv[1]);
+      return 1;
+    }
+    read_keys(f);
+    fclose(f);
   }
-  printf("Wasted buckets = %lu\n", wasted);
-  printf("Maximum = %lu at %lu\n", max, maxindex);
-  printf("Over 10 = %lu, total = %lu\n", overten, overtennum);
+  else
+    make_keys();
+
+  throughput();
+  distribution();
 
+  for (i = 0; i < numkeys; ++i) free(keys[i]);
+  free(keys);
   return 0;
 }
 
-//end.
\ No newline at end of file
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -20,7 +20,7 @@
 #define NUMCHARS 37
 
 
-int main(int argc, char *argv[])
+int main(void)
 {
   size_t i, j;
   char buf[MAXLEN+1];
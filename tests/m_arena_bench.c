@@ -0,0 +1,99 @@
+/*
+ *  Requests making many small strings, and a btree of them, all freed
+ *  at the end: one by one through the pool, or by resetting an arena.
+ *
+ *  Usage: m_arena_bench [number of strings per request]
+ */
+
+#include <m_arena.h>
+
+#include <m_btree.h>
+#include <m_mempool.h>
+#include <m_string.h>
+
+#define DEFAULT_NUM 10000
+#define REQUESTS 100
+
+static volatile M_SZ sink;
+
+static M_DOUBLE
+elapsed(const clock_t start)
+{
+  return (M_DOUBLE)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static M_VOID
+delete_string(M_PTR s)
+{
+  m_String_delete((m_String**) &s);
+}
+
+/*
+ *  One request, with strings from the pool if alloc is NULL.
+ */
+static M_VOID
+request(const M_SZ num,
+        const m_Allocator* const alloc)
+{
+  static const M_CHAR words[] = "lorem ipsum dolor sit amet consectetur";
+  m_BTree bt;
+  m_String* s;
+  M_SZ i;
+
+  if (alloc) m_BTree_init2(&bt, &m_Arena_malloc, &m_Arena_drop);
+  else m_BTree_init(&bt);
+  for (i = 0; i < num; ++i)
+  {
+    s = NULL;
+    m_assert(m_String_new2(&s, words, 8 + i % 24, alloc));
+    m_assert(m_String_cat(s, words + i % 16));
+    m_assert(m_BTree_insert(&bt, i * 2654435761u, s) == 1);
+  }
+  sink += bt.num;
+  if (!alloc)
+  {
+    m_BTree_traverse(&bt, &delete_string);
+    m_BTree_fini(&bt);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  m_Arena a;
+  M_DOUBLE t1, t2;
+  clock_t start;
+  M_SZ i, num;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (!num) num = DEFAULT_NUM;
+
+  M_MEMPOOL_INIT();
+  m_assert(m_Arena_init(&a, 0));
+  m_Arena_set(&a);
+
+  start = clock();
+  for (i = 0; i < REQUESTS; ++i)
+    request(num, NULL);
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < REQUESTS; ++i)
+  {
+    request(num, m_Arena_allocator());
+    m_Arena_reset(&a);
+  }
+  t2 = elapsed(start);
+
+  printf("-- %d requests of "M_SZ_FMT" strings\n", REQUESTS, num);
+  printf("%-10s %10s %10s %9s\n", "(seconds)", "MemPool", "Arena",
+      "speedup");
+  printf("%-10s %10.3f %10.3f %8.2fx\n", "total", t1, t2, t1 / t2);
+  printf("%-10s %10s %10lu\n", "held", "",
+      (unsigned long) a.size);
+
+  m_Arena_set(NULL);
+  m_Arena_fini(&a);
+  M_MEMPOOL_FINI();
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
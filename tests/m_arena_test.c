@@ -0,0 +1,127 @@
+#include <m_arena.h>
+
+#include <m_btree.h>
+#include <m_mempool.h>
+#include <m_string.h>
+
+#define NUM 1000
+
+M_INT32
+m_arena_test(M_VOID)
+{
+  m_Arena a;
+  m_ArenaMark m1, m2;
+  m_BTree bt;
+  m_Array arr;
+  m_String* s = NULL;
+  M_UCHAR* p;
+  M_UCHAR* q;
+  M_PTR first;
+  M_SZ i, size;
+
+  M_MEMPOOL_INIT();
+
+  m_assert(m_Arena_init(&a, 1024));
+  m_assert(a.size == 0);
+
+  /* bump allocations, aligned, until a second block */
+  first = p = m_Arena_alloc(&a, 1);
+  m_assert(p && a.size == 1024);
+  for (i = 0; i < 50; ++i)
+  {
+    q = m_Arena_alloc(&a, 1 + i % 40);
+    m_assert(q && ((M_SZ) q % M_ARENA_ALIGN) == 0);
+    memset(q, 0xAB, 1 + i % 40);
+  }
+  m_assert(a.first->next && a.size == 2048);
+
+  /* bigger than a block */
+  q = m_Arena_alloc(&a, 5000);
+  m_assert(q && a.block->size == 5008 && a.size == 2048 + 5008);
+
+  /* the last allocation grows and shrinks in place */
+  p = m_Arena_alloc(&a, 100);
+  q = m_Arena_resize(&a, p, 200, 100);
+  m_assert(q == p);
+  m_Arena_release(&a, p, 200);
+  m_assert(m_Arena_alloc(&a, 8) == p);
+
+  /* reset reuses the blocks */
+  size = a.size;
+  m_Arena_reset(&a);
+  m_assert(a.used == 0);
+  m_assert(m_Arena_alloc(&a, 1) == first);
+  for (i = 0; i < 50; ++i)
+    m_assert(m_Arena_alloc(&a, 1 + i % 40));
+  m_assert(a.size == size);
+
+  /* nested marks */
+  m_Arena_mark(&a, &m1);
+  p = m_Arena_alloc(&a, 16);
+  m_Arena_mark(&a, &m2);
+  q = m_Arena_alloc(&a, 3000);
+  m_assert(q);
+  m_Arena_rewind(&a, &m2);
+  m_assert(m_Arena_alloc(&a, 16) == p + 16);
+  m_Arena_rewind(&a, &m1);
+  m_assert(m_Arena_alloc(&a, 16) == p);
+
+  /* memory from before a mark does not grow into what comes after */
+  m_Arena_mark(&a, &m1);
+  m_assert(m_Arena_resize(&a, p, 32, 16) == p + 16);
+  m_Arena_rewind(&a, &m1);
+  m_Arena_mark(&a, &m1);
+  m_Arena_release(&a, p, 16);
+  m_assert(m_Arena_alloc(&a, 16) == p + 16);
+  m_Arena_rewind(&a, &m1);
+  /* but does once the mark is gone */
+  m_assert(m_Arena_resize(&a, p, 32, 16) == p);
+
+  /* containers */
+  m_Arena_reset(&a);
+  m_Arena_set(&a);
+  m_assert(m_String_new2(&s, "abc", 3, m_Arena_allocator()));
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_String_cat(s, "defg"));
+  m_assert(m_String_LEN(s) == 3 + 4 * NUM);
+  m_assert(!strncmp(s->data, "abcdefgdefg", 11));
+  m_assert(m_String_replace(s, "defg", "x"));
+  m_assert(m_String_LEN(s) == 3 + NUM);
+  m_assert(m_String_replace(s, "x", "yz"));
+  m_assert(m_String_LEN(s) == 3 + 2 * NUM);
+  m_assert(!strncmp(s->data, "abcyzyz", 7));
+
+  m_assert(m_Array_init2(&arr, 0, sizeof(M_SZ), NULL, m_Arena_allocator()));
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_Array_append(&arr, &i, 1, NULL));
+  for (i = 0; i < NUM; ++i)
+    m_assert(*(M_SZ*) m_Array_get(&arr, i) == i);
+
+  m_assert(m_BTree_init2(&bt, &m_Arena_malloc, &m_Arena_drop));
+  for (i = 1; i <= NUM; ++i)
+    m_assert(m_BTree_insert(&bt, i, (M_PTR) i) == 1);
+  for (i = 1; i <= NUM; ++i)
+    m_assert(m_BTree_get(&bt, i) == (M_PTR) i);
+
+  /* no finalization, all at once */
+  m_assert(a.used > NUM * sizeof(m_BTNode));
+  m_Arena_reset(&a);
+  m_Arena_purge(&a);
+  m_assert(a.size == 1024);
+  m_Arena_set(NULL);
+
+  m_Arena_fini(&a);
+  m_assert(a.size == 0);
+
+  M_MEMPOOL_FINI();
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_arena_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,132 @@
+#include <m_bdict.h>
+
+static M_VOID
+init_key(m_Array* const key,
+        M_PTR data,
+        const M_SZ len)
+{
+  key->data = data;
+  key->len = len;
+  key->unit = 1;
+  key->capacity = len;
+  key->calc_space_fn = NULL;
+  key->allocator = NULL;
+}
+
+static M_VOID
+count_keyval(m_Array* key,
+        M_PTR val,
+        M_PTR udata)
+{
+  m_assert(key->unit == 1);
+  m_assert(key->len == (M_SZ) val);
+  *(M_SZ*) udata += key->len;
+}
+
+static M_INT32
+m_BDict_len_test(M_VOID)
+{
+  m_BDict d;
+  M_UCHAR b1[] = {0, 1, 2, 3};
+  M_UCHAR b2[] = {0, 1, 2, 3, 0};
+  M_UCHAR b3[] = {7, 7, 7};
+  M_UCHAR b4[] = {7, 7, 7};
+  M_UINT32 u[] = {0x03020100};
+  m_Array ka;
+  M_SZ total = 0;
+  M_PTR old;
+
+  m_assert(m_BDict_init(&d));
+
+  /* copied keys */
+  m_assert(m_BDict_set_len(&d, b1, sizeof(b1), (M_PTR)0x4, &old));
+  m_assert(old == (M_PTR)0x4);
+  m_assert(m_BDict_set_len(&d, b2, sizeof(b2), (M_PTR)0x5, NULL));
+  m_assert(m_BDict_get_len(&d, b1, sizeof(b1)) == (M_PTR)0x4);
+  m_assert(m_BDict_get_len(&d, b2, sizeof(b2)) == (M_PTR)0x5);
+  m_assert(m_BDict_get_len(&d, b2, 3) == NULL);
+  b1[0] = 9;
+  m_assert(m_BDict_get_len(&d, b1, sizeof(b1)) == NULL);
+  b1[0] = 0;
+
+  /* keys are compared as bytes, whatever the array unit */
+  ka.data = u;
+  ka.len = 1;
+  ka.unit = sizeof(M_UINT32);
+  ka.capacity = 1;
+  ka.calc_space_fn = NULL;
+  ka.allocator = NULL;
+  if (b1[0] == ((M_UCHAR*) u)[0])
+    m_assert(m_BDict_get(&d, &ka) == (M_PTR)0x4);
+
+  /* borrowed keys */
+  m_assert(m_BDict_set_ro(&d, b3, sizeof(b3), (M_PTR)0x3, &old));
+  m_assert(old == (M_PTR)0x3);
+  m_assert(m_BDict_get_len(&d, b4, sizeof(b4)) == (M_PTR)0x3);
+  m_assert(m_BDict_set_len(&d, b4, sizeof(b4), (M_PTR)0x3, &old));
+  m_assert(old == (M_PTR)0x3);
+  m_assert(m_BDict_set_ro(&d, b1, sizeof(b1), (M_PTR)0x4, &old));
+  m_assert(old == (M_PTR)0x4);
+
+  m_BDict_traverse_keyval2(&d, &count_keyval, &total);
+  m_assert(total == sizeof(b1) + sizeof(b2) + sizeof(b3));
+
+  m_assert(m_BDict_unset_len(&d, b4, sizeof(b4)) == (M_PTR)0x3);
+  m_assert(m_BDict_get_len(&d, b3, sizeof(b3)) == NULL);
+  m_assert(m_BDict_unset_len(&d, b1, sizeof(b1)) == (M_PTR)0x4);
+
+  m_BDict_fini(&d);
+  return 0;
+}
+
+M_INT32
+m_BDict_test(M_VOID)
+{
+  m_BDict d;
+  m_Array k1, k2, k3;
+  M_UCHAR b1[] = {0, 1, 2, 3};
+  M_UCHAR b2[] = {0, 1, 2, 4};
+  M_UCHAR b3[] = {0, 1, 2};
+  M_PTR old;
+
+  M_MEMPOOL_INIT();
+
+  init_key(&k1, b1, sizeof(b1));
+  init_key(&k2, b2, sizeof(b2));
+  init_key(&k3, b3, sizeof(b3));
+
+  m_assert(m_BDict_init2(&d, &m_hash_fnv1a, m_hash_seed()));
+
+  m_assert(m_BDict_set(&d, &k1, (M_PTR)0x1, &old));
+  m_assert(old == (M_PTR)0x1);
+  m_assert(m_BDict_set(&d, &k2, (M_PTR)0x2, &old));
+  m_assert(m_BDict_get(&d, &k1) == (M_PTR)0x1);
+  m_assert(m_BDict_get(&d, &k2) == (M_PTR)0x2);
+  m_assert(m_BDict_get(&d, &k3) == NULL);
+
+  m_assert(m_BDict_set(&d, &k1, (M_PTR)0x3, &old));
+  m_assert(old == (M_PTR)0x1);
+  m_assert(m_BDict_get(&d, &k1) == (M_PTR)0x3);
+
+  m_assert(m_BDict_unset(&d, &k3) == NULL);
+  m_assert(m_BDict_unset(&d, &k1) == (M_PTR)0x3);
+  m_assert(m_BDict_get(&d, &k1) == NULL);
+  m_assert(m_BDict_get(&d, &k2) == (M_PTR)0x2);
+
+  m_BDict_fini(&d);
+
+  m_assert(!m_BDict_len_test());
+
+  M_MEMPOOL_STATUS();
+  M_MEMPOOL_FINI();
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_BDict_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,115 @@
+/*
+ *  Compare the AVL tree (m_BTree) and the B+tree (m_BPTree).
+ *
+ *  Usage: m_bptree_bench [number of keys]
+ */
+
+#include <m_bptree.h>
+#include <m_btree.h>
+
+#define DEFAULT_NUM 1000000
+
+static M_ID* keys;
+static M_SZ num;
+static M_SZ sum;
+
+static M_ID
+key_at(const M_SZ i)
+{
+  /* odd multiplier, so that keys are unique and scattered */
+  return (M_ID)(i * 0x9E3779B97F4A7C15ULL);
+}
+
+static M_DOUBLE
+elapsed(const clock_t start)
+{
+  return (M_DOUBLE)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static M_VOID
+report(const M_CHAR* const what,
+        const M_DOUBLE avl,
+        const M_DOUBLE bp)
+{
+  printf("%-10s %10.3f %10.3f %8.2fx\n", what, avl, bp, bp > 0 ? avl / bp : 0);
+}
+
+static M_VOID
+count_fn(M_PTR val,
+        M_PTR udata)
+{
+  *(M_SZ*)udata += (M_SZ) val;
+}
+
+int main(int argc, char* argv[])
+{
+  m_BTree avl;
+  m_BPTree bp;
+  M_DOUBLE t1, t2;
+  clock_t start;
+  M_SZ i;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (num == 0) num = DEFAULT_NUM;
+  keys = malloc(num * sizeof(M_ID));
+  m_assert(keys);
+  for (i = 0; i < num; ++i) keys[i] = key_at(i);
+
+  /* plain malloc/free for both */
+  m_assert(m_BTree_init2(&avl, NULL, NULL));
+  m_assert(m_BPTree_init2(&bp, NULL, NULL));
+
+  printf("-- keys: "M_SZ_FMT", node sizes: avl "M_SZ_FMT", bptree "M_SZ_FMT"\n",
+      num, sizeof(m_BTNode), sizeof(m_BPTNode));
+  printf("%-10s %10s %10s %9s\n", "(seconds)", "avl", "bptree", "speedup");
+
+  start = clock();
+  for (i = 0; i < num; ++i)
+    m_BTree_insert(&avl, keys[i], (M_PTR)(i + 1));
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < num; ++i)
+    m_BPTree_insert(&bp, keys[i], (M_PTR)(i + 1));
+  t2 = elapsed(start);
+  report("insert", t1, t2);
+
+  /* look up in another order than insertion, else the AVL tree nodes
+     are visited in allocation order */
+  sum = 0;
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum += (M_SZ) m_BTree_get(&avl, keys[(i * 7919) % num]);
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum -= (M_SZ) m_BPTree_get(&bp, keys[(i * 7919) % num]);
+  t2 = elapsed(start);
+  m_assert(sum == 0);
+  report("get", t1, t2);
+
+  start = clock();
+  m_BTree_traverse2(&avl, &count_fn, &sum);
+  t1 = elapsed(start);
+  start = clock();
+  m_BPTree_traverse2(&bp, &count_fn, &sum);
+  t2 = elapsed(start);
+  m_assert(sum == num * (num + 1));
+  report("iterate", t1, t2);
+
+  start = clock();
+  for (i = 0; i < num; ++i)
+    m_BTree_remove(&avl, keys[(i * 7919) % num], NULL);
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < num; ++i)
+    m_BPTree_remove(&bp, keys[(i * 7919) % num], NULL);
+  t2 = elapsed(start);
+  report("remove", t1, t2);
+
+  m_BTree_fini(&avl);
+  m_BPTree_fini(&bp);
+  free(keys);
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
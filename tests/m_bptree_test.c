@@ -0,0 +1,94 @@
+#include <m_bptree.h>
+#include <m_mempool.h>
+
+#define NUM 5000
+
+static M_ID
+shuffled(const M_ID i)
+{
+  /* a bijection on [0, NUM) */
+  return (i * 2903) % NUM;
+}
+
+M_INT32
+m_bptree_test(M_VOID)
+{
+  m_BPTree bt;
+  M_PTR prev;
+  M_ID i;
+
+  printf("-- BPTREE -- test\n"
+         "-- sizeof( bptree ) = "M_SZ_FMT"\n"
+         "-- sizeof( node )   = "M_SZ_FMT"\n"
+         "--\n",
+      sizeof(m_BPTree),
+      sizeof(m_BPTNode));
+
+  M_MEMPOOL_INIT();
+
+  m_assert(m_BPTree_init(&bt));
+  m_assert(m_BPTree_get(&bt, 1) == NULL);
+  m_BPTree_remove(&bt, 1, NULL);
+
+  for (i = 0; i < NUM; ++i)
+  {
+    const M_ID k = shuffled(i);
+    m_assert(m_BPTree_insert(&bt, k, (M_PTR)(k + 1)) == 1);
+  }
+  m_assert(m_BPTree_insert(&bt, 42, (M_PTR)1) == 0);
+  m_assert(m_BPTree_count(&bt) == NUM);
+  m_assert(m_BPTree_check(&bt));
+  m_assert(m_BPTree_min(&bt) == 0);
+  m_assert(m_BPTree_max(&bt) == NUM - 1);
+
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_BPTree_get(&bt, i) == (M_PTR)(i + 1));
+  m_assert(m_BPTree_get(&bt, NUM) == NULL);
+
+  m_assert(m_BPTree_set(&bt, 7, (M_PTR)0xdeadbeef, &prev));
+  m_assert(prev == (M_PTR)8);
+  m_assert(m_BPTree_get(&bt, 7) == (M_PTR)0xdeadbeef);
+  m_assert(!m_BPTree_set(&bt, NUM, NULL, NULL));
+  m_assert(m_BPTree_set(&bt, 7, (M_PTR)8, NULL));
+
+  /* remove every other key */
+  for (i = 0; i < NUM; i += 2)
+    m_BPTree_remove(&bt, shuffled(i), NULL);
+  m_assert(m_BPTree_count(&bt) == NUM / 2);
+  m_assert(m_BPTree_check(&bt));
+  for (i = 0; i < NUM; ++i)
+  {
+    const M_ID k = shuffled(i);
+    m_assert(m_BPTree_get(&bt, k) == (i % 2 ? (M_PTR)(k + 1) : NULL));
+  }
+
+  /* remove the rest */
+  for (i = 1; i < NUM; i += 2)
+  {
+    m_BPTree_remove(&bt, shuffled(i), NULL);
+    if (i % 501 == 0) m_assert(m_BPTree_check(&bt));
+  }
+  m_assert(m_BPTree_count(&bt) == 0);
+  m_assert(bt.root == NULL);
+
+  /* sequential fill, then fini with elements */
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_BPTree_insert(&bt, i, (M_PTR)(i + 1)) == 1);
+  m_assert(m_BPTree_check(&bt));
+  m_BPTree_fini(&bt);
+
+  M_MEMPOOL_STATUS();
+  M_MEMPOOL_FINI();
+
+  printf("-- end bptree test\n");
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_bptree_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,183 @@
+/*
+ *  Load an m_BTree from sorted keys: one insert per key, against
+ *  m_BTree_build_sorted, and random lookups one at a time or in batches.
+ *  Then full scans, one value per call against batches and iterators.
+ *
+ *  Usage: m_btree_bench [number of keys]
+ */
+
+#include <m_btree.h>
+#include <m_mempool.h>
+
+#define DEFAULT_NUM 2000000
+
+static M_DOUBLE
+elapsed(const clock_t start)
+{
+  return (M_DOUBLE)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* look up all keys in random order */
+static M_DOUBLE
+lookups(const m_BTree* const bt,
+        const M_ID* const keys,
+        const M_SZ num)
+{
+  M_UINT64 x = 88172645463325252ULL;
+  clock_t start = clock();
+  M_SZ i, sum = 0;
+
+  for (i = 0; i < num; ++i)
+  {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    sum += (M_SZ) m_BTree_get(bt, keys[x % num]);
+  }
+  m_assert(sum);
+  return elapsed(start);
+}
+
+/* the same, BATCH keys per call to m_BTree_get_many */
+#define BATCH 32
+
+static M_DOUBLE
+lookups_many(const m_BTree* const bt,
+        const M_ID* const keys,
+        const M_SZ num)
+{
+  M_UINT64 x = 88172645463325252ULL;
+  M_ID batch[BATCH];
+  M_PTR vals[BATCH];
+  clock_t start = clock();
+  M_SZ i, j, n, sum = 0;
+
+  for (i = 0; i < num; i += n)
+  {
+    n = M_MIN(num - i, (M_SZ) BATCH);
+    for (j = 0; j < n; ++j)
+    {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      batch[j] = keys[x % num];
+    }
+    m_BTree_get_many(bt, batch, vals, n);
+    for (j = 0; j < n; ++j)
+      sum += (M_SZ) vals[j];
+  }
+  m_assert(sum);
+  return elapsed(start);
+}
+
+static M_VOID
+sum_fn(M_PTR val,
+        M_PTR udata)
+{
+  *(M_SZ*)udata += (M_SZ) val;
+}
+
+static M_VOID
+sum_batch_fn(const M_ID* keys,
+        M_PTR* vals,
+        M_SZ num,
+        M_PTR udata)
+{
+  M_SZ i, sum = 0;
+
+  M_UNUSED(keys);
+  for (i = 0; i < num; ++i)
+    sum += (M_SZ) vals[i];
+  *(M_SZ*)udata += sum;
+}
+
+/* scan a tree three ways, for the same sum */
+static M_VOID
+scans(const M_CHAR* const what,
+        m_BTree* const bt)
+{
+  m_BTreeIter it;
+  M_DOUBLE t1, t2, t3;
+  clock_t start;
+  M_SZ s1 = 0, s2 = 0, s3 = 0;
+
+  start = clock();
+  m_BTree_traverse2(bt, &sum_fn, &s1);
+  t1 = elapsed(start);
+  start = clock();
+  for (m_BTreeIter_begin(&it, bt); it.depth; m_BTreeIter_next(&it))
+    s2 += (M_SZ) m_BTreeIter_val(&it);
+  t2 = elapsed(start);
+  start = clock();
+  m_BTree_traverse_batch(bt, &sum_batch_fn, &s3);
+  t3 = elapsed(start);
+  m_assert(s1 == s2 && s2 == s3);
+  printf("%-10s %10.3f %10.3f %10.3f\n", what, t1, t2, t3);
+}
+
+int main(int argc, char* argv[])
+{
+  m_BTree bt1, bt2;
+  M_ID* keys;
+  M_PTR* vals;
+  M_DOUBLE t1, t2;
+  clock_t start;
+  M_SZ i, num;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (num == 0) num = DEFAULT_NUM;
+  keys = malloc(num * sizeof(M_ID));
+  vals = malloc(num * sizeof(M_PTR));
+  m_assert(keys && vals);
+  for (i = 0; i < num; ++i)
+  {
+    keys[i] = 3 * i + 1;
+    vals[i] = (M_PTR)(i + 1);
+  }
+
+  M_MEMPOOL_INIT();
+  m_assert(m_BTree_init(&bt1));
+  m_assert(m_BTree_init(&bt2));
+
+  printf("-- keys: "M_SZ_FMT"\n", num);
+  printf("%-10s %10s %12s %9s\n", "(seconds)", "insert", "build_sorted",
+      "speedup");
+
+  start = clock();
+  for (i = 0; i < num; ++i)
+    m_BTree_insert(&bt1, keys[i], vals[i]);
+  t1 = elapsed(start);
+  start = clock();
+  m_assert(m_BTree_build_sorted(&bt2, keys, vals, num));
+  t2 = elapsed(start);
+  printf("%-10s %10.3f %12.3f %8.2fx\n", "load", t1, t2, t2 > 0 ? t1 / t2 : 0);
+
+  t1 = lookups(&bt1, keys, num);
+  t2 = lookups(&bt2, keys, num);
+  printf("%-10s %10.3f %12.3f %8.2fx\n", "get", t1, t2, t2 > 0 ? t1 / t2 : 0);
+  t1 = lookups_many(&bt1, keys, num);
+  t2 = lookups_many(&bt2, keys, num);
+  printf("%-10s %10.3f %12.3f %8.2fx\n", "get_many", t1, t2,
+      t2 > 0 ? t1 / t2 : 0);
+
+  printf("\n%-10s %10s %10s %10s\n", "(seconds)", "traverse2", "iter",
+      "batch");
+  scans("inserted", &bt1);
+  scans("built", &bt2);
+  printf("\n");
+
+  start = clock();
+  m_BTree_fini(&bt1);
+  t1 = elapsed(start);
+  start = clock();
+  m_BTree_fini(&bt2);
+  t2 = elapsed(start);
+  printf("%-10s %10.3f %12.3f\n", "fini", t1, t2);
+
+  M_MEMPOOL_FINI();
+  free(keys);
+  free(vals);
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
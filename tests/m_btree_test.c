@@ -1,6 +1,313 @@
 #include <m_btree.h>
 #include <m_memcnt.h>
 
+#define NUM 1000
+
+/*
+ *  Height of a subtree, checking balance factors and parent links.
+ */
+static M_INT32
+check_node(const m_BTNode* const nd)
+{
+  M_INT32 l, r;
+
+  if (!nd) return 0;
+  m_assert(!nd->less || (nd->less->parent == nd && nd->less->key < nd->key));
+  m_assert(!nd->more || (nd->more->parent == nd && nd->more->key > nd->key));
+  l = check_node(nd->less);
+  r = check_node(nd->more);
+  m_assert(nd->bfactor == r - l);
+#ifdef M_BTREE_RANK
+  m_assert(nd->size == 1 + (nd->less ? nd->less->size : 0)
+      + (nd->more ? nd->more->size : 0));
+#endif
+  return 1 + (l > r ? l : r);
+}
+
+static M_VOID
+build_sorted_test(M_VOID)
+{
+  m_BTree bt;
+  M_ID keys[NUM];
+  M_PTR vals[NUM];
+  m_BTNode* nd;
+  M_SZ i, n;
+
+  m_BTree_init2(&bt, _M_MALLOC_REF, (void(*)(void*))_M_FREE_REF);
+  for (i = 0; i < NUM; ++i)
+  {
+    keys[i] = 2 * i + 2;
+    vals[i] = (M_PTR)(2 * i + 2);
+  }
+  keys[1] = keys[0];
+  m_assert(!m_BTree_build_sorted(&bt, keys, vals, NUM));
+  keys[1] = 4;
+
+  /* every size up to a few levels, then a large one */
+  for (n = 0; n <= 40; ++n)
+  {
+    m_assert(m_BTree_build_sorted(&bt, keys, vals, n));
+    m_assert(m_BTree_count(&bt) == n);
+    check_node(bt.root);
+    m_BTree_fini(&bt);
+    m_BTree_init2(&bt, _M_MALLOC_REF, (void(*)(void*))_M_FREE_REF);
+  }
+  m_assert(m_BTree_build_sorted(&bt, keys, vals, NUM));
+  check_node(bt.root);
+  for (i = 0, nd = m_BTree_least(&bt); nd; nd = m_BTree_next(nd), ++i)
+    m_assert(nd->key == keys[i] && nd->val == vals[i]);
+  m_assert(i == NUM);
+
+  /* then nodes from the slab and nodes from mallocdoer mix */
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_BTree_insert(&bt, 2 * i + 1, (M_PTR)(2 * i + 1)) == 1);
+  check_node(bt.root);
+  m_assert(m_BTree_count(&bt) == 2 * NUM);
+  for (i = 1; i <= 2 * NUM; i += 3)
+    m_BTree_remove(&bt, i, NULL);
+  m_BTree_remove(&bt, 1, NULL);
+  check_node(bt.root);
+  m_assert(m_BTree_count(&bt) == m_BTNode_count(bt.root));
+  for (i = 1; i <= 2 * NUM; ++i)
+    m_assert(m_BTree_get(&bt, i) == (i % 3 == 1 ? NULL : (M_PTR) i));
+  m_BTree_fini(&bt);
+}
+
+static M_VOID
+range_fn(const M_ID* keys,
+        M_PTR* vals,
+        M_SZ num,
+        M_PTR udata)
+{
+  M_ID* const next = udata;
+  M_SZ i;
+
+  m_assert(num && num <= M_BTREE_BATCH);
+  for (i = 0; i < num; ++i)
+  {
+    m_assert(keys[i] == *next && vals[i] == (M_PTR) keys[i]);
+    *next += 1;
+  }
+}
+
+static M_VOID
+get_many_test(M_VOID)
+{
+  m_BTree bt;
+  M_ID keys[NUM];
+  M_PTR vals[NUM];
+  M_SZ i;
+
+  m_assert(m_BTree_init(&bt));
+  m_BTree_get_many(&bt, keys, vals, 0);
+  keys[0] = 1;
+  m_BTree_get_many(&bt, keys, vals, 1);
+  m_assert(vals[0] == NULL);
+
+  for (i = 0; i < NUM; i += 2)
+    m_assert(m_BTree_insert(&bt, i, (M_PTR)(i + 1)) == 1);
+  /* a number of keys that is not a multiple of M_BTREE_GROUP */
+  for (i = 0; i < NUM - 3; ++i)
+    keys[i] = (i * 7919) % NUM;
+  m_BTree_get_many(&bt, keys, vals, NUM - 3);
+  for (i = 0; i < NUM - 3; ++i)
+    m_assert(vals[i] == (keys[i] % 2 ? NULL : (M_PTR)(keys[i] + 1)));
+  m_BTree_fini(&bt);
+}
+
+static M_VOID
+iter_test(M_VOID)
+{
+  m_BTree bt;
+  m_BTreeIter it;
+  M_ID k;
+  M_SZ i;
+
+  m_BTree_init2(&bt, _M_MALLOC_REF, (void(*)(void*))_M_FREE_REF);
+  m_assert(!m_BTreeIter_begin(&it, &bt));
+  m_assert(!m_BTreeIter_seek(&it, &bt, 1));
+  m_assert(m_BTreeIter_node(&it) == NULL);
+
+  /* keys 2, 4, ... 2 * NUM, inserted in some scattered order */
+  for (i = 0; i < NUM; ++i)
+  {
+    k = (i * 7919) % NUM;
+    m_assert(m_BTree_insert(&bt, 2 * k + 2, (M_PTR)(2 * k + 2)) == 1);
+  }
+
+  k = 2;
+  for (m_BTreeIter_begin(&it, &bt); m_BTreeIter_node(&it); m_BTreeIter_next(&it))
+  {
+    m_assert(m_BTreeIter_key(&it) == k);
+    m_assert(m_BTreeIter_val(&it) == (M_PTR) k);
+    k += 2;
+  }
+  m_assert(k == 2 * NUM + 2);
+  m_assert(!m_BTreeIter_next(&it));
+
+  k = 2 * NUM;
+  for (m_BTreeIter_last(&it, &bt); m_BTreeIter_node(&it); m_BTreeIter_prev(&it))
+  {
+    m_assert(m_BTreeIter_key(&it) == k);
+    k -= 2;
+  }
+  m_assert(k == 0);
+
+  /* lower bounds */
+  for (k = 0; k <= 2 * NUM; ++k)
+  {
+    m_assert(m_BTreeIter_seek(&it, &bt, k));
+    m_assert(m_BTreeIter_key(&it) == (k % 2 ? k + 1 : (k ? k : 2)));
+  }
+  m_assert(!m_BTreeIter_seek(&it, &bt, 2 * NUM + 1));
+  m_assert(m_BTreeIter_seek(&it, &bt, 501));
+  m_assert(m_BTreeIter_prev(&it) && m_BTreeIter_key(&it) == 500);
+  m_assert(m_BTreeIter_next(&it) && m_BTreeIter_key(&it) == 502);
+
+  /* batched reads, in range */
+  {
+    M_ID keys[10];
+    m_assert(m_BTreeIter_seek(&it, &bt, 11));
+    m_assert(m_BTreeIter_read(&it, 30, keys, NULL, 10) == 10);
+    m_assert(keys[0] == 12 && keys[9] == 30);
+    m_assert(m_BTreeIter_key(&it) == 32);
+    m_assert(m_BTreeIter_read(&it, 33, keys, NULL, 10) == 1);
+    m_assert(m_BTreeIter_read(&it, 33, keys, NULL, 10) == 0);
+  }
+
+  /* odd keys too, then whole ranges */
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_BTree_insert(&bt, 2 * i + 1, (M_PTR)(2 * i + 1)) == 1);
+  k = 1;
+  m_BTree_traverse_batch(&bt, &range_fn, &k);
+  m_assert(k == 2 * NUM + 1);
+  k = 100;
+  m_BTree_traverse_range(&bt, 100, 399, &range_fn, &k);
+  m_assert(k == 400);
+  k = 0;
+  m_BTree_traverse_range(&bt, 5, 4, &range_fn, &k);
+  m_assert(k == 0);
+
+  m_BTree_fini(&bt);
+}
+
+#ifdef M_BTREE_RANK
+static M_VOID
+rank_test(M_VOID)
+{
+  m_BTree bt;
+  M_SZ i;
+
+  m_BTree_init2(&bt, _M_MALLOC_REF, (void(*)(void*))_M_FREE_REF);
+  m_assert(m_BTree_rank(&bt, 5) == 0);
+  m_assert(m_BTree_select(&bt, 0) == NULL);
+
+  /* keys 10, 20, ... inserted out of order */
+  for (i = 0; i < NUM; ++i)
+    m_BTree_insert(&bt, 10 * ((i * 7919) % NUM + 1), NULL);
+  check_node(bt.root);
+  for (i = 0; i < NUM; ++i)
+  {
+    m_assert(m_BTree_select(&bt, i)->key == 10 * (i + 1));
+    m_assert(m_BTree_rank(&bt, 10 * (i + 1)) == i);
+    m_assert(m_BTree_rank(&bt, 10 * (i + 1) + 5) == i + 1);
+  }
+  m_assert(m_BTree_rank(&bt, 0) == 0);
+  m_assert(m_BTree_select(&bt, NUM) == NULL);
+
+  /* remove every third key, sizes must follow */
+  for (i = 0; i < NUM; i += 3)
+    m_BTree_remove(&bt, 10 * (i + 1), NULL);
+  check_node(bt.root);
+  for (i = 0; i < m_BTree_count(&bt); ++i)
+    m_assert(m_BTree_rank(&bt, m_BTree_select(&bt, i)->key) == i);
+  m_BTree_fini(&bt);
+}
+#endif /* M_BTREE_RANK */
+
+static M_SZ finalized = 0;
+
+static M_VOID
+finalize_fn(M_PTR val)
+{
+  M_UNUSED(val);
+  finalized += 1;
+}
+
+static M_VOID
+pages_test(M_VOID)
+{
+  m_BTree bt;
+  m_BTNode* nd;
+  M_ID keys[NUM];
+  M_SZ i;
+
+  /* nodes from the pages of the tree */
+  m_assert(m_BTree_init(&bt));
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_BTree_insert(&bt, (i * 7919) % NUM, (M_PTR)(i + 1)) == 1);
+  check_node(bt.root);
+
+  /* freed nodes are reused first */
+  nd = m_BTree_node(&bt, 10);
+  m_BTree_remove(&bt, 10, NULL);
+  m_assert(m_BTree_insert(&bt, NUM + 10, NULL) == 1);
+  m_assert(m_BTree_node(&bt, NUM + 10) == nd);
+
+  for (i = 0; i < NUM; i += 2)
+    m_BTree_remove(&bt, i, NULL);
+  for (i = 0; i < NUM; i += 2)
+    m_assert(m_BTree_insert(&bt, i, NULL) == 1);
+  check_node(bt.root);
+  m_assert(m_BTree_count(&bt) == NUM + 1);
+
+  bt.finalize_fn = &finalize_fn;
+  m_BTree_fini(&bt);
+  m_assert(finalized == NUM + 1);
+
+  /* a bulk build then inserts, in pages too */
+  m_assert(m_BTree_init(&bt));
+  for (i = 0; i < NUM; ++i)
+    keys[i] = 2 * i;
+  m_assert(m_BTree_build_sorted(&bt, keys, NULL, NUM));
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_BTree_insert(&bt, 2 * i + 1, NULL) == 1);
+  for (i = 0; i < 2 * NUM; i += 3)
+    m_BTree_remove(&bt, i, NULL);
+  check_node(bt.root);
+  m_BTree_fini(&bt);
+}
+
+/* nodes given to the freedoer, poisoned and kept until the end */
+static M_PTR poisoned[NUM];
+static M_SZ npoisoned = 0;
+
+static M_VOID
+poison_free(M_PTR p)
+{
+  m_assert(npoisoned < NUM);
+  memset(p, 0xA5, sizeof(m_BTNode));
+  poisoned[npoisoned++] = p;
+}
+
+static M_VOID
+delete_all_test(M_VOID)
+{
+  m_BTree bt;
+  M_SZ i;
+
+  /* a freed node is never read again, its links would be garbage */
+  m_BTree_init2(&bt, &malloc, &poison_free);
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_BTree_insert(&bt, (i * 7919) % NUM, (M_PTR)(i + 1)) == 1);
+  check_node(bt.root);
+  m_BTree_fini(&bt);
+  m_assert(!bt.root);
+  m_assert(npoisoned == NUM);
+  for (i = 0; i < npoisoned; ++i)
+    free(poisoned[i]);
+}
+
 typedef struct Test
 {
   M_ID idx;
@@ -107,6 +414,16 @@ m_btree_test(M_VOID)
   m_BTree_fini(&bt);
   M_MEMCNT_DEBUG();
 
+  build_sorted_test();
+  get_many_test();
+  iter_test();
+  pages_test();
+  delete_all_test();
+#ifdef M_BTREE_RANK
+  rank_test();
+#endif
+  M_MEMCNT_DEBUG();
+
   printf("-- end btree test\n");
   return 0;
 }
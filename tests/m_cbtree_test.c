@@ -0,0 +1,203 @@
+#include <m_cbtree.h>
+#include <m_memcnt.h>
+
+#define NUM 2000
+
+static M_SZ finalized = 0;
+
+static M_VOID
+finalize_fn(M_PTR val)
+{
+  M_UNUSED(val);
+  finalized += 1;
+}
+
+/* keys in order, and the same as the keys present in the mirror */
+static M_VOID
+check_tree(const m_CBTree* const bt,
+        const M_BOOL* const present)
+{
+  m_CBTreeIter it;
+  M_SZ i, num = 0;
+
+  m_assert(m_CBTree_check(bt));
+  m_CBTreeIter_begin(&it, bt);
+  for (i = 0; i < NUM; ++i)
+  {
+    if (!present[i])
+    {
+      m_assert(!m_CBTree_get(bt, i));
+      continue;
+    }
+    m_assert(it.depth && m_CBTreeIter_node(&it)->key == i);
+    m_assert(m_CBTree_get(bt, i) == (M_PTR)(i + 1));
+    m_CBTreeIter_next(&it);
+    num += 1;
+  }
+  m_assert(!it.depth);
+  m_assert(m_CBTree_count(bt) == num);
+}
+
+static M_VOID
+iter_test(M_VOID)
+{
+  m_CBTree bt;
+  m_CBTreeIter it;
+  M_ID i;
+
+  m_assert(m_CBTree_init(&bt));
+  m_assert(!m_CBTreeIter_begin(&it, &bt));
+  m_assert(!m_CBTreeIter_seek(&it, &bt, 0));
+  for (i = 10; i <= 100; i += 10)
+    m_assert(m_CBTree_insert(&bt, i, (M_PTR) i) == 1);
+
+  m_assert(m_CBTreeIter_seek(&it, &bt, 50));
+  m_assert(m_CBTreeIter_node(&it)->key == 50);
+  m_assert(m_CBTreeIter_seek(&it, &bt, 51));
+  m_assert(m_CBTreeIter_node(&it)->key == 60);
+  m_assert(m_CBTreeIter_seek(&it, &bt, 0));
+  m_assert(m_CBTreeIter_node(&it)->key == 10);
+  m_assert(!m_CBTreeIter_seek(&it, &bt, 101));
+  m_assert(!m_CBTreeIter_node(&it));
+
+  m_CBTreeIter_seek(&it, &bt, 75);
+  for (i = 80; i <= 100; i += 10)
+  {
+    m_assert(m_CBTreeIter_node(&it)->key == i);
+    m_CBTreeIter_next(&it);
+  }
+  m_assert(!m_CBTreeIter_next(&it));
+  m_CBTree_fini(&bt);
+}
+
+/*
+ *  A tree with every node index taken refuses more keys.
+ */
+static M_VOID
+full_test(M_VOID)
+{
+  m_CBTree bt;
+  M_UINT32 capacity, used;
+
+  m_assert(m_CBTree_init(&bt));
+  m_assert(m_CBTree_insert(&bt, 1, (M_PTR) 1) == 1);
+  capacity = bt.capacity;
+  used = bt.used;
+  /* pretend, the array is not touched past the root */
+  bt.capacity = bt.used = (M_UINT32) M_CBTREE_MAXNODES + 1;
+  m_assert(m_CBTree_insert(&bt, 2, (M_PTR) 2) == -1);
+  m_assert(m_CBTree_insert(&bt, 1, (M_PTR) 3) == 0);
+  bt.capacity = capacity;
+  bt.used = used;
+  m_assert(m_CBTree_get(&bt, 1) == (M_PTR) 1);
+  m_CBTree_fini(&bt);
+}
+
+M_INT32
+m_cbtree_test(M_VOID)
+{
+  m_CBTree bt;
+  m_CBTree* pbt;
+  M_BOOL present[NUM];
+  M_PTR prev;
+  M_UINT32 x = 2463534242U;
+  M_SZ i, j;
+
+  printf("-- start cbtree test\n");
+  printf("-- sizeof(m_CBTNode) = "M_SZ_FMT"\n", sizeof(m_CBTNode));
+
+  m_assert(m_CBTree_new(&pbt));
+  m_assert(m_CBTree_count(pbt) == 0);
+  m_assert(!m_CBTree_remove(pbt, 1, NULL));
+  m_CBTree_delete(&pbt);
+  m_assert(!pbt);
+
+  m_assert(m_CBTree_init(&bt));
+  memset(present, 0, sizeof(present));
+
+  /* ascending, then descending keys: rotations on both sides */
+  for (i = 0; i < NUM; i += 2)
+  {
+    m_assert(m_CBTree_insert(&bt, i, (M_PTR)(i + 1)) == 1);
+    present[i] = M_TRUE;
+  }
+  for (i = NUM - 1; i < NUM; i -= 2)
+  {
+    m_assert(m_CBTree_insert(&bt, i, (M_PTR)(i + 1)) == 1);
+    present[i] = M_TRUE;
+  }
+  m_assert(m_CBTree_insert(&bt, 0, NULL) == 0);
+  check_tree(&bt, present);
+
+  m_assert(m_CBTree_set(&bt, 7, (M_PTR) 70, &prev));
+  m_assert(prev == (M_PTR) 8);
+  m_assert(m_CBTree_set(&bt, 7, (M_PTR) 8, NULL));
+  m_assert(!m_CBTree_set(&bt, NUM, NULL, NULL));
+
+  /* random removes and inserts */
+  for (j = 0; j < 20 * NUM; ++j)
+  {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    i = x % NUM;
+    if (present[i])
+    {
+      m_assert(m_CBTree_remove(&bt, i, NULL));
+      present[i] = M_FALSE;
+    }
+    else
+    {
+      m_assert(!m_CBTree_remove(&bt, i, NULL));
+      m_assert(m_CBTree_insert(&bt, i, (M_PTR)(i + 1)) == 1);
+      present[i] = M_TRUE;
+    }
+    if (j % 997 == 0) check_tree(&bt, present);
+  }
+  check_tree(&bt, present);
+
+  /* down to empty, nodes go back to the free list */
+  for (i = 0; i < NUM; ++i)
+  {
+    m_assert(m_CBTree_remove(&bt, i, NULL) == present[i]);
+    present[i] = M_FALSE;
+  }
+  check_tree(&bt, present);
+  m_assert(bt.root == 0);
+  j = bt.used;
+  for (i = 0; i < NUM; ++i)
+  {
+    m_assert(m_CBTree_insert(&bt, i, (M_PTR)(i + 1)) == 1);
+    present[i] = M_TRUE;
+  }
+  m_assert(bt.used == j);
+  check_tree(&bt, present);
+
+  bt.finalize_fn = &finalize_fn;
+  m_CBTree_fini(&bt);
+  m_assert(finalized == NUM);
+
+  /* reserved room is used without moving */
+  m_assert(m_CBTree_reserve(&bt, NUM));
+  pbt = (m_CBTree*) bt.nodes;
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_CBTree_insert(&bt, i, (M_PTR)(i + 1)) == 1);
+  m_assert((m_CBTree*) bt.nodes == pbt);
+  m_CBTree_fini(&bt);
+
+  iter_test();
+  full_test();
+  M_MEMCNT_DEBUG();
+
+  printf("-- end cbtree test\n");
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_cbtree_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
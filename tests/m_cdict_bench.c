@@ -0,0 +1,165 @@
+/*
+ *  Read throughput of a dict shared between threads: m_Dict behind one
+ *  mutex, against m_CDict.
+ *
+ *  Usage: m_cdict_bench [number of keys] [max threads] [writes per 1000]
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <m_cdict.h>
+#include <m_dict.h>
+#include <m_mempool.h>
+#include <m_mutex.h>
+#include <m_strdup.h>
+
+#include <pthread.h>
+#include <time.h>
+
+#define DEFAULT_NUM 100000
+#define DEFAULT_THREADS 8
+#define LOOKUPS 2000000
+
+static M_CHAR** keys;
+static M_SZ num;
+static M_SZ writes;
+
+static m_Dict dict;
+static M_MUTEX dict_mtx = M_MUTEX_INITIALIZER;
+static m_CDict cdict;
+
+static M_DOUBLE
+now(M_VOID)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* xorshift, one state per thread */
+static M_SZ
+next_key(M_UINT64* const x)
+{
+  *x ^= *x << 13;
+  *x ^= *x >> 7;
+  *x ^= *x << 17;
+  return (M_SZ)(*x % num);
+}
+
+static M_PTR
+run_dict(M_PTR arg)
+{
+  M_UINT64 x = (M_UINT64)(M_SZ) arg * 0x9E3779B97F4A7C15ULL + 1;
+  M_SZ i, k, hits = 0;
+
+  for (i = 0; i < LOOKUPS; ++i)
+  {
+    k = next_key(&x);
+    m_Mutex_lock(dict_mtx);
+    if (writes && i % 1000 < writes)
+      m_Dict_set(&dict, keys[k], (M_PTR)(k + 1), NULL);
+    else
+      hits += m_Dict_get(&dict, keys[k]) != NULL;
+    m_Mutex_unlock(dict_mtx);
+  }
+  return (M_PTR) hits;
+}
+
+static M_PTR
+run_cdict(M_PTR arg)
+{
+  M_UINT64 x = (M_UINT64)(M_SZ) arg * 0x9E3779B97F4A7C15ULL + 1;
+  M_SZ i, k, hits = 0;
+
+  for (i = 0; i < LOOKUPS; ++i)
+  {
+    k = next_key(&x);
+    if (writes && i % 1000 < writes)
+      m_CDict_set(&cdict, keys[k], (M_PTR)(k + 1), NULL);
+    else
+      hits += m_CDict_get(&cdict, keys[k]) != NULL;
+  }
+  return (M_PTR) hits;
+}
+
+/* million operations per second, for all threads */
+static M_DOUBLE
+measure(M_PTR (*run)(M_PTR),
+        const M_SZ nthreads)
+{
+  pthread_t th[256];
+  M_DOUBLE start;
+  M_SZ i;
+
+  start = now();
+  for (i = 0; i < nthreads; ++i)
+    m_assert(!pthread_create(&th[i], NULL, run, (M_PTR)(i + 1)));
+  for (i = 0; i < nthreads; ++i)
+    pthread_join(th[i], NULL);
+  return nthreads * (M_DOUBLE) LOOKUPS / (now() - start) / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+  M_CHAR buf[64];
+  M_DOUBLE t1, t2, base1 = 0, base2 = 0;
+  M_SZ i, maxth;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (num == 0) num = DEFAULT_NUM;
+  maxth = argc > 2 ? strtoul(argv[2], NULL, 10) : DEFAULT_THREADS;
+  if (maxth == 0 || maxth > 256) maxth = DEFAULT_THREADS;
+  writes = argc > 3 ? strtoul(argv[3], NULL, 10) : 0;
+  if (writes > 1000) writes = 1000;
+
+  keys = malloc(num * sizeof(M_CHAR*));
+  m_assert(keys);
+  for (i = 0; i < num; ++i)
+  {
+    sprintf(buf, "some/path/to/key/"M_SZ_FMT, i);
+    keys[i] = m_strdup(buf);
+    m_assert(keys[i]);
+  }
+
+  /*
+   *  All keys are set beforehand: writes only replace values, and threads
+   *  need no mempool of their own for m_Dict.
+   */
+  M_MEMPOOL_INIT();
+  m_assert(m_Dict_init(&dict));
+  m_assert(m_CDict_init(&cdict));
+  for (i = 0; i < num; ++i)
+  {
+    m_assert(m_Dict_set(&dict, keys[i], (M_PTR)(i + 1), NULL));
+    m_assert(m_CDict_set(&cdict, keys[i], (M_PTR)(i + 1), NULL));
+  }
+
+  printf("-- keys: "M_SZ_FMT", ops per thread: %d, writes per 1000: "
+      M_SZ_FMT"\n", num, LOOKUPS, writes);
+  printf("%-8s %12s %8s %12s %8s  (million ops/s)\n", "threads",
+      "mutex+dict", "scale", "cdict", "scale");
+  for (i = 1; i <= maxth; i *= 2)
+  {
+    t1 = measure(&run_dict, i);
+    t2 = measure(&run_cdict, i);
+    if (i == 1)
+    {
+      base1 = t1;
+      base2 = t2;
+    }
+    printf("%-8lu %12.2f %7.2fx %12.2f %7.2fx\n", (unsigned long) i,
+        t1, base1 > 0 ? t1 / base1 : 0, t2, base2 > 0 ? t2 / base2 : 0);
+    if (i < maxth && i * 2 > maxth) i = maxth / 2;
+  }
+
+  /* skip freeing each node, the pool goes at once */
+  M_MEMPOOL_FINI();
+  m_CDict_fini(&cdict);
+  for (i = 0; i < num; ++i)
+    free(keys[i]);
+  free(keys);
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
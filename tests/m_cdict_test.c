@@ -0,0 +1,165 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <m_cdict.h>
+#include <m_mempool.h>
+
+#include <pthread.h>
+
+#define NUM 5000
+#define THREADS 4
+
+static m_CDict shared;
+
+static M_VOID
+key_at(M_CHAR* const buf,
+        const M_SZ i)
+{
+  sprintf(buf, "key-"M_SZ_FMT, i);
+}
+
+static M_VOID
+count_fn(m_String* key,
+        M_PTR val,
+        M_PTR udata)
+{
+  M_CHAR buf[32];
+
+  key_at(buf, (M_SZ) val - 1);
+  m_assert(!strcmp(key->data, buf));
+  *(M_SZ*)udata += 1;
+}
+
+static M_SZ finalized = 0;
+
+static M_VOID
+finalize_fn(M_PTR val)
+{
+  M_UNUSED(val);
+  finalized += 1;
+}
+
+/*
+ *  Each writer inserts, then removes every other key of its own range,
+ *  while readers look up keys of all ranges.
+ */
+static M_PTR
+writer(M_PTR arg)
+{
+  const M_SZ t = (M_SZ) arg;
+  M_CHAR buf[32];
+  M_SZ i;
+
+  for (i = t * NUM; i < (t + 1) * NUM; ++i)
+  {
+    key_at(buf, i);
+    m_assert(m_CDict_set(&shared, buf, (M_PTR)(i + 1), NULL));
+  }
+  for (i = t * NUM; i < (t + 1) * NUM; i += 2)
+  {
+    key_at(buf, i);
+    m_assert(m_CDict_unset(&shared, buf) == (M_PTR)(i + 1));
+  }
+  return NULL;
+}
+
+static M_PTR
+reader(M_PTR arg)
+{
+  M_CHAR buf[32];
+  M_PTR val;
+  M_SZ i;
+
+  M_UNUSED(arg);
+  for (i = 0; i < THREADS * NUM; ++i)
+  {
+    key_at(buf, i);
+    val = m_CDict_get(&shared, buf);
+    m_assert(val == NULL || val == (M_PTR)(i + 1));
+  }
+  return NULL;
+}
+
+M_INT32
+m_CDict_test(M_VOID)
+{
+  m_CDict d;
+  pthread_t th[2 * THREADS];
+  M_CHAR buf[32];
+  M_PTR old;
+  M_SZ i, cnt;
+
+  M_MEMPOOL_INIT();
+
+  m_assert(m_CDict_init2(&d, 1, NULL, 0));
+  m_CDict_set(&d, "moo", (M_PTR)0x12345678, NULL);
+  m_assert(m_CDict_get(&d, "moo") == (M_PTR)0x12345678);
+  m_CDict_fini(&d);
+
+  m_assert(m_CDict_init(&d));
+  m_assert(m_CDict_get(&d, "nothing") == NULL);
+  m_assert(m_CDict_unset(&d, "nothing") == NULL);
+
+  m_CDict_set(&d, "test", (M_PTR)0xdeadbeef, &old);
+  m_assert(old == (M_PTR)0xdeadbeef);
+  m_CDict_set(&d, "moo", (M_PTR)0x12345678, &old);
+  m_assert(old == (M_PTR)0x12345678);
+  m_CDict_set(&d, "moo", (M_PTR)0x87654321, &old);
+  m_assert(old == (M_PTR)0x12345678);
+  m_assert(m_CDict_get(&d, "moo") == (M_PTR)0x87654321);
+  m_assert(m_CDict_get(&d, "mo") == NULL);
+  m_assert(m_CDict_unset(&d, "moo") == (M_PTR)0x87654321);
+  m_assert(m_CDict_unset(&d, "test") == (M_PTR)0xdeadbeef);
+  m_assert(m_CDict_count(&d) == 0);
+
+  for (i = 0; i < NUM; ++i)
+  {
+    key_at(buf, i);
+    m_assert(m_CDict_set(&d, buf, (M_PTR)(i + 1), NULL));
+  }
+  m_assert(m_CDict_count(&d) == NUM);
+  m_assert(m_CDict_check(&d));
+  for (i = 0; i < NUM; ++i)
+  {
+    key_at(buf, i);
+    m_assert(m_CDict_get(&d, buf) == (M_PTR)(i + 1));
+  }
+  cnt = 0;
+  m_CDict_traverse_keyval2(&d, &count_fn, &cnt);
+  m_assert(cnt == NUM);
+
+  d.finalize_fn = &finalize_fn;
+  m_CDict_fini(&d);
+  m_assert(finalized == NUM);
+
+  /* concurrent writers and readers */
+  m_assert(m_CDict_init(&shared));
+  for (i = 0; i < THREADS; ++i)
+  {
+    m_assert(!pthread_create(&th[2 * i], NULL, &writer, (M_PTR) i));
+    m_assert(!pthread_create(&th[2 * i + 1], NULL, &reader, NULL));
+  }
+  for (i = 0; i < 2 * THREADS; ++i)
+    pthread_join(th[i], NULL);
+
+  m_assert(m_CDict_count(&shared) == THREADS * NUM / 2);
+  m_assert(m_CDict_check(&shared));
+  for (i = 0; i < THREADS * NUM; ++i)
+  {
+    key_at(buf, i);
+    m_assert(m_CDict_get(&shared, buf) == (i % 2 ? (M_PTR)(i + 1) : NULL));
+  }
+  m_CDict_fini(&shared);
+
+  M_MEMPOOL_STATUS();
+  M_MEMPOOL_FINI();
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_CDict_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,83 @@
+/*
+ *  Random lookups in an m_Dict, one m_Dict_get per key against
+ *  m_Dict_get_many with batches of keys.
+ *
+ *  Usage: m_dict_bench [number of keys]
+ */
+
+#include <m_dict.h>
+#include <m_mempool.h>
+
+#define DEFAULT_NUM 1000000
+#define BATCH 32
+
+static M_DOUBLE
+elapsed(const clock_t start)
+{
+  return (M_DOUBLE)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char* argv[])
+{
+  m_Dict d;
+  M_CHAR* buf;
+  const M_CHAR** keys;
+  const M_CHAR** order;
+  M_PTR vals[BATCH];
+  M_DOUBLE t1, t2;
+  clock_t start;
+  M_UINT64 x = 88172645463325252ULL;
+  M_SZ i, j, n, num, sum1 = 0, sum2 = 0;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (num == 0) num = DEFAULT_NUM;
+  buf = malloc(num * 32);
+  keys = malloc(num * sizeof(M_CHAR*));
+  order = malloc(num * sizeof(M_CHAR*));
+  m_assert(buf && keys && order);
+
+  M_MEMPOOL_INIT();
+  m_assert(m_Dict_init(&d));
+  for (i = 0; i < num; ++i)
+  {
+    sprintf(buf + i * 32, "some/key/%lu", (unsigned long) i);
+    keys[i] = buf + i * 32;
+    m_assert(m_Dict_set(&d, keys[i], (M_PTR)(i + 1), NULL));
+  }
+  for (i = 0; i < num; ++i)
+  {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    order[i] = keys[x % num];
+  }
+
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum1 += (M_SZ) m_Dict_get(&d, order[i]);
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < num; i += n)
+  {
+    n = M_MIN(num - i, (M_SZ) BATCH);
+    m_Dict_get_many(&d, order + i, vals, n);
+    for (j = 0; j < n; ++j)
+      sum2 += (M_SZ) vals[j];
+  }
+  t2 = elapsed(start);
+  m_assert(sum1 == sum2);
+
+  printf("-- keys: "M_SZ_FMT", batches of %d\n", num, BATCH);
+  printf("%-10s %10s %10s %9s\n", "(seconds)", "get", "get_many", "speedup");
+  printf("%-10s %10.3f %10.3f %8.2fx\n", "lookups", t1, t2,
+      t2 > 0 ? t1 / t2 : 0);
+
+  /* no m_Dict_fini, the pool frees it all at once */
+  M_MEMPOOL_FINI();
+  free(order);
+  free(keys);
+  free(buf);
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
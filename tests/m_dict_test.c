@@ -1,10 +1,67 @@
 #include <m_dict.h>
 
+static M_VOID
+keyval_fn(m_String* key,
+        M_PTR val,
+        M_PTR udata)
+{
+  m_assert(!strcmp(key->data, "test"));
+  m_assert(key->len == 5);
+  m_assert(val == (M_PTR)0xdeadbeef);
+  *(M_SZ*)udata += 1;
+}
+
+/* every key collides */
+static M_ID
+same_hash(const M_PTR k,
+        const M_SZ len,
+        const M_ID seed)
+{
+  M_UNUSED(k);
+  M_UNUSED(len);
+  M_UNUSED(seed);
+  return 42;
+}
+
+static M_VOID
+get_many_test(const m_hash_fn_t hash_fn)
+{
+  m_Dict d;
+  M_CHAR buf[40][8];
+  const M_CHAR* keys[41];
+  M_SZ lens[41];
+  M_PTR vals[41];
+  M_SZ i;
+
+  m_assert(m_Dict_init2(&d, hash_fn, 0));
+  for (i = 0; i < 40; ++i)
+  {
+    sprintf(buf[i], "k%lu", (unsigned long) i);
+    keys[i] = buf[i];
+    lens[i] = strlen(buf[i]);
+    if (i % 3) m_assert(m_Dict_set(&d, keys[i], (M_PTR)(i + 1), NULL));
+  }
+  keys[40] = "";
+  lens[40] = 0;
+  m_Dict_get_many(&d, keys, vals, 41);
+  for (i = 0; i < 40; ++i)
+    m_assert(vals[i] == (i % 3 ? (M_PTR)(i + 1) : NULL));
+  m_assert(vals[40] == NULL);
+
+  /* k1 of k10, k2 of k20... */
+  for (i = 10; i < 40; ++i) lens[i] = 2;
+  m_Dict_get_many_len(&d, keys, lens, vals, 40);
+  for (i = 10; i < 40; ++i)
+    m_assert(vals[i] == (i / 10 % 3 ? (M_PTR)(i / 10 + 1) : NULL));
+  m_Dict_fini(&d);
+}
+
 M_INT32
 m_Dict_test(M_VOID)
 {
   m_Dict d;
   M_PTR old;
+  M_SZ cnt = 0;
 
   M_MEMPOOL_INIT();
 
@@ -26,10 +83,27 @@ m_Dict_test(M_VOID)
   m_assert(m_Dict_unset(&d, "moo") == (M_PTR)0x87654321);
   m_assert(m_Dict_get(&d, "moo") == NULL);
 
+  /* keys of known length, not null-terminated */
+  m_assert(m_Dict_set_len(&d, "moo/bar", 3, (M_PTR)0x1, NULL));
+  m_assert(m_Dict_get(&d, "moo") == (M_PTR)0x1);
+  m_assert(m_Dict_get_len(&d, "moo/bar", 3) == (M_PTR)0x1);
+  m_assert(m_Dict_get_len(&d, "moo/bar", 7) == NULL);
+  m_assert(m_Dict_get_len(&d, "mo", 2) == NULL);
+  m_assert(m_Dict_get_len(&d, "test!", 4) == (M_PTR)0xdeadbeef);
+  m_assert(m_Dict_unset_len(&d, "moo/bar", 7) == NULL);
+  m_assert(m_Dict_unset_len(&d, "moo/bar", 3) == (M_PTR)0x1);
+  m_assert(m_Dict_get(&d, "moo") == NULL);
+
+  m_Dict_traverse_keyval2(&d, &keyval_fn, &cnt);
+  m_assert(cnt == 1);
+
   m_Dict_debug(&d);
 
   m_Dict_fini(&d);
 
+  get_many_test(NULL);
+  get_many_test(&same_hash);
+
   M_MEMPOOL_STATUS();
   M_MEMPOOL_FINI();
   return 0;
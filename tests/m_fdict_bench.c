@@ -0,0 +1,100 @@
+/*
+ *  Random lookups in an m_Dict and in the same dict frozen (with sorted
+ *  hashes, then with a perfect hash), with the memory each takes from
+ *  the pool.
+ *
+ *  Usage: m_fdict_bench [number of keys]
+ */
+
+#include <m_fdict.h>
+#include <m_mempool.h>
+
+#define DEFAULT_NUM 1000000
+
+static M_DOUBLE
+elapsed(const clock_t start)
+{
+  return (M_DOUBLE)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char* argv[])
+{
+  m_Dict d;
+  m_FDict fd, fdm;
+  M_CHAR* buf;
+  const M_CHAR** order;
+  M_DOUBLE t1, t2;
+  clock_t start;
+  M_UINT64 x = 88172645463325252ULL;
+  M_SZ i, num, sum1 = 0, sum2 = 0, sum3 = 0, used1, used2, used3;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (num == 0) num = DEFAULT_NUM;
+  buf = malloc(num * 32);
+  order = malloc(num * sizeof(M_CHAR*));
+  m_assert(buf && order);
+
+  M_MEMPOOL_INIT();
+  m_assert(m_Dict_init(&d));
+  for (i = 0; i < num; ++i)
+  {
+    sprintf(buf + i * 32, "some/key/%lu", (unsigned long) i);
+    m_assert(m_Dict_set(&d, buf + i * 32, (M_PTR)(i + 1), NULL));
+  }
+#ifndef M_NO_MEMPOOL
+  used1 = (*m_MemPool_get())->used;
+#else
+  used1 = 0; /* not counted */
+#endif
+  m_assert(m_FDict_freeze(&fd, &d));
+  used2 = fd.size;
+  start = clock();
+  m_assert(m_FDict_freeze_mph(&fdm, &d));
+  t1 = elapsed(start);
+  used3 = fdm.size + fdm.mph.nbuckets * sizeof(M_UINT32);
+  for (i = 0; i < num; ++i)
+  {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    order[i] = buf + (x % num) * 32;
+  }
+
+  printf("-- keys: "M_SZ_FMT", perfect hash built in %.3fs\n", num, t1);
+  printf("%-10s %10s %10s %9s\n", "(seconds)", "Dict", "FDict", "speedup");
+
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum1 += (M_SZ) m_Dict_get(&d, order[i]);
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum2 += (M_SZ) m_FDict_get(&fd, order[i]);
+  t2 = elapsed(start);
+  m_assert(sum1 == sum2);
+  printf("%-10s %10.3f %10.3f %8.2fx\n", "get", t1, t2,
+      t2 > 0 ? t1 / t2 : 0);
+
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum3 += (M_SZ) m_FDict_get(&fdm, order[i]);
+  t2 = elapsed(start);
+  m_assert(sum1 == sum3);
+  printf("%-10s %10.3f %10.3f %8.2fx\n", "get (mph)", t1, t2,
+      t2 > 0 ? t1 / t2 : 0);
+
+  /* bucket nodes of the tree are not counted by the pool */
+  printf("%-10s %10lu %10lu\n", "bytes/key",
+      (unsigned long)((used1 + m_BTree_count(&d.tree) * sizeof(m_BTNode)) / num),
+      (unsigned long)(used2 / num));
+  printf("%-10s %10s %10lu\n", "(mph)", "",
+      (unsigned long)(used3 / num));
+
+  /* no fini, the pool frees it all at once */
+  M_MEMPOOL_FINI();
+  free(order);
+  free(buf);
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
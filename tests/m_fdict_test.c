@@ -0,0 +1,108 @@
+#include <m_fdict.h>
+
+#define NUM 500
+
+/* few hashes, many keys for each */
+static M_ID
+len_hash(const M_PTR k,
+        const M_SZ len,
+        const M_ID seed)
+{
+  M_UNUSED(k);
+  M_UNUSED(seed);
+  return len % 3;
+}
+
+static M_VOID
+sum_keyval(m_String* key,
+        M_PTR val,
+        M_PTR udata)
+{
+  m_assert(strlen(key->data) + 1 == key->len);
+  *(M_SZ*) udata += (M_SZ) val;
+}
+
+static M_VOID
+freeze_test(const m_hash_fn_t hash_fn,
+        const M_BOOL mph)
+{
+  m_Dict d, d2;
+  m_FDict fd;
+  M_CHAR buf[16];
+  M_SZ i, sum = 0, expect = 0;
+
+  m_assert(m_Dict_init2(&d, hash_fn, 7));
+
+  /* empty */
+  m_assert(mph ? m_FDict_freeze_mph(&fd, &d) : m_FDict_freeze(&fd, &d));
+  m_assert(m_FDict_count(&fd) == 0);
+  m_assert(!m_FDict_get(&fd, "k1"));
+  m_assert(m_FDict_unfreeze(&fd, &d2));
+  m_assert(!m_Dict_get(&d2, "k1"));
+  m_Dict_fini(&d2);
+  m_FDict_fini(&fd);
+
+  for (i = 0; i < NUM; ++i)
+  {
+    sprintf(buf, "k%lu", (unsigned long) i);
+    if (!(i % 4)) continue;
+    m_assert(m_Dict_set(&d, buf, (M_PTR)(i + 1), NULL));
+    expect += i + 1;
+  }
+  m_assert(mph ? m_FDict_freeze_mph(&fd, &d) : m_FDict_freeze(&fd, &d));
+  m_assert(mph == (fd.mph.disp != NULL));
+  m_Dict_fini(&d);
+
+  m_assert(m_FDict_count(&fd) == NUM - NUM / 4);
+  for (i = 0; i < NUM; ++i)
+  {
+    sprintf(buf, "k%lu", (unsigned long) i);
+    m_assert(m_FDict_get(&fd, buf) == (i % 4 ? (M_PTR)(i + 1) : NULL));
+    m_assert(m_FDict_get_len(&fd, buf, strlen(buf) - 1)
+        == (i >= 10 && (i / 10) % 4 ? (M_PTR)(i / 10 + 1) : NULL));
+  }
+  m_assert(!m_FDict_get(&fd, "k"));
+  m_assert(!m_FDict_get(&fd, "zzz"));
+
+  m_FDict_traverse_keyval2(&fd, &sum_keyval, &sum);
+  m_assert(sum == expect);
+
+  /* and back */
+  m_assert(m_FDict_unfreeze(&fd, &d2));
+  m_FDict_fini(&fd);
+  for (i = 0; i < NUM; ++i)
+  {
+    sprintf(buf, "k%lu", (unsigned long) i);
+    m_assert(m_Dict_get(&d2, buf) == (i % 4 ? (M_PTR)(i + 1) : NULL));
+  }
+  m_assert(m_Dict_set(&d2, "k0", (M_PTR) 1, NULL));
+  m_assert(m_Dict_unset(&d2, "k1") == (M_PTR) 2);
+  m_assert(m_Dict_get(&d2, "k0") == (M_PTR) 1);
+  m_Dict_fini(&d2);
+}
+
+M_INT32
+m_fdict_test(M_VOID)
+{
+  printf("-- start fdict test\n");
+  M_MEMPOOL_INIT();
+
+  freeze_test(NULL, M_FALSE);
+  freeze_test(&len_hash, M_FALSE);
+  freeze_test(NULL, M_TRUE);
+  freeze_test(&len_hash, M_TRUE);
+
+  M_MEMPOOL_STATUS();
+  M_MEMPOOL_FINI();
+  printf("-- end fdict test\n");
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_fdict_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,60 @@
+#include <m_hash.h>
+
+#define MAXLEN 100
+
+static const m_hash_fn_t funcs[] = {
+  &m_hash_oaat,
+  &m_hash_fnv1a,
+  &m_hash_wy
+};
+
+M_INT32
+m_hash_test(M_VOID)
+{
+  M_UCHAR buf[MAXLEN + 1], moved[MAXLEN + 8];
+  M_SZ i, len, f;
+  M_ID h;
+
+  for (i = 0; i < sizeof(buf); ++i) buf[i] = (M_UCHAR)(i * 7 + 1);
+
+  /* oaat with seed 0 is the former dict hash */
+  m_assert(sizeof(M_ID) < 8
+      || m_hash_oaat("moo", 3, 0) == (M_ID) 0x7a54c0f40198d2ULL);
+
+  for (f = 0; f < sizeof(funcs) / sizeof(funcs[0]); ++f)
+  {
+    for (len = 0; len <= MAXLEN; ++len)
+    {
+      h = (*funcs[f])(buf, len, 0);
+      /* same hash at any alignment */
+      for (i = 1; i < 8; ++i)
+      {
+        memcpy(moved + i, buf, len);
+        m_assert((*funcs[f])(moved + i, len, 0) == h);
+      }
+      /* each byte matters, and so does the seed */
+      if (len)
+      {
+        buf[len - 1] ^= 0x10;
+        m_assert((*funcs[f])(buf, len, 0) != h);
+        buf[len - 1] ^= 0x10;
+        m_assert((*funcs[f])(buf, len, 12345) != h);
+      }
+      /* and the length */
+      m_assert((*funcs[f])(buf, len + 1, 0) != h);
+    }
+  }
+
+  m_assert(m_hash_seed() != 0);
+  m_assert(m_hash_seed() == m_hash_seed());
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_hash_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
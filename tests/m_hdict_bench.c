@@ -0,0 +1,125 @@
+/*
+ *  Compare the tree-based dict (m_Dict) and the hash table (m_HDict).
+ *
+ *  Usage: m_hdict_bench [number of keys]
+ */
+
+#include <m_dict.h>
+#include <m_hdict.h>
+#include <m_mempool.h>
+#include <m_strdup.h>
+
+#define DEFAULT_NUM 200000
+#define ROUNDS 5
+
+static M_CHAR** keys;
+static M_SZ num;
+static M_SZ sum;
+
+static M_DOUBLE
+elapsed(const clock_t start)
+{
+  return (M_DOUBLE)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static M_VOID
+report(const M_CHAR* const what,
+        const M_DOUBLE dict,
+        const M_DOUBLE hdict)
+{
+  printf("%-10s %10.3f %10.3f %8.2fx\n", what, dict, hdict,
+      hdict > 0 ? dict / hdict : 0);
+}
+
+static M_VOID
+count_fn(M_PTR val,
+        M_PTR udata)
+{
+  *(M_SZ*)udata += (M_SZ) val;
+}
+
+int main(int argc, char* argv[])
+{
+  m_Dict d;
+  m_HDict hd;
+  M_CHAR buf[64];
+  M_DOUBLE t1, t2;
+  clock_t start;
+  M_SZ i, r;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (num == 0) num = DEFAULT_NUM;
+  keys = malloc(2 * num * sizeof(M_CHAR*));
+  m_assert(keys);
+  for (i = 0; i < 2 * num; ++i)
+  {
+    /* half the keys are never inserted, to look up misses */
+    sprintf(buf, "some/path/to/key/"M_SZ_FMT"/%s", i, i < num ? "in" : "out");
+    keys[i] = m_strdup(buf);
+    m_assert(keys[i]);
+  }
+
+  M_MEMPOOL_INIT();
+  m_assert(m_Dict_init(&d));
+  m_assert(m_HDict_init(&hd));
+
+  printf("-- keys: "M_SZ_FMT", lookups: "M_SZ_FMT"\n", num, ROUNDS * num);
+  printf("%-10s %10s %10s %9s\n", "(seconds)", "dict", "hdict", "speedup");
+
+  start = clock();
+  for (i = 0; i < num; ++i)
+    m_Dict_set(&d, keys[i], (M_PTR)(i + 1), NULL);
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < num; ++i)
+    m_HDict_set(&hd, keys[i], (M_PTR)(i + 1), NULL);
+  t2 = elapsed(start);
+  report("set", t1, t2);
+  printf("-- hdict: "M_SZ_FMT" slots, %u control bytes per probe\n",
+      hd.capacity, (unsigned) hd.group);
+
+  sum = 0;
+  start = clock();
+  for (r = 0; r < ROUNDS; ++r)
+    for (i = 0; i < num; ++i)
+      sum += (M_SZ) m_Dict_get(&d, keys[(i * 7919) % num]);
+  t1 = elapsed(start);
+  start = clock();
+  for (r = 0; r < ROUNDS; ++r)
+    for (i = 0; i < num; ++i)
+      sum -= (M_SZ) m_HDict_get(&hd, keys[(i * 7919) % num]);
+  t2 = elapsed(start);
+  m_assert(sum == 0);
+  report("get", t1, t2);
+
+  start = clock();
+  for (r = 0; r < ROUNDS; ++r)
+    for (i = 0; i < num; ++i)
+      sum += (M_SZ) m_Dict_get(&d, keys[num + i]);
+  t1 = elapsed(start);
+  start = clock();
+  for (r = 0; r < ROUNDS; ++r)
+    for (i = 0; i < num; ++i)
+      sum += (M_SZ) m_HDict_get(&hd, keys[num + i]);
+  t2 = elapsed(start);
+  m_assert(sum == 0);
+  report("get-miss", t1, t2);
+
+  start = clock();
+  m_Dict_traverse2(&d, &count_fn, &sum);
+  t1 = elapsed(start);
+  start = clock();
+  m_HDict_traverse2(&hd, &count_fn, &sum);
+  t2 = elapsed(start);
+  m_assert(sum == num * (num + 1));
+  report("iterate", t1, t2);
+
+  /* freeing nodes one by one is slow with the mempool,
+     all memory is released with it */
+  M_MEMPOOL_FINI();
+  for (i = 0; i < 2 * num; ++i) free(keys[i]);
+  free(keys);
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
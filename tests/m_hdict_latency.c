@@ -0,0 +1,109 @@
+/*
+ *  Time of each insert into an m_HDict, growing or reserved, and into
+ *  an m_Dict, to see the worst ones and not only the mean.
+ *
+ *  Usage: m_hdict_latency [number of keys]
+ */
+
+#define _POSIX_C_SOURCE 199309L /* for clock_gettime */
+
+#include <time.h>
+
+#include <m_dict.h>
+#include <m_hdict.h>
+#include <m_mempool.h>
+
+#define DEFAULT_NUM 4000000
+
+static M_CHAR* buf;
+static M_DOUBLE* lat;
+
+static M_DOUBLE
+now(M_VOID)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int
+cmp_fn(const void* a,
+        const void* b)
+{
+  const M_DOUBLE x = *(const M_DOUBLE*) a;
+  const M_DOUBLE y = *(const M_DOUBLE*) b;
+  return x < y ? -1 : x > y;
+}
+
+/* microseconds: mean, 99th and 99.9th percentiles, worst */
+static M_VOID
+report(const M_CHAR* const what,
+        const M_SZ num)
+{
+  M_DOUBLE sum = 0;
+  M_SZ i;
+
+  for (i = 0; i < num; ++i)
+    sum += lat[i];
+  qsort(lat, num, sizeof(M_DOUBLE), &cmp_fn);
+  printf("%-14s %10.3f %10.3f %10.3f %12.1f\n", what, sum / num,
+      lat[num * 99 / 100], lat[num * 999 / 1000], lat[num - 1]);
+}
+
+int main(int argc, char* argv[])
+{
+  m_HDict hd;
+  m_Dict d;
+  M_DOUBLE t;
+  M_SZ i, num;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (num == 0) num = DEFAULT_NUM;
+  buf = malloc(num * 32);
+  lat = malloc(num * sizeof(M_DOUBLE));
+  m_assert(buf && lat);
+  for (i = 0; i < num; ++i)
+    sprintf(buf + i * 32, "some/key/%lu", (unsigned long) i);
+
+  M_MEMPOOL_INIT();
+  printf("-- keys: "M_SZ_FMT"\n", num);
+  printf("%-14s %10s %10s %10s %12s\n", "(microseconds)", "mean", "p99",
+      "p99.9", "max");
+
+  m_assert(m_HDict_init(&hd));
+  for (i = 0; i < num; ++i)
+  {
+    t = now();
+    m_HDict_set(&hd, buf + i * 32, (M_PTR)(i + 1), NULL);
+    lat[i] = now() - t;
+  }
+  report("HDict", num);
+
+  m_assert(m_HDict_init(&hd));
+  m_assert(m_HDict_reserve(&hd, num));
+  for (i = 0; i < num; ++i)
+  {
+    t = now();
+    m_HDict_set(&hd, buf + i * 32, (M_PTR)(i + 1), NULL);
+    lat[i] = now() - t;
+  }
+  report("HDict reserved", num);
+
+  m_assert(m_Dict_init(&d));
+  for (i = 0; i < num; ++i)
+  {
+    t = now();
+    m_Dict_set(&d, buf + i * 32, (M_PTR)(i + 1), NULL);
+    lat[i] = now() - t;
+  }
+  report("Dict", num);
+
+  /* no fini, the pool frees it all at once */
+  M_MEMPOOL_FINI();
+  free(lat);
+  free(buf);
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,209 @@
+#include <m_hdict.h>
+#include <m_mempool.h>
+
+#define NUM 5000
+
+static M_VOID
+key_at(M_CHAR* const buf,
+        const M_SZ i)
+{
+  /* keys kept in their slot, and keys with a buffer of their own */
+  sprintf(buf, i % 2 ? "key-"M_SZ_FMT : "a/much/longer/key/"M_SZ_FMT, i);
+}
+
+static M_VOID
+count_fn(m_String* key,
+        M_PTR val,
+        M_PTR udata)
+{
+  M_CHAR buf[32];
+
+  key_at(buf, (M_SZ) val - 1);
+  m_assert(!strcmp(key->data, buf));
+  *(M_SZ*)udata += 1;
+}
+
+static M_SZ finalized = 0;
+
+static M_VOID
+finalize_fn(M_PTR val)
+{
+  M_UNUSED(val);
+  finalized += 1;
+}
+
+/* sets and unsets while the table grows, and fini before it is done */
+static M_VOID
+growing_test(M_VOID)
+{
+  m_HDict d;
+  M_CHAR buf[32];
+  M_SZ i, j, cap, cnt, during = 0;
+
+  m_assert(m_HDict_init(&d));
+  for (i = 0; i < NUM; ++i)
+  {
+    key_at(buf, i);
+    m_assert(m_HDict_set(&d, buf, (M_PTR)(i + 1), NULL));
+    if (!d.oslots) continue;
+    during += 1;
+    /* one out of three goes away while in the old table */
+    if (i % 3 == 0)
+    {
+      key_at(buf, i / 2);
+      m_HDict_unset(&d, buf);
+      m_assert(m_HDict_get(&d, buf) == NULL);
+    }
+    if (i % 61 == 0)
+    {
+      m_assert(m_HDict_check(&d));
+      for (j = 0; j <= i; ++j)
+      {
+        key_at(buf, j);
+        m_assert(m_HDict_get(&d, buf) == NULL
+            || m_HDict_get(&d, buf) == (M_PTR)(j + 1));
+      }
+      cnt = 0;
+      m_HDict_traverse_keyval2(&d, &count_fn, &cnt);
+      m_assert(cnt == m_HDict_count(&d));
+    }
+  }
+  m_assert(during);
+  m_assert(m_HDict_check(&d));
+
+  /* grow once more, and stop half way */
+  cap = d.capacity;
+  for (i = NUM; d.capacity == cap || d.moved < d.ocapacity / 2; ++i)
+  {
+    key_at(buf, i);
+    m_assert(m_HDict_set(&d, buf, (M_PTR)(i + 1), NULL));
+  }
+  m_assert(d.oslots);
+  m_assert(m_HDict_check(&d));
+  finalized = 0;
+  cnt = m_HDict_count(&d);
+  d.finalize_fn = &finalize_fn;
+  m_HDict_fini(&d);
+  m_assert(finalized == cnt);
+
+  /* no growing after reserve */
+  m_assert(m_HDict_reserve(&d, NUM));
+  cap = d.capacity;
+  for (i = 0; i < NUM; ++i)
+  {
+    key_at(buf, i);
+    m_assert(m_HDict_set(&d, buf, (M_PTR)(i + 1), NULL));
+  }
+  m_assert(d.capacity == cap && !d.oslots);
+  m_assert(m_HDict_reserve(&d, NUM / 2));
+  m_assert(d.capacity == cap);
+  m_assert(m_HDict_reserve(&d, 4 * NUM));
+  m_assert(d.capacity > cap && !d.oslots);
+  m_assert(m_HDict_check(&d));
+  m_HDict_fini(&d);
+}
+
+M_INT32
+m_HDict_test(M_VOID)
+{
+  m_HDict d;
+  M_CHAR buf[32];
+  M_PTR old;
+  M_SZ i, cnt;
+
+  M_MEMPOOL_INIT();
+
+  m_assert(m_HDict_init(&d));
+  m_assert(m_HDict_get(&d, "nothing") == NULL);
+  m_assert(m_HDict_unset(&d, "nothing") == NULL);
+
+  m_HDict_set(&d, "test", (M_PTR)0xdeadbeef, &old);
+  m_assert(old == (M_PTR)0xdeadbeef);
+  m_HDict_set(&d, "moo", (M_PTR)0x12345678, &old);
+  m_assert(old == (M_PTR)0x12345678);
+  m_assert(m_HDict_get(&d, "test") == (M_PTR)0xdeadbeef);
+  m_HDict_set(&d, "moo", (M_PTR)0x87654321, &old);
+  m_assert(old == (M_PTR)0x12345678);
+  m_assert(m_HDict_get(&d, "moo") == (M_PTR)0x87654321);
+  m_assert(m_HDict_get(&d, "mo") == NULL);
+  m_assert(m_HDict_get(&d, "mooo") == NULL);
+  m_assert(m_HDict_unset(&d, "moo") == (M_PTR)0x87654321);
+  m_assert(m_HDict_get(&d, "moo") == NULL);
+  m_assert(m_HDict_unset(&d, "test") == (M_PTR)0xdeadbeef);
+  m_assert(m_HDict_count(&d) == 0);
+  m_assert(m_HDict_check(&d));
+
+  /* fill */
+  for (i = 0; i < NUM; ++i)
+  {
+    key_at(buf, i);
+    m_assert(m_HDict_set(&d, buf, (M_PTR)(i + 1), NULL));
+  }
+  m_assert(m_HDict_count(&d) == NUM);
+  m_assert(m_HDict_check(&d));
+  for (i = 0; i < NUM; ++i)
+  {
+    key_at(buf, i);
+    m_assert(m_HDict_get(&d, buf) == (M_PTR)(i + 1));
+  }
+  key_at(buf, NUM);
+  m_assert(m_HDict_get(&d, buf) == NULL);
+
+  /* remove half, then put them back over deleted slots */
+  for (i = 0; i < NUM; i += 2)
+  {
+    key_at(buf, i);
+    m_assert(m_HDict_unset(&d, buf) == (M_PTR)(i + 1));
+    m_assert(m_HDict_get(&d, buf) == NULL);
+  }
+  m_assert(m_HDict_count(&d) == NUM / 2);
+  m_assert(m_HDict_check(&d));
+  for (i = 1; i < NUM; i += 2)
+  {
+    key_at(buf, i);
+    m_assert(m_HDict_get(&d, buf) == (M_PTR)(i + 1));
+  }
+  for (i = 0; i < NUM; i += 2)
+  {
+    key_at(buf, i);
+    m_assert(m_HDict_set(&d, buf, (M_PTR)(i + 1), &old));
+    m_assert(old == (M_PTR)(i + 1));
+  }
+  m_assert(m_HDict_count(&d) == NUM);
+  m_assert(m_HDict_check(&d));
+
+  /* churn, deleted slots must get recycled */
+  for (i = 0; i < 20 * NUM; ++i)
+  {
+    key_at(buf, NUM + i);
+    m_assert(m_HDict_set(&d, buf, (M_PTR)(NUM + i + 1), NULL));
+    m_assert(m_HDict_unset(&d, buf) == (M_PTR)(NUM + i + 1));
+  }
+  m_assert(m_HDict_count(&d) == NUM);
+  m_assert(d.capacity <= 4 * NUM);
+  m_assert(m_HDict_check(&d));
+
+  cnt = 0;
+  m_HDict_traverse_keyval2(&d, &count_fn, &cnt);
+  m_assert(cnt == NUM);
+
+  d.finalize_fn = &finalize_fn;
+  m_HDict_fini(&d);
+  m_assert(finalized == NUM);
+  m_assert(m_HDict_count(&d) == 0);
+
+  growing_test();
+
+  M_MEMPOOL_STATUS();
+  M_MEMPOOL_FINI();
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_HDict_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,97 @@
+/*
+ *  Random inserts, lookups and removes, in an m_BTree and in an m_IdMap
+ *  holding the same keys.
+ *
+ *  Usage: m_idmap_bench [number of keys]
+ */
+
+#include <m_btree.h>
+#include <m_idmap.h>
+#include <m_mempool.h>
+
+#define DEFAULT_NUM 2000000
+
+static M_DOUBLE
+elapsed(const clock_t start)
+{
+  return (M_DOUBLE)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char* argv[])
+{
+  m_BTree bt;
+  m_IdMap im;
+  M_ID* keys;
+  M_DOUBLE t1, t2;
+  clock_t start;
+  M_SZ i, num, sum1 = 0, sum2 = 0, bytes;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (num == 0) num = DEFAULT_NUM;
+  keys = malloc(num * sizeof(M_ID));
+  m_assert(keys);
+  /* a permutation of 1..num */
+  for (i = 0; i < num; ++i)
+    keys[i] = i + 1;
+  for (i = num - 1; i > 0; --i)
+  {
+    M_SZ j = (M_SZ)(((M_UINT64) rand() * RAND_MAX + rand()) % (i + 1));
+    M_ID k = keys[i];
+    keys[i] = keys[j];
+    keys[j] = k;
+  }
+
+  M_MEMPOOL_INIT();
+  m_assert(m_BTree_init(&bt));
+  m_assert(m_IdMap_init(&im));
+
+  printf("-- keys: "M_SZ_FMT"\n", num);
+  printf("%-10s %10s %10s %9s\n", "(seconds)", "BTree", "IdMap", "speedup");
+
+  start = clock();
+  for (i = 0; i < num; ++i)
+    m_BTree_insert(&bt, keys[i], (M_PTR) keys[i]);
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < num; ++i)
+    m_IdMap_insert(&im, keys[i], (M_PTR) keys[i]);
+  t2 = elapsed(start);
+  bytes = im.capacity * sizeof(m_IdMapSlot) / m_IdMap_count(&im);
+  printf("%-10s %10.3f %10.3f %8.2fx\n", "insert", t1, t2,
+      t2 > 0 ? t1 / t2 : 0);
+
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum1 += (M_SZ) m_BTree_get(&bt, keys[num - 1 - i]);
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum2 += (M_SZ) m_IdMap_get(&im, keys[num - 1 - i]);
+  t2 = elapsed(start);
+  m_assert(sum1 == sum2);
+  printf("%-10s %10.3f %10.3f %8.2fx\n", "get", t1, t2,
+      t2 > 0 ? t1 / t2 : 0);
+
+  start = clock();
+  for (i = 0; i < num; i += 2)
+    m_BTree_remove(&bt, keys[i], NULL);
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < num; i += 2)
+    m_IdMap_remove(&im, keys[i], NULL);
+  t2 = elapsed(start);
+  m_assert(m_BTree_count(&bt) == m_IdMap_count(&im));
+  printf("%-10s %10.3f %10.3f %8.2fx\n", "remove", t1, t2,
+      t2 > 0 ? t1 / t2 : 0);
+
+  printf("%-10s %10lu %10lu\n", "bytes/key",
+      (unsigned long) sizeof(m_BTNode), (unsigned long) bytes);
+
+  m_BTree_fini(&bt);
+  m_IdMap_fini(&im);
+  M_MEMPOOL_FINI();
+  free(keys);
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
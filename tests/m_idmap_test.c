@@ -0,0 +1,167 @@
+#include <m_idmap.h>
+#include <m_memcnt.h>
+
+#define NUM 2000
+
+static M_SZ finalized = 0;
+
+static M_VOID
+finalize_fn(M_PTR val)
+{
+  M_UNUSED(val);
+  finalized += 1;
+}
+
+static M_VOID
+sum_fn(M_PTR val,
+        M_PTR udata)
+{
+  *(M_SZ*) udata += (M_SZ) val;
+}
+
+/* keys (multiples of 64, key 0 included) as in the mirror */
+static M_VOID
+check_map(const m_IdMap* const m,
+        const M_BOOL* const present)
+{
+  m_IdMapIter it;
+  M_BOOL seen[NUM];
+  M_SZ i, num = 0;
+
+  m_assert(m_IdMap_check(m));
+  for (i = 0; i < NUM; ++i)
+  {
+    if (!present[i])
+    {
+      m_assert(!m_IdMap_get(m, i * 64));
+      continue;
+    }
+    m_assert(m_IdMap_get(m, i * 64) == (M_PTR)(i + 1));
+    num += 1;
+  }
+  m_assert(m_IdMap_count(m) == num);
+
+  memset(seen, 0, sizeof(seen));
+  if (m_IdMapIter_begin(&it, m))
+  {
+    do
+    {
+      i = m_IdMapIter_key(&it) / 64;
+      m_assert(i < NUM && present[i] && !seen[i]);
+      m_assert(m_IdMapIter_val(&it) == (M_PTR)(i + 1));
+      seen[i] = M_TRUE;
+      num -= 1;
+    }
+    while (m_IdMapIter_next(&it));
+  }
+  m_assert(num == 0);
+}
+
+M_INT32
+m_idmap_test(M_VOID)
+{
+  m_IdMap m;
+  m_IdMap* pm;
+  m_IdMapIter it;
+  M_BOOL present[NUM];
+  M_PTR prev;
+  M_UINT32 x = 2463534242U;
+  M_SZ i, j, sum = 0;
+
+  printf("-- start idmap test\n");
+
+  m_assert(m_IdMap_new(&pm));
+  m_assert(m_IdMap_count(pm) == 0);
+  m_assert(!m_IdMap_get(pm, 1));
+  m_assert(!m_IdMap_remove(pm, 1, NULL));
+  m_assert(!m_IdMapIter_begin(&it, pm));
+  m_IdMap_delete(&pm);
+  m_assert(!pm);
+
+  m_assert(m_IdMap_init(&m));
+  memset(present, 0, sizeof(present));
+
+  for (i = 0; i < NUM; i += 2)
+  {
+    m_assert(m_IdMap_insert(&m, i * 64, (M_PTR)(i + 1)) == 1);
+    present[i] = M_TRUE;
+  }
+  m_assert(m_IdMap_insert(&m, 0, NULL) == 0);
+  m_assert(m_IdMap_insert(&m, 64 * 2, NULL) == 0);
+  check_map(&m, present);
+
+  m_assert(m_IdMap_set(&m, 64 * 2, (M_PTR) 70, &prev));
+  m_assert(prev == (M_PTR) 3);
+  m_assert(m_IdMap_set(&m, 0, (M_PTR) 1, &prev));
+  m_assert(prev == (M_PTR) 1);
+  m_assert(m_IdMap_set(&m, 64 * 2, (M_PTR) 3, NULL));
+  m_assert(!m_IdMap_set(&m, 64, NULL, NULL));
+
+  m_IdMap_traverse2(&m, &sum_fn, &sum);
+  m_assert(sum == (NUM / 2) * (NUM / 2));
+
+  /* random removes and inserts */
+  for (j = 0; j < 20 * NUM; ++j)
+  {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    i = x % NUM;
+    if (present[i])
+    {
+      m_assert(m_IdMap_remove(&m, i * 64, NULL));
+      present[i] = M_FALSE;
+    }
+    else
+    {
+      m_assert(!m_IdMap_remove(&m, i * 64, NULL));
+      m_assert(m_IdMap_insert(&m, i * 64, (M_PTR)(i + 1)) == 1);
+      present[i] = M_TRUE;
+    }
+    if (j % 997 == 0) check_map(&m, present);
+  }
+  check_map(&m, present);
+
+  /* down to empty */
+  for (i = 0; i < NUM; ++i)
+  {
+    m_assert(m_IdMap_remove(&m, i * 64, NULL) == present[i]);
+    present[i] = M_FALSE;
+  }
+  check_map(&m, present);
+  for (i = 0; i < m.capacity; ++i)
+    m_assert(!m.slots[i].key);
+
+  for (i = 0; i < NUM; ++i)
+  {
+    m_assert(m_IdMap_insert(&m, i * 64, (M_PTR)(i + 1)) == 1);
+    present[i] = M_TRUE;
+  }
+  check_map(&m, present);
+
+  m.finalize_fn = &finalize_fn;
+  m_IdMap_fini(&m);
+  m_assert(finalized == NUM);
+
+  /* reserved room is used without moving */
+  m_assert(m_IdMap_reserve(&m, NUM));
+  pm = (m_IdMap*) m.slots;
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_IdMap_insert(&m, i + 1, (M_PTR)(i + 1)) == 1);
+  m_assert((m_IdMap*) m.slots == pm);
+  m_IdMap_fini(&m);
+
+  M_MEMCNT_DEBUG();
+
+  printf("-- end idmap test\n");
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_idmap_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
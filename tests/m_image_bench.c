@@ -0,0 +1,90 @@
+/*
+ *  Cold start of a dict of strings: building the m_Dict from its keys
+ *  and values, against opening its image. Then lookups in both.
+ *
+ *  Usage: m_image_bench [number of keys]
+ */
+
+#include <m_image.h>
+#include <m_mempool.h>
+
+#define DEFAULT_NUM 1000000
+#define PATH "m_image_bench.img"
+
+static M_DOUBLE
+elapsed(const clock_t start)
+{
+  return (M_DOUBLE)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static M_SZ
+str_fn(const M_PTR val,
+        M_PTR* data)
+{
+  *data = (M_PTR) val;
+  return strlen(val);
+}
+
+int main(int argc, char* argv[])
+{
+  m_Dict d;
+  m_Image img;
+  M_CHAR* buf;
+  M_CHAR** keys;
+  M_DOUBLE t1, t2;
+  clock_t start;
+  M_SZ i, num, sum1 = 0, sum2 = 0;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (num == 0) num = DEFAULT_NUM;
+  buf = malloc(num * 32);
+  keys = malloc(num * sizeof(M_CHAR*));
+  m_assert(buf && keys);
+  for (i = 0; i < num; ++i)
+  {
+    keys[i] = buf + i * 32;
+    sprintf(keys[i], "some/key/%lu", (unsigned long)(i * 2654435761UL));
+  }
+
+  M_MEMPOOL_INIT();
+  printf("-- keys: "M_SZ_FMT"\n", num);
+  printf("%-10s %10s %10s\n", "(seconds)", "Dict", "Image");
+
+  start = clock();
+  m_assert(m_Dict_init(&d));
+  for (i = 0; i < num; ++i)
+    m_assert(m_Dict_set(&d, keys[i], keys[i], NULL));
+  t1 = elapsed(start);
+  m_assert(m_Image_write_dict(&d, PATH, &str_fn));
+  start = clock();
+  m_assert(m_Image_open(&img, PATH));
+  t2 = elapsed(start);
+  printf("%-10s %10.3f %10.6f\n", "load", t1, t2);
+
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum1 += strlen(m_Dict_get(&d, keys[num - 1 - i]));
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum2 += strlen(m_Image_dict_get(&img, keys[num - 1 - i], NULL));
+  t2 = elapsed(start);
+  m_assert(sum1 == sum2);
+  printf("%-10s %10.3f %10.3f\n", "get", t1, t2);
+
+  start = clock();
+  m_assert(m_Image_verify(&img));
+  printf("%-10s %10s %10.3f\n", "verify", "", elapsed(start));
+  printf("%-10s %10s %10lu\n", "bytes", "",
+      (unsigned long) m_Image_header(&img)->size);
+
+  m_Image_close(&img);
+  /* no m_Dict_fini, the pool frees it all at once */
+  M_MEMPOOL_FINI();
+  remove(PATH);
+  free(keys);
+  free(buf);
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,133 @@
+#include <m_image.h>
+#include <m_memcnt.h>
+#include <m_mempool.h>
+
+#define NUM 1000
+#define PATH "m_image_test.img"
+
+/* values of the dict are strings */
+static M_SZ
+str_fn(const M_PTR val,
+        M_PTR* data)
+{
+  *data = (M_PTR) val;
+  return strlen(val);
+}
+
+static M_VOID
+btree_test(M_VOID)
+{
+  m_BTree bt;
+  m_Image img;
+  M_PTR v;
+  M_SZ i, len;
+
+  m_assert(m_BTree_init(&bt));
+
+  /* empty */
+  m_assert(m_Image_write_btree(&bt, PATH, NULL));
+  m_assert(m_Image_open(&img, PATH));
+  m_assert(m_Image_verify(&img));
+  m_assert(m_Image_count(&img) == 0);
+  m_assert(!m_Image_btree_get(&img, 0, NULL));
+  m_Image_close(&img);
+
+  for (i = 0; i < NUM; ++i)
+    m_assert(m_BTree_insert(&bt, 3 * ((i * 7919) % NUM) + 1,
+        (M_PTR)(i + 1)) == 1);
+  m_assert(m_Image_write_btree(&bt, PATH, NULL));
+  m_assert(m_Image_open(&img, PATH));
+  m_assert(m_Image_header(&img)->kind == M_IMAGE_BTREE);
+  m_assert(m_Image_verify(&img));
+  m_assert(m_Image_count(&img) == NUM);
+  for (i = 0; i <= 3 * NUM; ++i)
+  {
+    v = m_Image_btree_get(&img, i, &len);
+    if (i % 3 != 1)
+    {
+      m_assert(!v);
+      continue;
+    }
+    m_assert(v && len == sizeof(M_PTR));
+    m_assert(*(M_PTR*) v == m_BTree_get(&bt, i));
+  }
+  m_Image_close(&img);
+  m_BTree_fini(&bt);
+}
+
+static M_VOID
+dict_test(M_VOID)
+{
+  m_Dict d;
+  m_Image img;
+  M_CHAR keys[NUM][16];
+  M_CHAR vals[NUM][16];
+  M_UINT64* copy;
+  M_CHAR* v;
+  M_SZ i, len, size;
+
+  m_assert(m_Dict_init(&d));
+  for (i = 0; i < NUM; ++i)
+  {
+    sprintf(keys[i], "key%lu", (unsigned long) i);
+    sprintf(vals[i], "val%lu", (unsigned long) i * i);
+    m_assert(m_Dict_set(&d, keys[i], vals[i], NULL));
+  }
+  m_assert(m_Image_write_dict(&d, PATH, &str_fn));
+  m_Dict_fini(&d);
+
+  m_assert(m_Image_open(&img, PATH));
+  m_assert(m_Image_header(&img)->kind == M_IMAGE_DICT);
+  m_assert(m_Image_verify(&img));
+  m_assert(m_Image_count(&img) == NUM);
+  for (i = 0; i < NUM; ++i)
+  {
+    v = m_Image_dict_get(&img, keys[i], &len);
+    m_assert(v && len == strlen(vals[i]) && !strcmp(v, vals[i]));
+  }
+  m_assert(!m_Image_dict_get(&img, "key", NULL));
+  m_assert(!m_Image_dict_get(&img, "key1000", NULL));
+  m_assert(!strcmp(m_Image_dict_get_len(&img, "key10x", 5, NULL), "val100"));
+
+  /* a copy in memory, then damaged */
+  size = img.size;
+  copy = malloc(size);
+  m_assert(copy);
+  memcpy(copy, img.base, size);
+  m_Image_close(&img);
+  m_assert(m_Image_open_mem(&img, copy, size));
+  m_assert(m_Image_verify(&img));
+  ((M_UINT8*) copy)[size - 20] ^= 1;
+  m_assert(!m_Image_verify(&img));
+  m_assert(!m_Image_open_mem(&img, copy, size - 8));
+  ((m_ImageHeader*) copy)->version += 1;
+  m_assert(!m_Image_open_mem(&img, copy, size));
+  free(copy);
+
+  m_assert(!m_Image_open(&img, PATH".none"));
+}
+
+M_INT32
+m_image_test(M_VOID)
+{
+  printf("-- start image test\n");
+
+  M_MEMPOOL_INIT();
+  btree_test();
+  dict_test();
+  M_MEMPOOL_FINI();
+  remove(PATH);
+  M_MEMCNT_DEBUG();
+
+  printf("-- end image test\n");
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_image_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,99 @@
+/*
+ *  Many chunks of the same size, taken from the pool and then freed
+ *  in the order they were taken, against malloc and free. Then chunks
+ *  of many different sizes replaced at random, to see how much memory
+ *  the pool holds.
+ *
+ *  Usage: m_mempool_bench [number of chunks]
+ */
+
+#include <m_mempool.h>
+
+#define DEFAULT_NUM 1000000
+#define CHUNK_SZ 32
+#define MAX_SZ 4096
+
+static volatile M_SZ sink;
+
+static M_DOUBLE
+elapsed(const clock_t start)
+{
+  return (M_DOUBLE)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char* argv[])
+{
+  M_PTR* ptrs;
+  M_DOUBLE t1, t2;
+  clock_t start;
+  M_SZ* sizes;
+  M_SZ i, j, num, round, sum = 0;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (num < 100) num = DEFAULT_NUM;
+  ptrs = malloc(num * sizeof(M_PTR));
+  m_assert(ptrs);
+  sizes = malloc(num * sizeof(M_SZ));
+  m_assert(sizes);
+
+  M_MEMPOOL_INIT();
+
+  printf("-- chunks: "M_SZ_FMT" x %d bytes\n", num, CHUNK_SZ);
+  printf("%-10s %10s %10s %9s\n", "(seconds)", "malloc", "MemPool",
+      "speedup");
+
+  /* the second round takes every chunk from the trash */
+  for (round = 1; round <= 2; ++round)
+  {
+    start = clock();
+    for (i = 0; i < num; ++i)
+      ptrs[i] = malloc(CHUNK_SZ);
+    for (i = 0; i < num; ++i)
+      free(ptrs[i]);
+    t1 = elapsed(start);
+    start = clock();
+    for (i = 0; i < num; ++i)
+      ptrs[i] = M_MALLOC(CHUNK_SZ);
+    for (i = 0; i < num; ++i)
+      M_FREE(ptrs[i], CHUNK_SZ);
+    t2 = elapsed(start);
+    printf("%-10s %10.3f %10.3f %8.2fx\n", round == 1 ? "cold" : "warm",
+        t1, t2, t2 > 0 ? t1 / t2 : 0);
+  }
+
+  /* a working set of num / 100 chunks of 1 to MAX_SZ bytes, new pool */
+  M_MEMPOOL_FINI();
+  M_MEMPOOL_INIT();
+  for (i = 0; i < num / 100; ++i)
+  {
+    sizes[i] = 1 + rand() % MAX_SZ;
+    ptrs[i] = M_MALLOC(sizes[i]);
+    *(M_UCHAR*) ptrs[i] = (M_UCHAR) i;
+  }
+  start = clock();
+  for (i = 0; i < num; ++i)
+  {
+    /* used before and after */
+    j = rand() % (num / 100);
+    sum += *(M_UCHAR*) ptrs[j];
+    M_FREE(ptrs[j], sizes[j]);
+    sizes[j] = 1 + rand() % MAX_SZ;
+    ptrs[j] = M_MALLOC(sizes[j]);
+    *(M_UCHAR*) ptrs[j] = (M_UCHAR) i;
+  }
+  t2 = elapsed(start);
+  printf("-- churn: "M_SZ_FMT" chunks of 1..%d bytes, "M_SZ_FMT
+      " replaced\n", num / 100, MAX_SZ, num);
+  sink = sum;
+  printf("%-10s %10.3f\n", "MemPool", t2);
+#ifndef M_NO_MEMPOOL
+  printf("%-10s %10lu\n", "held", (unsigned long)(*m_MemPool_get())->used);
+#endif
+
+  M_MEMPOOL_FINI();
+  free(sizes);
+  free(ptrs);
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
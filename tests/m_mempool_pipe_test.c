@@ -0,0 +1,164 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <m_mempool.h>
+
+#include <pthread.h>
+
+#ifndef M_NO_MEMPOOL
+
+#define NUM 100000
+#define THREADS 2
+#define RING 256
+#define LARGE 16384
+
+/*
+ *  Producers fill buffers taken from their own pool and pass them on,
+ *  consumers without a pool check and free them. A first run mixes
+ *  sizes, a second one only sends buffers above the largest class.
+ */
+
+typedef struct
+{
+  M_UCHAR* p;
+  M_SZ sz;
+} message;
+
+static message ring[RING];
+static M_SZ head = 0;
+static M_SZ tail = 0;
+static M_SZ producing = THREADS;
+static pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t notfull = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t notempty = PTHREAD_COND_INITIALIZER;
+
+static m_MemPool* pools[THREADS];
+static M_BOOL large = M_FALSE;
+
+static M_PTR
+producer(M_PTR arg)
+{
+  const M_SZ t = (M_SZ) arg;
+  M_UINT32 x = (M_UINT32) t + 1;
+  message msg;
+  M_SZ i;
+
+  m_MemPool_set(pools[t]);
+  for (i = 0; i < (large ? NUM / 10 : NUM); ++i)
+  {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    /* now and then one above the largest class */
+    if (large)
+      msg.sz = M_MEMPOOL_MAXCLASS + 1 + x % LARGE;
+    else
+      msg.sz = x % 100 ? 1 + x % 4096 : M_MEMPOOL_MAXCLASS + 1 + x % 4096;
+    msg.p = M_MALLOC(msg.sz);
+    m_assert(msg.p);
+    memset(msg.p, (int)(msg.sz & 0xFF), msg.sz);
+
+    pthread_mutex_lock(&mtx);
+    while (head - tail == RING)
+      pthread_cond_wait(&notfull, &mtx);
+    ring[head++ % RING] = msg;
+    pthread_cond_signal(&notempty);
+    pthread_mutex_unlock(&mtx);
+  }
+
+  pthread_mutex_lock(&mtx);
+  producing -= 1;
+  pthread_cond_broadcast(&notempty);
+  pthread_mutex_unlock(&mtx);
+  m_MemPool_set(NULL);
+  return NULL;
+}
+
+static M_PTR
+consumer(M_PTR arg)
+{
+  message msg;
+
+  M_UNUSED(arg);
+  for (;;)
+  {
+    pthread_mutex_lock(&mtx);
+    while (head == tail && producing)
+      pthread_cond_wait(&notempty, &mtx);
+    if (head == tail)
+    {
+      pthread_mutex_unlock(&mtx);
+      return NULL;
+    }
+    msg = ring[tail++ % RING];
+    pthread_cond_signal(&notfull);
+    pthread_mutex_unlock(&mtx);
+
+    m_assert(msg.p[0] == (M_UCHAR)(msg.sz & 0xFF));
+    m_assert(msg.p[msg.sz - 1] == (M_UCHAR)(msg.sz & 0xFF));
+    M_FREE(msg.p, msg.sz);
+  }
+}
+
+static M_VOID
+run(M_VOID)
+{
+  pthread_t th[2 * THREADS];
+  M_SZ i, j;
+
+  producing = THREADS;
+  for (i = 0; i < THREADS; ++i)
+    m_assert(m_MemPool_new(&pools[i], 0));
+  for (i = 0; i < THREADS; ++i)
+  {
+    m_assert(!pthread_create(&th[2 * i], NULL, &producer, (M_PTR) i));
+    m_assert(!pthread_create(&th[2 * i + 1], NULL, &consumer, NULL));
+  }
+  for (i = 0; i < 2 * THREADS; ++i)
+    m_assert(!pthread_join(th[i], NULL));
+
+  for (i = 0; i < THREADS; ++i)
+  {
+    m_MemPool* const mp = pools[i];
+
+    /* memory freed by consumers came back, and was used again */
+    m_MemPool_stats(mp);
+    if (large)
+    {
+      /* no more than the ring, and a buffer in each thread */
+      m_assert(mp->record
+          <= (RING + 3 * THREADS) * (M_MEMPOOL_MAXCLASS + LARGE));
+    }
+    else
+      m_assert(mp->record < 64 * M_MEMPOOL_SLAB);
+    m_MemPool_set(mp);
+    m_MemPool_purge(mp, 0);
+    for (j = 0; j < M_MEMPOOL_CLASSES; ++j)
+      m_assert(mp->classes[j].inuse == 0 && mp->classes[j].slabs == 0);
+    m_assert(mp->large.inuse == 0 && !mp->large.alive);
+    m_assert(mp->used == 0);
+    m_MemPool_set(NULL);
+    m_MemPool_delete(&pools[i]);
+  }
+}
+
+#endif /* !M_NO_MEMPOOL */
+
+M_INT32
+m_mempool_pipe_test(M_VOID)
+{
+#ifndef M_NO_MEMPOOL
+  run();
+  large = M_TRUE;
+  run();
+#endif /* !M_NO_MEMPOOL */
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_mempool_pipe_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
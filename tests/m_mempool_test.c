@@ -0,0 +1,150 @@
+#include <m_mempool.h>
+
+#define NUM 1000
+
+M_INT32
+m_mempool_test(M_VOID)
+{
+#ifndef M_NO_MEMPOOL
+  M_PTR ptrs[NUM];
+  M_SZ i, sz;
+  M_PTR p;
+  M_PTR q;
+  m_MemPool* mp;
+  m_MemBucket* bkt;
+
+  M_MEMPOOL_INIT();
+  mp = *m_MemPool_get();
+
+  /* size classes */
+  m_assert(m_MemPool_class_size(1) == 8);
+  m_assert(m_MemPool_class_size(8) == 8);
+  m_assert(m_MemPool_class_size(9) == 16);
+  m_assert(m_MemPool_class_size(17) == 32);
+  m_assert(m_MemPool_class_size(128) == 128);
+  m_assert(m_MemPool_class_size(129) == 160);
+  m_assert(m_MemPool_class_size(1000) == 1024);
+  m_assert(m_MemPool_class_size(1025) == 1280);
+  m_assert(m_MemPool_class_size(M_MEMPOOL_MAXCLASS) == M_MEMPOOL_MAXCLASS);
+  m_assert(m_MemPool_class_size(M_MEMPOOL_MAXCLASS + 1)
+      == M_MEMPOOL_MAXCLASS + 1);
+  for (sz = 2; sz <= M_MEMPOOL_MAXCLASS; ++sz)
+  {
+    m_assert(m_MemPool_class_size(sz) >= sz);
+    m_assert(m_MemPool_class_size(sz) >= m_MemPool_class_size(sz - 1));
+  }
+
+  /* a few sizes, filled with a pattern */
+  for (i = 0; i < NUM; ++i)
+  {
+    sz = 1 + i % 37;
+    ptrs[i] = M_MALLOC(sz);
+    m_assert(ptrs[i]);
+    memset(ptrs[i], (int) i, sz);
+  }
+  m_assert(mp->used == mp->record);
+
+  /* free every other chunk, out of allocation order */
+  for (i = 0; i < NUM; i += 2)
+  {
+    sz = 1 + i % 37;
+    M_FREE(ptrs[i], sz);
+  }
+  for (i = 1; i < NUM; i += 2)
+  {
+    sz = 1 + i % 37;
+    m_assert(((M_UCHAR*)ptrs[i])[0] == (M_UCHAR) i);
+    m_assert(((M_UCHAR*)ptrs[i])[sz - 1] == (M_UCHAR) i);
+  }
+
+  /* sizes of a class share their chunks */
+  p = M_MALLOC(23);
+  M_FREE(p, 23);
+  q = M_MALLOC(17);
+  m_assert(p == q);
+  p = M_REALLOC(q, 32, 17);
+  m_assert(p == q);
+  M_FREE(p, 32);
+
+  /* chunks above the largest class go back at once */
+  sz = mp->used;
+  p = M_MALLOC(M_MEMPOOL_MAXCLASS + 100);
+  m_assert(p);
+  memset(p, 0, M_MEMPOOL_MAXCLASS + 100);
+  m_assert(mp->used == sz + M_MEMPOOL_MAXCLASS + 100);
+  M_FREE(p, M_MEMPOOL_MAXCLASS + 100);
+  m_assert(mp->used == sz);
+
+  /* a freed chunk is reused by the next malloc of its size */
+  p = M_MALLOC(7);
+  M_FREE(p, 7);
+  q = M_MALLOC(7);
+  m_assert(p == q);
+  M_FREE(q, 7);
+  sz = mp->used;
+  p = M_MALLOC(1);
+  m_assert(mp->used == sz);
+  for (i = 1, sz = 1; i < NUM; i += 2)
+    if (i % 37 < 8) sz += 1;
+  m_assert(mp->classes[0].inuse == sz);
+
+  /* realloc keeps the data */
+  p = M_REALLOC(p, 100, 1);
+  m_assert(p);
+  memset(p, 'x', 100);
+  p = M_REALLOC(p, 10, 100);
+  m_assert(((M_UCHAR*)p)[9] == 'x');
+  M_FREE(p, 10);
+
+  /* purging gives back the empty slabs */
+  for (i = 1; i < NUM; i += 2)
+  {
+    sz = 1 + i % 37;
+    M_FREE(ptrs[i], sz);
+  }
+  sz = mp->used;
+  m_assert(sz > 0);
+  m_MemPool_stats(mp);
+  m_MemPool_purge(mp, 10);
+  m_assert(mp->used < sz && (sz - mp->used) % 16 == 0);
+  m_MemPool_purge(mp, 0);
+  m_assert(mp->used == 0);
+
+  /* slabs empty, but for one */
+  for (i = 0; i < NUM; ++i)
+  {
+    ptrs[i] = M_MALLOC(200);
+    m_assert(((uintptr_t) ptrs[i] & 15) == 0);
+  }
+  bkt = m_MemSlab_of(ptrs[0])->bucket;
+  m_assert(bkt->size == 224);
+  sz = (M_MEMPOOL_SLAB - M_MEMSLAB_HEADER) / bkt->size;
+  m_assert(bkt->slabs == (NUM + sz - 1) / sz);
+  m_assert(mp->used == bkt->slabs * M_MEMPOOL_SLAB);
+  sz = bkt->slabs;
+  for (i = 0; i < NUM; ++i)
+    M_FREE(ptrs[i], 200);
+  m_assert(bkt->slabs == 1 && bkt->inuse == 0);
+  /* the others are spare, for any class */
+  m_assert(mp->nspare == sz - 1);
+  m_assert(mp->used == sz * M_MEMPOOL_SLAB);
+  p = M_MALLOC(3000);
+  m_assert(mp->nspare == sz - 2);
+  M_FREE(p, 3000);
+  m_MemPool_purge(mp, 0);
+  m_assert(mp->nspare == 0 && mp->used == 0);
+
+  M_MEMPOOL_STATUS();
+  M_MEMPOOL_FINI();
+#endif /* !M_NO_MEMPOOL */
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_mempool_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,120 @@
+#include <m_mph.h>
+#include <m_mempool.h>
+
+#define NUM 10000
+#define PATH "m_mph_test.c.out"
+
+static M_VOID
+build_test(const M_SZ num)
+{
+  m_MPH mph;
+  M_CHAR* buf;
+  const M_CHAR** keys;
+  M_SZ* lens;
+  M_UCHAR* seen;
+  M_SZ i;
+  M_UINT32 j;
+
+  buf = malloc(num * 16);
+  keys = malloc(num * sizeof(M_CHAR*));
+  lens = malloc(num * sizeof(M_SZ));
+  seen = calloc(num, 1);
+  m_assert(buf && keys && lens && seen);
+  for (i = 0; i < num; ++i)
+  {
+    sprintf(buf + i * 16, "key%lu", (unsigned long) i);
+    keys[i] = buf + i * 16;
+    lens[i] = strlen(keys[i]);
+  }
+
+  m_assert(m_MPH_build(&mph, keys, lens, num));
+  m_assert(mph.num == num);
+  /* one index for each key */
+  for (i = 0; i < num; ++i)
+  {
+    j = m_MPH_index(&mph, keys[i], lens[i]);
+    m_assert(j < num);
+    m_assert(!seen[j]);
+    seen[j] = 1;
+  }
+  /* others get some index too */
+  m_assert(m_MPH_index(&mph, "nokey", 5) < num);
+  m_MPH_fini(&mph);
+  m_assert(!mph.disp);
+
+  /* duplicate keys */
+  if (num > 1)
+  {
+    keys[num - 1] = keys[0];
+    lens[num - 1] = lens[0];
+    m_assert(!m_MPH_build(&mph, keys, lens, num));
+  }
+
+  free(seen);
+  free(lens);
+  free(keys);
+  free(buf);
+}
+
+static M_VOID
+write_c_test(M_VOID)
+{
+  m_MPH mph;
+  const M_CHAR* keys[] =
+      {"one", "two", "th\"r\\ee", "f\tour", "Really\?\?!"};
+  const M_CHAR* vals[] = {"un", "deux", "trois", NULL, "Vraiment\?\?)"};
+  M_SZ lens[5];
+  M_CHAR line[256];
+  FILE* f;
+  M_SZ i, found = 0;
+
+  for (i = 0; i < 5; ++i)
+    lens[i] = strlen(keys[i]);
+  m_assert(m_MPH_build(&mph, keys, lens, 5));
+  m_assert(m_MPH_write_c(&mph, keys, lens, vals, "words", PATH));
+  m_MPH_fini(&mph);
+
+  f = fopen(PATH, "r");
+  m_assert(f);
+  while (fgets(line, sizeof(line), f))
+  {
+    if (!strcmp(line, "const m_MPH words = {0, 5, 2, words_disp};\n")
+        || !strcmp(line, "  \"th\\\"r\\\\ee\",\n")
+        || !strcmp(line, "  \"f\\011our\",\n")
+        /* no trigraphs */
+        || !strcmp(line, "  \"Really\\?\\?!\",\n")
+        || !strcmp(line, "  \"Vraiment\\?\\?)\",\n")
+        || !strcmp(line, "words_find(const M_CHAR* key,\n"))
+      found += 1;
+  }
+  fclose(f);
+  remove(PATH);
+  m_assert(found == 6);
+}
+
+M_INT32
+m_mph_test(M_VOID)
+{
+  printf("-- start mph test\n");
+  M_MEMPOOL_INIT();
+
+  build_test(1);
+  build_test(2);
+  build_test(5);
+  build_test(NUM);
+  write_c_test();
+
+  M_MEMPOOL_STATUS();
+  M_MEMPOOL_FINI();
+  printf("-- end mph test\n");
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_mph_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
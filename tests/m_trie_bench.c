@@ -0,0 +1,131 @@
+/*
+ *  Random lookups in an m_Dict and in an m_Trie holding the same keys,
+ *  then prefix queries: a scan of the dict against a walk of the subtree
+ *  of the prefix.
+ *
+ *  Usage: m_trie_bench [number of keys]
+ */
+
+#include <m_dict.h>
+#include <m_trie.h>
+
+#define DEFAULT_NUM 200000
+#define QUERIES 200
+
+static M_DOUBLE
+elapsed(const clock_t start)
+{
+  return (M_DOUBLE)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+typedef struct
+{
+  const M_CHAR* prefix;
+  M_SZ len;
+  M_SZ num;
+} query;
+
+static M_VOID
+filter_fn(m_String* key,
+        M_PTR val,
+        M_PTR udata)
+{
+  query* const q = (query*) udata;
+  M_UNUSED(val);
+  if (!strncmp(key->data, q->prefix, q->len)) q->num += 1;
+}
+
+static M_VOID
+count_fn(m_String* key,
+        M_PTR val,
+        M_PTR udata)
+{
+  M_UNUSED(key);
+  M_UNUSED(val);
+  ((query*) udata)->num += 1;
+}
+
+int main(int argc, char* argv[])
+{
+  m_Dict d;
+  m_Trie t;
+  M_CHAR* buf;
+  const M_CHAR** order;
+  query q1, q2;
+  M_DOUBLE t1, t2;
+  clock_t start;
+  M_UINT64 x = 88172645463325252ULL;
+  M_SZ i, num, sum1 = 0, sum2 = 0;
+
+  num = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NUM;
+  if (num == 0) num = DEFAULT_NUM;
+  buf = malloc(num * 32);
+  order = malloc(num * sizeof(M_CHAR*));
+  m_assert(buf && order);
+
+  M_MEMPOOL_INIT();
+  m_assert(m_Dict_init(&d));
+  m_assert(m_Trie_init(&t));
+  for (i = 0; i < num; ++i)
+  {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    sprintf(buf + i * 32, "/route/%lu/%lu", (unsigned long)(x % 997),
+        (unsigned long) i);
+    m_assert(m_Dict_set(&d, buf + i * 32, (M_PTR)(i + 1), NULL));
+    m_assert(m_Trie_set(&t, buf + i * 32, (M_PTR)(i + 1), NULL));
+  }
+  for (i = 0; i < num; ++i)
+  {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    order[i] = buf + (x % num) * 32;
+  }
+
+  printf("-- keys: "M_SZ_FMT"\n", num);
+  printf("%-10s %10s %10s %9s\n", "(seconds)", "Dict", "Trie", "speedup");
+
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum1 += (M_SZ) m_Dict_get(&d, order[i]);
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < num; ++i)
+    sum2 += (M_SZ) m_Trie_get(&t, order[i]);
+  t2 = elapsed(start);
+  m_assert(sum1 == sum2);
+  printf("%-10s %10.3f %10.3f %8.2fx\n", "get", t1, t2,
+      t2 > 0 ? t1 / t2 : 0);
+
+  /* prefixes of random keys, up to their second slash */
+  q1.num = q2.num = 0;
+  start = clock();
+  for (i = 0; i < QUERIES; ++i)
+  {
+    q1.prefix = order[i];
+    q1.len = strrchr(order[i], '/') - order[i] + 1;
+    m_Dict_traverse_keyval2(&d, &filter_fn, &q1);
+  }
+  t1 = elapsed(start);
+  start = clock();
+  for (i = 0; i < QUERIES; ++i)
+  {
+    q2.prefix = order[i];
+    q2.len = strrchr(order[i], '/') - order[i] + 1;
+    m_Trie_traverse_prefix(&t, q2.prefix, q2.len, &count_fn, &q2);
+  }
+  t2 = elapsed(start);
+  m_assert(q1.num == q2.num);
+  printf("%-10s %10.3f %10.3f %8.2fx\n", "prefix", t1, t2,
+      t2 > 0 ? t1 / t2 : 0);
+
+  /* no fini, the pool frees it all at once */
+  M_MEMPOOL_FINI();
+  free(order);
+  free(buf);
+  return 0;
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */
@@ -0,0 +1,186 @@
+#include <m_trie.h>
+
+#define NUM 3000
+
+static M_CHAR keys[NUM][8];
+static M_BOOL present[NUM];
+
+/* unsigned compare, as in the trie */
+static int
+cmp_keys(const void* a,
+        const void* b)
+{
+  return strcmp(*(const M_CHAR* const*) a, *(const M_CHAR* const*) b);
+}
+
+static M_VOID
+count_fn(m_String* key,
+        M_PTR val,
+        M_PTR udata)
+{
+  M_SZ* const n = (M_SZ*) udata;
+  m_assert(!strcmp(key->data, keys[(M_SZ) val - 1]));
+  *n += 1;
+}
+
+/* random keys over a small alphabet, many of them prefixes of others */
+static M_VOID
+make_keys(M_VOID)
+{
+  M_UINT32 x = 2463534242U;
+  M_SZ i, j, len;
+
+  for (i = 0; i < NUM; ++i)
+  {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    len = 1 + x % 6;
+    for (j = 0; j < len; ++j)
+    {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      keys[i][j] = "abc\xe9"[x % 4];
+    }
+    keys[i][len] = '\0';
+  }
+}
+
+/* all present keys in order, and lower bounds of all keys */
+static M_VOID
+check_trie(const m_Trie* const t)
+{
+  const M_CHAR* sorted[NUM];
+  m_TrieIter it;
+  m_TrieLeaf* l;
+  M_SZ i, j, num = 0;
+
+  m_assert(m_Trie_check(t));
+  /* present keys are all different */
+  for (i = 0; i < NUM; ++i)
+  {
+    const M_SZ v = (M_SZ) m_Trie_get(t, keys[i]);
+    if (present[i])
+    {
+      m_assert(v == i + 1);
+      sorted[num++] = keys[i];
+    }
+    else
+      m_assert(!v || (present[v - 1] && !strcmp(keys[v - 1], keys[i])));
+  }
+  m_assert(num == m_Trie_count(t));
+  qsort(sorted, num, sizeof(M_CHAR*), &cmp_keys);
+
+  i = 0;
+  if (m_TrieIter_begin(&it, t))
+  {
+    do
+      m_assert(i < num && !strcmp(it.leaf->key, sorted[i++]));
+    while (m_TrieIter_next(&it));
+  }
+  m_assert(i == num);
+
+  for (i = 0; i < NUM; i += 7)
+  {
+    for (j = 0; j < num && strcmp(sorted[j], keys[i]) < 0; ++j) ;
+    l = m_Trie_lower_bound(t, keys[i], strlen(keys[i]));
+    m_assert(j == num ? !l : l && !strcmp(l->key, sorted[j]));
+  }
+}
+
+M_INT32
+m_trie_test(M_VOID)
+{
+  m_Trie t;
+  m_Trie* pt;
+  m_TrieIter it;
+  M_PTR prev;
+  M_SZ i, j, n;
+
+  printf("-- start trie test\n");
+  M_MEMPOOL_INIT();
+  make_keys();
+
+  m_assert(m_Trie_new(&pt));
+  m_assert(!m_Trie_get(pt, "a"));
+  m_assert(!m_Trie_unset(pt, "a"));
+  m_assert(!m_Trie_lower_bound(pt, "", 0));
+  m_assert(!m_TrieIter_begin(&it, pt));
+  m_Trie_delete(&pt);
+  m_assert(!pt);
+
+  m_assert(m_Trie_init(&t));
+  memset(present, 0, sizeof(present));
+  for (i = 0; i < NUM; ++i)
+  {
+    /* duplicates keep the first value */
+    if (m_Trie_get(&t, keys[i])) continue;
+    m_assert(m_Trie_set(&t, keys[i], (M_PTR)(i + 1), &prev));
+    m_assert(prev == (M_PTR)(i + 1));
+    present[i] = M_TRUE;
+  }
+  check_trie(&t);
+
+  /* lower bounds around the ends */
+  m_assert(m_Trie_lower_bound(&t, "", 0) == m_Trie_lower_bound(&t, "a", 1));
+  m_assert(!m_Trie_lower_bound(&t, "\xff", 1));
+  m_assert(m_TrieIter_seek(&it, &t, "ab", 2));
+  m_assert(strcmp(it.leaf->key, "ab") >= 0);
+
+  /* prefixes */
+  for (i = 0; i < NUM; i += 11)
+  {
+    for (j = 0; keys[i][j]; ++j)
+    {
+      M_SZ expect = 0, k;
+      for (k = 0; k < NUM; ++k)
+        if (present[k] && !strncmp(keys[k], keys[i], j)) expect += 1;
+      n = 0;
+      m_assert(m_Trie_traverse_prefix(&t, keys[i], j, &count_fn, &n) == expect);
+      m_assert(n == expect);
+    }
+  }
+  n = 0;
+  m_assert(m_Trie_traverse_prefix(&t, "abcabcabc", 9, &count_fn, &n) == 0);
+
+  /* unset half, set again */
+  for (i = 0; i < NUM; i += 2)
+  {
+    if (!present[i]) continue;
+    m_assert(m_Trie_unset(&t, keys[i]) == (M_PTR)(i + 1));
+    m_assert(!m_Trie_unset(&t, keys[i]));
+    present[i] = M_FALSE;
+  }
+  check_trie(&t);
+  m_assert(m_Trie_set(&t, "xyz", (M_PTR) 1, &prev));
+  m_assert(m_Trie_set_len(&t, "xyzXYZ", 3, (M_PTR) 2, &prev));
+  m_assert(prev == (M_PTR) 1);
+  m_assert(m_Trie_unset_len(&t, "xyzXYZ", 3) == (M_PTR) 2);
+
+  for (i = 0; i < NUM; ++i)
+  {
+    if (present[i]) m_assert(m_Trie_unset(&t, keys[i]) == (M_PTR)(i + 1));
+    present[i] = M_FALSE;
+  }
+  check_trie(&t);
+  m_assert(!t.root);
+
+  m_assert(m_Trie_set(&t, "one", (M_PTR) 1, NULL));
+  m_assert(m_Trie_set(&t, "two", (M_PTR) 2, NULL));
+  m_Trie_fini(&t);
+
+  M_MEMPOOL_STATUS();
+  M_MEMPOOL_FINI();
+  printf("-- end trie test\n");
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  M_UNUSED(argc);
+  M_UNUSED(argv);
+  return m_trie_test();
+}
+
+/* vi: set fenc=utf-8 ff=unix et sw=2 ts=2 sts=2 : */